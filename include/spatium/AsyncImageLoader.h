@@ -0,0 +1,286 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_ASYNCIMAGELOADER_H
+#define SPATIUMLIB_ASYNCIMAGELOADER_H
+
+#include "Image.h"
+
+#include <condition_variable> // std::condition_variable
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <functional> // std::function
+#include <mutex> // std::mutex, std::unique_lock
+#include <string> // std::string
+#include <thread> // std::thread
+#include <vector> // std::vector
+
+namespace spatium {
+
+/// \class AsyncImageLoader
+/// \brief Load a sequence of images on background threads
+///
+/// The loader reads images from a queue of paths on worker threads while the
+/// consumer processes previously loaded images. Images are delivered to the
+/// consumer in the order of the paths, regardless of the order in which the
+/// workers finish.
+///
+/// The number of images loaded ahead of the consumer is bounded by the
+/// buffer count. The image buffers are recycled: next() swaps a loaded
+/// buffer with the image of the consumer, which then becomes the buffer for
+/// a subsequent path. When all images have the same size no memory is
+/// allocated after the first round of buffers.
+///
+/// Example:
+/// \code
+/// AsyncImageLoader<unsigned char, 3> loader(
+///   [](const std::string &path, Image<unsigned char, 3> &image) {
+///     return ImageIO::readRgbImageFromPpm(path, image);
+///   });
+/// loader.enqueue(paths);
+///
+/// Image<unsigned char, 3> frame;
+/// bool success;
+/// while (loader.next(frame, success))
+/// {
+///   // Process frame
+/// }
+/// \endcode
+template<typename T = unsigned char, int N = 3>
+class AsyncImageLoader
+{
+public:
+  /// Function that reads the image at a path. Returns true on success.
+  /// An exception thrown by the function is rethrown by next().
+  typedef std::function<bool(const std::string &, Image<T, N> &)> ReadFunction;
+
+  /// Constructor. Starts the worker threads.
+  ///
+  /// \param[in] read Function that reads an image. It is called
+  /// concurrently from multiple worker threads.
+  /// \param[in] threadCount Number of worker threads (default = 2)
+  /// \param[in] bufferCount Maximum number of images loaded ahead of the
+  /// consumer (default = 4)
+  explicit AsyncImageLoader(ReadFunction read, size_t threadCount = 2, size_t bufferCount = 4)
+    : m_read(read)
+    , m_slots(bufferCount > 0 ? bufferCount : 1)
+    , m_nextToLoad(0)
+    , m_nextToDeliver(0)
+    , m_stop(false)
+  {
+    for (size_t i = 0; i < (threadCount > 0 ? threadCount : 1); i++)
+    {
+      m_threads.push_back(std::thread(&AsyncImageLoader::work, this));
+    }
+  }
+
+  /// Destructor. Stops the worker threads.
+  ///
+  /// Images that are being read are finished; remaining paths are not read.
+  ~AsyncImageLoader()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (std::thread &thread : m_threads)
+    {
+      thread.join();
+    }
+  }
+
+  AsyncImageLoader(const AsyncImageLoader &) = delete;
+  AsyncImageLoader &operator=(const AsyncImageLoader &) = delete;
+
+  /// Add a path to the queue.
+  ///
+  /// \param[in] path Path to image file
+  void enqueue(const std::string &path)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_paths.push_back(path);
+    }
+    m_workAvailable.notify_one();
+  }
+
+  /// Add paths to the queue.
+  ///
+  /// \param[in] paths Paths to image files
+  void enqueue(const std::vector<std::string> &paths)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_paths.insert(m_paths.end(), paths.begin(), paths.end());
+    }
+    m_workAvailable.notify_all();
+  }
+
+  /// Number of paths that have been enqueued.
+  size_t size() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_paths.size();
+  }
+
+  /// Number of images that have been delivered by next().
+  size_t delivered() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nextToDeliver;
+  }
+
+  /// Get the next image in queue order.
+  ///
+  /// Blocks until the image has been loaded. The loaded image is swapped
+  /// with the given image; the previous contents of the given image are
+  /// reused as buffer for another path.
+  ///
+  /// \param[in,out] image Image
+  /// \param[out] success True if the image has been read successfully. If
+  /// false the contents of the image are undefined.
+  /// \return True if an image has been delivered, false if all enqueued
+  /// paths have been delivered
+  /// \throw Exception thrown by the read function for this path. The
+  /// loader remains usable; the next call delivers the subsequent path.
+  bool next(Image<T, N> &image, bool &success)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_nextToDeliver >= m_paths.size())
+    {
+      return false;
+    }
+
+    Slot &slot = m_slots[m_nextToDeliver % m_slots.size()];
+    m_imageReady.wait(lock, [&slot]() { return slot.ready; });
+
+    image.swap(slot.image);
+    success = slot.success;
+    std::exception_ptr error = slot.error;
+    slot.error = nullptr;
+    slot.ready = false;
+    m_nextToDeliver++;
+    lock.unlock();
+
+    // Slot is free for the next path
+    m_workAvailable.notify_one();
+
+    if (error)
+    {
+      std::rethrow_exception(error);
+    }
+    return true;
+  }
+
+protected:
+  /// Buffer of a path being loaded or waiting for delivery.
+  struct Slot
+  {
+    Slot()
+      : ready(false)
+      , success(false)
+    {
+    }
+
+    /// Image buffer
+    Image<T, N> image;
+
+    /// Image has been loaded (or failed to load)
+    bool ready;
+
+    /// Image has been loaded successfully
+    bool success;
+
+    /// Exception thrown by the read function, if any
+    std::exception_ptr error;
+  };
+
+  /// Worker thread function.
+  ///
+  /// Path i is loaded into slot i modulo the slot count. A path is only
+  /// taken once its slot has been delivered, which bounds the number of
+  /// images loaded ahead.
+  void work()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+      m_workAvailable.wait(lock, [this]() {
+        return (m_stop || (m_nextToLoad < m_paths.size()
+                           && m_nextToLoad < m_nextToDeliver + m_slots.size()));
+      });
+      if (m_stop)
+      {
+        return;
+      }
+
+      const size_t index = m_nextToLoad++;
+      const std::string path = m_paths[index];
+      Slot &slot = m_slots[index % m_slots.size()];
+      lock.unlock();
+
+      // Read without holding the lock
+      bool success = false;
+      std::exception_ptr error;
+      try
+      {
+        success = m_read(path, slot.image);
+      }
+      catch (...)
+      {
+        // Forward to the consumer; an escaping exception would terminate
+        error = std::current_exception();
+      }
+
+      lock.lock();
+      slot.success = success;
+      slot.error = error;
+      slot.ready = true;
+      m_imageReady.notify_one();
+    }
+  }
+
+  /// Function that reads an image
+  ReadFunction m_read;
+
+  /// Ring of image buffers
+  std::vector<Slot> m_slots;
+
+  /// Queue of paths
+  std::vector<std::string> m_paths;
+
+  /// Index of next path to load
+  size_t m_nextToLoad;
+
+  /// Index of next path to deliver
+  size_t m_nextToDeliver;
+
+  /// Worker threads should stop
+  bool m_stop;
+
+  /// Worker threads
+  std::vector<std::thread> m_threads;
+
+  /// Guards all members above
+  mutable std::mutex m_mutex;
+
+  /// Signals workers that a path and a free slot are available
+  std::condition_variable m_workAvailable;
+
+  /// Signals the consumer that an image has been loaded
+  std::condition_variable m_imageReady;
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_ASYNCIMAGELOADER_H
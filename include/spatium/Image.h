@@ -46,14 +46,20 @@ struct PixelValue<T, 1>
   static std::array<T, 1> value(const std::array<T, 3> &input)
   {
     // Convert 3 channel RGB to 1 channel Grayscale
-    return { input[0] * 0.2125 + input[1] * 0.7154 + input[2] * 0.0721 };
+    return { static_cast<T>(input[0] * 0.2125 + input[1] * 0.7154 + input[2] * 0.0721) };
   }
 
   // Convert 4 channel pixel value to 1 channel
-  static std::array<T, 1> pixelValue(const std::array<T, 4> &input)
+  static std::array<T, 1> value(const std::array<T, 4> &input)
   {
     // Convert 4 channel RGBA to grayscale by luminosity (BT.709) (Alpha is ignored)
-    return { input[0] * 0.2125 + input[1] * 0.7154 + input[2] * 0.0721 };
+    return { static_cast<T>(input[0] * 0.2125 + input[1] * 0.7154 + input[2] * 0.0721) };
+  }
+
+  // Convert 4 channel pixel value to 1 channel
+  static std::array<T, 1> pixelValue(const std::array<T, 4> &input)
+  {
+    return value(input);
   }
 };
 
@@ -312,21 +318,36 @@ public:
   }
 
   /// Resize image.
-  /// This allocates new memory without copying pixel values.
+  /// This allocates new memory without copying pixel values. If the pixel
+  /// count is unchanged the existing memory is reused.
   ///
   /// \param[in] width Image width in pixels
   /// \param[in] height Image height in pixels
   /// \throw std::bad_alloc on bad allocation
   void resize(size_t newWidth, size_t newHeight)
   {
+    if (newWidth * newHeight != m_width * m_height)
+    {
+      m_imageData.reset(new std::array<T,N>[newHeight * newWidth]);
+    }
     m_width = newWidth;
     m_height = newHeight;
-    m_imageData.reset(new std::array<T,N>[m_height * m_width]);
 
     // Clear values
     clear();
   }
 
+  /// Swap the contents of two images.
+  /// No memory is allocated and no pixel values are copied.
+  ///
+  /// \param[in,out] other Other image
+  void swap(Image &other)
+  {
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    std::swap(m_imageData, other.m_imageData);
+  }
+
   /// Clear the image data (Set to zero)
   void clear()
   {
@@ -14,17 +14,32 @@
 #define SPATIUMLIB_IMAGEIO_H
 
 #include "Image.h"
+#include "TiffReader.h"
 
 #include <fstream> // std::ofstream, std::ifstream
 #include <cctype> // std::isspace
 #include <string> // std::stol
+#include <sstream> // std::istringstream
+#include <memory> // std::unique_ptr
+#include <vector> // std::vector
+#include <cstdint> // std::uint8_t
+#include <streambuf> // std::streambuf
+#include <type_traits> // std::is_same
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUMLIB_IMAGEIO_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
 
 namespace spatium {
 
+template<typename T, int N> class PnmScanlineReader;
+template<typename T, int N> class PnmScanlineWriter;
+
 /// \class ImageIO
 /// \brief Read and write images
 ///
-/// This class supports 4 file formats:
+/// This class supports 6 file formats:
 ///
 /// - Portable Bit Map (PBM) for binary images (values 0 and 1).
 ///   - http://netpbm.sourceforge.net/doc/pbm.html
@@ -37,9 +52,27 @@ namespace spatium {
 ///   - Although this file format supports many pixel formats, it is not widely
 /// supported. Consider using the other 3 file formats when possisble. Only use
 /// this format if you require transparancy (alpha channel).
+/// - Quite OK Image format (QOI) for RGB and RGBA images.
+///   - https://qoiformat.org
+///   - Lossless compression with fast encoding and decoding.
+/// - Tagged Image File Format (TIFF and BigTIFF), read only.
+///   - Uncompressed and PackBits compressed strips and tiles. See TiffReader
+/// for reading individual strips, tiles or windows.
+///
+/// Each image can be read from and written to a file, a memory buffer or a
+/// standard stream. Reading from and writing to memory avoids a round-trip
+/// through the file system. TIFF images can only be read from a file.
+///
+/// Input streams are read sequentially, up to the end of the image (QOI and
+/// ASCII PNM images: up to the end of the stream). They need not be
+/// seekable; pipes, sockets and std::cin can be read as well.
+///
+/// PBM, PGM and PPM files are written in the binary variant (P4, P5, P6).
+/// Both the binary and the ASCII variant (P1, P2, P3) can be read.
 ///
-/// Beware! These functions have not been tested on endianness; big-endian vs
-/// little-endian.
+/// Pixel data is transferred in blocks of whole rows or whole images rather
+/// than per pixel. 16-bit samples are stored big-endian (most significant
+/// byte first) as prescribed by the file formats.
 class ImageIO
 {
 public:
@@ -59,40 +92,51 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    ofile.write("P4\n", 3);
+    return writeBinaryImageAsPbm(image, ofile);
+  }
 
-    // Write width ASCII
-    std::string widthStr = std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
+  /// Write binary image to memory buffer as PBM (Portable Bit Map).
+  ///
+  /// In this file each pixel is represented by 1 bit. In the Image object
+  /// each pixel is represented by 1 byte.
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeBinaryImageAsPbm(const Image<unsigned char, 1> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeBinaryImageAsPbm(image, ofile);
+  }
 
-    // Write height as ASCII
-    std::string heightStr = std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
+  /// Write binary image to output stream as PBM (Portable Bit Map).
+  ///
+  /// In this file each pixel is represented by 1 bit. In the Image object
+  /// each pixel is represented by 1 byte.
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeBinaryImageAsPbm(const Image<unsigned char, 1> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePnmFileHeader(ofile, "P4", image.width(), image.height(), 1);
 
-    // Write pixel values
+    // Write pixel values. Pack each row into bits (8 pixels per byte).
     const size_t width = image.width();
+    const size_t rowSize = (width + 7) / 8;
+    std::unique_ptr<unsigned char[]> row(new unsigned char[rowSize]);
+    const unsigned char *data = imageBytes(image);
     for (size_t y = 0; y < image.height(); y++)
     {
-      for (size_t x = 0; x < width; x += 8)
-      {
-        // Construct byte
-        unsigned char val = 0x00; // inverted (black = 0)
-        for (unsigned char i = 0; (i < 8 && x + i < width); i++)
-        {
-          unsigned char shift = 7 - i;
-          unsigned char pixel = (image.pixel(x+i,y,false)[0] == 0 ? 0x00 : 0x01); // inverted (white = 1)
-          unsigned char mask = static_cast<unsigned char>(pixel << shift);
-          val |= mask;
-        }
-        val = ~val; // invert as needed (black = 1, white = 0)
-
-        // Write byte
-        ofile.write(reinterpret_cast<char*>(&val), 1);
-      }
+      packBinaryRow(data + y * width, width, row.get());
+      ofile.write(reinterpret_cast<const char*>(row.get()), static_cast<std::streamsize>(rowSize));
     }
 
-    return  true;
+    return ofile.good();
   }
 
   /// Write 8-bit grayscale image to file as PGM (Portable Gray Map)
@@ -108,35 +152,44 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    ofile.write("P5\n", 3);
-
-    // Write width ASCII
-    std::string widthStr = std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
+    return writeGrayscaleImageAsPgm(image, ofile);
+  }
 
-    // Write height as ASCII
-    std::string heightStr = std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
+  /// Write 8-bit grayscale image to memory buffer as PGM (Portable Gray Map)
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeGrayscaleImageAsPgm(const Image<unsigned char, 1> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeGrayscaleImageAsPgm(image, ofile);
+  }
 
-    // Write maximum value
-    ofile.write("255\n", 4);
+  /// Write 8-bit grayscale image to output stream as PGM (Portable Gray Map)
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeGrayscaleImageAsPgm(const Image<unsigned char, 1> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePnmFileHeader(ofile, "P5", image.width(), image.height(), 255);
 
-    // Write pixel values
-    for (size_t y = 0; y < image.height(); y++)
-    {
-      for (size_t x = 0; x < image.width(); x++)
-      {
-        char val = static_cast<char>(image.pixel(x,y,false)[0]);
-        ofile.write(&val, 1);
-      }
-    }
+    // Write pixel values. Memory layout equals file layout.
+    writeBytes(ofile, imageBytes(image), image.width() * image.height());
 
-    return  true;
+    return ofile.good();
   }
 
   /// Write 16-bit grayscale image to file as PGM (Portable Gray Map)
   ///
+  /// Each sample is written as 2 bytes, most significant byte first
+  /// (big-endian), regardless of the endianness of the machine.
+  ///
   /// \param[in] image Image
   /// \param[in] pgmPath Path to PGM file. Should have file extension *.pgm
   /// \return True on success, false otherwise
@@ -148,34 +201,50 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    ofile.write("P5\n", 3);
-
-    // Write width ASCII
-    std::string widthStr = std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
+    return writeGrayscaleImageAsPgm(image, ofile);
+  }
 
-    // Write height as ASCII
-    std::string heightStr = std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
+  /// Write 16-bit grayscale image to memory buffer as PGM (Portable Gray Map)
+  ///
+  /// Each sample is written as 2 bytes, most significant byte first
+  /// (big-endian), regardless of the endianness of the machine.
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeGrayscaleImageAsPgm(const Image<unsigned short, 1> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeGrayscaleImageAsPgm(image, ofile);
+  }
 
-    // Write maximum value
-    ofile.write("65535\n", 6);
+  /// Write 16-bit grayscale image to output stream as PGM (Portable Gray Map)
+  ///
+  /// Each sample is written as 2 bytes, most significant byte first
+  /// (big-endian), regardless of the endianness of the machine.
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeGrayscaleImageAsPgm(const Image<unsigned short, 1> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePnmFileHeader(ofile, "P5", image.width(), image.height(), 65535);
 
-    // Write pixel values
-    unsigned short inputval;
-    unsigned short *inputvalPtr = &inputval;
-    char *v = reinterpret_cast<char*>(inputvalPtr);
+    // Write pixel values. Convert each row to big-endian.
+    const size_t width = image.width();
+    std::unique_ptr<unsigned char[]> row(new unsigned char[width * 2]);
+    const unsigned short *data = imageSamples(image);
     for (size_t y = 0; y < image.height(); y++)
     {
-      for (size_t x = 0; x < image.width(); x++)
-      {
-        inputval = image.pixel(x,y,false)[0];
-        ofile.write(v, 2); // NOT WORKING! Always 0
-      }
+      encodeBigEndian(data + y * width, width, row.get());
+      writeBytes(ofile, row.get(), width * 2);
     }
 
-    return true;
+    return ofile.good();
   }
 
   /// Write 24-bit RGB image to file as PPM (Portable Pixel Map)
@@ -191,32 +260,37 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    ofile.write("P6\n", 3);
-
-    // Write width ASCII
-    std::string widthStr = std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
+    return writeRgbImageAsPpm(image, ofile);
+  }
 
-    // Write height as ASCII
-    std::string heightStr = std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
+  /// Write 24-bit RGB image to memory buffer as PPM (Portable Pixel Map)
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsPpm(const Image<unsigned char, 3> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeRgbImageAsPpm(image, ofile);
+  }
 
-    // Write maximum value
-    ofile.write("255\n", 4);
+  /// Write 24-bit RGB image to output stream as PPM (Portable Pixel Map)
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsPpm(const Image<unsigned char, 3> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePnmFileHeader(ofile, "P6", image.width(), image.height(), 255);
 
-    // Write pixel values
-    for (size_t y = 0; y < image.height(); y++)
-    {
-      for (size_t x = 0; x < image.width(); x++)
-      {
-        std::array<unsigned char, 3> pixel = image.pixel(x, y, false);
-        char val[3] = { static_cast<char>(pixel[0]), static_cast<char>(pixel[1]), static_cast<char>(pixel[2]) };
-        ofile.write(val, 3);
-      }
-    }
+    // Write pixel values. Memory layout equals file layout.
+    writeBytes(ofile, imageBytes(image), image.width() * image.height() * 3);
 
-    return true;
+    return ofile.good();
   }
 
   /// Write 32-bit RGBA image to file as PPM (Portable Pixel Map)
@@ -227,8 +301,7 @@ public:
   /// \param[in] image Image
   /// \param[in] ppmPath Path to PPM file. Should have file extension *.ppm
   /// \return True on success, false otherwise
-  static bool writeRgbaImageAsPpm(const Image<unsigned char, 4> &image,
-                                  const std::string &ppmPath)
+  static bool writeRgbaImageAsPpm(const Image<unsigned char, 4> &image, const std::string &ppmPath)
   {
     std::ofstream ofile(ppmPath, std::ios::out | std::ios::binary);
     if (!ofile.is_open())
@@ -236,34 +309,56 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    ofile.write("P6\n", 3);
-
-    // Write width ASCII
-    std::string widthStr = std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
+    return writeRgbaImageAsPpm(image, ofile);
+  }
 
-    // Write height as ASCII
-    std::string heightStr = std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
+  /// Write 32-bit RGBA image to memory buffer as PPM (Portable Pixel Map)
+  ///
+  /// This file format does not support transparancy. The alpha channel is
+  /// omitted. Use PAM instead.
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsPpm(const Image<unsigned char, 4> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeRgbaImageAsPpm(image, ofile);
+  }
 
-    // Write maximum value
-    ofile.write("255\n", 4);
+  /// Write 32-bit RGBA image to output stream as PPM (Portable Pixel Map)
+  ///
+  /// This file format does not support transparancy. The alpha channel is
+  /// omitted. Use PAM instead.
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsPpm(const Image<unsigned char, 4> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePnmFileHeader(ofile, "P6", image.width(), image.height(), 255);
 
-    // Write pixel values
+    // Write pixel values. Strip the alpha channel of each row.
+    const size_t width = image.width();
+    std::unique_ptr<unsigned char[]> row(new unsigned char[width * 3]);
+    const unsigned char *data = imageBytes(image);
     for (size_t y = 0; y < image.height(); y++)
     {
-      for (size_t x = 0; x < image.width(); x++)
+      const unsigned char *rowData = data + y * width * 4;
+      for (size_t x = 0; x < width; x++)
       {
-        std::array<unsigned char, 4> pixel = image.pixel(x, y, false);
-        char val[3] = { static_cast<char>(pixel[0]),
-                        static_cast<char>(pixel[1]),
-                        static_cast<char>(pixel[2]) };
-        ofile.write(val, 3);
+        row[3*x] = rowData[4*x];
+        row[3*x+1] = rowData[4*x+1];
+        row[3*x+2] = rowData[4*x+2];
       }
+      writeBytes(ofile, row.get(), width * 3);
     }
 
-    return true;
+    return ofile.good();
   }
 
   /// Write 24-bit RGB image to file as PAM (Portable Arbitrary Map)
@@ -271,8 +366,7 @@ public:
   /// \param[in] image Image
   /// \param[in] pamPath Path to PAM file. Should have file extension *.pam
   /// \return True on success, false otherwise
-  static bool writeRgbImageAsPam(const Image<unsigned char, 3> &image,
-                                 const std::string &pamPath)
+  static bool writeRgbImageAsPam(const Image<unsigned char, 3> &image, const std::string &pamPath)
   {
     std::ofstream ofile(pamPath, std::ios::out | std::ios::binary);
     if (!ofile.is_open())
@@ -280,48 +374,37 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    std::string magicNumberStr = "P7\n";
-    ofile.write(magicNumberStr.c_str(), magicNumberStr.length());
-
-    // Write width ASCII
-    std::string widthStr = "WIDTH " + std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
-
-    // Write height as ASCII
-    std::string heightStr = "HEIGHT " + std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
-
-    // Write depth
-    std::string depthStr = "DEPTH 3\n";
-    ofile.write(depthStr.c_str(), depthStr.length());
-
-    // Write maximum value
-    std::string maxValStr = "MAXVAL 255\n";
-    ofile.write(maxValStr.c_str(), maxValStr.length());
+    return writeRgbImageAsPam(image, ofile);
+  }
 
-    // Write tuple type
-    std::string tupleTypeStr = "TUPLTYPE RGB\n";
-    ofile.write(tupleTypeStr.c_str(), tupleTypeStr.length());
+  /// Write 24-bit RGB image to memory buffer as PAM (Portable Arbitrary Map)
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsPam(const Image<unsigned char, 3> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeRgbImageAsPam(image, ofile);
+  }
 
-    // Write header end
-    std::string headerEndStr = "ENDHDR\n";
-    ofile.write(headerEndStr.c_str(), headerEndStr.length());
+  /// Write 24-bit RGB image to output stream as PAM (Portable Arbitrary Map)
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsPam(const Image<unsigned char, 3> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePamFileHeader(ofile, image.width(), image.height(), 3, 255, "RGB");
 
-    // Write pixel values
-    for (size_t y = 0; y < image.height(); y++)
-    {
-      for (size_t x = 0; x < image.width(); x++)
-      {
-        std::array<unsigned char, 3> pixel = image.pixel(x, y, false);
-        char val[3] = { static_cast<char>(pixel[0]),
-                        static_cast<char>(pixel[1]),
-                        static_cast<char>(pixel[2]) };
-        ofile.write(val, 3);
-      }
-    }
+    // Write pixel values. Memory layout equals file layout.
+    writeBytes(ofile, imageBytes(image), image.width() * image.height() * 3);
 
-    return true;
+    return ofile.good();
   }
 
   /// Write 32-bit RGBA image to file as PAM (Portable Arbitrary Map)
@@ -337,86 +420,97 @@ public:
       return false;
     }
 
-    // Write magic number ASCII
-    std::string magicNumberStr = "P7\n";
-    ofile.write(magicNumberStr.c_str(), magicNumberStr.length());
-
-    // Write width ASCII
-    std::string widthStr = "WIDTH " + std::to_string(image.width()) + "\n";
-    ofile.write(widthStr.c_str(), widthStr.length());
-
-    // Write height as ASCII
-    std::string heightStr = "HEIGHT " + std::to_string(image.height()) + "\n";
-    ofile.write(heightStr.c_str(), heightStr.length());
+    return writeRgbaImageAsPam(image, ofile);
+  }
 
-    // Write depth
-    std::string depthStr = "DEPTH 4\n";
-    ofile.write(depthStr.c_str(), depthStr.length());
+  /// Write 32-bit RGBA image to memory buffer as PAM (Portable Arbitrary Map)
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsPam(const Image<unsigned char, 4> &image, std::vector<std::uint8_t> &buffer)
+  {
+    MemoryOutputBuffer streamBuffer(buffer);
+    std::ostream ofile(&streamBuffer);
+    return writeRgbaImageAsPam(image, ofile);
+  }
 
-    // Write maximum value
-    std::string maxValStr = "MAXVAL 255\n";
-    ofile.write(maxValStr.c_str(), maxValStr.length());
+  /// Write 32-bit RGBA image to output stream as PAM (Portable Arbitrary Map)
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsPam(const Image<unsigned char, 4> &image, std::ostream &ofile)
+  {
+    // Write header
+    writePamFileHeader(ofile, image.width(), image.height(), 4, 255, "RGB_ALPHA");
 
-    // Write tuple type
-    std::string tupleTypeStr = "TUPLTYPE RGB\n";
-    ofile.write(tupleTypeStr.c_str(), tupleTypeStr.length());
+    // Write pixel values. Memory layout equals file layout.
+    writeBytes(ofile, imageBytes(image), image.width() * image.height() * 4);
 
-    // Write header end
-    std::string headerEndStr = "ENDHDR\n";
-    ofile.write(headerEndStr.c_str(), headerEndStr.length());
+    return ofile.good();
+  }
 
-    // Write pixel values
-    for (size_t y = 0; y < image.height(); y++)
+  /// Read 1-bit binary image from PBM file (Portable Bit Map).
+  ///
+  /// \param[in] pbmPath Path to PBM file. Should have file extension *.pbm
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readBinaryImageFromPbm(const std::string &pbmPath, Image<unsigned char, 1> &image)
+  {
+    std::ifstream ifile(pbmPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
     {
-      for (size_t x = 0; x < image.width(); x++)
-      {
-        std::array<unsigned char, 4> pixel = image.pixel(x, y, false);
-        char val[4] = { static_cast<char>(pixel[0]),
-                        static_cast<char>(pixel[1]),
-                        static_cast<char>(pixel[2]),
-                        static_cast<char>(pixel[3]) };
-        ofile.write(val, 4);
-      }
+      return false;
     }
 
-    return true;
+    return readBinaryImageFromPbm(ifile, image);
   }
 
-  /// Read 1-bit binary image from PBM file (Portable Bit Map).
+  /// Read 1-bit binary image from PBM data in memory (Portable Bit Map).
   ///
-  /// \param[in] pbmPath Path to PBM file. Should have file extension *.pbm
+  /// The pixel data is read straight from the buffer without intermediate
+  /// copies.
+  ///
+  /// \param[in] data Pointer to PBM data
+  /// \param[in] size Size of PBM data in bytes
   /// \param[out] image Image
   /// \return True on success, false otherwise
-  static bool readBinaryImageFromPbm(const std::string &pbmPath, Image<unsigned char, 1> &image)
+  static bool readBinaryImageFromPbm(const std::uint8_t *data, size_t size, Image<unsigned char, 1> &image)
+  {
+    MemoryInputBuffer streamBuffer(data, size);
+    std::istream ifile(&streamBuffer);
+    return readBinaryImageFromPbm(ifile, image);
+  }
+
+  /// Read 1-bit binary image from PBM data in input stream (Portable Bit Map).
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readBinaryImageFromPbm(std::istream &ifile, Image<unsigned char, 1> &image)
   {
     // Minimal file content:
     //P4\n        (magic number + whitespace; 3 bytes)
     //1 1\n       (width height whitespaces; 4 bytes)
     //0x01        (binary: bits; 1 byte) (1 = black, 0 = white)
 
+    // ASCII variant: magic number P1, one digit per pixel.
+
     // Optional content:
     //# Comments with spaces.\n (comment ending with \n)
 
-    // Open file
-    std::ifstream ifile(pbmPath, std::ios::in | std::ios::binary);
-    if (!ifile.is_open())
-    {
-      return false;
-    }
-
-    // Check file size
-    ifile.seekg (0, ifile.end);
-    long size = ifile.tellg();
-    ifile.seekg (0, ifile.beg);
-    if (size < 8)
-    {
-      return false;
-    }
-
-    // Read header
+    // Read header. The magic number determines the variant.
+    std::string magicNumber;
+    ifile >> magicNumber;
+    const bool ascii = (magicNumber == "P1");
     size_t width = 1, height = 1;
     unsigned long maxVal = 0;
-    if (!readPnmFileHeader(ifile, "P4", width, height, maxVal))
+    if ((!ascii && magicNumber != "P4")
+        || !readPnmHeaderValues(ifile, magicNumber, width, height, maxVal)
+        || !isValidImageSize(width, height))
     {
       return false;
     }
@@ -424,31 +518,28 @@ public:
     // Resize output image
     image.resize(width, height);
 
+    if (ascii)
+    {
+      // Parse digits. Whitespace between digits is optional.
+      std::vector<std::uint8_t> text;
+      return (readRemainingBytes(ifile, text)
+              && parseAsciiBits(text.data(), text.data() + text.size(), imageBytes(image), width * height));
+    }
+
     // Pass last whitespace
-    ifile.seekg(1, ifile.cur);
+    ifile.get();
 
-    // Read pixels
-    //std::unique_ptr<unsigned char> pixel(new unsigned char);
-    unsigned char pixel;
+    // Read pixels. Unpack each row of bits (8 pixels per byte).
+    const size_t rowSize = (width + 7) / 8;
+    std::unique_ptr<unsigned char[]> row(new unsigned char[rowSize]);
+    unsigned char *data = imageBytes(image);
     for (size_t y = 0; y < height; y++)
     {
-      for (size_t x = 0; x < width; x += 8)
+      if (!readBytes(ifile, row.get(), rowSize))
       {
-        // Read byte
-        ifile.read(reinterpret_cast<char*>(&pixel), 1);
-
-        // Iterate bits
-        for (unsigned char i = 0; (i < 8 && x + i < width); i++)
-        {
-          // Extract value
-          unsigned char shift = 7 - i;
-          unsigned char mask = static_cast<unsigned char>(0x01 << shift);
-          unsigned char value = ((pixel & mask) > 0 ? 0 : 255);
-
-          // Set pixel value
-          image.pixel(x+i, y, false) = { value };
-        }
+        return false;
       }
+      unpackBinaryRow(row.get(), width, data + y * width);
     }
 
     return true;
@@ -456,162 +547,927 @@ public:
 
   /// Read 8-bit grayscale image from PGM file (Portable Gray Map)
   ///
-  /// Beware! This file format also supports 16-bit grayscale format (2 bytes
-  /// per channel). This is not implemented and function will return false in
-  /// that situation.
+  /// Files with a maximum value above 255 (2 bytes per sample) are rejected.
+  /// Read those into an Image<unsigned short, 1> instead.
   ///
   /// \param[in] pgmPath Path to PGM file. Should have file extension *.pgm
   /// \param[out] image Image
   /// \return True on success, false otherwise
   static bool readGrayscaleImageFromPgm(const std::string &pgmPath, Image<unsigned char, 1> &image)
   {
-    // Minimal file content:
-    //P5\n        (magic number + whitespace; 3 bytes)
-    //1 1\n       (width height whitespaces; 4 bytes)
-    //1\n         (max value + whitespace; 2 bytes)
-    //0x11        (binary: gray; 1 byte)
-
-    // Optional content:
-    //# Comments with spaces.\n (comment ending with \n)
-
     std::ifstream ifile(pgmPath, std::ios::in | std::ios::binary);
     if (!ifile.is_open())
     {
       return false;
     }
 
-    // Check file size
-    ifile.seekg (0, ifile.end);
-    long size = ifile.tellg();
-    ifile.seekg (0, ifile.beg);
-    if (size < 10)
-    {
-      return false;
-    }
-
-    // Read header
-    size_t width = 1, height = 1;
-    unsigned long maxVal = 255;
-    if (!readPnmFileHeader(ifile, "P5", width, height, maxVal))
-    {
-      return false;
-    }
-
-    // Check max value
-    if (maxVal > 255)
-    {
-      return false;
-    }
-
-    // Resize output image
-    image.resize(width, height);
-
-    // Pass last whitespace
-    ifile.seekg(1, ifile.cur);
-
-    // Read pixels
-    std::unique_ptr<unsigned char> pixel(new unsigned char);
-    for (size_t y = 0; y < height; y++)
-    {
-      for (size_t x = 0; x < width; x++)
-      {
-        ifile.read(reinterpret_cast<char*>(pixel.get()), 1);
-        image.pixel(x,y) = { *(pixel.get()) };
-      }
-    }
+    return readGrayscaleImageFromPgm(ifile, image);
+  }
 
-    return true;
+  /// Read 8-bit grayscale image from PGM data in memory (Portable Gray Map)
+  ///
+  /// Files with a maximum value above 255 (2 bytes per sample) are rejected.
+  /// Read those into an Image<unsigned short, 1> instead.
+  ///
+  /// The pixel data is read straight from the buffer without intermediate
+  /// copies.
+  ///
+  /// \param[in] data Pointer to PGM data
+  /// \param[in] size Size of PGM data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readGrayscaleImageFromPgm(const std::uint8_t *data, size_t size, Image<unsigned char, 1> &image)
+  {
+    MemoryInputBuffer streamBuffer(data, size);
+    std::istream ifile(&streamBuffer);
+    return readGrayscaleImageFromPgm(ifile, image);
   }
 
-  /// Read 24-bit RGB image from PPM file (Portable Pixel Map)
+  /// Read 8-bit grayscale image from PGM data in input stream (Portable Gray Map)
   ///
-  /// Beware! This file format also supports 48-bit RGB format (2 bytes per
-  /// channel). This is not implemented and function will return false in that
-  /// situation.
+  /// Files with a maximum value above 255 (2 bytes per sample) are rejected.
+  /// Read those into an Image<unsigned short, 1> instead.
   ///
-  /// \param[in] ppmPath Path to PPM file. Should have file extension *.ppm
+  /// \param[in] ifile Input stream
   /// \param[out] image Image
   /// \return True on success, false otherwise
-  static bool readRgbImageFromPpm(const std::string &ppmPath, Image<unsigned char, 3> &image)
+  static bool readGrayscaleImageFromPgm(std::istream &ifile, Image<unsigned char, 1> &image)
   {
     // Minimal file content:
-    //P6\n        (magic number + whitespace; 3 bytes)
+    //P5\n        (magic number + whitespace; 3 bytes)
     //1 1\n       (width height whitespaces; 4 bytes)
     //1\n         (max value + whitespace; 2 bytes)
-    //0x001122    (binary: red green, blue; 3 bytes)
+    //0x11        (binary: gray; 1 byte)
+
+    // ASCII variant: magic number P2, decimal values separated by whitespace.
 
     // Optional content:
     //# Comments with spaces.\n (comment ending with \n)
 
-    std::ifstream ifile(ppmPath, std::ios::in | std::ios::binary);
-    if (!ifile.is_open())
-    {
-      return false;
-    }
+    return readPnm(ifile, "P5", "P2", image);
+  }
 
-    // Check file size
-    ifile.seekg (0, ifile.end);
-    long size = ifile.tellg();
-    ifile.seekg (0, ifile.beg);
-    if (size < 12)
+  /// Read 16-bit grayscale image from PGM file (Portable Gray Map)
+  ///
+  /// Files with a maximum value up to 255 (1 byte per sample) are read as
+  /// well. Sample values are not scaled.
+  ///
+  /// \param[in] pgmPath Path to PGM file. Should have file extension *.pgm
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readGrayscaleImageFromPgm(const std::string &pgmPath, Image<unsigned short, 1> &image)
+  {
+    std::ifstream ifile(pgmPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
     {
       return false;
     }
 
-    // Read header
-    size_t width = 1, height = 1;
-    unsigned long maxVal = 255;
-    if (!readPnmFileHeader(ifile, "P6", width, height, maxVal))
-    {
-      return false;
-    }
+    return readGrayscaleImageFromPgm(ifile, image);
+  }
 
-    // Check max value
-    if (maxVal > 255)
-    {
-      return false;
+  /// Read 16-bit grayscale image from PGM data in memory (Portable Gray Map)
+  ///
+  /// Files with a maximum value up to 255 (1 byte per sample) are read as
+  /// well. Sample values are not scaled.
+  ///
+  /// \param[in] data Pointer to PGM data
+  /// \param[in] size Size of PGM data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readGrayscaleImageFromPgm(const std::uint8_t *data, size_t size, Image<unsigned short, 1> &image)
+  {
+    MemoryInputBuffer streamBuffer(data, size);
+    std::istream ifile(&streamBuffer);
+    return readGrayscaleImageFromPgm(ifile, image);
+  }
+
+  /// Read 16-bit grayscale image from PGM data in input stream (Portable Gray
+  /// Map)
+  ///
+  /// Files with a maximum value up to 255 (1 byte per sample) are read as
+  /// well. Sample values are not scaled.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readGrayscaleImageFromPgm(std::istream &ifile, Image<unsigned short, 1> &image)
+  {
+    return readPnm(ifile, "P5", "P2", image);
+  }
+
+  /// Read 24-bit RGB image from PPM file (Portable Pixel Map)
+  ///
+  /// Files with a maximum value above 255 (2 bytes per sample) are rejected.
+  /// Read those into an Image<unsigned short, 3> instead.
+  ///
+  /// \param[in] ppmPath Path to PPM file. Should have file extension *.ppm
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromPpm(const std::string &ppmPath, Image<unsigned char, 3> &image)
+  {
+    std::ifstream ifile(ppmPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
+    {
+      return false;
+    }
+
+    return readRgbImageFromPpm(ifile, image);
+  }
+
+  /// Read 24-bit RGB image from PPM data in memory (Portable Pixel Map)
+  ///
+  /// Files with a maximum value above 255 (2 bytes per sample) are rejected.
+  /// Read those into an Image<unsigned short, 3> instead.
+  ///
+  /// The pixel data is read straight from the buffer without intermediate
+  /// copies.
+  ///
+  /// \param[in] data Pointer to PPM data
+  /// \param[in] size Size of PPM data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromPpm(const std::uint8_t *data, size_t size, Image<unsigned char, 3> &image)
+  {
+    MemoryInputBuffer streamBuffer(data, size);
+    std::istream ifile(&streamBuffer);
+    return readRgbImageFromPpm(ifile, image);
+  }
+
+  /// Read 24-bit RGB image from PPM data in input stream (Portable Pixel Map)
+  ///
+  /// Files with a maximum value above 255 (2 bytes per sample) are rejected.
+  /// Read those into an Image<unsigned short, 3> instead.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromPpm(std::istream &ifile, Image<unsigned char, 3> &image)
+  {
+    // Minimal file content:
+    //P6\n        (magic number + whitespace; 3 bytes)
+    //1 1\n       (width height whitespaces; 4 bytes)
+    //1\n         (max value + whitespace; 2 bytes)
+    //0x001122    (binary: red green, blue; 3 bytes)
+
+    // ASCII variant: magic number P3, decimal values separated by whitespace.
+
+    // Optional content:
+    //# Comments with spaces.\n (comment ending with \n)
+
+    return readPnm(ifile, "P6", "P3", image);
+  }
+
+  /// Read 48-bit RGB image from PPM file (Portable Pixel Map)
+  ///
+  /// Files with a maximum value up to 255 (1 byte per sample) are read as
+  /// well. Sample values are not scaled.
+  ///
+  /// \param[in] ppmPath Path to PPM file. Should have file extension *.ppm
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromPpm(const std::string &ppmPath, Image<unsigned short, 3> &image)
+  {
+    std::ifstream ifile(ppmPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
+    {
+      return false;
+    }
+
+    return readRgbImageFromPpm(ifile, image);
+  }
+
+  /// Read 48-bit RGB image from PPM data in memory (Portable Pixel Map)
+  ///
+  /// Files with a maximum value up to 255 (1 byte per sample) are read as
+  /// well. Sample values are not scaled.
+  ///
+  /// \param[in] data Pointer to PPM data
+  /// \param[in] size Size of PPM data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromPpm(const std::uint8_t *data, size_t size, Image<unsigned short, 3> &image)
+  {
+    MemoryInputBuffer streamBuffer(data, size);
+    std::istream ifile(&streamBuffer);
+    return readRgbImageFromPpm(ifile, image);
+  }
+
+  /// Read 48-bit RGB image from PPM data in input stream (Portable Pixel Map)
+  ///
+  /// Files with a maximum value up to 255 (1 byte per sample) are read as
+  /// well. Sample values are not scaled.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromPpm(std::istream &ifile, Image<unsigned short, 3> &image)
+  {
+    return readPnm(ifile, "P6", "P3", image);
+  }
+
+  /// Read image from PAM file (Portable Arbitrary Map)
+  ///
+  /// The depth of the file must equal the channel count of the image; e.g.
+  /// Image<unsigned char, 4> for a file with tuple type RGB_ALPHA. Files with
+  /// a maximum value above 255 can only be read into an image with 16-bit
+  /// samples (unsigned short).
+  ///
+  /// \param[in] pamPath Path to PAM file. Should have file extension *.pam
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  static bool readImageFromPam(const std::string &pamPath, Image<T, N> &image)
+  {
+    std::ifstream ifile(pamPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
+    {
+      return false;
+    }
+
+    return readImageFromPam(ifile, image);
+  }
+
+  /// Read image from PAM data in memory (Portable Arbitrary Map)
+  ///
+  /// The depth of the file must equal the channel count of the image.
+  ///
+  /// \param[in] data Pointer to PAM data
+  /// \param[in] size Size of PAM data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  static bool readImageFromPam(const std::uint8_t *data, size_t size, Image<T, N> &image)
+  {
+    MemoryInputBuffer streamBuffer(data, size);
+    std::istream ifile(&streamBuffer);
+    return readImageFromPam(ifile, image);
+  }
+
+  /// Read image from PAM data in input stream (Portable Arbitrary Map)
+  ///
+  /// The depth of the file must equal the channel count of the image.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  static bool readImageFromPam(std::istream &ifile, Image<T, N> &image)
+  {
+    // Read header
+    size_t width = 1, height = 1, depth = 0;
+    unsigned long maxVal = 255;
+    std::string tupleType;
+    if (!readPamFileHeader(ifile, width, height, depth, maxVal, tupleType)
+        || depth != static_cast<size_t>(N))
+    {
+      return false;
+    }
+
+    return readPixels(ifile, width, height, maxVal, false, image);
+  }
+
+  /// Write 24-bit RGB image to file as QOI (Quite OK Image format)
+  ///
+  /// QOI is a lossless compressed format that encodes and decodes fast.
+  ///
+  /// \param[in] image Image
+  /// \param[in] qoiPath Path to QOI file. Should have file extension *.qoi
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsQoi(const Image<unsigned char, 3> &image, const std::string &qoiPath)
+  {
+    std::ofstream ofile(qoiPath, std::ios::out | std::ios::binary);
+    if (!ofile.is_open())
+    {
+      return false;
+    }
+
+    return writeRgbImageAsQoi(image, ofile);
+  }
+
+  /// Write 24-bit RGB image to memory buffer as QOI (Quite OK Image format)
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsQoi(const Image<unsigned char, 3> &image, std::vector<std::uint8_t> &buffer)
+  {
+    return encodeQoi(image, buffer);
+  }
+
+  /// Write 24-bit RGB image to output stream as QOI (Quite OK Image format)
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeRgbImageAsQoi(const Image<unsigned char, 3> &image, std::ostream &ofile)
+  {
+    std::vector<std::uint8_t> buffer;
+    if (!encodeQoi(image, buffer))
+    {
+      return false;
+    }
+
+    writeBytes(ofile, buffer.data(), buffer.size());
+    return ofile.good();
+  }
+
+  /// Write 32-bit RGBA image to file as QOI (Quite OK Image format)
+  ///
+  /// \param[in] image Image
+  /// \param[in] qoiPath Path to QOI file. Should have file extension *.qoi
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsQoi(const Image<unsigned char, 4> &image, const std::string &qoiPath)
+  {
+    std::ofstream ofile(qoiPath, std::ios::out | std::ios::binary);
+    if (!ofile.is_open())
+    {
+      return false;
+    }
+
+    return writeRgbaImageAsQoi(image, ofile);
+  }
+
+  /// Write 32-bit RGBA image to memory buffer as QOI (Quite OK Image format)
+  ///
+  /// The encoded image is appended to the buffer.
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsQoi(const Image<unsigned char, 4> &image, std::vector<std::uint8_t> &buffer)
+  {
+    return encodeQoi(image, buffer);
+  }
+
+  /// Write 32-bit RGBA image to output stream as QOI (Quite OK Image format)
+  ///
+  /// \param[in] image Image
+  /// \param[in] ofile Output stream
+  /// \return True on success, false otherwise
+  static bool writeRgbaImageAsQoi(const Image<unsigned char, 4> &image, std::ostream &ofile)
+  {
+    std::vector<std::uint8_t> buffer;
+    if (!encodeQoi(image, buffer))
+    {
+      return false;
+    }
+
+    writeBytes(ofile, buffer.data(), buffer.size());
+    return ofile.good();
+  }
+
+  /// Read 24-bit RGB image from QOI file (Quite OK Image format)
+  ///
+  /// The alpha channel of an RGBA file is omitted.
+  ///
+  /// \param[in] qoiPath Path to QOI file. Should have file extension *.qoi
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromQoi(const std::string &qoiPath, Image<unsigned char, 3> &image)
+  {
+    std::ifstream ifile(qoiPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
+    {
+      return false;
+    }
+
+    return readRgbImageFromQoi(ifile, image);
+  }
+
+  /// Read 24-bit RGB image from QOI data in memory (Quite OK Image format)
+  ///
+  /// The alpha channel of an RGBA file is omitted.
+  ///
+  /// \param[in] data Pointer to QOI data
+  /// \param[in] size Size of QOI data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromQoi(const std::uint8_t *data, size_t size, Image<unsigned char, 3> &image)
+  {
+    return decodeQoi(data, size, image);
+  }
+
+  /// Read 24-bit RGB image from QOI data in input stream (Quite OK Image
+  /// format)
+  ///
+  /// The alpha channel of an RGBA file is omitted.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbImageFromQoi(std::istream &ifile, Image<unsigned char, 3> &image)
+  {
+    std::vector<std::uint8_t> buffer;
+    return (readRemainingBytes(ifile, buffer) && decodeQoi(buffer.data(), buffer.size(), image));
+  }
+
+  /// Read 32-bit RGBA image from QOI file (Quite OK Image format)
+  ///
+  /// The alpha channel of an RGB file is set to 255 (fully opaque).
+  ///
+  /// \param[in] qoiPath Path to QOI file. Should have file extension *.qoi
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbaImageFromQoi(const std::string &qoiPath, Image<unsigned char, 4> &image)
+  {
+    std::ifstream ifile(qoiPath, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
+    {
+      return false;
+    }
+
+    return readRgbaImageFromQoi(ifile, image);
+  }
+
+  /// Read 32-bit RGBA image from QOI data in memory (Quite OK Image format)
+  ///
+  /// The alpha channel of an RGB file is set to 255 (fully opaque).
+  ///
+  /// \param[in] data Pointer to QOI data
+  /// \param[in] size Size of QOI data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbaImageFromQoi(const std::uint8_t *data, size_t size, Image<unsigned char, 4> &image)
+  {
+    return decodeQoi(data, size, image);
+  }
+
+  /// Read 32-bit RGBA image from QOI data in input stream (Quite OK Image
+  /// format)
+  ///
+  /// The alpha channel of an RGB file is set to 255 (fully opaque).
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  static bool readRgbaImageFromQoi(std::istream &ifile, Image<unsigned char, 4> &image)
+  {
+    std::vector<std::uint8_t> buffer;
+    return (readRemainingBytes(ifile, buffer) && decodeQoi(buffer.data(), buffer.size(), image));
+  }
+
+  /// Read image from TIFF or BigTIFF file (Tagged Image File Format)
+  ///
+  /// The first image of the file is read. The sample type and channel count
+  /// of the image must match the file; e.g. Image<unsigned short, 1> for a
+  /// 16-bit grayscale file and Image<float, 1> for a 32-bit floating point
+  /// file.
+  ///
+  /// \param[in] tiffPath Path to TIFF file. Should have file extension *.tif
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  static bool readImageFromTiff(const std::string &tiffPath, Image<T, N> &image)
+  {
+    TiffReader reader(tiffPath);
+    return reader.readImage(image);
+  }
+
+  /// Read header of a PNM file (PBM, PGM or PPM)
+  ///
+  /// On success the stream is positioned at the single whitespace character
+  /// that separates the header from the pixel data. For the ASCII variants
+  /// (P1, P2, P3) any amount of whitespace may follow.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[in] magicNumber Expected magic number
+  /// \param[out] width Image width
+  /// \param[out] height Image height
+  /// \param[out] maxVal Maximum pixel value (ignored for PBM images)
+  /// \return True on success, false otherwise
+  static bool readPnmFileHeader(std::istream &ifile, std::string magicNumber, size_t &width, size_t &height, unsigned long &maxVal)
+  {
+    // Read magic number
+    std::string line;
+    ifile >> line;
+    if (line != magicNumber)
+    {
+      return false;
+    }
+
+    return readPnmHeaderValues(ifile, magicNumber, width, height, maxVal);
+  }
+
+  /// Read header of a PAM file (Portable Arbitrary Map)
+  ///
+  /// On success the stream is positioned at the first byte of the pixel data.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] width Image width
+  /// \param[out] height Image height
+  /// \param[out] depth Channel count
+  /// \param[out] maxVal Maximum pixel value
+  /// \param[out] tupleType Tuple type (empty if not specified)
+  /// \return True on success, false otherwise
+  static bool readPamFileHeader(std::istream &ifile, size_t &width, size_t &height, size_t &depth, unsigned long &maxVal, std::string &tupleType)
+  {
+    // Minimal file content:
+    //P7\n
+    //WIDTH 1\n
+    //HEIGHT 1\n
+    //DEPTH 3\n
+    //MAXVAL 255\n
+    //ENDHDR\n
+    //0x001122    (binary: red green, blue; 3 bytes)
+
+    // Read magic number
+    std::string line;
+    std::getline(ifile, line);
+    if (line != "P7")
+    {
+      return false;
+    }
+
+    bool hasWidth = false, hasHeight = false, hasDepth = false, hasMaxVal = false;
+    tupleType.clear();
+
+    // Read header lines up to and including ENDHDR
+    while (std::getline(ifile, line))
+    {
+      // Skip empty lines and comments
+      if (line.empty() || line[0] == '#')
+      {
+        continue;
+      }
+
+      std::istringstream lineStream(line);
+      std::string key, value;
+      lineStream >> key >> value;
+
+      try
+      {
+        if (key == "ENDHDR")
+        {
+          return (hasWidth && hasHeight && hasDepth && hasMaxVal);
+        }
+        else if (key == "WIDTH")
+        {
+          width = std::stoul(value);
+          hasWidth = true;
+        }
+        else if (key == "HEIGHT")
+        {
+          height = std::stoul(value);
+          hasHeight = true;
+        }
+        else if (key == "DEPTH")
+        {
+          depth = std::stoul(value);
+          hasDepth = true;
+        }
+        else if (key == "MAXVAL")
+        {
+          maxVal = std::stoul(value);
+          hasMaxVal = true;
+        }
+        else if (key == "TUPLTYPE")
+        {
+          // Multiple TUPLTYPE lines are concatenated
+          tupleType += (tupleType.empty() ? "" : " ") + value;
+        }
+      }
+      catch (const std::exception &)
+      {
+        return false;
+      }
+    }
+
+    // No ENDHDR
+    return false;
+  }
+
+protected:
+  /// \class MemoryInputBuffer
+  /// \brief Stream buffer reading from a block of memory
+  ///
+  /// The memory is used in place; no data is copied until it is read.
+  class MemoryInputBuffer : public std::streambuf
+  {
+  public:
+    /// Constructor
+    ///
+    /// \param[in] data Pointer to data. Must remain valid during use.
+    /// \param[in] size Size of data in bytes
+    MemoryInputBuffer(const std::uint8_t *data, size_t size)
+    {
+      // The get area is never written to
+      char *begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+      setg(begin, begin, begin + size);
+    }
+
+  protected:
+    std::streampos seekoff(std::streamoff off, std::ios_base::seekdir dir,
+                           std::ios_base::openmode which = std::ios_base::in) override
+    {
+      std::streamoff position = off;
+      if (dir == std::ios_base::cur)
+      {
+        position += gptr() - eback();
+      }
+      else if (dir == std::ios_base::end)
+      {
+        position += egptr() - eback();
+      }
+      return seekpos(position, which);
+    }
+
+    std::streampos seekpos(std::streampos pos,
+                           std::ios_base::openmode which = std::ios_base::in) override
+    {
+      const std::streamoff position = pos;
+      if ((which & std::ios_base::in) == 0 || position < 0 || position > egptr() - eback())
+      {
+        return std::streampos(std::streamoff(-1));
+      }
+      setg(eback(), eback() + position, egptr());
+      return pos;
+    }
+  };
+
+  /// \class MemoryOutputBuffer
+  /// \brief Stream buffer appending to a byte vector
+  ///
+  /// Blocks of data are appended to the vector directly, without an
+  /// intermediate buffer.
+  class MemoryOutputBuffer : public std::streambuf
+  {
+  public:
+    /// Constructor
+    ///
+    /// \param[in,out] buffer Byte vector to append to
+    explicit MemoryOutputBuffer(std::vector<std::uint8_t> &buffer)
+      : m_buffer(buffer)
+    {
+    }
+
+  protected:
+    int_type overflow(int_type ch) override
+    {
+      if (!traits_type::eq_int_type(ch, traits_type::eof()))
+      {
+        m_buffer.push_back(static_cast<std::uint8_t>(traits_type::to_char_type(ch)));
+      }
+      return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize count) override
+    {
+      const std::uint8_t *bytes = reinterpret_cast<const std::uint8_t*>(s);
+      m_buffer.insert(m_buffer.end(), bytes, bytes + count);
+      return count;
+    }
+
+  private:
+    std::vector<std::uint8_t> &m_buffer;
+  };
+
+  /// Write header of a PNM file (PBM, PGM or PPM)
+  ///
+  /// The header is written with a single write call.
+  ///
+  /// \param[in] ofile Output stream
+  /// \param[in] magicNumber Magic number
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] maxVal Maximum pixel value (ignored for PBM images)
+  static void writePnmFileHeader(std::ostream &ofile, const std::string &magicNumber, size_t width, size_t height, unsigned long maxVal)
+  {
+    std::string header = magicNumber + "\n"
+                       + std::to_string(width) + "\n"
+                       + std::to_string(height) + "\n";
+    if (magicNumber != "P1" && magicNumber != "P4")
+    {
+      header += std::to_string(maxVal) + "\n";
+    }
+    ofile.write(header.c_str(), static_cast<std::streamsize>(header.length()));
+  }
+
+  /// Write header of a PAM file (Portable Arbitrary Map)
+  ///
+  /// The header is written with a single write call.
+  ///
+  /// \param[in] ofile Output stream
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] depth Channel count
+  /// \param[in] maxVal Maximum pixel value
+  /// \param[in] tupleType Tuple type
+  static void writePamFileHeader(std::ostream &ofile, size_t width, size_t height, size_t depth, unsigned long maxVal, const std::string &tupleType)
+  {
+    std::string header = "P7\n"
+                         "WIDTH " + std::to_string(width) + "\n"
+                         "HEIGHT " + std::to_string(height) + "\n"
+                         "DEPTH " + std::to_string(depth) + "\n"
+                         "MAXVAL " + std::to_string(maxVal) + "\n"
+                         "TUPLTYPE " + tupleType + "\n"
+                         "ENDHDR\n";
+    ofile.write(header.c_str(), static_cast<std::streamsize>(header.length()));
+  }
+
+  /// Pointer to the image data as bytes.
+  ///
+  /// The pixels of an 8-bit image are stored contiguously without padding,
+  /// so the image data can be transferred as a single block of bytes.
+  template<int N>
+  static unsigned char *imageBytes(const Image<unsigned char, N> &image)
+  {
+    static_assert(sizeof(std::array<unsigned char, N>) == N,
+                  "Pixel values must not be padded");
+    return reinterpret_cast<unsigned char*>(image.imageDataPtr());
+  }
+
+  /// Pointer to the image data as samples.
+  ///
+  /// The pixels are stored contiguously without padding, so the samples of
+  /// all pixels form a single array of width * height * N values.
+  template<typename T, int N>
+  static T *imageSamples(const Image<T, N> &image)
+  {
+    static_assert(sizeof(std::array<T, N>) == N * sizeof(T),
+                  "Pixel values must not be padded");
+    return reinterpret_cast<T*>(image.imageDataPtr());
+  }
+
+  /// Encode 16-bit samples as big-endian bytes (most significant byte first).
+  ///
+  /// \param[in] samples Samples
+  /// \param[in] count Number of samples
+  /// \param[out] bytes Encoded bytes; 2 * count bytes
+  static void encodeBigEndian(const unsigned short *samples, size_t count, unsigned char *bytes)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      bytes[2*i] = static_cast<unsigned char>(samples[i] >> 8);
+      bytes[2*i+1] = static_cast<unsigned char>(samples[i] & 0xFF);
+    }
+  }
+
+  /// Decode big-endian bytes (most significant byte first) to 16-bit samples.
+  ///
+  /// The samples may overlap the bytes exactly (in-place decoding).
+  ///
+  /// \param[in] bytes Encoded bytes; 2 * count bytes
+  /// \param[in] count Number of samples
+  /// \param[out] samples Samples
+  static void decodeBigEndian(const unsigned char *bytes, size_t count, unsigned short *samples)
+  {
+    size_t i = 0;
+
+#ifdef SPATIUMLIB_IMAGEIO_SSE2
+    // Swap the bytes of 8 samples at a time
+    for (; i + 8 <= count; i += 8)
+    {
+      const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + 2 * i));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i),
+                       _mm_or_si128(_mm_slli_epi16(values, 8), _mm_srli_epi16(values, 8)));
     }
+#endif
 
-    // Resize output image
-    image.resize(width, height);
+    for (; i < count; i++)
+    {
+      samples[i] = static_cast<unsigned short>(bytes[2*i] << 8 | bytes[2*i+1]);
+    }
+  }
 
-    // Pass last whitespace
-    ifile.seekg(1, ifile.cur);
+  /// Write a block of bytes.
+  ///
+  /// \param[in] ofile Output stream
+  /// \param[in] data Bytes to write
+  /// \param[in] count Number of bytes
+  static void writeBytes(std::ostream &ofile, const unsigned char *data, size_t count)
+  {
+    ofile.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count));
+  }
 
-    // Read pixels
-    std::unique_ptr<std::array<unsigned char, 3>> pixel(new std::array<unsigned char, 3>());
-    for (size_t y = 0; y < height; y++)
+  /// Read a block of bytes.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] data Destination of bytes
+  /// \param[in] count Number of bytes
+  /// \return True if all bytes have been read, false otherwise
+  static bool readBytes(std::istream &ifile, unsigned char *data, size_t count)
+  {
+    ifile.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count));
+    return (static_cast<size_t>(ifile.gcount()) == count);
+  }
+
+  /// Pack a row of binary pixels into bits as stored in a PBM file.
+  ///
+  /// Each byte holds 8 pixels, the first pixel in the most significant bit.
+  /// A bit is 1 for black (pixel value 0) and 0 for white (any other value).
+  /// The last byte is padded with zero bits.
+  ///
+  /// \param[in] pixels Pixel values
+  /// \param[in] width Number of pixels
+  /// \param[out] bits Packed bits; (width + 7) / 8 bytes
+  static void packBinaryRow(const unsigned char *pixels, size_t width, unsigned char *bits)
+  {
+    size_t x = 0;
+
+#ifdef SPATIUMLIB_IMAGEIO_SSE2
+    // Pack 16 pixels at a time: compare with zero and gather the sign bits.
+    // The gathered bits are in reverse order (first pixel in bit 0).
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= width; x += 16)
     {
-      for (size_t x = 0; x < width; x++)
+      const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+      const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(values, zero));
+      bits[x / 8] = reverseBits(static_cast<unsigned char>(mask & 0xFF));
+      bits[x / 8 + 1] = reverseBits(static_cast<unsigned char>((mask >> 8) & 0xFF));
+    }
+#endif
+
+    // Pack 8 pixels at a time
+    for (; x + 8 <= width; x += 8)
+    {
+      const unsigned char *p = pixels + x;
+      bits[x / 8] = static_cast<unsigned char>((p[0] == 0) << 7 | (p[1] == 0) << 6 |
+                                               (p[2] == 0) << 5 | (p[3] == 0) << 4 |
+                                               (p[4] == 0) << 3 | (p[5] == 0) << 2 |
+                                               (p[6] == 0) << 1 | (p[7] == 0));
+    }
+
+    // Pack remaining pixels
+    if (x < width)
+    {
+      unsigned char val = 0x00;
+      for (unsigned char i = 0; x + i < width; i++)
       {
-        ifile.read(reinterpret_cast<char*>(pixel->data()), 3);// pixel.get(), 3);
-        image.pixel(x,y) = *(pixel.get());
+        val |= static_cast<unsigned char>((pixels[x + i] == 0) << (7 - i));
       }
+      bits[x / 8] = val;
+    }
+  }
+
+  /// Unpack a row of bits as stored in a PBM file into binary pixels.
+  ///
+  /// A 1 bit (black) becomes pixel value 0, a 0 bit (white) becomes 255.
+  ///
+  /// \param[in] bits Packed bits; (width + 7) / 8 bytes
+  /// \param[in] width Number of pixels
+  /// \param[out] pixels Pixel values
+  static void unpackBinaryRow(const unsigned char *bits, size_t width, unsigned char *pixels)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      const unsigned char bit = (bits[x / 8] >> (7 - (x % 8))) & 0x01;
+      pixels[x] = static_cast<unsigned char>(bit - 1); // 1 -> 0, 0 -> 255
     }
+  }
 
-    return true;
+  /// Reverse the order of bits in a byte.
+  static unsigned char reverseBits(unsigned char b)
+  {
+    b = static_cast<unsigned char>((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+    b = static_cast<unsigned char>((b & 0xCC) >> 2 | (b & 0x33) << 2);
+    b = static_cast<unsigned char>((b & 0xAA) >> 1 | (b & 0x55) << 1);
+    return b;
   }
 
-protected:
-  /// Read header of a PNM file (PBM, PGM or PPM)
+  /// Read all remaining bytes of a stream.
   ///
-  /// \param[in] ifile Input file stream
-  /// \param[in] magicNumber Expected magic number
-  /// \param[out] width Image width
-  /// \param[out] height Image height
-  /// \param[out] maxVal Maximum pixel value (ignored for PBM images)
+  /// The stream is read sequentially up to its end; it need not be seekable.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[out] buffer Bytes read
   /// \return True on success, false otherwise
-  static bool readPnmFileHeader(std::ifstream &ifile, std::string magicNumber, size_t &width, size_t &height, unsigned long &maxVal)
+  static bool readRemainingBytes(std::istream &ifile, std::vector<std::uint8_t> &buffer)
   {
-    // Read magic number
-    std::string line;
-    ifile >> line;
-    if (line != magicNumber)
+    // Read in blocks of growing size
+    size_t size = 0;
+    buffer.resize(65536);
+    while (ifile.read(reinterpret_cast<char*>(buffer.data() + size), static_cast<std::streamsize>(buffer.size() - size)))
+    {
+      size = buffer.size();
+      buffer.resize(2 * size);
+    }
+    size += static_cast<size_t>(ifile.gcount());
+    buffer.resize(size);
+
+    // Reading stops at the end of the stream, not on an error
+    if (ifile.bad() || !ifile.eof())
     {
       return false;
     }
+    ifile.clear(std::ios::eofbit);
+    return true;
+  }
 
+  /// Read the values of a PNM header that follow the magic number.
+  ///
+  /// \param[in] ifile Input stream, positioned after the magic number
+  /// \param[in] magicNumber Magic number that has been read
+  /// \param[out] width Image width
+  /// \param[out] height Image height
+  /// \param[out] maxVal Maximum pixel value (ignored for PBM images)
+  /// \return True on success, false otherwise
+  static bool readPnmHeaderValues(std::istream &ifile, const std::string &magicNumber, size_t &width, size_t &height, unsigned long &maxVal)
+  {
     // Read next token and skip any comments
+    std::string line;
     ifile >> line;
     while (line.find("#") == 0)
     {
@@ -647,7 +1503,7 @@ protected:
       return false;
     }
 
-    if (magicNumber == "P4")
+    if (magicNumber == "P1" || magicNumber == "P4")
     {
       // Binaryt image header has no max value
       maxVal = 1;
@@ -676,9 +1532,487 @@ protected:
     return true;
   }
 
+  /// Check that an image size read from a header can be allocated.
+  ///
+  /// Images are limited to 400 million pixels, as the QOI specification
+  /// recommends, so that a corrupt header neither overflows the image size
+  /// nor allocates a huge image.
+  ///
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \return True if the image has at most 400 million pixels
+  static bool isValidImageSize(size_t width, size_t height)
+  {
+    const size_t maxPixelCount = 400000000;
+    return (width == 0 || height <= maxPixelCount / width);
+  }
+
+  /// Read a PGM or PPM image; binary or ASCII, 8-bit or 16-bit.
+  ///
+  /// \param[in] ifile Input stream
+  /// \param[in] binaryMagicNumber Magic number of the binary variant
+  /// \param[in] asciiMagicNumber Magic number of the ASCII variant
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  static bool readPnm(std::istream &ifile, const std::string &binaryMagicNumber, const std::string &asciiMagicNumber, Image<T, N> &image)
+  {
+    // Read header. The magic number determines the variant.
+    std::string magicNumber;
+    ifile >> magicNumber;
+    const bool ascii = (magicNumber == asciiMagicNumber);
+    size_t width = 1, height = 1;
+    unsigned long maxVal = 255;
+    if ((!ascii && magicNumber != binaryMagicNumber)
+        || !readPnmHeaderValues(ifile, magicNumber, width, height, maxVal))
+    {
+      return false;
+    }
+
+    // Pass last whitespace
+    if (!ascii)
+    {
+      ifile.get();
+    }
+
+    return readPixels(ifile, width, height, maxVal, ascii, image);
+  }
+
+  /// Read the pixels of a PGM, PPM or PAM image.
+  ///
+  /// Binary samples take 1 byte if the maximum value is below 256, 2 bytes
+  /// (big-endian) otherwise. The image is resized.
+  ///
+  /// \param[in] ifile Input stream, positioned at the pixel data
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] maxVal Maximum pixel value
+  /// \param[in] ascii Samples are stored as decimal text
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  static bool readPixels(std::istream &ifile, size_t width, size_t height, unsigned long maxVal, bool ascii, Image<T, N> &image)
+  {
+    static_assert(std::is_same<T, unsigned char>::value || std::is_same<T, unsigned short>::value,
+                  "Only 8-bit and 16-bit samples are supported");
+
+    // Check max value. 8-bit samples cannot hold values above 255.
+    if (maxVal == 0 || maxVal > 65535 || (sizeof(T) == 1 && maxVal > 255)
+        || !isValidImageSize(width, height))
+    {
+      return false;
+    }
+
+    // Resize output image
+    image.resize(width, height);
+    T *samples = imageSamples(image);
+    const size_t count = width * height * N;
+
+    if (ascii)
+    {
+      std::vector<std::uint8_t> text;
+      return (readRemainingBytes(ifile, text)
+              && parseAsciiSamples(text.data(), text.data() + text.size(), maxVal, samples, count));
+    }
+
+    // Read all samples at once into the image data, then convert in place
+    unsigned char *bytes = reinterpret_cast<unsigned char*>(samples);
+    if (maxVal > 255)
+    {
+      if (!readBytes(ifile, bytes, count * 2))
+      {
+        return false;
+      }
+      decodeBigEndian(bytes, count, reinterpret_cast<unsigned short*>(samples));
+    }
+    else
+    {
+      if (!readBytes(ifile, bytes, count))
+      {
+        return false;
+      }
+
+      // Widen 8-bit samples; back to front so no byte is overwritten before
+      // it has been read.
+      if (sizeof(T) > 1)
+      {
+        for (size_t i = count; i-- > 0; )
+        {
+          samples[i] = bytes[i];
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /// Skip whitespace and comments in ASCII pixel data.
+  ///
+  /// \param[in] pos Current position
+  /// \param[in] end End of data
+  /// \return Position of the next other character, or end
+  static const std::uint8_t *skipWhitespace(const std::uint8_t *pos, const std::uint8_t *end)
+  {
+    while (pos != end)
+    {
+      if (*pos == '#')
+      {
+        // Comment runs to the end of the line
+        while (pos != end && *pos != '\n')
+        {
+          pos++;
+        }
+      }
+      else if (*pos == ' ' || (*pos >= '\t' && *pos <= '\r'))
+      {
+        pos++;
+      }
+      else
+      {
+        break;
+      }
+    }
+    return pos;
+  }
+
+  /// Parse decimal samples of an ASCII PGM or PPM file (P2, P3).
+  ///
+  /// \param[in] pos Start of text
+  /// \param[in] end End of text
+  /// \param[in] maxVal Maximum pixel value
+  /// \param[out] samples Samples
+  /// \param[in] count Number of samples to parse
+  /// \return True on success, false if the text is malformed, too short or
+  /// holds a value above the maximum value
+  template<typename T>
+  static bool parseAsciiSamples(const std::uint8_t *pos, const std::uint8_t *end, unsigned long maxVal, T *samples, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      pos = skipWhitespace(pos, end);
+      if (pos == end || static_cast<unsigned char>(*pos - '0') > 9)
+      {
+        return false;
+      }
+
+      unsigned long value = 0;
+      do
+      {
+        value = value * 10 + static_cast<unsigned long>(*pos++ - '0');
+        if (value > maxVal)
+        {
+          return false;
+        }
+      }
+      while (pos != end && static_cast<unsigned char>(*pos - '0') <= 9);
+
+      samples[i] = static_cast<T>(value);
+    }
+
+    return true;
+  }
+
+  /// Parse the digits of an ASCII PBM file (P1) into binary pixels.
+  ///
+  /// A 1 (black) becomes pixel value 0, a 0 (white) becomes 255.
+  ///
+  /// \param[in] pos Start of text
+  /// \param[in] end End of text
+  /// \param[out] pixels Pixel values
+  /// \param[in] count Number of pixels to parse
+  /// \return True on success, false if the text is malformed or too short
+  static bool parseAsciiBits(const std::uint8_t *pos, const std::uint8_t *end, unsigned char *pixels, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      pos = skipWhitespace(pos, end);
+      if (pos == end || (*pos != '0' && *pos != '1'))
+      {
+        return false;
+      }
+      pixels[i] = static_cast<unsigned char>(*pos++ - '1'); // 1 -> 0, 0 -> 255
+    }
+
+    return true;
+  }
+
+  /// Hash of an RGBA value into the QOI index of 64 previously seen values.
+  static unsigned int qoiHash(const std::array<unsigned char, 4> &px)
+  {
+    return (px[0] * 3u + px[1] * 5u + px[2] * 7u + px[3] * 11u) % 64u;
+  }
+
+  /// Encode an RGB or RGBA image as QOI.
+  ///
+  /// Specification: https://qoiformat.org/qoi-specification.pdf
+  ///
+  /// \param[in] image Image
+  /// \param[in,out] buffer Output buffer. Encoded data is appended.
+  /// \return True on success, false otherwise
+  template<int N>
+  static bool encodeQoi(const Image<unsigned char, N> &image, std::vector<std::uint8_t> &buffer)
+  {
+    static_assert(N == 3 || N == 4, "QOI supports 3 or 4 channels");
+
+    const size_t width = image.width();
+    const size_t height = image.height();
+    if (width > 0xFFFFFFFFu || height > 0xFFFFFFFFu)
+    {
+      return false;
+    }
+
+    // Reserve worst case size: header, 1 tag byte per pixel, end marker
+    const size_t pixelCount = width * height;
+    const size_t offset = buffer.size();
+    buffer.resize(offset + 14 + pixelCount * (N + 1) + 8);
+    std::uint8_t *out = buffer.data() + offset;
+
+    // Write header
+    const std::uint8_t header[14] = {
+      'q', 'o', 'i', 'f',
+      static_cast<std::uint8_t>(width >> 24), static_cast<std::uint8_t>(width >> 16),
+      static_cast<std::uint8_t>(width >> 8), static_cast<std::uint8_t>(width),
+      static_cast<std::uint8_t>(height >> 24), static_cast<std::uint8_t>(height >> 16),
+      static_cast<std::uint8_t>(height >> 8), static_cast<std::uint8_t>(height),
+      static_cast<std::uint8_t>(N), 0 };
+    std::memcpy(out, header, 14);
+    size_t pos = 14;
+
+    // Encode pixels
+    std::array<std::array<unsigned char, 4>, 64> index = {};
+    std::array<unsigned char, 4> prev = {{ 0, 0, 0, 255 }};
+    std::array<unsigned char, 4> px = prev;
+    const unsigned char *data = imageBytes(image);
+    unsigned int run = 0;
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+      const unsigned char *p = data + i * N;
+      px[0] = p[0];
+      px[1] = p[1];
+      px[2] = p[2];
+      if (N == 4)
+      {
+        px[3] = p[N-1];
+      }
+
+      if (px == prev)
+      {
+        // QOI_OP_RUN: up to 62 repetitions of the previous pixel
+        run++;
+        if (run == 62 || i + 1 == pixelCount)
+        {
+          out[pos++] = static_cast<std::uint8_t>(0xC0 | (run - 1));
+          run = 0;
+        }
+        continue;
+      }
+
+      if (run > 0)
+      {
+        out[pos++] = static_cast<std::uint8_t>(0xC0 | (run - 1));
+        run = 0;
+      }
+
+      const unsigned int hash = qoiHash(px);
+      if (index[hash] == px)
+      {
+        // QOI_OP_INDEX: previously seen pixel
+        out[pos++] = static_cast<std::uint8_t>(hash);
+      }
+      else
+      {
+        index[hash] = px;
+
+        if (px[3] == prev[3])
+        {
+          const signed char dr = static_cast<signed char>(px[0] - prev[0]);
+          const signed char dg = static_cast<signed char>(px[1] - prev[1]);
+          const signed char db = static_cast<signed char>(px[2] - prev[2]);
+          const signed char dr_dg = static_cast<signed char>(dr - dg);
+          const signed char db_dg = static_cast<signed char>(db - dg);
+
+          if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+          {
+            // QOI_OP_DIFF: small difference to previous pixel
+            out[pos++] = static_cast<std::uint8_t>(0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+          }
+          else if (dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7)
+          {
+            // QOI_OP_LUMA: difference to previous pixel relative to green
+            out[pos++] = static_cast<std::uint8_t>(0x80 | (dg + 32));
+            out[pos++] = static_cast<std::uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+          }
+          else
+          {
+            // QOI_OP_RGB
+            out[pos++] = 0xFE;
+            out[pos++] = px[0];
+            out[pos++] = px[1];
+            out[pos++] = px[2];
+          }
+        }
+        else
+        {
+          // QOI_OP_RGBA
+          out[pos++] = 0xFF;
+          out[pos++] = px[0];
+          out[pos++] = px[1];
+          out[pos++] = px[2];
+          out[pos++] = px[3];
+        }
+      }
+
+      prev = px;
+    }
+
+    // Write end marker
+    const std::uint8_t endMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    std::memcpy(out + pos, endMarker, 8);
+    pos += 8;
+
+    buffer.resize(offset + pos);
+    return true;
+  }
+
+  /// Decode a QOI image into an RGB or RGBA image.
+  ///
+  /// Specification: https://qoiformat.org/qoi-specification.pdf
+  ///
+  /// \param[in] data Pointer to QOI data
+  /// \param[in] size Size of QOI data in bytes
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<int N>
+  static bool decodeQoi(const std::uint8_t *data, size_t size, Image<unsigned char, N> &image)
+  {
+    static_assert(N == 3 || N == 4, "QOI supports 3 or 4 channels");
+
+    // Header (14 bytes) and end marker (8 bytes)
+    if (size < 14 + 8 || std::memcmp(data, "qoif", 4) != 0)
+    {
+      return false;
+    }
+
+    const size_t width = static_cast<size_t>(data[4]) << 24 | static_cast<size_t>(data[5]) << 16 |
+                         static_cast<size_t>(data[6]) << 8 | static_cast<size_t>(data[7]);
+    const size_t height = static_cast<size_t>(data[8]) << 24 | static_cast<size_t>(data[9]) << 16 |
+                          static_cast<size_t>(data[10]) << 8 | static_cast<size_t>(data[11]);
+    const unsigned char channels = data[12];
+    const unsigned char colorspace = data[13];
+    if (width == 0 || height == 0 || (channels != 3 && channels != 4) || colorspace > 1)
+    {
+      return false;
+    }
+
+    // Limit the pixel count, and to 62 pixels (the longest run) per byte of
+    // data, so that a corrupt header does not allocate a huge image
+    if (!isValidImageSize(width, height) || (width * height + 61) / 62 > size - 14 - 8)
+    {
+      return false;
+    }
+
+    image.resize(width, height);
+
+    // Decode pixels
+    std::array<std::array<unsigned char, 4>, 64> index = {};
+    std::array<unsigned char, 4> px = {{ 0, 0, 0, 255 }};
+    unsigned char *out = imageBytes(image);
+    const size_t pixelCount = width * height;
+    const size_t end = size - 8;
+    size_t pos = 14;
+    unsigned int run = 0;
+    for (size_t i = 0; i < pixelCount; i++)
+    {
+      if (run > 0)
+      {
+        run--;
+      }
+      else
+      {
+        if (pos >= end)
+        {
+          return false;
+        }
+
+        const std::uint8_t b1 = data[pos++];
+        if (b1 == 0xFE)
+        {
+          // QOI_OP_RGB
+          if (pos + 3 > end)
+          {
+            return false;
+          }
+          px[0] = data[pos++];
+          px[1] = data[pos++];
+          px[2] = data[pos++];
+        }
+        else if (b1 == 0xFF)
+        {
+          // QOI_OP_RGBA
+          if (pos + 4 > end)
+          {
+            return false;
+          }
+          px[0] = data[pos++];
+          px[1] = data[pos++];
+          px[2] = data[pos++];
+          px[3] = data[pos++];
+        }
+        else if ((b1 & 0xC0) == 0x00)
+        {
+          // QOI_OP_INDEX
+          px = index[b1];
+        }
+        else if ((b1 & 0xC0) == 0x40)
+        {
+          // QOI_OP_DIFF
+          px[0] = static_cast<unsigned char>(px[0] + ((b1 >> 4) & 0x03) - 2);
+          px[1] = static_cast<unsigned char>(px[1] + ((b1 >> 2) & 0x03) - 2);
+          px[2] = static_cast<unsigned char>(px[2] + (b1 & 0x03) - 2);
+        }
+        else if ((b1 & 0xC0) == 0x80)
+        {
+          // QOI_OP_LUMA
+          if (pos >= end)
+          {
+            return false;
+          }
+          const std::uint8_t b2 = data[pos++];
+          const int dg = (b1 & 0x3F) - 32;
+          px[0] = static_cast<unsigned char>(px[0] + dg - 8 + ((b2 >> 4) & 0x0F));
+          px[1] = static_cast<unsigned char>(px[1] + dg);
+          px[2] = static_cast<unsigned char>(px[2] + dg - 8 + (b2 & 0x0F));
+        }
+        else
+        {
+          // QOI_OP_RUN
+          run = b1 & 0x3F;
+        }
+
+        index[qoiHash(px)] = px;
+      }
+
+      unsigned char *p = out + i * N;
+      p[0] = px[0];
+      p[1] = px[1];
+      p[2] = px[2];
+      if (N == 4)
+      {
+        p[N-1] = px[3];
+      }
+    }
+
+    return true;
+  }
+
 private:
   // Disable object instantiation
   ImageIO() = delete;
+
+  // Scanline readers and writers share the header and pixel conversion
+  // functions.
+  template<typename T, int N> friend class PnmScanlineReader;
+  template<typename T, int N> friend class PnmScanlineWriter;
 };
 
 } // namespace spatium
@@ -0,0 +1,228 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMAGEPOOL_H
+#define SPATIUMLIB_IMAGEPOOL_H
+
+#include "Image.h"
+
+#include <memory> // std::unique_ptr
+#include <mutex> // std::mutex, std::lock_guard
+#include <utility> // std::move
+#include <vector> // std::vector
+
+namespace spatium {
+
+/// \class ImagePool
+/// \brief Pool of reusable images
+///
+/// An image pool hands out leases on images of a requested size. When a
+/// lease is destroyed the image is returned to the pool and handed out again
+/// by a later request for the same size. Processing a stream of equally
+/// sized frames therefore only allocates image memory for the first frame.
+///
+/// The pixel values of a reused image are those left by its previous user;
+/// they are not cleared. Newly allocated images are cleared.
+///
+/// The pool must outlive its leases. Leases may be acquired and released from
+/// multiple threads.
+///
+/// Example:
+/// \code
+/// ImagePool<unsigned char, 1> pool;
+/// for (...) // Every frame
+/// {
+///   ImagePool<unsigned char, 1>::Lease gray = pool.acquire(width, height);
+///   grayscaleFilter.apply(frame, *gray);
+/// } // Image returns to pool
+/// \endcode
+template<typename T = unsigned char, int N = 3>
+class ImagePool
+{
+public:
+  /// \class Lease
+  /// \brief Exclusive use of an image of the pool
+  ///
+  /// The image is returned to the pool when the lease is destroyed or
+  /// released. A lease can be moved, not copied.
+  class Lease
+  {
+  public:
+    /// Constructor. Empty lease.
+    Lease()
+      : m_pool(nullptr)
+    {
+    }
+
+    /// Move constructor
+    Lease(Lease &&other)
+      : m_pool(other.m_pool)
+      , m_image(std::move(other.m_image))
+    {
+      other.m_pool = nullptr;
+    }
+
+    /// Move assignment operator. Releases the current image.
+    Lease &operator=(Lease &&other)
+    {
+      if (&other != this)
+      {
+        release();
+        m_pool = other.m_pool;
+        m_image = std::move(other.m_image);
+        other.m_pool = nullptr;
+      }
+      return *this;
+    }
+
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    /// Destructor. Returns the image to the pool.
+    ~Lease()
+    {
+      release();
+    }
+
+    /// Return the image to the pool. The lease becomes empty.
+    void release()
+    {
+      if (m_pool != nullptr && m_image)
+      {
+        m_pool->recycle(std::move(m_image));
+      }
+      m_pool = nullptr;
+      m_image.reset();
+    }
+
+    /// Check if the lease holds an image.
+    explicit operator bool() const
+    {
+      return static_cast<bool>(m_image);
+    }
+
+    /// Leased image
+    Image<T, N> &operator*() const
+    {
+      return *m_image;
+    }
+
+    /// Leased image
+    Image<T, N> *operator->() const
+    {
+      return m_image.get();
+    }
+
+    /// Leased image
+    Image<T, N> *get() const
+    {
+      return m_image.get();
+    }
+
+  private:
+    friend class ImagePool;
+
+    /// Constructor
+    Lease(ImagePool *pool, std::unique_ptr<Image<T, N>> image)
+      : m_pool(pool)
+      , m_image(std::move(image))
+    {
+    }
+
+    /// Pool to return the image to
+    ImagePool *m_pool;
+
+    /// Leased image
+    std::unique_ptr<Image<T, N>> m_image;
+  };
+
+  /// Constructor
+  ImagePool()
+    : m_allocationCount(0)
+  {
+  }
+
+  ImagePool(const ImagePool &) = delete;
+  ImagePool &operator=(const ImagePool &) = delete;
+
+  /// Acquire an image of a given size.
+  ///
+  /// An idle image of the same size is reused if available, otherwise a new
+  /// image is allocated.
+  ///
+  /// \param[in] width Image width in pixels
+  /// \param[in] height Image height in pixels
+  /// \return Lease on image
+  /// \throw std::bad_alloc on bad allocation
+  Lease acquire(size_t width, size_t height)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (size_t i = 0; i < m_idle.size(); i++)
+      {
+        if (m_idle[i]->width() == width && m_idle[i]->height() == height)
+        {
+          // Move last idle image into the gap
+          std::unique_ptr<Image<T, N>> image(std::move(m_idle[i]));
+          m_idle[i] = std::move(m_idle.back());
+          m_idle.pop_back();
+          return Lease(this, std::move(image));
+        }
+      }
+      m_allocationCount++;
+    }
+
+    return Lease(this, std::unique_ptr<Image<T, N>>(new Image<T, N>(width, height)));
+  }
+
+  /// Number of idle images in the pool.
+  size_t idleCount() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_idle.size();
+  }
+
+  /// Number of images allocated by the pool since construction.
+  size_t allocationCount() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_allocationCount;
+  }
+
+  /// Free all idle images.
+  void clear()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.clear();
+  }
+
+protected:
+  /// Return an image to the pool.
+  void recycle(std::unique_ptr<Image<T, N>> image)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(std::move(image));
+  }
+
+  /// Idle images
+  std::vector<std::unique_ptr<Image<T, N>>> m_idle;
+
+  /// Number of images allocated
+  size_t m_allocationCount;
+
+  /// Guards the members above
+  mutable std::mutex m_mutex;
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMAGEPOOL_H
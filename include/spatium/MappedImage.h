@@ -0,0 +1,470 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_MAPPEDIMAGE_H
+#define SPATIUMLIB_MAPPEDIMAGE_H
+
+#include "Image.h"
+#include "ImageIO.h"
+
+#include <cstring> // std::memcpy
+#include <fstream> // std::ifstream
+#include <limits> // std::numeric_limits
+#include <string> // std::string
+#include <type_traits> // std::is_same
+#include <utility> // std::swap
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h> // CreateFileMapping, MapViewOfFile
+#else
+#include <fcntl.h> // open
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h> // close
+#endif
+
+namespace spatium {
+
+/// \class MappedImage
+/// \brief Image backed by a memory mapped PNM or PAM file
+///
+/// The pixel data of binary PGM (P5), PPM (P6) and PAM (P7) files with 8-bit
+/// samples is stored in the same layout as the pixel data of an Image. A
+/// MappedImage maps such a file into memory instead of reading it. Opening
+/// a file is therefore independent of its size; pages are loaded from disk
+/// by the operating system on first access.
+///
+/// The following files can be opened:
+///
+/// - MappedImage<unsigned char, 1>: PGM (P5) or PAM (P7) with depth 1.
+/// - MappedImage<unsigned char, 3>: PPM (P6) or PAM (P7) with depth 3.
+/// - MappedImage<unsigned char, 4>: PAM (P7) with depth 4.
+///
+/// In mode ReadOnly the pixel data cannot be modified. In mode CopyOnWrite
+/// the pixel data can be modified. Modified pages are private to this object
+/// and are never written back to the file.
+template<typename T = unsigned char, int N = 3>
+class MappedImage
+{
+  static_assert(std::is_same<T, unsigned char>::value,
+                "MappedImage only supports 8-bit samples");
+
+public:
+  /// Access mode of the mapped pixel data
+  enum class Mode
+  {
+    ReadOnly,   ///< Pixel data is read-only
+    CopyOnWrite ///< Pixel data is writable; changes are not saved to file
+  };
+
+  /// Constructor
+  MappedImage()
+    : m_width(0)
+    , m_height(0)
+    , m_mode(Mode::ReadOnly)
+    , m_mapping(nullptr)
+    , m_mappingSize(0)
+    , m_imageData(nullptr)
+#ifdef _WIN32
+    , m_fileHandle(INVALID_HANDLE_VALUE)
+    , m_mappingHandle(nullptr)
+#endif
+  {
+  }
+
+  /// Constructor. Opens a file.
+  ///
+  /// Use isOpen() to check whether the file has been opened successfully.
+  ///
+  /// \param[in] path Path to PGM, PPM or PAM file
+  /// \param[in] mode Access mode (default = ReadOnly)
+  MappedImage(const std::string &path, Mode mode = Mode::ReadOnly)
+    : MappedImage()
+  {
+    open(path, mode);
+  }
+
+  // No copy constructor; a mapping has a single owner
+  MappedImage(const MappedImage &other) = delete;
+
+  // No copy assignment operator; a mapping has a single owner
+  MappedImage& operator=(const MappedImage &other) = delete;
+
+  /// Move constructor
+  MappedImage(MappedImage &&other)
+    : MappedImage()
+  {
+    swap(other);
+  }
+
+  /// Move assignment operator
+  MappedImage& operator=(MappedImage &&other)
+  {
+    if (&other != this)
+    {
+      close();
+      swap(other);
+    }
+    return *this;
+  }
+
+  /// Destructor. Unmaps the file.
+  ~MappedImage()
+  {
+    close();
+  }
+
+  /// Open and map a file.
+  ///
+  /// A previously opened file is closed first.
+  ///
+  /// \param[in] path Path to PGM, PPM or PAM file
+  /// \param[in] mode Access mode (default = ReadOnly)
+  /// \return True on success, false otherwise
+  bool open(const std::string &path, Mode mode = Mode::ReadOnly)
+  {
+    close();
+
+    // Parse header to find dimensions and offset of pixel data
+    size_t width = 0, height = 0, dataOffset = 0;
+    if (!readHeader(path, width, height, dataOffset))
+    {
+      return false;
+    }
+
+    // Reject dimensions of which the data size overflows
+    if (width != 0 && height > std::numeric_limits<size_t>::max() / N / width)
+    {
+      return false;
+    }
+    const size_t dataSize = width * height * N;
+    if (dataOffset > std::numeric_limits<size_t>::max() - dataSize)
+    {
+      return false;
+    }
+
+    if (!mapFile(path, mode, dataOffset + dataSize))
+    {
+      return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_mode = mode;
+    m_imageData = reinterpret_cast<std::array<T, N>*>(static_cast<unsigned char*>(m_mapping) + dataOffset);
+    return true;
+  }
+
+  /// Unmap the file. Does nothing if no file is open.
+  void close()
+  {
+#ifdef _WIN32
+    if (m_mapping != nullptr)
+    {
+      UnmapViewOfFile(m_mapping);
+    }
+    if (m_mappingHandle != nullptr)
+    {
+      CloseHandle(m_mappingHandle);
+    }
+    if (m_fileHandle != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle(m_fileHandle);
+    }
+    m_mappingHandle = nullptr;
+    m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (m_mapping != nullptr)
+    {
+      munmap(m_mapping, m_mappingSize);
+    }
+#endif
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_imageData = nullptr;
+    m_width = 0;
+    m_height = 0;
+  }
+
+  /// Check if a file is open.
+  bool isOpen() const
+  {
+    return (m_imageData != nullptr);
+  }
+
+  /// Check if the pixel data is writable (mode CopyOnWrite).
+  bool isWritable() const
+  {
+    return (isOpen() && m_mode == Mode::CopyOnWrite);
+  }
+
+  /// Image width in pixels.
+  size_t width() const
+  {
+    return m_width;
+  }
+
+  /// Image height in pixels.
+  size_t height() const
+  {
+    return m_height;
+  }
+
+  /// Channel count of pixel values.
+  size_t channelCount() const
+  {
+    return N;
+  }
+
+  /// Pointer to read-only image data.
+  const std::array<T, N> *imageDataPtr() const
+  {
+    return m_imageData;
+  }
+
+  /// Pointer to writable image data.
+  ///
+  /// \return Pointer to image data, nullptr if not writable
+  std::array<T, N> *writableImageDataPtr()
+  {
+    return (isWritable() ? m_imageData : nullptr);
+  }
+
+  /// Access pixel by value.
+  ///
+  /// \param[in] x X coordinate
+  /// \param[in] y Y coordinate
+  /// \param[in] checkBounds Check bounds (default = true). If the coordinates
+  /// are out of bounds they are clamped.
+  /// \return Pixel value
+  std::array<T, N> pixel(size_t x, size_t y, bool checkBounds = true) const
+  {
+    if (checkBounds)
+    {
+      // Clamp coordinates
+      x = (x >= m_width ? m_width-1 : x);
+      y = (y >= m_height ? m_height-1 : y);
+    }
+
+    // Return value
+    return m_imageData[y * m_width + x];
+  }
+
+  /// Copy the pixel data into an Image.
+  ///
+  /// \param[out] image Image
+  /// \return True on success, false if no file is open
+  /// \throw std::bad_alloc on bad allocation
+  bool toImage(Image<T, N> &image) const
+  {
+    if (!isOpen())
+    {
+      return false;
+    }
+
+    image.resize(m_width, m_height);
+    std::memcpy(image.imageDataPtr(), m_imageData, m_width * m_height * sizeof(std::array<T, N>));
+    return true;
+  }
+
+protected:
+  /// Parse the PNM or PAM header of a file.
+  ///
+  /// \param[in] path Path to file
+  /// \param[out] width Image width
+  /// \param[out] height Image height
+  /// \param[out] dataOffset Offset of pixel data in bytes
+  /// \return True on success, false otherwise
+  static bool readHeader(const std::string &path, size_t &width, size_t &height, size_t &dataOffset)
+  {
+    std::ifstream ifile(path, std::ios::in | std::ios::binary);
+    if (!ifile.is_open())
+    {
+      return false;
+    }
+
+    // Peek magic number
+    char magic[2] = {};
+    ifile.read(magic, 2);
+    ifile.seekg(0, ifile.beg);
+    if (!ifile || magic[0] != 'P')
+    {
+      return false;
+    }
+
+    unsigned long maxVal = 0;
+    if (magic[1] == '7')
+    {
+      size_t depth = 0;
+      std::string tupleType;
+      if (!ImageIO::readPamFileHeader(ifile, width, height, depth, maxVal, tupleType)
+          || depth != N)
+      {
+        return false;
+      }
+    }
+    else if ((N == 1 && magic[1] == '5') || (N == 3 && magic[1] == '6'))
+    {
+      if (!ImageIO::readPnmFileHeader(ifile, std::string(magic, 2), width, height, maxVal))
+      {
+        return false;
+      }
+
+      // Pass last whitespace
+      ifile.seekg(1, ifile.cur);
+    }
+    else
+    {
+      return false;
+    }
+
+    // Only 8-bit samples can be mapped
+    if (maxVal > 255 || width == 0 || height == 0)
+    {
+      return false;
+    }
+
+    const std::streamoff offset = ifile.tellg();
+    if (offset < 0)
+    {
+      return false;
+    }
+    dataOffset = static_cast<size_t>(offset);
+    return true;
+  }
+
+  /// Map a file into memory.
+  ///
+  /// \param[in] path Path to file
+  /// \param[in] mode Access mode
+  /// \param[in] minimumSize Minimum file size in bytes
+  /// \return True on success, false otherwise
+  bool mapFile(const std::string &path, Mode mode, size_t minimumSize)
+  {
+#ifdef _WIN32
+    m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                               nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+    {
+      return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_fileHandle, &fileSize)
+        || static_cast<unsigned long long>(fileSize.QuadPart) < minimumSize)
+    {
+      close();
+      return false;
+    }
+
+    const bool copyOnWrite = (mode == Mode::CopyOnWrite);
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr,
+                                         (copyOnWrite ? PAGE_WRITECOPY : PAGE_READONLY),
+                                         0, 0, nullptr);
+    if (m_mappingHandle == nullptr)
+    {
+      close();
+      return false;
+    }
+
+    m_mapping = MapViewOfFile(m_mappingHandle,
+                              (copyOnWrite ? FILE_MAP_COPY : FILE_MAP_READ),
+                              0, 0, 0);
+    if (m_mapping == nullptr)
+    {
+      close();
+      return false;
+    }
+    m_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+      return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0
+        || static_cast<unsigned long long>(fileStat.st_size) < minimumSize)
+    {
+      ::close(fd);
+      return false;
+    }
+
+    const bool copyOnWrite = (mode == Mode::CopyOnWrite);
+    void *mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size),
+                         (copyOnWrite ? PROT_READ | PROT_WRITE : PROT_READ),
+                         (copyOnWrite ? MAP_PRIVATE : MAP_SHARED),
+                         fd, 0);
+
+    // The mapping remains valid after closing the file descriptor
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+      return false;
+    }
+    m_mapping = mapping;
+    m_mappingSize = static_cast<size_t>(fileStat.st_size);
+#endif
+    return true;
+  }
+
+  /// Swap state with another object
+  void swap(MappedImage &other)
+  {
+    std::swap(m_width, other.m_width);
+    std::swap(m_height, other.m_height);
+    std::swap(m_mode, other.m_mode);
+    std::swap(m_mapping, other.m_mapping);
+    std::swap(m_mappingSize, other.m_mappingSize);
+    std::swap(m_imageData, other.m_imageData);
+#ifdef _WIN32
+    std::swap(m_fileHandle, other.m_fileHandle);
+    std::swap(m_mappingHandle, other.m_mappingHandle);
+#endif
+  }
+
+  /// Image width in pixels.
+  size_t m_width;
+
+  /// Image height in pixels.
+  size_t m_height;
+
+  /// Access mode
+  Mode m_mode;
+
+  /// Start of the mapped file
+  void *m_mapping;
+
+  /// Size of the mapped file in bytes
+  size_t m_mappingSize;
+
+  /// Pointer to image data (inside the mapped file)
+  std::array<T, N> *m_imageData;
+
+#ifdef _WIN32
+  /// File handle
+  HANDLE m_fileHandle;
+
+  /// File mapping handle
+  HANDLE m_mappingHandle;
+#endif
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_MAPPEDIMAGE_H
@@ -0,0 +1,326 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_PNMSCANLINEREADER_H
+#define SPATIUMLIB_PNMSCANLINEREADER_H
+
+#include "Image.h"
+#include "ImageIO.h"
+
+#include <algorithm> // std::min
+#include <fstream> // std::ifstream
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+#include <type_traits> // std::is_same
+
+namespace spatium {
+
+/// \class PnmScanlineReader
+/// \brief Read a PNM or PAM file row by row
+///
+/// A scanline reader parses the file header on open() and then reads a band
+/// of rows at a time into an image supplied by the caller. That image is
+/// reused for every band, so an image of arbitrary height can be processed
+/// with memory bounded by the band size.
+///
+/// The following files can be read:
+///
+/// - PnmScanlineReader<T, 1>: PBM (P4, unsigned char only), PGM (P5) or PAM
+///   (P7) with depth 1.
+/// - PnmScanlineReader<T, 3>: PPM (P6) or PAM (P7) with depth 3.
+/// - PnmScanlineReader<T, N>: PAM (P7) with depth N.
+///
+/// T is either unsigned char (maximum value <= 255) or unsigned short (any
+/// maximum value).
+///
+/// Example:
+/// \code
+/// PnmScanlineReader<unsigned char, 3> reader("huge.ppm");
+/// Image<unsigned char, 3> band(reader.width(), 64);
+/// size_t rows;
+/// while ((rows = reader.readRows(band)) > 0)
+/// {
+///   // Process first 'rows' rows of band
+/// }
+/// \endcode
+template<typename T = unsigned char, int N = 3>
+class PnmScanlineReader
+{
+  static_assert(std::is_same<T, unsigned char>::value || std::is_same<T, unsigned short>::value,
+                "PnmScanlineReader only supports 8-bit and 16-bit samples");
+
+public:
+  /// Constructor
+  PnmScanlineReader()
+    : m_width(0)
+    , m_height(0)
+    , m_row(0)
+    , m_maxVal(0)
+    , m_bytesPerSample(1)
+    , m_binary(false)
+    , m_rowSize(0)
+  {
+  }
+
+  /// Constructor. Opens a file.
+  ///
+  /// Use isOpen() to check whether the file has been opened successfully.
+  ///
+  /// \param[in] path Path to PBM, PGM, PPM or PAM file
+  explicit PnmScanlineReader(const std::string &path)
+    : PnmScanlineReader()
+  {
+    open(path);
+  }
+
+  /// Open a file and read its header.
+  ///
+  /// A previously opened file is closed first.
+  ///
+  /// \param[in] path Path to PBM, PGM, PPM or PAM file
+  /// \return True on success, false otherwise
+  bool open(const std::string &path)
+  {
+    close();
+
+    m_file.open(path, std::ios::in | std::ios::binary);
+    if (!m_file.is_open())
+    {
+      return false;
+    }
+
+    if (!readHeader())
+    {
+      close();
+      return false;
+    }
+
+    m_row = 0;
+    m_rowSize = (m_binary ? (m_width + 7) / 8 : m_width * N * m_bytesPerSample);
+    if (!isDirect())
+    {
+      m_rowBuffer.reset(new unsigned char[m_rowSize]);
+    }
+    return true;
+  }
+
+  /// Close the file. Does nothing if no file is open.
+  void close()
+  {
+    if (m_file.is_open())
+    {
+      m_file.close();
+    }
+    m_file.clear();
+    m_width = 0;
+    m_height = 0;
+    m_row = 0;
+    m_rowSize = 0;
+    m_rowBuffer.reset();
+  }
+
+  /// Check if a file is open.
+  bool isOpen() const
+  {
+    return m_file.is_open();
+  }
+
+  /// Image width in pixels.
+  size_t width() const
+  {
+    return m_width;
+  }
+
+  /// Image height in pixels.
+  size_t height() const
+  {
+    return m_height;
+  }
+
+  /// Maximum pixel value as specified in the file header.
+  unsigned long maxVal() const
+  {
+    return m_maxVal;
+  }
+
+  /// Index of the next row to read.
+  size_t currentRow() const
+  {
+    return m_row;
+  }
+
+  /// Number of rows not read yet.
+  size_t remainingRows() const
+  {
+    return m_height - m_row;
+  }
+
+  /// Read the next band of rows.
+  ///
+  /// Rows are read into the image from the top. The band size is the height
+  /// of the image; near the end of the file fewer rows may be read. The
+  /// rows of the image beyond the returned count are left untouched.
+  ///
+  /// \param[out] rows Image with the width of the file
+  /// \return Number of rows read, 0 at end of file or on failure
+  size_t readRows(Image<T, N> &rows)
+  {
+    if (!isOpen() || rows.width() != m_width)
+    {
+      return 0;
+    }
+
+    const size_t count = std::min(rows.height(), m_height - m_row);
+    if (count == 0)
+    {
+      return 0;
+    }
+
+    T *samples = ImageIO::imageSamples(rows);
+    if (isDirect())
+    {
+      // Memory layout equals file layout: read all rows at once
+      if (!ImageIO::readBytes(m_file, reinterpret_cast<unsigned char*>(samples), count * m_rowSize))
+      {
+        return 0;
+      }
+    }
+    else
+    {
+      // Convert row by row
+      for (size_t y = 0; y < count; y++)
+      {
+        if (!ImageIO::readBytes(m_file, m_rowBuffer.get(), m_rowSize))
+        {
+          return 0;
+        }
+        convertRow(m_rowBuffer.get(), samples + y * m_width * N);
+      }
+    }
+
+    m_row += count;
+    return count;
+  }
+
+protected:
+  /// Parse the file header.
+  ///
+  /// \return True on success, false otherwise
+  bool readHeader()
+  {
+    // Peek magic number
+    char magic[2] = {};
+    m_file.read(magic, 2);
+    m_file.seekg(0, m_file.beg);
+    if (!m_file || magic[0] != 'P')
+    {
+      return false;
+    }
+
+    m_binary = false;
+    if (magic[1] == '7')
+    {
+      size_t depth = 0;
+      std::string tupleType;
+      if (!ImageIO::readPamFileHeader(m_file, m_width, m_height, depth, m_maxVal, tupleType)
+          || depth != N)
+      {
+        return false;
+      }
+    }
+    else if ((N == 1 && (magic[1] == '4' || magic[1] == '5')) || (N == 3 && magic[1] == '6'))
+    {
+      if (!ImageIO::readPnmFileHeader(m_file, std::string(magic, 2), m_width, m_height, m_maxVal))
+      {
+        return false;
+      }
+
+      // Pass last whitespace
+      m_file.seekg(1, m_file.cur);
+
+      m_binary = (magic[1] == '4');
+    }
+    else
+    {
+      return false;
+    }
+
+    if (m_maxVal == 0 || m_maxVal > 65535
+        || (m_binary && sizeof(T) != 1))
+    {
+      return false;
+    }
+
+    m_bytesPerSample = (m_maxVal > 255 ? 2 : 1);
+    return (m_bytesPerSample <= sizeof(T));
+  }
+
+  /// Check whether rows can be read without conversion.
+  bool isDirect() const
+  {
+    return (!m_binary && sizeof(T) == 1);
+  }
+
+  /// Convert a row as stored in the file to samples.
+  ///
+  /// \param[in] bytes Row as stored in the file
+  /// \param[out] samples Samples of the row
+  void convertRow(const unsigned char *bytes, T *samples) const
+  {
+    if (m_binary)
+    {
+      ImageIO::unpackBinaryRow(bytes, m_width, reinterpret_cast<unsigned char*>(samples));
+    }
+    else if (m_bytesPerSample == 2)
+    {
+      ImageIO::decodeBigEndian(bytes, m_width * N, reinterpret_cast<unsigned short*>(samples));
+    }
+    else
+    {
+      for (size_t i = 0; i < m_width * N; i++)
+      {
+        samples[i] = bytes[i];
+      }
+    }
+  }
+
+  /// Input file stream
+  std::ifstream m_file;
+
+  /// Image width in pixels.
+  size_t m_width;
+
+  /// Image height in pixels.
+  size_t m_height;
+
+  /// Index of next row to read
+  size_t m_row;
+
+  /// Maximum pixel value
+  unsigned long m_maxVal;
+
+  /// Bytes per sample in the file (1 or 2)
+  size_t m_bytesPerSample;
+
+  /// File is a bit packed PBM file
+  bool m_binary;
+
+  /// Size of a row in the file in bytes
+  size_t m_rowSize;
+
+  /// Buffer for a single row as stored in the file
+  std::unique_ptr<unsigned char[]> m_rowBuffer;
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_PNMSCANLINEREADER_H
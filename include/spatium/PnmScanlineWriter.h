@@ -0,0 +1,247 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_PNMSCANLINEWRITER_H
+#define SPATIUMLIB_PNMSCANLINEWRITER_H
+
+#include "Image.h"
+#include "ImageIO.h"
+
+#include <algorithm> // std::min
+#include <fstream> // std::ofstream
+#include <memory> // std::unique_ptr
+#include <string> // std::string
+#include <type_traits> // std::is_same
+
+namespace spatium {
+
+/// \class PnmScanlineWriter
+/// \brief Write a PNM or PAM file row by row
+///
+/// A scanline writer writes the file header on open() and then writes a band
+/// of rows at a time from an image supplied by the caller. Together with
+/// PnmScanlineReader an image of arbitrary height can be processed with
+/// memory bounded by the band size.
+///
+/// The file format follows from the channel count:
+///
+/// - PnmScanlineWriter<T, 1>: PGM (P5)
+/// - PnmScanlineWriter<T, 3>: PPM (P6)
+/// - PnmScanlineWriter<T, 2>: PAM (P7) with tuple type GRAYSCALE_ALPHA
+/// - PnmScanlineWriter<T, 4>: PAM (P7) with tuple type RGB_ALPHA
+///
+/// T is either unsigned char (maximum value 255) or unsigned short (maximum
+/// value 65535).
+template<typename T = unsigned char, int N = 3>
+class PnmScanlineWriter
+{
+  static_assert(std::is_same<T, unsigned char>::value || std::is_same<T, unsigned short>::value,
+                "PnmScanlineWriter only supports 8-bit and 16-bit samples");
+  static_assert(N >= 1 && N <= 4, "PnmScanlineWriter supports 1 to 4 channels");
+
+public:
+  /// Constructor
+  PnmScanlineWriter()
+    : m_width(0)
+    , m_height(0)
+    , m_row(0)
+  {
+  }
+
+  /// Constructor. Opens a file.
+  ///
+  /// Use isOpen() to check whether the file has been opened successfully.
+  ///
+  /// \param[in] path Path to output file
+  /// \param[in] width Image width in pixels
+  /// \param[in] height Image height in pixels
+  PnmScanlineWriter(const std::string &path, size_t width, size_t height)
+    : PnmScanlineWriter()
+  {
+    open(path, width, height);
+  }
+
+  /// Destructor. Closes the file.
+  ~PnmScanlineWriter()
+  {
+    close();
+  }
+
+  /// Open a file and write its header.
+  ///
+  /// A previously opened file is closed first.
+  ///
+  /// \param[in] path Path to output file
+  /// \param[in] width Image width in pixels
+  /// \param[in] height Image height in pixels
+  /// \return True on success, false otherwise
+  bool open(const std::string &path, size_t width, size_t height)
+  {
+    close();
+
+    m_file.open(path, std::ios::out | std::ios::binary);
+    if (!m_file.is_open())
+    {
+      return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_row = 0;
+
+    const unsigned long maxVal = (sizeof(T) == 1 ? 255 : 65535);
+    if (N == 1)
+    {
+      ImageIO::writePnmFileHeader(m_file, "P5", width, height, maxVal);
+    }
+    else if (N == 3)
+    {
+      ImageIO::writePnmFileHeader(m_file, "P6", width, height, maxVal);
+    }
+    else
+    {
+      ImageIO::writePamFileHeader(m_file, width, height, N, maxVal,
+                                  (N == 2 ? "GRAYSCALE_ALPHA" : "RGB_ALPHA"));
+    }
+
+    if (sizeof(T) == 2)
+    {
+      m_rowBuffer.reset(new unsigned char[width * N * 2]);
+    }
+
+    return m_file.good();
+  }
+
+  /// Close the file. Does nothing if no file is open.
+  ///
+  /// \return True if all rows have been written successfully, false
+  /// otherwise
+  bool close()
+  {
+    if (!m_file.is_open())
+    {
+      return false;
+    }
+
+    m_file.flush();
+    const bool success = (m_file.good() && m_row == m_height);
+    m_file.close();
+    m_file.clear();
+    m_rowBuffer.reset();
+    m_width = 0;
+    m_height = 0;
+    m_row = 0;
+    return success;
+  }
+
+  /// Check if a file is open.
+  bool isOpen() const
+  {
+    return m_file.is_open();
+  }
+
+  /// Image width in pixels.
+  size_t width() const
+  {
+    return m_width;
+  }
+
+  /// Image height in pixels.
+  size_t height() const
+  {
+    return m_height;
+  }
+
+  /// Index of the next row to write.
+  size_t currentRow() const
+  {
+    return m_row;
+  }
+
+  /// Number of rows not written yet.
+  size_t remainingRows() const
+  {
+    return m_height - m_row;
+  }
+
+  /// Write the next band of rows.
+  ///
+  /// Rows are written from the top of the image. Rows beyond the height of
+  /// the file are ignored.
+  ///
+  /// \param[in] rows Image with the width of the file
+  /// \param[in] rowCount Number of rows to write. At most the image height.
+  /// \return Number of rows written, 0 on failure
+  size_t writeRows(const Image<T, N> &rows, size_t rowCount)
+  {
+    if (!isOpen() || rows.width() != m_width)
+    {
+      return 0;
+    }
+
+    const size_t count = std::min(std::min(rowCount, rows.height()), m_height - m_row);
+    const T *samples = ImageIO::imageSamples(rows);
+    const size_t rowSamples = m_width * N;
+    if (sizeof(T) == 1)
+    {
+      // Memory layout equals file layout: write all rows at once
+      ImageIO::writeBytes(m_file, reinterpret_cast<const unsigned char*>(samples), count * rowSamples);
+    }
+    else
+    {
+      // Convert row by row to big-endian
+      for (size_t y = 0; y < count; y++)
+      {
+        ImageIO::encodeBigEndian(reinterpret_cast<const unsigned short*>(samples + y * rowSamples),
+                                 rowSamples, m_rowBuffer.get());
+        ImageIO::writeBytes(m_file, m_rowBuffer.get(), rowSamples * 2);
+      }
+    }
+
+    if (!m_file.good())
+    {
+      return 0;
+    }
+
+    m_row += count;
+    return count;
+  }
+
+  /// Write the next band of rows; all rows of the image.
+  ///
+  /// \param[in] rows Image with the width of the file
+  /// \return Number of rows written, 0 on failure
+  size_t writeRows(const Image<T, N> &rows)
+  {
+    return writeRows(rows, rows.height());
+  }
+
+protected:
+  /// Output file stream
+  std::ofstream m_file;
+
+  /// Image width in pixels.
+  size_t m_width;
+
+  /// Image height in pixels.
+  size_t m_height;
+
+  /// Index of next row to write
+  size_t m_row;
+
+  /// Buffer for a single row as stored in the file (16-bit only)
+  std::unique_ptr<unsigned char[]> m_rowBuffer;
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_PNMSCANLINEWRITER_H
@@ -0,0 +1,290 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_THREADPOOL_H
+#define SPATIUMLIB_THREADPOOL_H
+
+#include <condition_variable> // std::condition_variable
+#include <cstddef> // size_t
+#include <exception> // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <functional> // std::function
+#include <mutex> // std::mutex, std::lock_guard, std::unique_lock
+#include <thread> // std::thread
+#include <vector> // std::vector
+
+namespace spatium {
+
+/// \class ThreadPool
+/// \brief Pool of threads that execute indexed tasks with work stealing
+///
+/// run() executes tasks 0 .. n-1 on all threads of the pool, including the
+/// calling thread, and returns when all tasks have finished. Every thread
+/// starts with an equal, contiguous range of task indices and executes it
+/// in order. A thread that runs out of tasks steals the upper half of the
+/// remaining range of another thread, so threads keep busy when tasks take
+/// unequal time.
+///
+/// Example:
+/// \code
+/// ThreadPool pool(4);
+/// pool.run(rowCount, [&](size_t row, size_t thread) {
+///   // Process row
+/// });
+/// \endcode
+class ThreadPool
+{
+public:
+  /// Task function. Arguments are the task index and the index of the
+  /// executing thread (0 .. threadCount()-1). A thread executes one task at
+  /// a time, so per thread resources can be indexed by the thread index.
+  typedef std::function<void(size_t, size_t)> Task;
+
+  /// Constructor. Starts the worker threads.
+  ///
+  /// \param[in] threadCount Number of threads, including the thread that
+  /// calls run(). 0 for the number of hardware threads.
+  explicit ThreadPool(size_t threadCount = 0)
+    : m_ranges(threadCount > 0 ? threadCount : hardwareThreadCount())
+    , m_task(nullptr)
+    , m_generation(0)
+    , m_busyCount(0)
+    , m_stop(false)
+  {
+    for (size_t i = 1; i < m_ranges.size(); i++)
+    {
+      m_threads.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+  }
+
+  /// Destructor. Stops the worker threads.
+  ~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (std::thread &thread : m_threads)
+    {
+      thread.join();
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /// Number of threads, including the thread that calls run().
+  size_t threadCount() const
+  {
+    return m_ranges.size();
+  }
+
+  /// Number of hardware threads; at least 1.
+  static size_t hardwareThreadCount()
+  {
+    const unsigned int count = std::thread::hardware_concurrency();
+    return (count > 0 ? count : 1);
+  }
+
+  /// Execute tasks and wait for them to finish.
+  ///
+  /// Calls from multiple threads are executed one after another. Must not be
+  /// called from within a task.
+  ///
+  /// \param[in] taskCount Number of tasks
+  /// \param[in] task Task function
+  /// \throw Rethrows the first exception thrown by a task, after all other
+  /// tasks have finished
+  void run(size_t taskCount, const Task &task)
+  {
+    std::lock_guard<std::mutex> runLock(m_runMutex);
+    if (taskCount == 0)
+    {
+      return;
+    }
+
+    // Divide tasks into equal ranges
+    const size_t threads = m_ranges.size();
+    for (size_t i = 0; i < threads; i++)
+    {
+      std::lock_guard<std::mutex> lock(m_ranges[i].mutex);
+      m_ranges[i].begin = taskCount * i / threads;
+      m_ranges[i].end = taskCount * (i + 1) / threads;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_task = &task;
+      m_exception = nullptr;
+      m_busyCount = threads - 1;
+      m_generation++;
+    }
+    m_workAvailable.notify_all();
+
+    execute(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this]() { return m_busyCount == 0; });
+    m_task = nullptr;
+    if (m_exception)
+    {
+      std::exception_ptr exception = m_exception;
+      m_exception = nullptr;
+      std::rethrow_exception(exception);
+    }
+  }
+
+protected:
+  /// Range of task indices of a thread
+  struct Range
+  {
+    Range()
+      : begin(0)
+      , end(0)
+    {
+    }
+
+    std::mutex mutex;
+    size_t begin;
+    size_t end;
+  };
+
+  /// Worker thread function
+  void work(size_t thread)
+  {
+    size_t generation = 0;
+    while (true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workAvailable.wait(lock, [this, generation]() {
+          return (m_stop || m_generation != generation);
+        });
+        if (m_stop)
+        {
+          return;
+        }
+        generation = m_generation;
+      }
+
+      execute(thread);
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (--m_busyCount == 0)
+      {
+        m_workDone.notify_one();
+      }
+    }
+  }
+
+  /// Execute tasks of own range, then steal until no tasks remain.
+  void execute(size_t thread)
+  {
+    size_t index;
+    while (pop(thread, index) || steal(thread, index))
+    {
+      try
+      {
+        (*m_task)(index, thread);
+      }
+      catch (...)
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_exception)
+        {
+          m_exception = std::current_exception();
+        }
+      }
+    }
+  }
+
+  /// Take the next task of own range.
+  bool pop(size_t thread, size_t &index)
+  {
+    Range &range = m_ranges[thread];
+    std::lock_guard<std::mutex> lock(range.mutex);
+    if (range.begin < range.end)
+    {
+      index = range.begin++;
+      return true;
+    }
+    return false;
+  }
+
+  /// Take the upper half of the range of another thread. The first task of
+  /// it is returned; the rest becomes the own range.
+  bool steal(size_t thread, size_t &index)
+  {
+    const size_t threads = m_ranges.size();
+    for (size_t i = 1; i < threads; i++)
+    {
+      Range &victim = m_ranges[(thread + i) % threads];
+      size_t begin, end;
+      {
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.begin >= victim.end)
+        {
+          continue;
+        }
+        begin = victim.begin + (victim.end - victim.begin) / 2;
+        end = victim.end;
+        victim.end = begin;
+      }
+
+      Range &range = m_ranges[thread];
+      std::lock_guard<std::mutex> lock(range.mutex);
+      index = begin;
+      range.begin = begin + 1;
+      range.end = end;
+      return true;
+    }
+    return false;
+  }
+
+  /// Task ranges; one per thread
+  std::vector<Range> m_ranges;
+
+  /// Worker threads (threads 1 .. n-1)
+  std::vector<std::thread> m_threads;
+
+  /// Task function of current run
+  const Task *m_task;
+
+  /// First exception thrown by a task
+  std::exception_ptr m_exception;
+
+  /// Incremented for every run
+  size_t m_generation;
+
+  /// Number of worker threads executing the current run
+  size_t m_busyCount;
+
+  /// Worker threads should stop
+  bool m_stop;
+
+  /// Guards the members above, except the ranges
+  std::mutex m_mutex;
+
+  /// Serializes calls to run()
+  std::mutex m_runMutex;
+
+  /// Signals workers that a run has started
+  std::condition_variable m_workAvailable;
+
+  /// Signals run() that all workers have finished
+  std::condition_variable m_workDone;
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_THREADPOOL_H
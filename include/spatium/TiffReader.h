@@ -0,0 +1,809 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_TIFFREADER_H
+#define SPATIUMLIB_TIFFREADER_H
+
+#include "Image.h"
+
+#include <algorithm> // std::min, std::max, std::reverse
+#include <cstdint> // std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t
+#include <cstring> // std::memcpy
+#include <fstream> // std::ifstream
+#include <limits> // std::numeric_limits
+#include <string> // std::string
+#include <type_traits> // std::is_floating_point, std::is_signed
+#include <vector> // std::vector
+
+namespace spatium {
+
+/// \class TiffReader
+/// \brief Read baseline TIFF and BigTIFF files
+///
+/// TiffReader reads the pixel data of a single image file directory (IFD)
+/// of a TIFF or BigTIFF file. The image data of a TIFF file is stored in
+/// chunks: either strips (bands of full rows) or tiles (rectangular blocks).
+/// Each chunk can be read individually. A window of the image can be read,
+/// in which case only the chunks that overlap the window are read from disk.
+///
+/// Supported:
+///
+/// - Classic TIFF and BigTIFF, little-endian (II) and big-endian (MM).
+/// - Strips and tiles.
+/// - No compression and PackBits compression.
+/// - Interleaved samples (planar configuration 1) with 8, 16, 32 or 64 bits
+///   per sample; unsigned integer, signed integer or floating point.
+///
+/// Not supported: other compression schemes, predictors, separate sample
+/// planes and sample sizes that are not a whole number of bytes.
+///
+/// The sample type T of the destination image must match the file: same
+/// size as BitsPerSample, floating point if and only if SampleFormat is
+/// IEEE floating point. The channel count N must equal SamplesPerPixel.
+///
+/// Specification: https://www.itu.int/itudoc/itu-t/com16/tiff-fx/docs/tiff6.pdf
+class TiffReader
+{
+public:
+  /// Constructor
+  TiffReader()
+    : m_bigEndian(false)
+    , m_bigTiff(false)
+    , m_width(0)
+    , m_height(0)
+    , m_samplesPerPixel(1)
+    , m_bitsPerSample(1)
+    , m_sampleFormat(1)
+    , m_compression(1)
+    , m_planarConfiguration(1)
+    , m_predictor(1)
+    , m_tiled(false)
+    , m_chunkWidth(0)
+    , m_chunkHeight(0)
+  {
+  }
+
+  /// Constructor. Opens a file.
+  ///
+  /// Use isOpen() to check whether the file has been opened successfully.
+  ///
+  /// \param[in] path Path to TIFF file
+  /// \param[in] directory Index of image file directory (default = 0)
+  explicit TiffReader(const std::string &path, size_t directory = 0)
+    : TiffReader()
+  {
+    open(path, directory);
+  }
+
+  /// Open a file and read an image file directory.
+  ///
+  /// A previously opened file is closed first.
+  ///
+  /// \param[in] path Path to TIFF file
+  /// \param[in] directory Index of image file directory (default = 0)
+  /// \return True on success, false otherwise
+  bool open(const std::string &path, size_t directory = 0)
+  {
+    close();
+
+    m_file.open(path, std::ios::in | std::ios::binary);
+    if (!m_file.is_open())
+    {
+      return false;
+    }
+
+    if (!readHeader(directory) || !isSupported())
+    {
+      close();
+      return false;
+    }
+
+    return true;
+  }
+
+  /// Close the file. Does nothing if no file is open.
+  void close()
+  {
+    if (m_file.is_open())
+    {
+      m_file.close();
+    }
+    m_file.clear();
+    m_width = 0;
+    m_height = 0;
+    m_chunkOffsets.clear();
+    m_chunkByteCounts.clear();
+  }
+
+  /// Check if a file is open.
+  bool isOpen() const
+  {
+    return m_file.is_open();
+  }
+
+  /// Check if the file is a BigTIFF file.
+  bool isBigTiff() const
+  {
+    return m_bigTiff;
+  }
+
+  /// Image width in pixels.
+  size_t width() const
+  {
+    return m_width;
+  }
+
+  /// Image height in pixels.
+  size_t height() const
+  {
+    return m_height;
+  }
+
+  /// Number of samples (channels) per pixel.
+  size_t samplesPerPixel() const
+  {
+    return m_samplesPerPixel;
+  }
+
+  /// Number of bits per sample.
+  size_t bitsPerSample() const
+  {
+    return m_bitsPerSample;
+  }
+
+  /// Sample format: 1 = unsigned integer, 2 = signed integer, 3 = floating
+  /// point.
+  unsigned int sampleFormat() const
+  {
+    return m_sampleFormat;
+  }
+
+  /// Check if the image data is stored in tiles rather than strips.
+  bool isTiled() const
+  {
+    return m_tiled;
+  }
+
+  /// Width of a chunk in pixels: the tile width or the image width.
+  size_t chunkWidth() const
+  {
+    return m_chunkWidth;
+  }
+
+  /// Height of a chunk in pixels: the tile length or rows per strip.
+  size_t chunkHeight() const
+  {
+    return m_chunkHeight;
+  }
+
+  /// Number of chunks (strips or tiles).
+  size_t chunkCount() const
+  {
+    return m_chunkOffsets.size();
+  }
+
+  /// Number of chunks (strips or tiles) per row of chunks.
+  size_t chunksAcross() const
+  {
+    return (m_width + m_chunkWidth - 1) / m_chunkWidth;
+  }
+
+  /// Read a single strip.
+  ///
+  /// The image is resized to the image width and the number of rows in the
+  /// strip. The last strip may have fewer rows than the others.
+  ///
+  /// \param[in] index Strip index
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  bool readStrip(size_t index, Image<T, N> &image)
+  {
+    if (m_tiled)
+    {
+      return false;
+    }
+
+    return readChunk(index, image);
+  }
+
+  /// Read a single tile.
+  ///
+  /// The image is resized to the tile size. Tiles on the right and bottom
+  /// edge are padded; the padding is included.
+  ///
+  /// \param[in] index Tile index. Tiles are ordered left to right, top to
+  /// bottom.
+  /// \param[out] image Image
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  bool readTile(size_t index, Image<T, N> &image)
+  {
+    if (!m_tiled)
+    {
+      return false;
+    }
+
+    return readChunk(index, image);
+  }
+
+  /// Read a window of the image.
+  ///
+  /// Only the strips or tiles that overlap the window are read.
+  ///
+  /// \param[in] x X coordinate of top left corner
+  /// \param[in] y Y coordinate of top left corner
+  /// \param[in] width Window width in pixels
+  /// \param[in] height Window height in pixels
+  /// \param[out] image Image. Resized to the window size.
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  bool readWindow(size_t x, size_t y, size_t width, size_t height, Image<T, N> &image)
+  {
+    if (!isOpen() || !isCompatible<T, N>()
+        || width == 0 || height == 0
+        || x >= m_width || y >= m_height
+        || width > m_width - x || height > m_height - y)
+    {
+      return false;
+    }
+
+    image.resize(width, height);
+
+    const size_t pixelSize = N * sizeof(T);
+    const size_t across = chunksAcross();
+    const size_t firstColumn = x / m_chunkWidth;
+    const size_t lastColumn = (x + width - 1) / m_chunkWidth;
+    const size_t firstRow = y / m_chunkHeight;
+    const size_t lastRow = (y + height - 1) / m_chunkHeight;
+    unsigned char *out = reinterpret_cast<unsigned char*>(image.imageDataPtr());
+
+    // Iterate overlapping chunks
+    for (size_t row = firstRow; row <= lastRow; row++)
+    {
+      for (size_t column = firstColumn; column <= lastColumn; column++)
+      {
+        const size_t index = row * across + column;
+        size_t chunkRows = 0;
+        if (!decodeChunk(index, chunkRows))
+        {
+          return false;
+        }
+
+        // Overlap of chunk and window in image coordinates
+        const size_t chunkX = column * m_chunkWidth;
+        const size_t chunkY = row * m_chunkHeight;
+        const size_t x0 = std::max(x, chunkX);
+        const size_t x1 = std::min(x + width, std::min(chunkX + m_chunkWidth, m_width));
+        const size_t y0 = std::max(y, chunkY);
+        const size_t y1 = std::min(y + height, chunkY + chunkRows);
+
+        // Copy overlapping part row by row
+        for (size_t yy = y0; yy < y1; yy++)
+        {
+          const unsigned char *src = m_chunk.data() + ((yy - chunkY) * m_chunkWidth + (x0 - chunkX)) * pixelSize;
+          unsigned char *dst = out + ((yy - y) * width + (x0 - x)) * pixelSize;
+          std::memcpy(dst, src, (x1 - x0) * pixelSize);
+        }
+      }
+    }
+
+    return true;
+  }
+
+  /// Read the whole image.
+  ///
+  /// \param[out] image Image. Resized to the image size.
+  /// \return True on success, false otherwise
+  template<typename T, int N>
+  bool readImage(Image<T, N> &image)
+  {
+    return readWindow(0, 0, m_width, m_height, image);
+  }
+
+protected:
+  // TIFF tags
+  static const std::uint16_t TagImageWidth = 256;
+  static const std::uint16_t TagImageLength = 257;
+  static const std::uint16_t TagBitsPerSample = 258;
+  static const std::uint16_t TagCompression = 259;
+  static const std::uint16_t TagStripOffsets = 273;
+  static const std::uint16_t TagSamplesPerPixel = 277;
+  static const std::uint16_t TagRowsPerStrip = 278;
+  static const std::uint16_t TagStripByteCounts = 279;
+  static const std::uint16_t TagPlanarConfiguration = 284;
+  static const std::uint16_t TagPredictor = 317;
+  static const std::uint16_t TagTileWidth = 322;
+  static const std::uint16_t TagTileLength = 323;
+  static const std::uint16_t TagTileOffsets = 324;
+  static const std::uint16_t TagTileByteCounts = 325;
+  static const std::uint16_t TagSampleFormat = 339;
+
+  /// Check if the sample type and channel count match the file.
+  template<typename T, int N>
+  bool isCompatible() const
+  {
+    return (static_cast<size_t>(N) == m_samplesPerPixel
+            && sizeof(T) * 8 == m_bitsPerSample
+            && std::is_floating_point<T>::value == (m_sampleFormat == 3)
+            && (std::is_floating_point<T>::value || std::is_signed<T>::value == (m_sampleFormat == 2)));
+  }
+
+  /// Check if the image file directory describes a supported image.
+  bool isSupported() const
+  {
+    return (m_width > 0 && m_height > 0
+            && m_chunkWidth > 0 && m_chunkHeight > 0
+            && (m_bitsPerSample == 8 || m_bitsPerSample == 16 || m_bitsPerSample == 32 || m_bitsPerSample == 64)
+            && m_sampleFormat >= 1 && m_sampleFormat <= 3
+            && (m_compression == 1 || m_compression == 32773)
+            && (m_planarConfiguration == 1 || m_samplesPerPixel == 1)
+            && m_predictor == 1
+            && hasValidSize()
+            && !m_chunkOffsets.empty()
+            && m_chunkOffsets.size() == m_chunkByteCounts.size()
+            && m_chunkOffsets.size() >= chunksAcross() * ((m_height + m_chunkHeight - 1) / m_chunkHeight));
+  }
+
+  /// Check that the sizes of the image and of a chunk do not overflow.
+  ///
+  /// A chunk is limited to 400 million pixels, as QOI images are, so that a
+  /// corrupt header does not allocate a huge chunk buffer. Requires positive
+  /// dimensions and a supported sample size.
+  bool hasValidSize() const
+  {
+    const size_t maximum = std::numeric_limits<size_t>::max();
+    const size_t maxChunkPixels = 400000000;
+    if (m_samplesPerPixel == 0 || m_samplesPerPixel > 65535)
+    {
+      return false;
+    }
+    const size_t pixelSize = m_samplesPerPixel * (m_bitsPerSample / 8);
+    return (m_chunkWidth <= maxChunkPixels / m_chunkHeight
+            && m_chunkWidth * m_chunkHeight <= maximum / pixelSize
+            && m_width <= maximum / m_height / pixelSize
+            && m_width <= maximum - m_chunkWidth
+            && m_height <= maximum - m_chunkHeight);
+  }
+
+  /// Read a single chunk into an image.
+  template<typename T, int N>
+  bool readChunk(size_t index, Image<T, N> &image)
+  {
+    if (!isOpen() || !isCompatible<T, N>())
+    {
+      return false;
+    }
+
+    size_t chunkRows = 0;
+    if (!decodeChunk(index, chunkRows))
+    {
+      return false;
+    }
+
+    image.resize(m_chunkWidth, chunkRows);
+    std::memcpy(image.imageDataPtr(), m_chunk.data(), m_chunkWidth * chunkRows * N * sizeof(T));
+    return true;
+  }
+
+  /// Read, decompress and byte swap a chunk into the chunk buffer.
+  ///
+  /// \param[in] index Chunk index
+  /// \param[out] chunkRows Number of rows in the chunk
+  /// \return True on success, false otherwise
+  bool decodeChunk(size_t index, size_t &chunkRows)
+  {
+    if (index >= m_chunkOffsets.size())
+    {
+      return false;
+    }
+
+    // Tiles always have the full tile length. The last strip may be shorter.
+    chunkRows = m_chunkHeight;
+    if (!m_tiled)
+    {
+      chunkRows = std::min(m_chunkHeight, m_height - index * m_chunkHeight);
+    }
+
+    const size_t bytesPerSample = m_bitsPerSample / 8;
+    const size_t decodedSize = m_chunkWidth * chunkRows * m_samplesPerPixel * bytesPerSample;
+    const std::uint64_t byteCount = m_chunkByteCounts[index];
+    m_chunk.resize(decodedSize);
+
+    if (m_compression == 1)
+    {
+      // No compression: read directly into the chunk buffer
+      if (byteCount < decodedSize || !readAt(m_chunkOffsets[index], m_chunk.data(), decodedSize))
+      {
+        return false;
+      }
+    }
+    else
+    {
+      // PackBits compression
+      m_compressed.resize(static_cast<size_t>(byteCount));
+      if (!readAt(m_chunkOffsets[index], m_compressed.data(), m_compressed.size())
+          || !unpackBits(m_compressed.data(), m_compressed.size(), m_chunk.data(), decodedSize))
+      {
+        return false;
+      }
+    }
+
+    // Swap bytes if the file byte order differs from the machine byte order
+    if (bytesPerSample > 1 && m_bigEndian != isMachineBigEndian())
+    {
+      for (size_t i = 0; i < decodedSize; i += bytesPerSample)
+      {
+        std::reverse(m_chunk.begin() + static_cast<std::ptrdiff_t>(i),
+                     m_chunk.begin() + static_cast<std::ptrdiff_t>(i + bytesPerSample));
+      }
+    }
+
+    return true;
+  }
+
+  /// Decompress PackBits data.
+  ///
+  /// \param[in] in Compressed data
+  /// \param[in] inSize Size of compressed data in bytes
+  /// \param[out] out Decompressed data
+  /// \param[in] outSize Expected size of decompressed data in bytes
+  /// \return True on success, false if the data is corrupt
+  static bool unpackBits(const std::uint8_t *in, size_t inSize, std::uint8_t *out, size_t outSize)
+  {
+    size_t i = 0, o = 0;
+    while (o < outSize && i < inSize)
+    {
+      const int n = static_cast<signed char>(in[i++]);
+      if (n >= 0)
+      {
+        // Copy next n+1 bytes literally
+        const size_t count = static_cast<size_t>(n) + 1;
+        if (i + count > inSize || o + count > outSize)
+        {
+          return false;
+        }
+        std::memcpy(out + o, in + i, count);
+        i += count;
+        o += count;
+      }
+      else if (n != -128)
+      {
+        // Repeat next byte -n+1 times
+        const size_t count = static_cast<size_t>(1 - n);
+        if (i >= inSize || o + count > outSize)
+        {
+          return false;
+        }
+        std::memset(out + o, in[i++], count);
+        o += count;
+      }
+    }
+
+    return (o == outSize);
+  }
+
+  /// Parse the file header and an image file directory.
+  ///
+  /// \param[in] directory Index of image file directory
+  /// \return True on success, false otherwise
+  bool readHeader(size_t directory)
+  {
+    // Defaults of the fields that a directory may omit, so that nothing
+    // carries over from a previously opened file
+    m_bigEndian = false;
+    m_bigTiff = false;
+    m_width = 0;
+    m_height = 0;
+    m_samplesPerPixel = 1;
+    m_bitsPerSample = 1;
+    m_sampleFormat = 1;
+    m_compression = 1;
+    m_planarConfiguration = 1;
+    m_predictor = 1;
+    m_tiled = false;
+    m_chunkWidth = 0;
+    m_chunkHeight = 0;
+
+    // Byte order
+    std::uint8_t header[16];
+    if (!readAt(0, header, 8))
+    {
+      return false;
+    }
+    if (header[0] == 'I' && header[1] == 'I')
+    {
+      m_bigEndian = false;
+    }
+    else if (header[0] == 'M' && header[1] == 'M')
+    {
+      m_bigEndian = true;
+    }
+    else
+    {
+      return false;
+    }
+
+    // Version: 42 = TIFF, 43 = BigTIFF
+    std::uint64_t ifdOffset = 0;
+    const std::uint16_t version = static_cast<std::uint16_t>(decode(header + 2, 2));
+    if (version == 42)
+    {
+      m_bigTiff = false;
+      ifdOffset = decode(header + 4, 4);
+    }
+    else if (version == 43)
+    {
+      m_bigTiff = true;
+      if (!readAt(0, header, 16) || decode(header + 4, 2) != 8)
+      {
+        return false;
+      }
+      ifdOffset = decode(header + 8, 8);
+    }
+    else
+    {
+      return false;
+    }
+
+    // Follow chain of image file directories
+    const size_t countSize = (m_bigTiff ? 8 : 2);
+    const size_t entrySize = (m_bigTiff ? 20 : 12);
+    const size_t offsetSize = (m_bigTiff ? 8 : 4);
+    for (size_t i = 0; i < directory; i++)
+    {
+      std::uint8_t buffer[8];
+      if (ifdOffset == 0 || !readAt(ifdOffset, buffer, countSize))
+      {
+        return false;
+      }
+      const std::uint64_t entryCount = decode(buffer, countSize);
+      if (!readAt(ifdOffset + countSize + entryCount * entrySize, buffer, offsetSize))
+      {
+        return false;
+      }
+      ifdOffset = decode(buffer, offsetSize);
+    }
+    if (ifdOffset == 0)
+    {
+      return false;
+    }
+
+    // Read entries
+    std::uint8_t buffer[8];
+    if (!readAt(ifdOffset, buffer, countSize))
+    {
+      return false;
+    }
+    const std::uint64_t entryCount = decode(buffer, countSize);
+    if (entryCount == 0 || entryCount > 4096)
+    {
+      return false;
+    }
+    std::vector<std::uint8_t> entries(static_cast<size_t>(entryCount) * entrySize);
+    if (!readAt(ifdOffset + countSize, entries.data(), entries.size()))
+    {
+      return false;
+    }
+
+    size_t rowsPerStrip = 0, tileWidth = 0, tileLength = 0;
+    std::vector<std::uint64_t> stripOffsets, stripByteCounts, tileOffsets, tileByteCounts;
+    for (size_t e = 0; e < entryCount; e++)
+    {
+      const std::uint8_t *entry = entries.data() + e * entrySize;
+      const std::uint16_t tag = static_cast<std::uint16_t>(decode(entry, 2));
+
+      std::vector<std::uint64_t> values;
+      if (!readEntryValues(entry, values) || values.empty())
+      {
+        // Ignore tags with types that are not needed (ASCII, RATIONAL, ...)
+        continue;
+      }
+
+      switch (tag)
+      {
+      case TagImageWidth: m_width = static_cast<size_t>(values[0]); break;
+      case TagImageLength: m_height = static_cast<size_t>(values[0]); break;
+      case TagBitsPerSample:
+        m_bitsPerSample = static_cast<size_t>(values[0]);
+        for (size_t v = 1; v < values.size(); v++)
+        {
+          if (values[v] != values[0])
+          {
+            return false; // Mixed sample sizes
+          }
+        }
+        break;
+      case TagCompression: m_compression = static_cast<unsigned int>(values[0]); break;
+      case TagSamplesPerPixel: m_samplesPerPixel = static_cast<size_t>(values[0]); break;
+      case TagRowsPerStrip: rowsPerStrip = static_cast<size_t>(values[0]); break;
+      case TagPlanarConfiguration: m_planarConfiguration = static_cast<unsigned int>(values[0]); break;
+      case TagPredictor: m_predictor = static_cast<unsigned int>(values[0]); break;
+      case TagTileWidth: tileWidth = static_cast<size_t>(values[0]); break;
+      case TagTileLength: tileLength = static_cast<size_t>(values[0]); break;
+      case TagSampleFormat: m_sampleFormat = static_cast<unsigned int>(values[0]); break;
+      case TagStripOffsets: stripOffsets.swap(values); break;
+      case TagStripByteCounts: stripByteCounts.swap(values); break;
+      case TagTileOffsets: tileOffsets.swap(values); break;
+      case TagTileByteCounts: tileByteCounts.swap(values); break;
+      default: break;
+      }
+    }
+
+    // Chunk layout
+    m_tiled = !tileOffsets.empty();
+    if (m_tiled)
+    {
+      m_chunkWidth = tileWidth;
+      m_chunkHeight = tileLength;
+      m_chunkOffsets.swap(tileOffsets);
+      m_chunkByteCounts.swap(tileByteCounts);
+    }
+    else
+    {
+      m_chunkWidth = m_width;
+      m_chunkHeight = ((rowsPerStrip == 0 || rowsPerStrip > m_height) ? m_height : rowsPerStrip);
+      m_chunkOffsets.swap(stripOffsets);
+      m_chunkByteCounts.swap(stripByteCounts);
+    }
+
+    return true;
+  }
+
+  /// Read the values of an image file directory entry.
+  ///
+  /// Only integer types are read.
+  ///
+  /// \param[in] entry Image file directory entry
+  /// \param[out] values Values
+  /// \return True on success, false for other types or on read failure
+  bool readEntryValues(const std::uint8_t *entry, std::vector<std::uint64_t> &values)
+  {
+    const std::uint16_t type = static_cast<std::uint16_t>(decode(entry + 2, 2));
+    const std::uint64_t count = decode(entry + 4, (m_bigTiff ? 8 : 4));
+    const std::uint8_t *valueField = entry + (m_bigTiff ? 12 : 8);
+    const size_t valueFieldSize = (m_bigTiff ? 8 : 4);
+
+    size_t typeSize = 0;
+    switch (type)
+    {
+    case 1: typeSize = 1; break;  // BYTE
+    case 3: typeSize = 2; break;  // SHORT
+    case 4: typeSize = 4; break;  // LONG
+    case 16: typeSize = 8; break; // LONG8
+    default: return false;
+    }
+
+    // Limit count to guard against corrupt files
+    if (count == 0 || count > (1u << 28))
+    {
+      return false;
+    }
+
+    // Values are stored in the entry itself if they fit, otherwise the
+    // entry holds an offset to the values.
+    const size_t size = static_cast<size_t>(count) * typeSize;
+    std::vector<std::uint8_t> data(size);
+    if (size <= valueFieldSize)
+    {
+      std::memcpy(data.data(), valueField, size);
+    }
+    else if (!readAt(decode(valueField, valueFieldSize), data.data(), size))
+    {
+      return false;
+    }
+
+    values.resize(static_cast<size_t>(count));
+    for (size_t i = 0; i < values.size(); i++)
+    {
+      values[i] = decode(data.data() + i * typeSize, typeSize);
+    }
+    return true;
+  }
+
+  /// Decode an unsigned integer in file byte order.
+  ///
+  /// \param[in] data Pointer to bytes
+  /// \param[in] size Number of bytes (1, 2, 4 or 8)
+  /// \return Value
+  std::uint64_t decode(const std::uint8_t *data, size_t size) const
+  {
+    std::uint64_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+      const size_t b = (m_bigEndian ? i : size - 1 - i);
+      value = (value << 8) | data[b];
+    }
+    return value;
+  }
+
+  /// Read bytes at an offset in the file.
+  ///
+  /// \param[in] offset Offset in bytes from the start of the file
+  /// \param[out] data Destination of bytes
+  /// \param[in] size Number of bytes
+  /// \return True if all bytes have been read, false otherwise
+  bool readAt(std::uint64_t offset, std::uint8_t *data, size_t size)
+  {
+    m_file.clear();
+    m_file.seekg(static_cast<std::streamoff>(offset), m_file.beg);
+    m_file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+    return (static_cast<size_t>(m_file.gcount()) == size);
+  }
+
+  /// Check if the machine byte order is big-endian.
+  static bool isMachineBigEndian()
+  {
+    const std::uint16_t value = 1;
+    std::uint8_t firstByte;
+    std::memcpy(&firstByte, &value, 1);
+    return (firstByte == 0);
+  }
+
+  /// Input file stream
+  std::ifstream m_file;
+
+  /// File byte order is big-endian (MM)
+  bool m_bigEndian;
+
+  /// File is a BigTIFF file
+  bool m_bigTiff;
+
+  /// Image width in pixels.
+  size_t m_width;
+
+  /// Image height in pixels.
+  size_t m_height;
+
+  /// Samples per pixel
+  size_t m_samplesPerPixel;
+
+  /// Bits per sample
+  size_t m_bitsPerSample;
+
+  /// Sample format (1 = unsigned, 2 = signed, 3 = floating point)
+  unsigned int m_sampleFormat;
+
+  /// Compression (1 = none, 32773 = PackBits)
+  unsigned int m_compression;
+
+  /// Planar configuration (1 = interleaved)
+  unsigned int m_planarConfiguration;
+
+  /// Predictor (1 = none)
+  unsigned int m_predictor;
+
+  /// Image data is stored in tiles
+  bool m_tiled;
+
+  /// Width of a chunk in pixels
+  size_t m_chunkWidth;
+
+  /// Height of a chunk in pixels
+  size_t m_chunkHeight;
+
+  /// File offsets of chunks
+  std::vector<std::uint64_t> m_chunkOffsets;
+
+  /// Sizes of chunks in the file in bytes
+  std::vector<std::uint64_t> m_chunkByteCounts;
+
+  /// Decoded chunk; reused for every chunk
+  std::vector<std::uint8_t> m_chunk;
+
+  /// Compressed chunk; reused for every chunk
+  std::vector<std::uint8_t> m_compressed;
+};
+
+} // namespace spatium
+
+#endif // SPATIUMLIB_TIFFREADER_H
@@ -14,9 +14,25 @@
 #define SPATIUMLIB_IMGPROC_H
 
 #include "imgproc/IImageFilter.h"
+#include "imgproc/Border.h"
 #include "imgproc/GlobalThreshold.h"
+#include "imgproc/Histogram.h"
+#include "imgproc/HistogramEqualization.h"
+#include "imgproc/Clahe.h"
+#include "imgproc/IntegralImage.h"
+#include "imgproc/AutoThreshold.h"
+#include "imgproc/AdaptiveThreshold.h"
+#include "imgproc/ConnectedComponents.h"
+#include "imgproc/DistanceTransform.h"
 #include "imgproc/Grayscale.h"
 #include "imgproc/Sobel.h"
 #include "imgproc/Blur.h"
+#include "imgproc/GaussianBlur.h"
+#include "imgproc/Convolve.h"
+#include "imgproc/Canny.h"
+#include "imgproc/Median.h"
+#include "imgproc/Morphology.h"
+#include "imgproc/Pipeline.h"
+#include "imgproc/ParallelExecutor.h"
 
 #endif // SPATIUMLIB_IMGPROC_H
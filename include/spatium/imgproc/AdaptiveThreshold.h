@@ -0,0 +1,214 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_ADAPTIVETHRESHOLD_H
+#define SPATIUMLIB_IMGPROC_ADAPTIVETHRESHOLD_H
+
+#include "IImageFilter.h"
+#include "GaussianBlur.h"
+#include "IntegralImage.h"
+
+#include <algorithm> // std::min
+#include <limits> // std::numeric_limits
+
+namespace spatium {
+namespace imgproc {
+
+/// \class AdaptiveThreshold
+/// \brief Local threshold image filter
+///
+/// Binarizes an image by a threshold that varies over the image: the
+/// weighted mean of the window around a pixel, minus an offset. Pixels with
+/// a value above their threshold become white (maximum value), others black
+/// (0).
+///
+/// Two methods are available:
+///
+/// - Mean: unweighted mean of the (2r+1) x (2r+1) window. Windows are
+///   clipped at the image border. Window sums are read from an
+///   IntegralImage with four lookups.
+/// - Gaussian: Gaussian weighted mean, with the sigma of a Gaussian kernel
+///   of 2r+1 samples: 0.3 * (r - 1) + 0.8. Computed by GaussianBlur, which
+///   switches to the recursive filter for large windows.
+///
+/// For both methods the cost per pixel does not depend on the radius.
+template<typename T>
+class AdaptiveThreshold : public IImageFilter
+{
+public:
+  /// Local mean method
+  enum class Method
+  {
+    Mean,    ///< Mean of window
+    Gaussian ///< Gaussian weighted mean of window
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] radius Radius of the window in pixels (default = 1)
+  /// \param[in] offset Offset subtracted from the local mean (default = 0)
+  /// \param[in] method Local mean method (default = Mean)
+  AdaptiveThreshold(size_t radius = 1, double offset = 0, Method method = Method::Mean)
+    : m_radius(radius)
+    , m_offset(offset)
+    , m_method(method)
+  {}
+
+  virtual ~AdaptiveThreshold() = default;
+
+  /// Get radius of the window.
+  ///
+  /// \return Radius in pixels
+  size_t radius() const
+  {
+    return m_radius;
+  }
+
+  /// Set radius of the window.
+  ///
+  /// \param[in] radius Radius in pixels
+  void setRadius(size_t radius)
+  {
+    m_radius = radius;
+  }
+
+  /// Get offset subtracted from the local mean.
+  ///
+  /// \return Offset
+  double offset() const
+  {
+    return m_offset;
+  }
+
+  /// Set offset subtracted from the local mean.
+  ///
+  /// \param[in] offset Offset
+  void setOffset(double offset)
+  {
+    m_offset = offset;
+  }
+
+  /// Get local mean method.
+  ///
+  /// \return Method
+  Method method() const
+  {
+    return m_method;
+  }
+
+  /// Set local mean method.
+  ///
+  /// \param[in] method Method
+  void setMethod(Method method)
+  {
+    m_method = method;
+  }
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<T, 1> &input, Image<T, 1> &output)
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    if (m_method == Method::Gaussian)
+    {
+      applyGaussian(input, output);
+    }
+    else
+    {
+      applyMean(input, output);
+    }
+    return true;
+  }
+
+protected:
+  /// Threshold by the mean of the window.
+  void applyMean(const Image<T, 1> &input, Image<T, 1> &output) const
+  {
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const std::array<T, 1> *in = input.imageDataPtr();
+    std::array<T, 1> *out = output.imageDataPtr();
+
+    IntegralImage<T> integral;
+    integral.compute(input);
+
+    // The integral image is complete before output is written; the output
+    // may be the input
+    const T newValue = std::numeric_limits<T>::max();
+    for (size_t y = 0; y < height; y++)
+    {
+      const size_t top = (y > m_radius ? y - m_radius : 0);
+      const size_t bottom = std::min(y + m_radius + 1, height);
+      const double rows = static_cast<double>(bottom - top);
+
+      for (size_t x = 0; x < width; x++)
+      {
+        const size_t left = (x > m_radius ? x - m_radius : 0);
+        const size_t right = std::min(x + m_radius + 1, width);
+        const typename IntegralImage<T>::Sum sum = integral.sum(left, top, right, bottom);
+        const double area = rows * static_cast<double>(right - left);
+
+        // value > sum / area - offset, without division
+        const double value = static_cast<double>(in[y * width + x][0]);
+        out[y * width + x][0] = ((value + m_offset) * area > static_cast<double>(sum) ? newValue : T(0));
+      }
+    }
+  }
+
+  /// Threshold by the Gaussian weighted mean of the window.
+  void applyGaussian(const Image<T, 1> &input, Image<T, 1> &output) const
+  {
+    const double sigma = 0.3 * (static_cast<double>(m_radius) - 1) + 0.8;
+    Image<T, 1> mean(input.width(), input.height());
+    GaussianBlur(sigma).apply(input, mean);
+
+    const size_t count = input.width() * input.height();
+    const std::array<T, 1> *in = input.imageDataPtr();
+    const std::array<T, 1> *local = mean.imageDataPtr();
+    std::array<T, 1> *out = output.imageDataPtr();
+    const T newValue = std::numeric_limits<T>::max();
+    for (size_t i = 0; i < count; i++)
+    {
+      const double value = static_cast<double>(in[i][0]);
+      out[i][0] = (value + m_offset > static_cast<double>(local[i][0]) ? newValue : T(0));
+    }
+  }
+
+  /// Radius of the window in pixels
+  size_t m_radius;
+
+  /// Offset subtracted from the local mean
+  double m_offset;
+
+  /// Local mean method
+  Method m_method;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_ADAPTIVETHRESHOLD_H
@@ -0,0 +1,263 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_AUTOTHRESHOLD_H
+#define SPATIUMLIB_IMGPROC_AUTOTHRESHOLD_H
+
+#include "IImageFilter.h"
+#include "GlobalThreshold.h"
+#include "Histogram.h"
+#include "spatium/ThreadPool.h"
+
+#include <cstddef> // size_t
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class AutoThreshold
+/// \brief Global threshold with automatic threshold selection
+///
+/// Binarizes an image like GlobalThreshold, with a threshold value selected
+/// from the histogram of the image. Pixels with a value above the threshold
+/// become white (maximum value), others black (0).
+///
+/// Two methods are available:
+///
+/// - Otsu: the threshold that maximizes the variance between the two
+///   classes of pixels (Otsu, 1979). Suited for bimodal histograms.
+/// - Triangle: the bin furthest below the line from the peak of the
+///   histogram to the end of its longest tail (Zack et al., 1977). Suited
+///   for a dominant background with few foreground pixels.
+///
+/// The histogram is computed in parallel if a thread pool is given.
+template<typename T>
+class AutoThreshold : public IImageFilter
+{
+public:
+  /// Threshold selection method
+  enum class Method
+  {
+    Otsu,    ///< Maximum between class variance
+    Triangle ///< Maximum distance to line from peak to tail
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] method Threshold selection method (default = Otsu)
+  /// \param[in] pool Thread pool for the histogram; nullptr to compute it on
+  /// the calling thread (default). Must outlive the filter.
+  AutoThreshold(Method method = Method::Otsu, ThreadPool *pool = nullptr)
+    : m_method(method)
+    , m_pool(pool)
+    , m_thresholdValue(0)
+  {}
+
+  virtual ~AutoThreshold() = default;
+
+  /// Get threshold selection method.
+  ///
+  /// \return Method
+  Method method() const
+  {
+    return m_method;
+  }
+
+  /// Set threshold selection method.
+  ///
+  /// \param[in] method Method
+  void setMethod(Method method)
+  {
+    m_method = method;
+  }
+
+  /// Get threshold value selected by the last apply().
+  ///
+  /// \return Threshold value
+  T thresholdValue() const
+  {
+    return m_thresholdValue;
+  }
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<T, 1> &input, Image<T, 1> &output)
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+
+    Histogram histogram;
+    if (m_pool != nullptr)
+    {
+      histogram.compute(input, *m_pool);
+    }
+    else
+    {
+      histogram.compute(input);
+    }
+
+    m_thresholdValue = static_cast<T>(m_method == Method::Triangle ? triangle(histogram) : otsu(histogram));
+
+    return GlobalThreshold<T>(m_thresholdValue).apply(input, output);
+  }
+
+  /// Select threshold by the method of Otsu.
+  ///
+  /// \param[in] histogram Histogram
+  /// \return Threshold; the greatest value of the lower class. The first
+  /// maximum if several thresholds are equally good. 0 for an empty
+  /// histogram.
+  static size_t otsu(const Histogram &histogram)
+  {
+    const std::vector<size_t> &counts = histogram.counts();
+
+    double total = 0;
+    double sum = 0;
+    for (size_t bin = 0; bin < counts.size(); bin++)
+    {
+      total += static_cast<double>(counts[bin]);
+      sum += static_cast<double>(bin) * static_cast<double>(counts[bin]);
+    }
+
+    // Between class variance (times total^2): w0 * w1 * (mean0 - mean1)^2
+    size_t threshold = 0;
+    double maxVariance = -1;
+    double weight0 = 0;
+    double sum0 = 0;
+    for (size_t bin = 0; bin < counts.size(); bin++)
+    {
+      weight0 += static_cast<double>(counts[bin]);
+      sum0 += static_cast<double>(bin) * static_cast<double>(counts[bin]);
+
+      const double weight1 = total - weight0;
+      if (weight0 == 0)
+      {
+        continue;
+      }
+      if (weight1 == 0)
+      {
+        break;
+      }
+
+      const double meanDifference = sum0 / weight0 - (sum - sum0) / weight1;
+      const double variance = weight0 * weight1 * meanDifference * meanDifference;
+      if (variance > maxVariance)
+      {
+        maxVariance = variance;
+        threshold = bin;
+      }
+    }
+
+    return threshold;
+  }
+
+  /// Select threshold by the triangle method.
+  ///
+  /// A line is drawn from the peak of the histogram to the first empty bin
+  /// beyond the end of the longest tail. The threshold is the bin where the
+  /// histogram lies furthest below this line. For a line of fixed slope the
+  /// distance is proportional to the vertical distance.
+  ///
+  /// \param[in] histogram Histogram
+  /// \return Threshold; the greatest value of the lower class. 0 for an
+  /// empty histogram.
+  static size_t triangle(const Histogram &histogram)
+  {
+    const std::vector<size_t> &counts = histogram.counts();
+
+    // First and last non-empty bins, and the peak
+    size_t first = counts.size();
+    size_t last = 0;
+    size_t peak = 0;
+    for (size_t bin = 0; bin < counts.size(); bin++)
+    {
+      if (counts[bin] > 0)
+      {
+        if (first == counts.size())
+        {
+          first = bin;
+        }
+        last = bin;
+      }
+      if (counts[bin] > counts[peak])
+      {
+        peak = bin;
+      }
+    }
+    if (first == counts.size())
+    {
+      return 0;
+    }
+
+    // End of the longest tail; one bin outside the histogram if possible
+    const bool tailLeft = (peak - first > last - peak);
+    size_t end;
+    if (tailLeft)
+    {
+      end = (first > 0 ? first - 1 : first);
+    }
+    else
+    {
+      end = (last + 1 < counts.size() ? last + 1 : last);
+    }
+    if (end == peak)
+    {
+      return peak;
+    }
+
+    const double peakCount = static_cast<double>(counts[peak]);
+    const double endCount = static_cast<double>(counts[end]);
+    const double length = (tailLeft ? static_cast<double>(peak - end) : static_cast<double>(end - peak));
+
+    size_t threshold = peak;
+    double maxDistance = 0;
+    const size_t begin = (tailLeft ? end : peak);
+    const size_t stop = (tailLeft ? peak : end);
+    for (size_t bin = begin; bin <= stop; bin++)
+    {
+      // Height of line above bin
+      const double fraction = (tailLeft ? static_cast<double>(bin - end) : static_cast<double>(end - bin)) / length;
+      const double distance = endCount + fraction * (peakCount - endCount) - static_cast<double>(counts[bin]);
+      if (distance > maxDistance)
+      {
+        maxDistance = distance;
+        threshold = bin;
+      }
+    }
+
+    return threshold;
+  }
+
+protected:
+  /// Threshold selection method
+  Method m_method;
+
+  /// Thread pool; nullptr for none
+  ThreadPool *m_pool;
+
+  /// Threshold value selected by the last apply()
+  T m_thresholdValue;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_AUTOTHRESHOLD_H
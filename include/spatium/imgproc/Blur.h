@@ -14,71 +14,367 @@
 #define SPATIUMLIB_IMGPROC_BLUR_H
 
 #include "IImageFilter.h"
+#include "Border.h"
+
+#include <algorithm> // std::min, std::max
+#include <cstddef> // std::ptrdiff_t
+#include <cstdint> // std::uint32_t, std::int64_t
+#include <limits> // std::numeric_limits
+#include <type_traits> // std::is_floating_point, std::is_unsigned
+#include <vector> // std::vector
 
 namespace spatium {
 namespace imgproc {
 
 /// \class Blur
+/// \brief Box blur (mean filter)
+///
+/// Each output pixel is the mean of the square window of
+/// (2 * radius + 1) x (2 * radius + 1) input pixels around it. Pixels outside
+/// the image are determined by a border policy (see Border.h); by default
+/// they are clamped to the nearest border pixel.
+///
+/// The filter is separable. A vertical pass keeps a running sum over the
+/// window rows for every column and a horizontal pass keeps a running sum
+/// over these column sums along the row. Each running sum is updated with
+/// one addition and one subtraction per pixel, so the cost is independent of
+/// the radius. Integer images are summed with integer accumulators (32-bit
+/// if the window sum cannot overflow). The vertical pass runs over whole rows
+/// of contiguous samples, which the compiler vectorizes. The border policy is
+/// only consulted for the window rows and columns that lie outside the image.
 class Blur
 {
 public:
-  Blur() = default;
+  /// Constructor
+  ///
+  /// \param[in] radius Window radius (default = 1; 3x3 window)
+  Blur(size_t radius = 1)
+    : m_radius(radius)
+  {
+  }
+
   virtual ~Blur() = default;
 
-  // Apply filter
-  template<typename T, int N>
-  bool apply(const Image<T, N> &input, Image<T, N> &output)
+  /// Get window radius.
+  ///
+  /// \return Window radius
+  size_t radius() const
+  {
+    return m_radius;
+  }
+
+  /// Set window radius.
+  ///
+  /// \param[in] radius Window radius
+  void setRadius(size_t radius)
+  {
+    m_radius = radius;
+  }
+
+  /// Apply filter.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input image
+  /// and should not be the input image itself.
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, int N, typename Border = BorderClamp>
+  bool apply(const Image<T, N> &input, Image<T, N> &output, const Border &border = Border())
   {
     if (input.width() != output.width() ||
-        input.height() != output.height())
+        input.height() != output.height() ||
+        &input == &output)
     {
       return false;
     }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    switch (accumulator<T>())
+    {
+    case Accumulator::UInt32:
+      boxFilter<std::uint32_t>(input, output, border);
+      break;
+    case Accumulator::Int64:
+      boxFilter<std::int64_t>(input, output, border);
+      break;
+    case Accumulator::Double:
+      boxFilter<double>(input, output, border);
+      break;
+    }
+
+    return true;
+  }
+
+protected:
+  /// Type of window sums
+  enum class Accumulator
+  {
+    UInt32,
+    Int64,
+    Double
+  };
+
+  /// Choose type of window sums for sample type T.
+  ///
+  /// The largest intermediate sum is a window of (2r+1)x(2r+1) samples plus
+  /// one more window row or column. 32-bit sums are kept below 2^31 for the
+  /// division in mean().
+  template<typename T>
+  Accumulator accumulator() const
+  {
+    const double maxSum = (2.0 * m_radius + 1) * (2.0 * m_radius + 2) * static_cast<double>(std::numeric_limits<T>::max());
+    if (std::is_floating_point<T>::value)
+    {
+      return Accumulator::Double;
+    }
+    else if (std::is_unsigned<T>::value && maxSum < 2147483648.0)
+    {
+      return Accumulator::UInt32;
+    }
+    return Accumulator::Int64;
+  }
 
-    // Iterate pixels
-    for (int y = 0; y < input.height(); y++)
+  /// Reciprocal of a divisor for exact division of 31-bit unsigned integers
+  /// by multiplication and shift (Granlund and Montgomery, 1994).
+  struct Reciprocal
+  {
+    /// Constructor
+    ///
+    /// \param[in] divisor Divisor; 1 to 2^31
+    explicit Reciprocal(std::uint32_t divisor)
+      : shift(31)
     {
-      for (int x = 0; x < input.width(); x++)
+      // shift = 31 + ceil(log2(divisor)), multiplier = ceil(2^shift / divisor)
+      while ((std::uint64_t(1) << (shift - 31)) < divisor)
       {
-        double divider = 1.0/9.0;
-        double sum[N] = {};
+        shift++;
+      }
+      multiplier = ((std::uint64_t(1) << shift) + divisor - 1) / divisor;
+    }
 
-        // Iterate window
-        for (int i = -1; i < 2; i++)
-        {
-          for (int j = -1; j < 2; j++)
-          {
-            // Clamp x and y
-            int dx = x+j;
-            int dy = y+i;
-            if (dx < 0) { dx = 0; } else if(dx == input.width()) { dx = input.width()-1; };
-            if (dy < 0) { dy = 0; } else if(dy == input.height()) { dy = input.height()-1; };
-
-            auto pixel = input.pixel(dx, dy);
-            for (int c = 0; c < N; c++)
-            {
-              sum[c] += divider * pixel[c];
-            }
-          }
-        }
+    /// Quotient of division by the divisor.
+    ///
+    /// \param[in] dividend Dividend; less than 2^31
+    /// \return Quotient, rounded down
+    std::uint32_t divide(std::uint32_t dividend) const
+    {
+      return static_cast<std::uint32_t>((dividend * multiplier) >> shift);
+    }
+
+    std::uint64_t multiplier;
+    unsigned int shift;
+  };
+
+  /// Box filter with accumulator type Acc.
+  template<typename Acc, typename T, int N, typename Border>
+  void boxFilter(const Image<T, N> &input, Image<T, N> &output, const Border &border) const
+  {
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const size_t rowSize = width * N;
+    const size_t r = m_radius;
+    const Acc area = static_cast<Acc>((2 * r + 1) * (2 * r + 1));
+    const Reciprocal reciprocal(static_cast<std::uint32_t>(std::min<size_t>((2 * r + 1) * (2 * r + 1), 0x80000000u)));
+    const T *in = reinterpret_cast<const T*>(input.imageDataPtr());
+    T *out = reinterpret_cast<T*>(output.imageDataPtr());
+
+    // Rows to filter; all but those of which the window extends outside the
+    // image if the border is skipped
+    size_t rowBegin = 0;
+    size_t rowEnd = height;
+    if (!Border::filtersBorder)
+    {
+      rowBegin = std::min(r, height);
+      rowEnd = std::max(rowBegin, height > r ? height - r : 0);
+    }
+    if (rowBegin >= rowEnd)
+    {
+      return;
+    }
+
+    // Row and column sums outside the image; constant border only
+    const T value = borderValue<T>(border);
+    const std::vector<T> outsideRow(rowSize, value);
+    Acc outsideColumn[N];
+    for (int c = 0; c < N; c++)
+    {
+      outsideColumn[c] = static_cast<Acc>(2 * r + 1) * static_cast<Acc>(value);
+    }
+
+    // Column sums of the window of the first row
+    std::vector<Acc> columnSums(rowSize, 0);
+    for (size_t k = 0; k <= 2 * r; k++)
+    {
+      const T *row = borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(rowBegin + k) - static_cast<std::ptrdiff_t>(r), height, rowSize, border);
+      for (size_t i = 0; i < rowSize; i++)
+      {
+        columnSums[i] += static_cast<Acc>(row[i]);
+      }
+    }
 
-        // Cast to T
-        std::array<T,N> value;
-        for (int c = 0; c < N; c++)
+    for (size_t y = rowBegin; y < rowEnd; y++)
+    {
+      // Horizontal pass over the column sums
+      filterRow<Acc, T, N>(columnSums.data(), width, area, reciprocal, out + y * rowSize, border, outsideColumn);
+
+      // Vertical pass: slide window one row down. Unsigned accumulators may
+      // wrap in between; the resulting sums are exact.
+      if (y + 1 < rowEnd)
+      {
+        const T *addRow = borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(y + r + 1), height, rowSize, border);
+        const T *subRow = borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(y) - static_cast<std::ptrdiff_t>(r), height, rowSize, border);
+        for (size_t i = 0; i < rowSize; i++)
         {
-          value[c] = sum[c]; /// \todo cast
+          columnSums[i] += static_cast<Acc>(addRow[i]) - static_cast<Acc>(subRow[i]);
         }
+      }
+    }
+  }
 
-        output.pixel(x, y) = value;
+  /// Row of the input image or outside the image.
+  ///
+  /// \param[in] in Input image data
+  /// \param[in] outsideRow Row of constant values
+  /// \param[in] y Row index; may be outside the image
+  /// \param[in] height Image height
+  /// \param[in] rowSize Number of samples per row
+  /// \param[in] border Border policy
+  /// \return Row
+  template<typename T, typename Border>
+  static const T *borderRow(const T *in, const T *outsideRow, std::ptrdiff_t y, size_t height, size_t rowSize, const Border &border)
+  {
+    size_t index;
+    return (border.index(y, height, index) ? in + index * rowSize : outsideRow);
+  }
+
+  /// Horizontal running sum over the column sums of a row; clamped border.
+  template<typename Acc, typename T, int N>
+  void filterRow(const Acc *columnSums, size_t width, Acc area, const Reciprocal &reciprocal, T *out) const
+  {
+    filterRow<Acc, T, N>(columnSums, width, area, reciprocal, out, BorderClamp(), columnSums);
+  }
+
+  /// Horizontal running sum over the column sums of a row.
+  ///
+  /// The window only slides over columns outside the image near the border.
+  /// These are looked up by the border policy; the interior is summed
+  /// directly.
+  ///
+  /// \param[in] columnSums Column sums; width * N values
+  /// \param[in] width Image width
+  /// \param[in] area Number of pixels in window
+  /// \param[in] reciprocal Reciprocal of area
+  /// \param[out] out Output row
+  /// \param[in] border Border policy
+  /// \param[in] outsideColumn Column sums outside the image; N values
+  template<typename Acc, typename T, int N, typename Border>
+  void filterRow(const Acc *columnSums, size_t width, Acc area, const Reciprocal &reciprocal, T *out,
+                 const Border &border, const Acc *outsideColumn) const
+  {
+    const std::ptrdiff_t r = static_cast<std::ptrdiff_t>(m_radius);
+    const std::ptrdiff_t w = static_cast<std::ptrdiff_t>(width);
+
+    // Pixels to filter; see boxFilter()
+    std::ptrdiff_t begin = 0;
+    std::ptrdiff_t end = w;
+    if (!Border::filtersBorder)
+    {
+      begin = std::min(r, w);
+      end = std::max(begin, w - r);
+    }
+    if (begin >= end)
+    {
+      return;
+    }
+
+    // Window sum of the first pixel
+    Acc sums[N];
+    for (int c = 0; c < N; c++)
+    {
+      sums[c] = 0;
+    }
+    for (std::ptrdiff_t k = begin - r; k <= begin + r; k++)
+    {
+      const Acc *column = borderColumn<Acc, N>(columnSums, outsideColumn, k, width, border);
+      for (int c = 0; c < N; c++)
+      {
+        sums[c] += column[c];
       }
     }
 
-    return true;
+    // Window slides over columns inside the image for x in [r, w - r - 1)
+    const std::ptrdiff_t interiorBegin = std::min(std::max(begin, r), end);
+    const std::ptrdiff_t interiorEnd = std::max(interiorBegin, std::min(end, w - r - 1));
+    std::ptrdiff_t x = begin;
+    for (; x < interiorBegin; x++)
+    {
+      slide<Acc, T, N>(sums, area, reciprocal, out + x * N,
+                       borderColumn<Acc, N>(columnSums, outsideColumn, x + r + 1, width, border),
+                       borderColumn<Acc, N>(columnSums, outsideColumn, x - r, width, border));
+    }
+    for (; x < interiorEnd; x++)
+    {
+      slide<Acc, T, N>(sums, area, reciprocal, out + x * N,
+                       columnSums + (x + r + 1) * N,
+                       columnSums + (x - r) * N);
+    }
+    for (; x < end; x++)
+    {
+      slide<Acc, T, N>(sums, area, reciprocal, out + x * N,
+                       borderColumn<Acc, N>(columnSums, outsideColumn, x + r + 1, width, border),
+                       borderColumn<Acc, N>(columnSums, outsideColumn, x - r, width, border));
+    }
+  }
+
+  /// Output the mean of a window and slide the window one pixel to the
+  /// right.
+  template<typename Acc, typename T, int N>
+  static void slide(Acc *sums, Acc area, const Reciprocal &reciprocal, T *out, const Acc *addColumn, const Acc *subColumn)
+  {
+    for (int c = 0; c < N; c++)
+    {
+      out[c] = mean<T>(sums[c], area, reciprocal);
+      sums[c] += addColumn[c] - subColumn[c];
+    }
+  }
+
+  /// Column sums inside or outside the image.
+  template<typename Acc, int N, typename Border>
+  static const Acc *borderColumn(const Acc *columnSums, const Acc *outsideColumn, std::ptrdiff_t x, size_t width, const Border &border)
+  {
+    size_t index;
+    return (border.index(x, width, index) ? columnSums + index * N : outsideColumn);
+  }
+
+  /// Mean of a window, rounded to nearest.
+  template<typename T>
+  static T mean(std::uint32_t sum, std::uint32_t area, const Reciprocal &reciprocal)
+  {
+    return static_cast<T>(reciprocal.divide(sum + area / 2));
+  }
+
+  /// Mean of a window, rounded to nearest.
+  template<typename T>
+  static T mean(std::int64_t sum, std::int64_t area, const Reciprocal &)
+  {
+    return static_cast<T>(sum >= 0 ? (sum + area / 2) / area : -((area / 2 - sum) / area));
+  }
+
+  /// Mean of a window.
+  template<typename T>
+  static T mean(double sum, double area, const Reciprocal &)
+  {
+    return static_cast<T>(sum / area);
   }
+
+  /// Window radius
+  size_t m_radius;
 };
 
 } // namespace imgproc
 } // namespace spatium
 
 #endif // SPATIUMLIB_IMGPROC_BLUR_H
-
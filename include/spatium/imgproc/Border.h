@@ -0,0 +1,193 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_BORDER_H
+#define SPATIUMLIB_IMGPROC_BORDER_H
+
+#include <cmath> // std::floor
+#include <cstddef> // size_t, std::ptrdiff_t
+#include <limits> // std::numeric_limits
+#include <type_traits> // std::is_floating_point
+
+namespace spatium {
+namespace imgproc {
+
+// Border policies of neighborhood filters.
+//
+// A neighborhood filter reads pixels outside the image near the border. The
+// border policy, a template parameter of the filter, decides which pixels
+// these are. Filters only consult the policy for the thin strips along the
+// border; the interior of the image is filtered without it.
+//
+// A policy provides:
+// - index(i, n, index): map coordinate i, which may lie outside [0, n), to
+//   an image coordinate. Returns false if the pixel has value value().
+// - value(): value of pixels outside the image, if index() returns false.
+// - filtersBorder: false if pixels of which the neighborhood extends outside
+//   the image are not filtered; their output is left unchanged.
+//
+// Example (row abcd, 2 pixels outside on both sides):
+//   BorderClamp:    aa|abcd|dd
+//   BorderReflect:  cb|abcd|cb
+//   BorderWrap:     cd|abcd|ab
+//   BorderConstant: vv|abcd|vv
+
+/// \class BorderClamp
+/// \brief Pixels outside the image are clamped to the nearest border pixel.
+struct BorderClamp
+{
+  static const bool filtersBorder = true;
+
+  bool index(std::ptrdiff_t i, size_t n, size_t &index) const
+  {
+    index = (i < 0 ? 0 : (static_cast<size_t>(i) >= n ? n - 1 : static_cast<size_t>(i)));
+    return true;
+  }
+
+  double value() const
+  {
+    return 0;
+  }
+};
+
+/// \class BorderReflect
+/// \brief Pixels outside the image are mirrored at the border pixel, which
+/// itself is not repeated.
+struct BorderReflect
+{
+  static const bool filtersBorder = true;
+
+  bool index(std::ptrdiff_t i, size_t n, size_t &index) const
+  {
+    if (n == 1)
+    {
+      index = 0;
+      return true;
+    }
+
+    // Reflection is periodic with period 2n - 2
+    const std::ptrdiff_t period = 2 * static_cast<std::ptrdiff_t>(n) - 2;
+    i = (i < 0 ? -i : i) % period;
+    index = static_cast<size_t>(i < static_cast<std::ptrdiff_t>(n) ? i : period - i);
+    return true;
+  }
+
+  double value() const
+  {
+    return 0;
+  }
+};
+
+/// \class BorderWrap
+/// \brief Pixels outside the image wrap around to the opposite border.
+struct BorderWrap
+{
+  static const bool filtersBorder = true;
+
+  bool index(std::ptrdiff_t i, size_t n, size_t &index) const
+  {
+    const std::ptrdiff_t m = static_cast<std::ptrdiff_t>(n);
+    index = static_cast<size_t>(((i % m) + m) % m);
+    return true;
+  }
+
+  double value() const
+  {
+    return 0;
+  }
+};
+
+/// \class BorderConstant
+/// \brief Pixels outside the image have a constant value.
+struct BorderConstant
+{
+  static const bool filtersBorder = true;
+
+  /// Constructor
+  ///
+  /// \param[in] value Value of pixels outside the image (default = 0)
+  explicit BorderConstant(double value = 0)
+    : m_value(value)
+  {
+  }
+
+  bool index(std::ptrdiff_t i, size_t n, size_t &index) const
+  {
+    if (i < 0 || static_cast<size_t>(i) >= n)
+    {
+      return false;
+    }
+    index = static_cast<size_t>(i);
+    return true;
+  }
+
+  double value() const
+  {
+    return m_value;
+  }
+
+protected:
+  double m_value;
+};
+
+/// \class BorderSkip
+/// \brief Pixels of which the neighborhood extends outside the image are not
+/// filtered.
+struct BorderSkip
+{
+  static const bool filtersBorder = false;
+
+  bool index(std::ptrdiff_t i, size_t n, size_t &index) const
+  {
+    return BorderClamp().index(i, n, index);
+  }
+
+  double value() const
+  {
+    return 0;
+  }
+};
+
+/// Value of pixels outside the image as a sample of type T.
+///
+/// For integer samples the value is rounded to nearest and saturated to the
+/// range of T; e.g. BorderConstant(-1) gives 0 for unsigned char.
+///
+/// \param[in] border Border policy
+/// \return Value of pixels outside the image
+template<typename T, typename Border>
+T borderValue(const Border &border)
+{
+  const double value = border.value();
+  if (std::is_floating_point<T>::value)
+  {
+    return static_cast<T>(value);
+  }
+
+  // Compare in double before casting; the maximum of a 64-bit type rounds
+  // up to a power of two, which is out of range itself
+  const double rounded = std::floor(value + 0.5);
+  if (!(rounded > static_cast<double>(std::numeric_limits<T>::lowest())))
+  {
+    return std::numeric_limits<T>::lowest();
+  }
+  if (rounded >= static_cast<double>(std::numeric_limits<T>::max()))
+  {
+    return std::numeric_limits<T>::max();
+  }
+  return static_cast<T>(rounded);
+}
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_BORDER_H
@@ -0,0 +1,475 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_CANNY_H
+#define SPATIUMLIB_IMGPROC_CANNY_H
+
+#include "IImageFilter.h"
+#include "GaussianBlur.h"
+#include "Sobel.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::floor
+#include <cstddef> // size_t, std::ptrdiff_t
+#include <cstdlib> // std::abs
+#include <limits> // std::numeric_limits
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class Canny
+/// \brief Canny edge detector for 8-bit images
+///
+/// Detects edges of one pixel wide in four steps (Canny, 1986):
+///
+/// 1. Gaussian blur to suppress noise (optional; see GaussianBlur).
+/// 2. Gradient and quantized gradient orientation by Sobel.
+/// 3. Non-maximum suppression: pixels whose gradient magnitude is not
+///    greater than that of both neighbours along the gradient orientation
+///    are removed. On plateaus the first pixel along the orientation is kept.
+/// 4. Double threshold with hysteresis: pixels with a magnitude above the
+///    high threshold are edges, as are pixels above the low threshold that
+///    are 8-connected to edges through such pixels. Edges are traced with an
+///    explicit stack, not by recursion.
+///
+/// Edge pixels become white (255), others black (0). Magnitudes are not
+/// saturated: up to 2040 for the L1 norm and 1443 for the L2 norm.
+///
+/// Buffers are kept by the filter and are only reallocated when the image
+/// size changes. With a thread pool, steps 2 to 4 are executed on bands of
+/// rows in parallel: edges are traced within the bands first, then across
+/// band borders. The result equals that on a single thread.
+///
+/// Example:
+/// \code
+/// Canny canny(50, 100);
+/// canny.apply(imageGray, edges);
+/// \endcode
+class Canny : public IImageFilter
+{
+public:
+  /// Constructor
+  ///
+  /// \param[in] lowThreshold Low threshold of the gradient magnitude
+  /// (default = 50)
+  /// \param[in] highThreshold High threshold of the gradient magnitude
+  /// (default = 100)
+  /// \param[in] sigma Standard deviation of the Gaussian blur in pixels; 0
+  /// for no blur (default = 1)
+  /// \param[in] norm Norm of the gradient magnitude (default = L2)
+  Canny(double lowThreshold = 50, double highThreshold = 100, double sigma = 1, Sobel::Norm norm = Sobel::Norm::L2)
+    : m_lowThreshold(lowThreshold)
+    , m_highThreshold(highThreshold)
+    , m_sigma(sigma)
+    , m_sobel(norm)
+    , m_width(0)
+    , m_height(0)
+    , m_blurred()
+    , m_gradientX()
+    , m_gradientY()
+    , m_orientation()
+    , m_magnitude()
+    , m_stacks()
+  {
+  }
+
+  virtual ~Canny() = default;
+
+  /// Get low threshold of the gradient magnitude.
+  ///
+  /// \return Low threshold
+  double lowThreshold() const
+  {
+    return m_lowThreshold;
+  }
+
+  /// Get high threshold of the gradient magnitude.
+  ///
+  /// \return High threshold
+  double highThreshold() const
+  {
+    return m_highThreshold;
+  }
+
+  /// Set thresholds of the gradient magnitude.
+  ///
+  /// \param[in] lowThreshold Low threshold
+  /// \param[in] highThreshold High threshold; not less than the low
+  /// threshold
+  void setThresholds(double lowThreshold, double highThreshold)
+  {
+    m_lowThreshold = lowThreshold;
+    m_highThreshold = highThreshold;
+  }
+
+  /// Get standard deviation of the Gaussian blur.
+  ///
+  /// \return Standard deviation in pixels; 0 for no blur
+  double sigma() const
+  {
+    return m_sigma;
+  }
+
+  /// Set standard deviation of the Gaussian blur.
+  ///
+  /// \param[in] sigma Standard deviation in pixels; 0 for no blur
+  void setSigma(double sigma)
+  {
+    m_sigma = sigma;
+  }
+
+  /// Get norm of the gradient magnitude.
+  ///
+  /// \return Norm
+  Sobel::Norm norm() const
+  {
+    return m_sobel.norm();
+  }
+
+  /// Set norm of the gradient magnitude.
+  ///
+  /// \param[in] norm Norm
+  void setNorm(Sobel::Norm norm)
+  {
+    m_sobel.setNorm(norm);
+  }
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Edges. Should have the size of the input image.
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<unsigned char, 1> &input, Image<unsigned char, 1> &output)
+  {
+    return detect(input, output, nullptr);
+  }
+
+  /// Apply filter on bands of rows in parallel.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Edges. Should have the size of the input image.
+  /// \param[in] pool Thread pool
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<unsigned char, 1> &input, Image<unsigned char, 1> &output, ThreadPool &pool)
+  {
+    return detect(input, output, &pool);
+  }
+
+protected:
+  /// Labels of output pixels during detection
+  enum Label
+  {
+    NoEdge = 0,      ///< Suppressed or below the low threshold
+    WeakEdge = 1,    ///< Above the low threshold; not (yet) connected to an edge
+    StrongEdge = 255 ///< Edge
+  };
+
+  /// Detect edges; in parallel if a thread pool is given.
+  bool detect(const Image<unsigned char, 1> &input, Image<unsigned char, 1> &output, ThreadPool *pool)
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const size_t threads = (pool != nullptr ? pool->threadCount() : 1);
+    allocate(width, height, threads);
+
+    // The input is read completely by the gradient step, before output is
+    // written; the output may be the input
+    const Image<unsigned char, 1> *source = &input;
+    if (m_sigma > 0)
+    {
+      if (m_blurred.width() != width || m_blurred.height() != height)
+      {
+        m_blurred = Image<unsigned char, 1>(width, height);
+      }
+      GaussianBlur(m_sigma).apply(input, m_blurred);
+      source = &m_blurred;
+    }
+
+    // About 4 bands per thread; a single band without thread pool
+    const size_t bandHeight = (pool != nullptr ? std::max<size_t>(16, height / (4 * threads) + 1) : height);
+    const size_t bandCount = (height + bandHeight - 1) / bandHeight;
+
+    // Gradients
+    runBands(pool, bandCount, [&](size_t band, size_t) {
+      const size_t firstRow = band * bandHeight;
+      const size_t lastRow = std::min(firstRow + bandHeight, height);
+      m_sobel.apply(*source, nullptr, &m_gradientX, &m_gradientY, &m_orientation, firstRow, lastRow);
+      computeMagnitude(firstRow * width, lastRow * width);
+    });
+
+    // Non-maximum suppression and hysteresis within bands
+    const int low = magnitudeThreshold(m_lowThreshold);
+    const int high = magnitudeThreshold(m_highThreshold);
+    unsigned char *out = reinterpret_cast<unsigned char*>(output.imageDataPtr());
+    runBands(pool, bandCount, [&](size_t band, size_t thread) {
+      const size_t firstRow = band * bandHeight;
+      const size_t lastRow = std::min(firstRow + bandHeight, height);
+      std::vector<size_t> &stack = m_stacks[thread];
+      suppress(out, firstRow, lastRow, low, high, stack);
+      trace(out, firstRow, lastRow, stack);
+    });
+
+    // Hysteresis across band borders, from the edges on both sides
+    if (bandCount > 1)
+    {
+      std::vector<size_t> &stack = m_stacks[0];
+      for (size_t band = 1; band < bandCount; band++)
+      {
+        const size_t begin = (band * bandHeight - 1) * width;
+        for (size_t i = begin; i < begin + 2 * width; i++)
+        {
+          if (out[i] == StrongEdge)
+          {
+            stack.push_back(i);
+          }
+        }
+      }
+      trace(out, 0, height, stack);
+    }
+
+    // Remove weak edges not connected to edges
+    runBands(pool, bandCount, [&](size_t band, size_t) {
+      const size_t end = std::min((band + 1) * bandHeight, height) * width;
+      for (size_t i = band * bandHeight * width; i < end; i++)
+      {
+        out[i] = (out[i] == StrongEdge ? StrongEdge : NoEdge);
+      }
+    });
+
+    return true;
+  }
+
+  /// Allocate buffers for an image size, unless already allocated.
+  void allocate(size_t width, size_t height, size_t threads)
+  {
+    if (width != m_width || height != m_height)
+    {
+      m_width = width;
+      m_height = height;
+      m_gradientX = Image<short, 1>(width, height);
+      m_gradientY = Image<short, 1>(width, height);
+      m_orientation = Image<unsigned char, 1>(width, height);
+      m_magnitude.assign(width * height, 0);
+    }
+    if (m_stacks.size() < threads)
+    {
+      m_stacks.resize(threads);
+    }
+  }
+
+  /// Run a task per band; on the thread pool if given.
+  static void runBands(ThreadPool *pool, size_t bandCount, const ThreadPool::Task &task)
+  {
+    if (pool != nullptr)
+    {
+      pool->run(bandCount, task);
+    }
+    else
+    {
+      for (size_t band = 0; band < bandCount; band++)
+      {
+        task(band, 0);
+      }
+    }
+  }
+
+  /// Threshold of the integer magnitudes computeMagnitude() produces.
+  ///
+  /// An integer magnitude exceeds a threshold if it exceeds its floor.
+  int magnitudeThreshold(double threshold) const
+  {
+    if (threshold < 0)
+    {
+      return -1;
+    }
+    const double value = (m_sobel.norm() == Sobel::Norm::L2 ? threshold * threshold : threshold);
+    return static_cast<int>(std::min(std::floor(value), static_cast<double>(std::numeric_limits<int>::max())));
+  }
+
+  /// Compute gradient magnitudes of pixels begin .. end-1: |Gx| + |Gy| for
+  /// the L1 norm, Gx^2 + Gy^2 (squared magnitude) for the L2 norm.
+  void computeMagnitude(size_t begin, size_t end)
+  {
+    const short *gradientX = reinterpret_cast<const short*>(m_gradientX.imageDataPtr());
+    const short *gradientY = reinterpret_cast<const short*>(m_gradientY.imageDataPtr());
+    int *magnitude = m_magnitude.data();
+    if (m_sobel.norm() == Sobel::Norm::L1)
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        magnitude[i] = std::abs(gradientX[i]) + std::abs(gradientY[i]);
+      }
+    }
+    else
+    {
+      for (size_t i = begin; i < end; i++)
+      {
+        magnitude[i] = gradientX[i] * gradientX[i] + gradientY[i] * gradientY[i];
+      }
+    }
+  }
+
+  /// Non-maximum suppression and double threshold of rows firstRow ..
+  /// lastRow-1. Edges are pushed on the stack.
+  void suppress(unsigned char *out, size_t firstRow, size_t lastRow, int low, int high, std::vector<size_t> &stack) const
+  {
+    const size_t width = m_width;
+    const int *magnitude = m_magnitude.data();
+    const unsigned char *orientation = reinterpret_cast<const unsigned char*>(m_orientation.imageDataPtr());
+
+    // Neighbour along the gradient per orientation; see Sobel::Orientation
+    const std::ptrdiff_t w = static_cast<std::ptrdiff_t>(width);
+    const std::ptrdiff_t offsets[4] = { 1, w + 1, w, 1 - w };
+    const int dx[4] = { 1, 1, 0, 1 };
+    const int dy[4] = { 0, 1, 1, -1 };
+
+    for (size_t y = firstRow; y < lastRow; y++)
+    {
+      const bool borderRow = (y == 0 || y + 1 == m_height);
+      for (size_t x = 0; x < width; x++)
+      {
+        const size_t i = y * width + x;
+        const int m = magnitude[i];
+        unsigned char label = NoEdge;
+        if (m > low)
+        {
+          const unsigned char o = orientation[i];
+          int before;
+          int after;
+          if (borderRow || x == 0 || x + 1 == width)
+          {
+            // Magnitude outside the image is 0
+            before = magnitudeAt(static_cast<std::ptrdiff_t>(x) - dx[o], static_cast<std::ptrdiff_t>(y) - dy[o]);
+            after = magnitudeAt(static_cast<std::ptrdiff_t>(x) + dx[o], static_cast<std::ptrdiff_t>(y) + dy[o]);
+          }
+          else
+          {
+            before = magnitude[i - offsets[o]];
+            after = magnitude[i + offsets[o]];
+          }
+
+          if (m > before && m >= after)
+          {
+            if (m > high)
+            {
+              label = StrongEdge;
+              stack.push_back(i);
+            }
+            else
+            {
+              label = WeakEdge;
+            }
+          }
+        }
+        out[i] = label;
+      }
+    }
+  }
+
+  /// Magnitude of a pixel; 0 outside the image.
+  int magnitudeAt(std::ptrdiff_t x, std::ptrdiff_t y) const
+  {
+    if (x < 0 || y < 0 || x >= static_cast<std::ptrdiff_t>(m_width) || y >= static_cast<std::ptrdiff_t>(m_height))
+    {
+      return 0;
+    }
+    return m_magnitude[static_cast<size_t>(y) * m_width + static_cast<size_t>(x)];
+  }
+
+  /// Mark weak edges connected to the edges on the stack, within rows
+  /// firstRow .. lastRow-1. Empties the stack.
+  void trace(unsigned char *out, size_t firstRow, size_t lastRow, std::vector<size_t> &stack) const
+  {
+    const size_t width = m_width;
+    while (!stack.empty())
+    {
+      const size_t i = stack.back();
+      stack.pop_back();
+
+      const size_t x = i % width;
+      const size_t y = i / width;
+      const size_t top = std::max(y, firstRow + 1) - 1;
+      const size_t bottom = std::min(y + 1, lastRow - 1);
+      const size_t left = (x > 0 ? x - 1 : 0);
+      const size_t right = std::min(x + 1, width - 1);
+      for (size_t v = top; v <= bottom; v++)
+      {
+        for (size_t u = left; u <= right; u++)
+        {
+          const size_t j = v * width + u;
+          if (out[j] == WeakEdge)
+          {
+            out[j] = StrongEdge;
+            stack.push_back(j);
+          }
+        }
+      }
+    }
+  }
+
+  /// Low threshold of the gradient magnitude
+  double m_lowThreshold;
+
+  /// High threshold of the gradient magnitude
+  double m_highThreshold;
+
+  /// Standard deviation of the Gaussian blur; 0 for none
+  double m_sigma;
+
+  /// Gradient filter
+  Sobel m_sobel;
+
+  /// Width of the allocated buffers
+  size_t m_width;
+
+  /// Height of the allocated buffers
+  size_t m_height;
+
+  /// Blurred input image; allocated if blurred
+  Image<unsigned char, 1> m_blurred;
+
+  /// Gradient Gx
+  Image<short, 1> m_gradientX;
+
+  /// Gradient Gy
+  Image<short, 1> m_gradientY;
+
+  /// Quantized gradient orientation
+  Image<unsigned char, 1> m_orientation;
+
+  /// Gradient magnitude; squared for the L2 norm
+  std::vector<int> m_magnitude;
+
+  /// Stack of edges to trace per thread
+  std::vector<std::vector<size_t>> m_stacks;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_CANNY_H
@@ -0,0 +1,366 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_CLAHE_H
+#define SPATIUMLIB_IMGPROC_CLAHE_H
+
+#include "IImageFilter.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::fill, std::max, std::min
+#include <array> // std::array
+#include <cstddef> // size_t
+#include <cstdint> // std::uint32_t
+#include <limits> // std::numeric_limits
+#include <type_traits> // std::is_integral, std::is_unsigned
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class Clahe
+/// \brief Contrast limited adaptive histogram equalization
+///
+/// Equalizes the histogram of an image with 8 or 16 bit unsigned integer
+/// values locally, per channel (Zuiderveld, 1994). The image is divided into
+/// a grid of tiles. Every tile gets a lookup table that equalizes its
+/// histogram; each output pixel interpolates bilinearly between the tables
+/// of the four tiles of which the centers surround it. Near the border of
+/// the image fewer tiles are interpolated.
+///
+/// To limit the amplification of noise in uniform regions, histogram bins
+/// are clipped at the clip limit times the mean bin count of a tile (but at
+/// least 1); the clipped pixels are redistributed over all bins. A clip
+/// limit of 0 disables clipping.
+///
+/// The lookup table of a tile maps value v to cdf(v) / area * maximum value,
+/// rounded to nearest, where cdf is the cumulative clipped histogram.
+///
+/// With a thread pool, the lookup tables are built per tile and the pixels
+/// are mapped on bands of rows in parallel.
+///
+/// Example:
+/// \code
+/// Clahe clahe(2.0, 8, 8);
+/// clahe.apply(image, image);
+/// \endcode
+class Clahe : public IImageFilter
+{
+public:
+  /// Constructor
+  ///
+  /// \param[in] clipLimit Clip limit, relative to the mean bin count
+  /// (default = 2)
+  /// \param[in] tilesX Number of tiles in horizontal direction (default = 8)
+  /// \param[in] tilesY Number of tiles in vertical direction (default = 8)
+  Clahe(double clipLimit = 2, size_t tilesX = 8, size_t tilesY = 8)
+    : m_clipLimit(clipLimit)
+    , m_tilesX(tilesX)
+    , m_tilesY(tilesY)
+  {
+  }
+
+  virtual ~Clahe() = default;
+
+  /// Get clip limit.
+  ///
+  /// \return Clip limit, relative to the mean bin count
+  double clipLimit() const
+  {
+    return m_clipLimit;
+  }
+
+  /// Set clip limit.
+  ///
+  /// \param[in] clipLimit Clip limit, relative to the mean bin count; 0 to
+  /// disable clipping
+  void setClipLimit(double clipLimit)
+  {
+    m_clipLimit = clipLimit;
+  }
+
+  /// Get number of tiles in horizontal direction.
+  ///
+  /// \return Number of tiles
+  size_t tilesX() const
+  {
+    return m_tilesX;
+  }
+
+  /// Get number of tiles in vertical direction.
+  ///
+  /// \return Number of tiles
+  size_t tilesY() const
+  {
+    return m_tilesY;
+  }
+
+  /// Set number of tiles.
+  ///
+  /// The number of tiles is limited to the image size.
+  ///
+  /// \param[in] tilesX Number of tiles in horizontal direction
+  /// \param[in] tilesY Number of tiles in vertical direction
+  void setTiles(size_t tilesX, size_t tilesY)
+  {
+    m_tilesX = tilesX;
+    m_tilesY = tilesY;
+  }
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, int N>
+  bool apply(const Image<T, N> &input, Image<T, N> &output) const
+  {
+    return equalize(input, output, nullptr);
+  }
+
+  /// Apply filter in parallel.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \param[in] pool Thread pool
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, int N>
+  bool apply(const Image<T, N> &input, Image<T, N> &output, ThreadPool &pool) const
+  {
+    return equalize(input, output, &pool);
+  }
+
+protected:
+  /// Interpolation between the tiles along one axis at a pixel coordinate
+  struct Interpolation
+  {
+    /// Tile before and tile after the coordinate; equal near the border
+    size_t before;
+    size_t after;
+
+    /// Weight of the tile after
+    float weight;
+  };
+
+  /// Equalize; in parallel if a thread pool is given.
+  template<typename T, int N>
+  bool equalize(const Image<T, N> &input, Image<T, N> &output, ThreadPool *pool) const
+  {
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value && sizeof(T) <= 2,
+                  "Clahe requires 8 or 16 bit unsigned integer pixels");
+
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const size_t tilesX = std::max<size_t>(1, std::min(m_tilesX, width));
+    const size_t tilesY = std::max<size_t>(1, std::min(m_tilesY, height));
+    const size_t bins = static_cast<size_t>(std::numeric_limits<T>::max()) + 1;
+    const std::array<T, N> *in = input.imageDataPtr();
+    std::array<T, N> *out = output.imageDataPtr();
+
+    // Lookup table per tile and channel: tables[((ty * tilesX + tx) * N + c) * bins + value]
+    std::vector<T> tables(tilesX * tilesY * N * bins);
+    runTasks(pool, tilesX * tilesY, [&](size_t tile, size_t) {
+      const size_t tx = tile % tilesX;
+      const size_t ty = tile / tilesX;
+      std::vector<std::uint32_t> histogram(bins);
+      for (int c = 0; c < N; c++)
+      {
+        std::fill(histogram.begin(), histogram.end(), 0);
+        const size_t left = tileStart(tx, tilesX, width);
+        const size_t right = tileStart(tx + 1, tilesX, width);
+        const size_t top = tileStart(ty, tilesY, height);
+        const size_t bottom = tileStart(ty + 1, tilesY, height);
+        for (size_t y = top; y < bottom; y++)
+        {
+          const std::array<T, N> *row = in + y * width;
+          for (size_t x = left; x < right; x++)
+          {
+            histogram[row[x][c]]++;
+          }
+        }
+        buildTable((right - left) * (bottom - top), histogram, &tables[(tile * N + c) * bins]);
+      }
+    });
+
+    // Interpolation per column and per row
+    std::vector<Interpolation> columns(width);
+    std::vector<Interpolation> rows(height);
+    interpolation(tilesX, columns);
+    interpolation(tilesY, rows);
+
+    // All tables are built before the first pixel is written, so the output
+    // may be the input
+    const size_t bandHeight = (pool != nullptr ? std::max<size_t>(16, height / (4 * pool->threadCount()) + 1) : height);
+    runTasks(pool, (height + bandHeight - 1) / bandHeight, [&](size_t band, size_t) {
+      for (size_t y = band * bandHeight; y < std::min((band + 1) * bandHeight, height); y++)
+      {
+        const Interpolation &row = rows[y];
+        const T *above = &tables[row.before * tilesX * N * bins];
+        const T *below = &tables[row.after * tilesX * N * bins];
+        const float wy = row.weight;
+        const std::array<T, N> *source = in + y * width;
+        std::array<T, N> *target = out + y * width;
+        for (size_t x = 0; x < width; x++)
+        {
+          const Interpolation &column = columns[x];
+          const size_t before = column.before * N * bins;
+          const size_t after = column.after * N * bins;
+          const float wx = column.weight;
+          for (int c = 0; c < N; c++)
+          {
+            const size_t value = c * bins + source[x][c];
+            const float top = (1 - wx) * above[before + value] + wx * above[after + value];
+            const float bottom = (1 - wx) * below[before + value] + wx * below[after + value];
+            target[x][c] = static_cast<T>((1 - wy) * top + wy * bottom + 0.5f);
+          }
+        }
+      }
+    });
+    return true;
+  }
+
+  /// First pixel of a tile; tiles differ at most one pixel in size.
+  static size_t tileStart(size_t tile, size_t tiles, size_t size)
+  {
+    return tile * size / tiles;
+  }
+
+  /// Interpolation between the centers of the tiles, for every pixel
+  /// coordinate along an axis.
+  static void interpolation(size_t tiles, std::vector<Interpolation> &coordinates)
+  {
+    // Twice the center of every tile, for exact comparisons
+    const size_t size = coordinates.size();
+    std::vector<size_t> centers(tiles);
+    for (size_t tile = 0; tile < tiles; tile++)
+    {
+      centers[tile] = tileStart(tile, tiles, size) + tileStart(tile + 1, tiles, size) - 1;
+    }
+
+    size_t tile = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+      while (tile + 1 < tiles && 2 * i >= centers[tile + 1])
+      {
+        tile++;
+      }
+      Interpolation &coordinate = coordinates[i];
+      coordinate.before = tile;
+      if (2 * i <= centers[tile] || tile + 1 == tiles)
+      {
+        // Before the first center or beyond the last
+        coordinate.after = tile;
+        coordinate.weight = 0;
+      }
+      else
+      {
+        coordinate.after = tile + 1;
+        coordinate.weight = static_cast<float>(2 * i - centers[tile]) / static_cast<float>(centers[tile + 1] - centers[tile]);
+      }
+    }
+  }
+
+  /// Clip a tile histogram and build its lookup table.
+  ///
+  /// \param[in] area Number of pixels of the tile
+  /// \param[in,out] histogram Histogram of the tile; clipped
+  /// \param[out] table Lookup table
+  template<typename T>
+  void buildTable(size_t area, std::vector<std::uint32_t> &histogram, T *table) const
+  {
+    const size_t bins = histogram.size();
+    if (m_clipLimit > 0)
+    {
+      const std::uint32_t limit = static_cast<std::uint32_t>(std::max(1.0, m_clipLimit * static_cast<double>(area) / static_cast<double>(bins)));
+      size_t clipped = 0;
+      for (size_t bin = 0; bin < bins; bin++)
+      {
+        if (histogram[bin] > limit)
+        {
+          clipped += histogram[bin] - limit;
+          histogram[bin] = limit;
+        }
+      }
+
+      // Redistribute evenly; the remainder over equally spaced bins
+      const std::uint32_t share = static_cast<std::uint32_t>(clipped / bins);
+      size_t remainder = clipped % bins;
+      for (size_t bin = 0; bin < bins; bin++)
+      {
+        histogram[bin] += share;
+      }
+      if (remainder > 0)
+      {
+        const size_t step = bins / remainder;
+        for (size_t bin = 0; remainder > 0; bin += step, remainder--)
+        {
+          histogram[bin]++;
+        }
+      }
+    }
+
+    // Rounding in 64-bit integers
+    const unsigned long long maximum = std::numeric_limits<T>::max();
+    unsigned long long cumulative = 0;
+    for (size_t bin = 0; bin < bins; bin++)
+    {
+      cumulative += histogram[bin];
+      table[bin] = static_cast<T>((cumulative * maximum + area / 2) / area);
+    }
+  }
+
+  /// Run tasks; on the thread pool if given.
+  static void runTasks(ThreadPool *pool, size_t taskCount, const ThreadPool::Task &task)
+  {
+    if (pool != nullptr)
+    {
+      pool->run(taskCount, task);
+    }
+    else
+    {
+      for (size_t index = 0; index < taskCount; index++)
+      {
+        task(index, 0);
+      }
+    }
+  }
+
+  /// Clip limit, relative to the mean bin count
+  double m_clipLimit;
+
+  /// Number of tiles in horizontal direction
+  size_t m_tilesX;
+
+  /// Number of tiles in vertical direction
+  size_t m_tilesY;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_CLAHE_H
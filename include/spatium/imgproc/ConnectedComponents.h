@@ -0,0 +1,426 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_CONNECTEDCOMPONENTS_H
+#define SPATIUMLIB_IMGPROC_CONNECTEDCOMPONENTS_H
+
+#include "spatium/Image.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::max, std::min
+#include <cstddef> // size_t
+#include <cstdint> // std::uint64_t
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class ConnectedComponents
+/// \brief Connected component labeling of binary images
+///
+/// Labels the connected components of the foreground (non-zero) pixels of a
+/// binary image with 1, 2, 3, ... in order of their first pixel in row major
+/// order; background pixels get label 0. Statistics of every component are
+/// computed as well: area, bounding box and centroid.
+///
+/// Labeling takes two passes (Wu et al., 2009). The first pass assigns
+/// provisional labels from the labeled neighbours above and left, records
+/// equivalent labels in a union-find structure with path compression, and
+/// accumulates statistics per provisional label. Equivalences are then
+/// resolved into final labels, merging the statistics. The second pass
+/// replaces provisional labels by final labels.
+///
+/// With a thread pool the first pass is executed on bands of rows
+/// independently. The equivalences of pixels on both sides of the band
+/// borders are merged afterwards. The result equals that on a single thread.
+///
+/// The number of pixels of an image is limited to the range of unsigned int.
+///
+/// Example:
+/// \code
+/// ConnectedComponents labeling;
+/// labeling.apply(mask, labels);
+/// for (const ConnectedComponents::Component &component : labeling.components())
+/// {
+///   double x = component.centroidX();
+/// }
+/// \endcode
+class ConnectedComponents
+{
+public:
+  /// Pixel connectivity
+  enum class Connectivity
+  {
+    Four, ///< Horizontal and vertical neighbours
+    Eight ///< Horizontal, vertical and diagonal neighbours
+  };
+
+  /// Component statistics
+  struct Component
+  {
+    size_t area;        ///< Number of pixels
+    size_t left;        ///< Left column of the bounding box
+    size_t top;         ///< Top row of the bounding box
+    size_t right;       ///< Right column of the bounding box (inclusive)
+    size_t bottom;      ///< Bottom row of the bounding box (inclusive)
+    std::uint64_t sumX; ///< Sum of the x coordinates of the pixels
+    std::uint64_t sumY; ///< Sum of the y coordinates of the pixels
+
+    /// Get x coordinate of the centroid.
+    ///
+    /// \return Mean x coordinate of the pixels
+    double centroidX() const
+    {
+      return static_cast<double>(sumX) / static_cast<double>(area);
+    }
+
+    /// Get y coordinate of the centroid.
+    ///
+    /// \return Mean y coordinate of the pixels
+    double centroidY() const
+    {
+      return static_cast<double>(sumY) / static_cast<double>(area);
+    }
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] connectivity Pixel connectivity (default = Eight)
+  ConnectedComponents(Connectivity connectivity = Connectivity::Eight)
+    : m_connectivity(connectivity)
+    , m_components()
+  {
+  }
+
+  /// Get pixel connectivity.
+  ///
+  /// \return Connectivity
+  Connectivity connectivity() const
+  {
+    return m_connectivity;
+  }
+
+  /// Set pixel connectivity.
+  ///
+  /// \param[in] connectivity Connectivity
+  void setConnectivity(Connectivity connectivity)
+  {
+    m_connectivity = connectivity;
+  }
+
+  /// Label connected components.
+  ///
+  /// \param[in] input Binary image; non-zero pixels are foreground
+  /// \param[out] labels Labels. Should have the size of the input image.
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<unsigned char, 1> &input, Image<unsigned int, 1> &labels)
+  {
+    return label(input, labels, nullptr);
+  }
+
+  /// Label connected components on bands of rows in parallel.
+  ///
+  /// \param[in] input Binary image; non-zero pixels are foreground
+  /// \param[out] labels Labels. Should have the size of the input image.
+  /// \param[in] pool Thread pool
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<unsigned char, 1> &input, Image<unsigned int, 1> &labels, ThreadPool &pool)
+  {
+    return label(input, labels, &pool);
+  }
+
+  /// Get number of components found by the last apply().
+  ///
+  /// \return Number of components
+  size_t componentCount() const
+  {
+    return m_components.size();
+  }
+
+  /// Get statistics of the components found by the last apply().
+  ///
+  /// \return Components; the component of label l at index l - 1
+  const std::vector<Component> &components() const
+  {
+    return m_components;
+  }
+
+protected:
+  /// Provisional labels of a band of rows
+  struct Band
+  {
+    /// Parent of every provisional label; a label is a root if it is its
+    /// own parent. Label 0 is the background.
+    std::vector<unsigned int> parents;
+
+    /// Statistics of the pixels of every provisional label
+    std::vector<Component> components;
+
+    /// Offset of the labels of the band in the labels of the image
+    unsigned int offset;
+  };
+
+  /// Label components; in parallel if a thread pool is given.
+  bool label(const Image<unsigned char, 1> &input, Image<unsigned int, 1> &labels, ThreadPool *pool)
+  {
+    if (input.width() != labels.width() ||
+        input.height() != labels.height())
+    {
+      return false;
+    }
+    m_components.clear();
+
+    const size_t width = input.width();
+    const size_t height = input.height();
+    if (width == 0 || height == 0)
+    {
+      return true;
+    }
+
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(input.imageDataPtr());
+    unsigned int *out = reinterpret_cast<unsigned int*>(labels.imageDataPtr());
+
+    // First pass; about 4 bands per thread, a single band without thread pool
+    const size_t bandHeight = (pool != nullptr ? std::max<size_t>(16, height / (4 * pool->threadCount()) + 1) : height);
+    const size_t bandCount = (height + bandHeight - 1) / bandHeight;
+    std::vector<Band> bands(bandCount);
+    runBands(pool, bandCount, [&](size_t band, size_t) {
+      scanBand(in, out, width, band * bandHeight, std::min((band + 1) * bandHeight, height), bands[band]);
+    });
+
+    // Labels of all bands, one after another
+    std::vector<unsigned int> parents(1, 0);
+    for (Band &band : bands)
+    {
+      band.offset = static_cast<unsigned int>(parents.size() - 1);
+      for (size_t i = 1; i < band.parents.size(); i++)
+      {
+        parents.push_back(band.parents[i] + band.offset);
+      }
+    }
+
+    // Equivalences across band borders
+    for (size_t band = 1; band < bandCount; band++)
+    {
+      mergeBorder(out, width, band * bandHeight, bands[band - 1].offset, bands[band].offset, parents);
+    }
+
+    // Final labels. A root is the least label of its component, so labels
+    // are numbered in order of the first pixel of the components; parents
+    // precede their children.
+    std::vector<unsigned int> finals(parents.size(), 0);
+    unsigned int count = 0;
+    for (size_t i = 1; i < parents.size(); i++)
+    {
+      finals[i] = (parents[i] == i ? ++count : finals[parents[i]]);
+    }
+
+    // Statistics of the final labels
+    Component empty = { 0, width, height, 0, 0, 0, 0 };
+    m_components.assign(count, empty);
+    for (const Band &band : bands)
+    {
+      for (size_t i = 1; i < band.components.size(); i++)
+      {
+        merge(m_components[finals[i + band.offset] - 1], band.components[i]);
+      }
+    }
+
+    // Second pass
+    runBands(pool, bandCount, [&](size_t band, size_t) {
+      const unsigned int offset = bands[band].offset;
+      const size_t end = std::min((band + 1) * bandHeight, height) * width;
+      for (size_t i = band * bandHeight * width; i < end; i++)
+      {
+        out[i] = (out[i] != 0 ? finals[out[i] + offset] : 0);
+      }
+    });
+
+    return true;
+  }
+
+  /// Run a task per band; on the thread pool if given.
+  static void runBands(ThreadPool *pool, size_t bandCount, const ThreadPool::Task &task)
+  {
+    if (pool != nullptr)
+    {
+      pool->run(bandCount, task);
+    }
+    else
+    {
+      for (size_t band = 0; band < bandCount; band++)
+      {
+        task(band, 0);
+      }
+    }
+  }
+
+  /// First pass over rows firstRow .. lastRow-1; provisional labels of the
+  /// band start at 1.
+  void scanBand(const unsigned char *in, unsigned int *out, size_t width, size_t firstRow, size_t lastRow, Band &band) const
+  {
+    band.parents.assign(1, 0);
+    band.components.assign(1, Component());
+    std::vector<unsigned int> &parents = band.parents;
+
+    // Background row above the band
+    const std::vector<unsigned int> outside(width, 0);
+
+    const bool eight = (m_connectivity == Connectivity::Eight);
+    for (size_t y = firstRow; y < lastRow; y++)
+    {
+      const unsigned int *above = (y > firstRow ? out + (y - 1) * width : outside.data());
+      unsigned int *row = out + y * width;
+      const unsigned char *inRow = in + y * width;
+      for (size_t x = 0; x < width; x++)
+      {
+        if (inRow[x] == 0)
+        {
+          row[x] = 0;
+          continue;
+        }
+
+        const unsigned int left = (x > 0 ? row[x - 1] : 0);
+        const unsigned int up = above[x];
+        unsigned int label;
+        if (eight)
+        {
+          // A neighbour above connects to all other neighbours, as does the
+          // upper left to the left neighbour
+          const unsigned int upLeft = (x > 0 ? above[x - 1] : 0);
+          const unsigned int upRight = (x + 1 < width ? above[x + 1] : 0);
+          if (up != 0)
+          {
+            label = up;
+          }
+          else if (upRight != 0)
+          {
+            label = upRight;
+            if (upLeft != 0 || left != 0)
+            {
+              unite(parents, upRight, (upLeft != 0 ? upLeft : left));
+            }
+          }
+          else if (upLeft != 0)
+          {
+            label = upLeft;
+          }
+          else
+          {
+            label = left;
+          }
+        }
+        else
+        {
+          label = (up != 0 ? up : left);
+          if (up != 0 && left != 0)
+          {
+            unite(parents, up, left);
+          }
+        }
+
+        if (label == 0)
+        {
+          label = static_cast<unsigned int>(parents.size());
+          parents.push_back(label);
+          const Component component = { 0, x, y, x, y, 0, 0 };
+          band.components.push_back(component);
+        }
+        row[x] = label;
+
+        Component &component = band.components[label];
+        component.area++;
+        component.left = std::min(component.left, x);
+        component.right = std::max(component.right, x);
+        component.bottom = y;
+        component.sumX += x;
+        component.sumY += y;
+      }
+    }
+  }
+
+  /// Merge equivalences of the pixels of the first row of a band and the
+  /// last row of the band above.
+  void mergeBorder(const unsigned int *out, size_t width, size_t row, unsigned int offsetAbove, unsigned int offset,
+                   std::vector<unsigned int> &parents) const
+  {
+    const unsigned int *above = out + (row - 1) * width;
+    const unsigned int *current = out + row * width;
+    const size_t reach = (m_connectivity == Connectivity::Eight ? 1 : 0);
+    for (size_t x = 0; x < width; x++)
+    {
+      if (current[x] == 0)
+      {
+        continue;
+      }
+      const size_t begin = (x >= reach ? x - reach : 0);
+      const size_t end = std::min(x + reach, width - 1);
+      for (size_t u = begin; u <= end; u++)
+      {
+        if (above[u] != 0)
+        {
+          unite(parents, current[x] + offset, above[u] + offsetAbove);
+        }
+      }
+    }
+  }
+
+  /// Find root of a label; halves the path on the way.
+  static unsigned int findRoot(std::vector<unsigned int> &parents, unsigned int label)
+  {
+    while (parents[label] != label)
+    {
+      parents[label] = parents[parents[label]];
+      label = parents[label];
+    }
+    return label;
+  }
+
+  /// Unite the sets of two labels. The least root becomes the root, so a
+  /// parent is never greater than its child.
+  static void unite(std::vector<unsigned int> &parents, unsigned int a, unsigned int b)
+  {
+    a = findRoot(parents, a);
+    b = findRoot(parents, b);
+    if (a < b)
+    {
+      parents[b] = a;
+    }
+    else if (b < a)
+    {
+      parents[a] = b;
+    }
+  }
+
+  /// Add statistics of a part of a component.
+  static void merge(Component &component, const Component &part)
+  {
+    component.area += part.area;
+    component.left = std::min(component.left, part.left);
+    component.top = std::min(component.top, part.top);
+    component.right = std::max(component.right, part.right);
+    component.bottom = std::max(component.bottom, part.bottom);
+    component.sumX += part.sumX;
+    component.sumY += part.sumY;
+  }
+
+  /// Pixel connectivity
+  Connectivity m_connectivity;
+
+  /// Statistics of the components found by the last apply()
+  std::vector<Component> m_components;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_CONNECTEDCOMPONENTS_H
@@ -0,0 +1,1062 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_CONVOLVE_H
+#define SPATIUMLIB_IMGPROC_CONVOLVE_H
+
+#include "IImageFilter.h"
+#include "Border.h"
+#include "spatium/Matrix.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::fill, std::max, std::min, std::swap_ranges
+#include <cmath> // std::abs, std::cos, std::floor, std::log2, std::sin
+#include <cstddef> // size_t, std::ptrdiff_t
+#include <limits> // std::numeric_limits
+#include <type_traits> // std::conditional, std::is_same
+#include <vector> // std::vector
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUMLIB_IMGPROC_CONVOLVE_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+
+namespace spatium {
+namespace imgproc {
+
+/// \class Convolve
+/// \brief Convolution with an arbitrary kernel
+///
+/// The image is convolved with a kernel of rows x cols weights, given as a
+/// Matrix. Kernel weight (i, j) weighs the input pixel (x + cols / 2 - j,
+/// y + rows / 2 - i) in output pixel (x, y), so a kernel of odd size is
+/// centered on the pixel. Pixels outside the image are determined by a
+/// border policy (see Border.h); by default they are clamped to the nearest
+/// border pixel.
+///
+/// Three methods are available:
+///
+/// - Direct: padded input rows are correlated with the kernel rows. With
+///   SSE2, float rows are correlated 16 samples per step, with the sums kept
+///   in registers for all kernel weights. The cost per pixel is rows * cols
+///   multiply-adds.
+/// - Separable: if the kernel is the outer product of a column and a row
+///   (rank 1), a horizontal pass as in Direct and a vertical pass that adds
+///   weighted rows, 8 float samples per step with SSE2. The cost per pixel
+///   is rows + cols multiply-adds.
+/// - Fft: overlap-add. The padded image is divided into blocks, which are
+///   convolved with the kernel by multiplication in the frequency domain.
+///   The results of neighbouring blocks overlap by the kernel size and are
+///   added. Two blocks are transformed at once as the real and imaginary
+///   part of one complex signal. The FFT is a radix-2 FFT along both axes
+///   that transforms many rows or columns side by side. The block size is
+///   chosen for the least work; the cost per pixel grows with the
+///   logarithm of the kernel size.
+///
+/// By default the method with the least estimated work is chosen.
+///
+/// Samples are filtered in floating point (double for double images, float
+/// otherwise). Integer results are rounded to nearest and saturated.
+///
+/// With a thread pool, bands of rows (Fft: rows of blocks) are filtered in
+/// parallel.
+///
+/// Example:
+/// \code
+/// Convolve sharpen(Matrix({ {  0, -1,  0 },
+///                           { -1,  5, -1 },
+///                           {  0, -1,  0 } }));
+/// sharpen.apply(input, output);
+/// \endcode
+class Convolve : public IImageFilter
+{
+public:
+  /// Convolution method
+  enum class Method
+  {
+    Automatic, ///< Method with the least estimated work
+    Direct,    ///< Multiply-add of every kernel weight
+    Separable, ///< Horizontal and vertical pass; rank 1 kernels only
+    Fft        ///< Overlap-add in the frequency domain
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] kernel Kernel (default = 1x1 identity)
+  /// \param[in] method Convolution method (default = Automatic)
+  Convolve(const Matrix &kernel = Matrix::identity(1), Method method = Method::Automatic)
+    : m_kernel(kernel)
+    , m_method(method)
+  {
+    factorize();
+  }
+
+  virtual ~Convolve() = default;
+
+  /// Get kernel.
+  ///
+  /// \return Kernel
+  const Matrix &kernel() const
+  {
+    return m_kernel;
+  }
+
+  /// Set kernel.
+  ///
+  /// \param[in] kernel Kernel; should not be empty
+  void setKernel(const Matrix &kernel)
+  {
+    m_kernel = kernel;
+    factorize();
+  }
+
+  /// Get convolution method.
+  ///
+  /// \return Convolution method
+  Method method() const
+  {
+    return m_method;
+  }
+
+  /// Set convolution method.
+  ///
+  /// Separable falls back to Direct if the kernel is not separable.
+  ///
+  /// \param[in] method Convolution method
+  void setMethod(Method method)
+  {
+    m_method = method;
+  }
+
+  /// Check if the kernel is the outer product of a column and a row.
+  ///
+  /// \return True if separable, otherwise false
+  bool isSeparable() const
+  {
+    return m_separable;
+  }
+
+  /// Get method used for an image size.
+  ///
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] channels Number of channels
+  /// \return Direct, Separable or Fft
+  Method methodFor(size_t width, size_t height, int channels) const
+  {
+    if (m_method == Method::Direct || m_method == Method::Fft)
+    {
+      return m_method;
+    }
+    if (m_method == Method::Separable)
+    {
+      return (m_separable ? Method::Separable : Method::Direct);
+    }
+
+    // Estimated multiply-adds per sample
+    const double direct = static_cast<double>(m_rows * m_cols);
+    const double separable = (m_separable ? static_cast<double>(m_rows + m_cols) : direct);
+    const double fft = tiling(width, height, channels).cost;
+    if (fft < std::min(direct, separable))
+    {
+      return Method::Fft;
+    }
+    return (separable < direct ? Method::Separable : Method::Direct);
+  }
+
+  /// Apply filter.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input image
+  /// and should not be the input image itself.
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch, aliasing or
+  /// an empty kernel
+  template<typename T, int N, typename Border = BorderClamp>
+  bool apply(const Image<T, N> &input, Image<T, N> &output, const Border &border = Border()) const
+  {
+    return convolve(input, output, border, nullptr);
+  }
+
+  /// Apply filter in parallel.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input image
+  /// and should not be the input image itself.
+  /// \param[in] pool Thread pool
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch, aliasing or
+  /// an empty kernel
+  template<typename T, int N, typename Border = BorderClamp>
+  bool apply(const Image<T, N> &input, Image<T, N> &output, ThreadPool &pool, const Border &border = Border()) const
+  {
+    return convolve(input, output, border, &pool);
+  }
+
+protected:
+  /// Padded image: the image extended by the kernel size minus one pixels.
+  /// Output pixel (x, y) is the correlation of the flipped kernel with the
+  /// padded pixels (x .. x + cols - 1, y .. y + rows - 1).
+  struct Padding
+  {
+    /// Image column of every padded column; -1 for the border value
+    std::vector<std::ptrdiff_t> columns;
+
+    /// Image row of every padded row; -1 for the border value
+    std::vector<std::ptrdiff_t> rows;
+
+    /// Value of pixels outside the image, if not mapped into the image
+    double value;
+
+    /// Output columns to filter, begin .. end-1
+    size_t columnBegin;
+    size_t columnEnd;
+
+    /// Output rows to filter, begin .. end-1
+    size_t rowBegin;
+    size_t rowEnd;
+  };
+
+  /// FFT block size
+  struct Tiling
+  {
+    /// FFT width and height; powers of two
+    size_t width;
+    size_t height;
+
+    /// Block width and height in padded pixels: FFT size - kernel size + 1
+    size_t blockWidth;
+    size_t blockHeight;
+
+    /// Estimated work per sample, comparable to multiply-adds
+    double cost;
+  };
+
+  /// Flip the kernel and factorize it into a column and a row if it is
+  /// separable.
+  void factorize()
+  {
+    m_rows = m_kernel.rows();
+    m_cols = m_kernel.cols();
+    m_weights.resize(m_rows * m_cols);
+    for (size_t i = 0; i < m_rows; i++)
+    {
+      for (size_t j = 0; j < m_cols; j++)
+      {
+        m_weights[i * m_cols + j] = m_kernel(m_rows - 1 - i, m_cols - 1 - j);
+      }
+    }
+
+    m_separable = false;
+    if (m_weights.empty())
+    {
+      return;
+    }
+
+    // Largest weight as pivot: column through it times row through it,
+    // divided by the pivot
+    size_t pivot = 0;
+    for (size_t k = 1; k < m_weights.size(); k++)
+    {
+      pivot = (std::abs(m_weights[k]) > std::abs(m_weights[pivot]) ? k : pivot);
+    }
+    const double scale = m_weights[pivot];
+    m_columnWeights.resize(m_rows);
+    m_rowWeights.resize(m_cols);
+    for (size_t i = 0; i < m_rows; i++)
+    {
+      m_columnWeights[i] = m_weights[i * m_cols + pivot % m_cols];
+    }
+    for (size_t j = 0; j < m_cols; j++)
+    {
+      m_rowWeights[j] = (scale != 0 ? m_weights[(pivot / m_cols) * m_cols + j] / scale : 0);
+    }
+
+    const double tolerance = 1e-9 * std::abs(scale);
+    m_separable = true;
+    for (size_t i = 0; i < m_rows && m_separable; i++)
+    {
+      for (size_t j = 0; j < m_cols; j++)
+      {
+        if (std::abs(m_weights[i * m_cols + j] - m_columnWeights[i] * m_rowWeights[j]) > tolerance)
+        {
+          m_separable = false;
+          break;
+        }
+      }
+    }
+  }
+
+  /// Convolve with the chosen method.
+  template<typename T, int N, typename Border>
+  bool convolve(const Image<T, N> &input, Image<T, N> &output, const Border &border, ThreadPool *pool) const
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height() ||
+        &input == &output ||
+        m_weights.empty())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    // Double images are filtered in double precision, others in single
+    typedef typename std::conditional<std::is_same<T, double>::value, double, float>::type Real;
+
+    const Padding padding = pad(input.width(), input.height(), border);
+    if (padding.columnBegin >= padding.columnEnd ||
+        padding.rowBegin >= padding.rowEnd)
+    {
+      return true;
+    }
+
+    switch (methodFor(input.width(), input.height(), N))
+    {
+    case Method::Separable:
+      filterSeparable<Real>(input, output, padding, pool);
+      break;
+    case Method::Fft:
+      filterFft<Real>(input, output, padding, pool);
+      break;
+    default:
+      filterDirect<Real>(input, output, padding, pool);
+      break;
+    }
+    return true;
+  }
+
+  /// Map the padded image into the image by the border policy.
+  template<typename Border>
+  Padding pad(size_t width, size_t height, const Border &border) const
+  {
+    // Pixels before the first pixel of the image
+    const std::ptrdiff_t left = static_cast<std::ptrdiff_t>((m_cols - 1) / 2);
+    const std::ptrdiff_t top = static_cast<std::ptrdiff_t>((m_rows - 1) / 2);
+
+    Padding padding;
+    padding.columns.resize(width + m_cols - 1);
+    padding.rows.resize(height + m_rows - 1);
+    padding.value = border.value();
+    size_t index;
+    for (size_t u = 0; u < padding.columns.size(); u++)
+    {
+      const bool inside = border.index(static_cast<std::ptrdiff_t>(u) - left, width, index);
+      padding.columns[u] = (inside ? static_cast<std::ptrdiff_t>(index) : -1);
+    }
+    for (size_t v = 0; v < padding.rows.size(); v++)
+    {
+      const bool inside = border.index(static_cast<std::ptrdiff_t>(v) - top, height, index);
+      padding.rows[v] = (inside ? static_cast<std::ptrdiff_t>(index) : -1);
+    }
+
+    // Pixels of which the kernel extends outside the image are not filtered
+    // if the border is skipped
+    padding.columnBegin = 0;
+    padding.columnEnd = width;
+    padding.rowBegin = 0;
+    padding.rowEnd = height;
+    if (!Border::filtersBorder)
+    {
+      padding.columnBegin = std::min(static_cast<size_t>(left), width);
+      padding.columnEnd = std::max(padding.columnBegin, width > m_cols / 2 ? width - m_cols / 2 : 0);
+      padding.rowBegin = std::min(static_cast<size_t>(top), height);
+      padding.rowEnd = std::max(padding.rowBegin, height > m_rows / 2 ? height - m_rows / 2 : 0);
+    }
+    return padding;
+  }
+
+  /// Run a task per band; on the thread pool if given.
+  static void runBands(ThreadPool *pool, size_t bandCount, const ThreadPool::Task &task)
+  {
+    if (pool != nullptr)
+    {
+      pool->run(bandCount, task);
+    }
+    else
+    {
+      for (size_t band = 0; band < bandCount; band++)
+      {
+        task(band, 0);
+      }
+    }
+  }
+
+  /// Height of bands of output rows; about 4 bands per thread.
+  static size_t bandHeight(size_t rows, ThreadPool *pool)
+  {
+    return (pool != nullptr ? std::max<size_t>(16, rows / (4 * pool->threadCount()) + 1) : rows);
+  }
+
+  /// Copy a padded row.
+  ///
+  /// \param[in] in Image row data; ignored for the border value
+  /// \param[in] row Image row; -1 for the border value
+  /// \param[in] padding Padded image
+  /// \param[out] padded Padded row; (width + cols - 1) * N samples
+  template<int N, typename T, typename Real>
+  static void padRow(const T *in, std::ptrdiff_t row, const Padding &padding, Real *padded)
+  {
+    const Real value = static_cast<Real>(padding.value);
+    const size_t width = padding.columns.size();
+    if (row < 0)
+    {
+      std::fill(padded, padded + width * N, value);
+      return;
+    }
+    for (size_t u = 0; u < width; u++)
+    {
+      const std::ptrdiff_t column = padding.columns[u];
+      for (int c = 0; c < N; c++)
+      {
+        padded[u * N + c] = (column >= 0 ? static_cast<Real>(in[column * N + c]) : value);
+      }
+    }
+  }
+
+  /// Direct convolution.
+  ///
+  /// Padded rows are kept in a ring buffer of as many rows as the kernel.
+  template<typename Real, typename T, int N>
+  void filterDirect(const Image<T, N> &input, Image<T, N> &output, const Padding &padding, ThreadPool *pool) const
+  {
+    const size_t rowSize = input.width() * N;
+    const size_t paddedSize = padding.columns.size() * N;
+    const std::vector<Real> weights(m_weights.begin(), m_weights.end());
+    const T *in = reinterpret_cast<const T*>(input.imageDataPtr());
+    T *out = reinterpret_cast<T*>(output.imageDataPtr());
+
+    const size_t rows = padding.rowEnd - padding.rowBegin;
+    const size_t height = bandHeight(rows, pool);
+    runBands(pool, (rows + height - 1) / height, [&](size_t band, size_t) {
+      const size_t first = padding.rowBegin + band * height;
+      const size_t last = std::min(first + height, padding.rowEnd);
+      std::vector<Real> ring(m_rows * paddedSize);
+      std::vector<Real> sum(rowSize);
+      size_t rowsPadded = first;
+      for (size_t y = first; y < last; y++)
+      {
+        for (; rowsPadded < y + m_rows; rowsPadded++)
+        {
+          const std::ptrdiff_t row = padding.rows[rowsPadded];
+          padRow<N>(in + (row >= 0 ? row : 0) * rowSize, row, padding, &ring[(rowsPadded % m_rows) * paddedSize]);
+        }
+
+        std::fill(sum.begin(), sum.end(), Real(0));
+        for (size_t i = 0; i < m_rows; i++)
+        {
+          correlateRow(sum.data(), &ring[((y + i) % m_rows) * paddedSize], &weights[i * m_cols], m_cols, N, rowSize);
+        }
+        writeRow(sum.data(), out + y * rowSize, padding.columnBegin * N, padding.columnEnd * N);
+      }
+    });
+  }
+
+  /// Separable convolution.
+  ///
+  /// Horizontally filtered rows are kept in a ring buffer of as many rows
+  /// as the kernel.
+  template<typename Real, typename T, int N>
+  void filterSeparable(const Image<T, N> &input, Image<T, N> &output, const Padding &padding, ThreadPool *pool) const
+  {
+    const size_t rowSize = input.width() * N;
+    const size_t paddedSize = padding.columns.size() * N;
+    const std::vector<Real> columnWeights(m_columnWeights.begin(), m_columnWeights.end());
+    const std::vector<Real> rowWeights(m_rowWeights.begin(), m_rowWeights.end());
+    const T *in = reinterpret_cast<const T*>(input.imageDataPtr());
+    T *out = reinterpret_cast<T*>(output.imageDataPtr());
+
+    const size_t rows = padding.rowEnd - padding.rowBegin;
+    const size_t height = bandHeight(rows, pool);
+    runBands(pool, (rows + height - 1) / height, [&](size_t band, size_t) {
+      const size_t first = padding.rowBegin + band * height;
+      const size_t last = std::min(first + height, padding.rowEnd);
+      std::vector<Real> padded(paddedSize);
+      std::vector<Real> ring(m_rows * rowSize);
+      std::vector<Real> sum(rowSize);
+      size_t rowsFiltered = first;
+      for (size_t y = first; y < last; y++)
+      {
+        // Horizontal pass
+        for (; rowsFiltered < y + m_rows; rowsFiltered++)
+        {
+          const std::ptrdiff_t row = padding.rows[rowsFiltered];
+          padRow<N>(in + (row >= 0 ? row : 0) * rowSize, row, padding, padded.data());
+          Real *filtered = &ring[(rowsFiltered % m_rows) * rowSize];
+          std::fill(filtered, filtered + rowSize, Real(0));
+          correlateRow(filtered, padded.data(), rowWeights.data(), m_cols, N, rowSize);
+        }
+
+        // Vertical pass
+        std::fill(sum.begin(), sum.end(), Real(0));
+        for (size_t i = 0; i < m_rows; i++)
+        {
+          multiplyAdd(sum.data(), &ring[((y + i) % m_rows) * rowSize], columnWeights[i], rowSize);
+        }
+        writeRow(sum.data(), out + y * rowSize, padding.columnBegin * N, padding.columnEnd * N);
+      }
+    });
+  }
+
+  /// Choose the FFT size with the least estimated work.
+  ///
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] channels Number of channels
+  /// \return FFT size and block size
+  Tiling tiling(size_t width, size_t height, int channels) const
+  {
+    Tiling best = { 0, 0, 0, 0, std::numeric_limits<double>::infinity() };
+    if (m_weights.empty() || width == 0 || height == 0)
+    {
+      return best;
+    }
+
+    // Sizes from the smallest that fits the kernel to the smallest that
+    // holds the whole padded image in one block
+    const size_t paddedWidth = width + m_cols - 1;
+    const size_t paddedHeight = height + m_rows - 1;
+    for (size_t fftHeight = powerOfTwo(m_rows); ; fftHeight *= 2)
+    {
+      const size_t blockHeight = fftHeight - m_rows + 1;
+      for (size_t fftWidth = powerOfTwo(m_cols); ; fftWidth *= 2)
+      {
+        // Work of a forward and an inverse transform of a pair of blocks,
+        // the multiplication and the overlap-add, in multiply-adds of the
+        // direct method (measured). A pair takes size * log2(size)
+        // butterflies; one costs about as much as 14 multiply-adds.
+        const size_t blockWidth = fftWidth - m_cols + 1;
+        const double size = static_cast<double>(fftWidth * fftHeight);
+        const double pairs = static_cast<double>((((paddedWidth + blockWidth - 1) / blockWidth) * channels + 1) / 2);
+        const double blockRows = static_cast<double>((paddedHeight + blockHeight - 1) / blockHeight);
+        const double work = blockRows * pairs * size * (14 * std::log2(size) + 32);
+        const double cost = work / (static_cast<double>(width * height) * channels);
+        if (cost < best.cost)
+        {
+          best = { fftWidth, fftHeight, blockWidth, blockHeight, cost };
+        }
+        if (blockWidth >= paddedWidth)
+        {
+          break;
+        }
+      }
+      if (blockHeight >= paddedHeight)
+      {
+        break;
+      }
+    }
+    return best;
+  }
+
+  /// Smallest power of two not less than n.
+  static size_t powerOfTwo(size_t n)
+  {
+    size_t power = 1;
+    while (power < n)
+    {
+      power *= 2;
+    }
+    return power;
+  }
+
+  /// Convolution by overlap-add in the frequency domain.
+  ///
+  /// The padded image is divided into rows of blocks. Each block is
+  /// convolved with the kernel and added into the strip of output rows of
+  /// its row of blocks; the strips are summed afterwards. Two planes (block
+  /// and channel) are transformed at once: the kernel is real, so the real
+  /// and imaginary part of the product are the convolutions of the planes.
+  template<typename Real, typename T, int N>
+  void filterFft(const Image<T, N> &input, Image<T, N> &output, const Padding &padding, ThreadPool *pool) const
+  {
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const size_t rowSize = width * N;
+    const Tiling tiles = tiling(width, height, N);
+    const size_t fftSize = tiles.width * tiles.height;
+    const size_t blockColumns = (padding.columns.size() + tiles.blockWidth - 1) / tiles.blockWidth;
+    const size_t blockRows = (padding.rows.size() + tiles.blockHeight - 1) / tiles.blockHeight;
+    const T *in = reinterpret_cast<const T*>(input.imageDataPtr());
+    T *out = reinterpret_cast<T*>(output.imageDataPtr());
+
+    // Twiddle factors; exp(-2 pi i k / n) for k < n / 2
+    std::vector<Real> cosinesX, sinesX, cosinesY, sinesY;
+    twiddles(tiles.width, cosinesX, sinesX);
+    twiddles(tiles.height, cosinesY, sinesY);
+
+    // Spectrum of the kernel, scaled by the inverse transform's 1 / size
+    std::vector<Real> kernelReal(fftSize, Real(0));
+    std::vector<Real> kernelImag(fftSize, Real(0));
+    std::vector<Real> scratchReal(fftSize);
+    std::vector<Real> scratchImag(fftSize);
+    for (size_t i = 0; i < m_rows; i++)
+    {
+      for (size_t j = 0; j < m_cols; j++)
+      {
+        kernelReal[i * tiles.width + j] = static_cast<Real>(m_kernel(i, j) / static_cast<double>(fftSize));
+      }
+    }
+    forward(kernelReal.data(), kernelImag.data(), scratchReal.data(), scratchImag.data(), tiles,
+            cosinesX.data(), sinesX.data(), cosinesY.data(), sinesY.data());
+    kernelReal.swap(scratchReal);
+    kernelImag.swap(scratchImag);
+
+    // Output rows of the strip of row of blocks b start at
+    // b * blockHeight - (rows - 1); a strip is as high as the FFT
+    std::vector<Real> strips(blockRows * tiles.height * rowSize, Real(0));
+    runBands(pool, blockRows, [&](size_t blockRow, size_t) {
+      std::vector<Real> real(fftSize), imag(fftSize), spectrumReal(fftSize), spectrumImag(fftSize);
+      Real *strip = &strips[blockRow * tiles.height * rowSize];
+      const size_t planes = blockColumns * N;
+      for (size_t plane = 0; plane < planes; plane += 2)
+      {
+        loadBlock<N>(in, rowSize, padding, tiles, blockRow, plane, real.data());
+        if (plane + 1 < planes)
+        {
+          loadBlock<N>(in, rowSize, padding, tiles, blockRow, plane + 1, imag.data());
+        }
+        else
+        {
+          std::fill(imag.begin(), imag.end(), Real(0));
+        }
+
+        forward(real.data(), imag.data(), spectrumReal.data(), spectrumImag.data(), tiles,
+                cosinesX.data(), sinesX.data(), cosinesY.data(), sinesY.data());
+        for (size_t k = 0; k < fftSize; k++)
+        {
+          const Real re = spectrumReal[k] * kernelReal[k] - spectrumImag[k] * kernelImag[k];
+          const Real im = spectrumReal[k] * kernelImag[k] + spectrumImag[k] * kernelReal[k];
+          spectrumReal[k] = re;
+          spectrumImag[k] = im;
+        }
+        inverse(spectrumReal.data(), spectrumImag.data(), real.data(), imag.data(), tiles,
+                cosinesX.data(), sinesX.data(), cosinesY.data(), sinesY.data());
+
+        addBlock<N>(real.data(), width, height, tiles, blockRow, plane, strip);
+        if (plane + 1 < planes)
+        {
+          addBlock<N>(imag.data(), width, height, tiles, blockRow, plane + 1, strip);
+        }
+      }
+    });
+
+    // Sum the strips that overlap each output row
+    const size_t rows = padding.rowEnd - padding.rowBegin;
+    const size_t bandRows = bandHeight(rows, pool);
+    runBands(pool, (rows + bandRows - 1) / bandRows, [&](size_t band, size_t) {
+      const size_t first = padding.rowBegin + band * bandRows;
+      const size_t last = std::min(first + bandRows, padding.rowEnd);
+      std::vector<Real> sum(rowSize);
+      for (size_t y = first; y < last; y++)
+      {
+        std::fill(sum.begin(), sum.end(), Real(0));
+        const size_t end = std::min(blockRows, (y + m_rows - 1) / tiles.blockHeight + 1);
+        for (size_t blockRow = y / tiles.blockHeight; blockRow < end; blockRow++)
+        {
+          const size_t row = y + m_rows - 1 - blockRow * tiles.blockHeight;
+          const Real *strip = &strips[(blockRow * tiles.height + row) * rowSize];
+          for (size_t i = 0; i < rowSize; i++)
+          {
+            sum[i] += strip[i];
+          }
+        }
+        writeRow(sum.data(), out + y * rowSize, padding.columnBegin * N, padding.columnEnd * N);
+      }
+    });
+  }
+
+  /// Load a plane of a block, zero padded to the FFT size.
+  ///
+  /// \param[in] in Input image data
+  /// \param[in] rowSize Number of samples per image row
+  /// \param[in] padding Padded image
+  /// \param[in] tiles FFT and block size
+  /// \param[in] blockRow Row of blocks
+  /// \param[in] plane Block column * N + channel
+  /// \param[out] block Block; FFT height rows of FFT width values
+  template<int N, typename T, typename Real>
+  static void loadBlock(const T *in, size_t rowSize, const Padding &padding, const Tiling &tiles,
+                        size_t blockRow, size_t plane, Real *block)
+  {
+    const size_t left = (plane / N) * tiles.blockWidth;
+    const size_t top = blockRow * tiles.blockHeight;
+    const size_t channel = plane % N;
+    const size_t columns = std::min(tiles.blockWidth, padding.columns.size() - left);
+    const size_t rows = std::min(tiles.blockHeight, padding.rows.size() - top);
+    const Real value = static_cast<Real>(padding.value);
+    std::fill(block, block + tiles.width * tiles.height, Real(0));
+    for (size_t t = 0; t < rows; t++)
+    {
+      Real *target = block + t * tiles.width;
+      const std::ptrdiff_t row = padding.rows[top + t];
+      if (row < 0)
+      {
+        std::fill(target, target + columns, value);
+        continue;
+      }
+      const T *source = in + row * rowSize + channel;
+      for (size_t s = 0; s < columns; s++)
+      {
+        const std::ptrdiff_t column = padding.columns[left + s];
+        target[s] = (column >= 0 ? static_cast<Real>(source[column * N]) : value);
+      }
+    }
+  }
+
+  /// Add a convolved plane of a block to the strip of its row of blocks.
+  ///
+  /// \param[in] block Convolved block; FFT height rows of FFT width values
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] tiles FFT and block size
+  /// \param[in] blockRow Row of blocks
+  /// \param[in] plane Block column * N + channel
+  /// \param[in,out] strip Strip; FFT height rows of width * N samples
+  template<int N, typename Real>
+  void addBlock(const Real *block, size_t width, size_t height, const Tiling &tiles,
+                size_t blockRow, size_t plane, Real *strip) const
+  {
+    // Block value (s, t) lands on output pixel (left + s - (cols - 1),
+    // top + t - (rows - 1))
+    const std::ptrdiff_t left = static_cast<std::ptrdiff_t>((plane / N) * tiles.blockWidth) - static_cast<std::ptrdiff_t>(m_cols - 1);
+    const std::ptrdiff_t top = static_cast<std::ptrdiff_t>(blockRow * tiles.blockHeight) - static_cast<std::ptrdiff_t>(m_rows - 1);
+    const size_t channel = plane % N;
+    const std::ptrdiff_t begin = std::max<std::ptrdiff_t>(0, -left);
+    const std::ptrdiff_t end = std::min(static_cast<std::ptrdiff_t>(tiles.width), static_cast<std::ptrdiff_t>(width) - left);
+    for (size_t t = 0; t < tiles.height; t++)
+    {
+      const std::ptrdiff_t y = top + static_cast<std::ptrdiff_t>(t);
+      if (y < 0 || y >= static_cast<std::ptrdiff_t>(height))
+      {
+        continue;
+      }
+      const Real *source = block + t * tiles.width;
+      Real *target = strip + t * width * N + channel;
+      for (std::ptrdiff_t s = begin; s < end; s++)
+      {
+        target[(left + s) * N] += source[s];
+      }
+    }
+  }
+
+  /// Twiddle factors exp(-2 pi i k / n) for k < n / 2.
+  template<typename Real>
+  static void twiddles(size_t n, std::vector<Real> &cosines, std::vector<Real> &sines)
+  {
+    const double pi = 3.14159265358979323846;
+    cosines.resize(n / 2);
+    sines.resize(n / 2);
+    for (size_t k = 0; k < n / 2; k++)
+    {
+      const double angle = -2 * pi * static_cast<double>(k) / static_cast<double>(n);
+      cosines[k] = static_cast<Real>(std::cos(angle));
+      sines[k] = static_cast<Real>(std::sin(angle));
+    }
+  }
+
+  /// Forward 2D FFT.
+  ///
+  /// \param[in,out] real Real part; FFT height rows of FFT width values.
+  /// Overwritten.
+  /// \param[in,out] imag Imaginary part. Overwritten.
+  /// \param[out] spectrumReal Real part of the spectrum; transposed, FFT
+  /// width rows of FFT height values
+  /// \param[out] spectrumImag Imaginary part of the spectrum; transposed
+  template<typename Real>
+  static void forward(Real *real, Real *imag, Real *spectrumReal, Real *spectrumImag, const Tiling &tiles,
+                      const Real *cosinesX, const Real *sinesX, const Real *cosinesY, const Real *sinesY)
+  {
+    fft(real, imag, tiles.height, tiles.width, cosinesY, sinesY, false);
+    transpose(real, tiles.height, tiles.width, spectrumReal);
+    transpose(imag, tiles.height, tiles.width, spectrumImag);
+    fft(spectrumReal, spectrumImag, tiles.width, tiles.height, cosinesX, sinesX, false);
+  }
+
+  /// Inverse 2D FFT of a transposed spectrum (see forward()), not scaled.
+  template<typename Real>
+  static void inverse(Real *spectrumReal, Real *spectrumImag, Real *real, Real *imag, const Tiling &tiles,
+                      const Real *cosinesX, const Real *sinesX, const Real *cosinesY, const Real *sinesY)
+  {
+    fft(spectrumReal, spectrumImag, tiles.width, tiles.height, cosinesX, sinesX, true);
+    transpose(spectrumReal, tiles.width, tiles.height, real);
+    transpose(spectrumImag, tiles.width, tiles.height, imag);
+    fft(real, imag, tiles.height, tiles.width, cosinesY, sinesY, true);
+  }
+
+  /// Transpose a matrix of rows x cols values.
+  template<typename Real>
+  static void transpose(const Real *source, size_t rows, size_t cols, Real *target)
+  {
+    // Blocks of 16 x 16 values stay in cache
+    const size_t block = 16;
+    for (size_t r0 = 0; r0 < rows; r0 += block)
+    {
+      for (size_t c0 = 0; c0 < cols; c0 += block)
+      {
+        for (size_t r = r0; r < std::min(r0 + block, rows); r++)
+        {
+          for (size_t c = c0; c < std::min(c0 + block, cols); c++)
+          {
+            target[c * rows + r] = source[r * cols + c];
+          }
+        }
+      }
+    }
+  }
+
+  /// Radix-2 FFT of signals stored side by side.
+  ///
+  /// Sample k of signal l is stored at data[k * lanes + l], so each
+  /// butterfly processes a contiguous vector of samples. The transform is
+  /// not scaled.
+  ///
+  /// \param[in,out] real Real part
+  /// \param[in,out] imag Imaginary part
+  /// \param[in] n Signal length; a power of two
+  /// \param[in] lanes Number of signals
+  /// \param[in] cosines Real part of the twiddle factors; n / 2 values
+  /// \param[in] sines Imaginary part of the twiddle factors; n / 2 values
+  /// \param[in] inverse True for the inverse transform
+  template<typename Real>
+  static void fft(Real *real, Real *imag, size_t n, size_t lanes, const Real *cosines, const Real *sines, bool inverse)
+  {
+    // Bit reversed order
+    for (size_t i = 1, j = 0; i < n; i++)
+    {
+      size_t bit = n >> 1;
+      for (; (j & bit) != 0; bit >>= 1)
+      {
+        j ^= bit;
+      }
+      j |= bit;
+      if (i < j)
+      {
+        std::swap_ranges(real + i * lanes, real + (i + 1) * lanes, real + j * lanes);
+        std::swap_ranges(imag + i * lanes, imag + (i + 1) * lanes, imag + j * lanes);
+      }
+    }
+
+    // Butterflies of transforms of length 2 * half
+    for (size_t half = 1; half < n; half *= 2)
+    {
+      const size_t step = n / (2 * half);
+      for (size_t start = 0; start < n; start += 2 * half)
+      {
+        for (size_t k = 0; k < half; k++)
+        {
+          const Real wr = cosines[k * step];
+          const Real wi = (inverse ? -sines[k * step] : sines[k * step]);
+          Real *a = real + (start + k) * lanes;
+          Real *b = imag + (start + k) * lanes;
+          butterflies(a, b, a + half * lanes, b + half * lanes, wr, wi, lanes);
+        }
+      }
+    }
+  }
+
+  /// Butterflies of signals side by side: a + w b and a - w b, with complex
+  /// samples a = (ar, ai), b = (br, bi) and twiddle factor w = (wr, wi).
+  template<typename Real>
+  static void butterflies(Real *ar, Real *ai, Real *br, Real *bi, Real wr, Real wi, size_t lanes)
+  {
+    for (size_t l = 0; l < lanes; l++)
+    {
+      const Real tr = wr * br[l] - wi * bi[l];
+      const Real ti = wr * bi[l] + wi * br[l];
+      br[l] = ar[l] - tr;
+      bi[l] = ai[l] - ti;
+      ar[l] += tr;
+      ai[l] += ti;
+    }
+  }
+
+  /// Correlate a padded row with a kernel row:
+  /// sum[i] += weights[0] * row[i] + weights[1] * row[i + stride] + ...
+  template<typename Real>
+  static void correlateRow(Real *sum, const Real *row, const Real *weights, size_t taps, size_t stride, size_t count)
+  {
+    for (size_t j = 0; j < taps; j++)
+    {
+      multiplyAdd(sum, row + j * stride, weights[j], count);
+    }
+  }
+
+  /// Add a row multiplied by a weight: sum[i] += weight * row[i].
+  template<typename Real>
+  static void multiplyAdd(Real *sum, const Real *row, Real weight, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      sum[i] += weight * row[i];
+    }
+  }
+
+#ifdef SPATIUMLIB_IMGPROC_CONVOLVE_SSE2
+  /// Add a row multiplied by a weight; 8 floats per step.
+  static void multiplyAdd(float *sum, const float *row, float weight, size_t count)
+  {
+    const __m128 w = _mm_set1_ps(weight);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+      const __m128 low = _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(w, _mm_loadu_ps(row + i)));
+      const __m128 high = _mm_add_ps(_mm_loadu_ps(sum + i + 4), _mm_mul_ps(w, _mm_loadu_ps(row + i + 4)));
+      _mm_storeu_ps(sum + i, low);
+      _mm_storeu_ps(sum + i + 4, high);
+    }
+    for (; i < count; i++)
+    {
+      sum[i] += weight * row[i];
+    }
+  }
+
+  /// Butterflies of signals side by side; 4 floats per step.
+  static void butterflies(float *ar, float *ai, float *br, float *bi, float wr, float wi, size_t lanes)
+  {
+    const __m128 cr = _mm_set1_ps(wr);
+    const __m128 ci = _mm_set1_ps(wi);
+    size_t l = 0;
+    for (; l + 4 <= lanes; l += 4)
+    {
+      const __m128 xr = _mm_loadu_ps(br + l);
+      const __m128 xi = _mm_loadu_ps(bi + l);
+      const __m128 yr = _mm_loadu_ps(ar + l);
+      const __m128 yi = _mm_loadu_ps(ai + l);
+      const __m128 tr = _mm_sub_ps(_mm_mul_ps(cr, xr), _mm_mul_ps(ci, xi));
+      const __m128 ti = _mm_add_ps(_mm_mul_ps(cr, xi), _mm_mul_ps(ci, xr));
+      _mm_storeu_ps(br + l, _mm_sub_ps(yr, tr));
+      _mm_storeu_ps(bi + l, _mm_sub_ps(yi, ti));
+      _mm_storeu_ps(ar + l, _mm_add_ps(yr, tr));
+      _mm_storeu_ps(ai + l, _mm_add_ps(yi, ti));
+    }
+    for (; l < lanes; l++)
+    {
+      const float tr = wr * br[l] - wi * bi[l];
+      const float ti = wr * bi[l] + wi * br[l];
+      br[l] = ar[l] - tr;
+      bi[l] = ai[l] - ti;
+      ar[l] += tr;
+      ai[l] += ti;
+    }
+  }
+
+  /// Correlate a padded row with a kernel row; 16 floats per step. The sums
+  /// stay in registers for all taps; four independent sums hide the latency
+  /// of the additions.
+  static void correlateRow(float *sum, const float *row, const float *weights, size_t taps, size_t stride, size_t count)
+  {
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+      __m128 s0 = _mm_loadu_ps(sum + i);
+      __m128 s1 = _mm_loadu_ps(sum + i + 4);
+      __m128 s2 = _mm_loadu_ps(sum + i + 8);
+      __m128 s3 = _mm_loadu_ps(sum + i + 12);
+      const float *tap = row + i;
+      for (size_t j = 0; j < taps; j++, tap += stride)
+      {
+        const __m128 w = _mm_set1_ps(weights[j]);
+        s0 = _mm_add_ps(s0, _mm_mul_ps(w, _mm_loadu_ps(tap)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(w, _mm_loadu_ps(tap + 4)));
+        s2 = _mm_add_ps(s2, _mm_mul_ps(w, _mm_loadu_ps(tap + 8)));
+        s3 = _mm_add_ps(s3, _mm_mul_ps(w, _mm_loadu_ps(tap + 12)));
+      }
+      _mm_storeu_ps(sum + i, s0);
+      _mm_storeu_ps(sum + i + 4, s1);
+      _mm_storeu_ps(sum + i + 8, s2);
+      _mm_storeu_ps(sum + i + 12, s3);
+    }
+    for (; i < count; i++)
+    {
+      for (size_t j = 0; j < taps; j++)
+      {
+        sum[i] += weights[j] * row[i + j * stride];
+      }
+    }
+  }
+
+  /// Add a row multiplied by a weight; 4 doubles per step.
+  static void multiplyAdd(double *sum, const double *row, double weight, size_t count)
+  {
+    const __m128d w = _mm_set1_pd(weight);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+      const __m128d low = _mm_add_pd(_mm_loadu_pd(sum + i), _mm_mul_pd(w, _mm_loadu_pd(row + i)));
+      const __m128d high = _mm_add_pd(_mm_loadu_pd(sum + i + 2), _mm_mul_pd(w, _mm_loadu_pd(row + i + 2)));
+      _mm_storeu_pd(sum + i, low);
+      _mm_storeu_pd(sum + i + 2, high);
+    }
+    for (; i < count; i++)
+    {
+      sum[i] += weight * row[i];
+    }
+  }
+#endif
+
+  /// Convert filtered samples begin .. end-1 of a row to sample type.
+  template<typename Real, typename T>
+  static void writeRow(const Real *sums, T *out, size_t begin, size_t end)
+  {
+    for (size_t i = begin; i < end; i++)
+    {
+      out[i] = toSample<T>(sums[i]);
+    }
+  }
+
+  /// Convert filtered value to sample type.
+  template<typename T, typename Real>
+  static T toSample(Real value)
+  {
+    if (!std::numeric_limits<T>::is_integer)
+    {
+      return static_cast<T>(value);
+    }
+    // Round to nearest, then saturate. Kernels may amplify far beyond the
+    // sample range, so saturate before the conversion.
+    const double rounded = std::floor(static_cast<double>(value) + 0.5);
+    if (rounded <= static_cast<double>(std::numeric_limits<T>::min()))
+    {
+      return std::numeric_limits<T>::min();
+    }
+    if (rounded >= static_cast<double>(std::numeric_limits<T>::max()))
+    {
+      return std::numeric_limits<T>::max();
+    }
+    return static_cast<T>(rounded);
+  }
+
+  /// Kernel
+  Matrix m_kernel;
+
+  /// Convolution method
+  Method m_method;
+
+  /// Kernel rows and columns
+  size_t m_rows;
+  size_t m_cols;
+
+  /// Flipped kernel; row major
+  std::vector<double> m_weights;
+
+  /// Flipped kernel = column * row, if separable
+  std::vector<double> m_columnWeights;
+  std::vector<double> m_rowWeights;
+  bool m_separable;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_CONVOLVE_H
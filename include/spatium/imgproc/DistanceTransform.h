@@ -0,0 +1,313 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_DISTANCETRANSFORM_H
+#define SPATIUMLIB_IMGPROC_DISTANCETRANSFORM_H
+
+#include "spatium/Image.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::sqrt
+#include <cstddef> // size_t
+#include <cstdint> // std::int64_t
+#include <limits> // std::numeric_limits
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class DistanceTransform
+/// \brief Euclidean distance transform of binary images
+///
+/// Computes for every pixel the Euclidean distance to the nearest feature
+/// (non-zero) pixel of a mask, and optionally the index (y * width + x) of
+/// that feature pixel. Distances are exact.
+///
+/// The transform is separable (Felzenszwalb and Huttenlocher, 2012):
+///
+/// 1. Columns: the nearest feature pixel in the same column, by a scan down
+///    and a scan up. Columns are scanned side by side, a row at a time.
+/// 2. Rows: the squared distance is the lower envelope of the parabolas
+///    (x - q)^2 + f(q) of the columns q of the row, where f(q) is the
+///    squared column distance. The envelope is built in one sweep and then
+///    sampled.
+///
+/// Both passes take linear time, regardless of the distances. With a thread
+/// pool the column pass is executed on bands of columns and the row pass on
+/// bands of rows in parallel.
+///
+/// If the mask has no feature pixels, all distances are infinite and all
+/// indices are the maximum unsigned int. The number of pixels of an image
+/// is limited to the range of unsigned int.
+///
+/// Example:
+/// \code
+/// DistanceTransform transform;
+/// transform.apply(mask, distances);
+/// \endcode
+class DistanceTransform
+{
+public:
+  /// Compute distances.
+  ///
+  /// \param[in] mask Binary image; non-zero pixels are features
+  /// \param[out] distance Distance to the nearest feature pixel. Should have
+  /// the size of the mask.
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<unsigned char, 1> &mask, Image<float, 1> &distance) const
+  {
+    return apply(mask, &distance, nullptr, nullptr);
+  }
+
+  /// Compute distances in parallel.
+  ///
+  /// \param[in] mask Binary image; non-zero pixels are features
+  /// \param[out] distance Distance to the nearest feature pixel. Should have
+  /// the size of the mask.
+  /// \param[in] pool Thread pool
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<unsigned char, 1> &mask, Image<float, 1> &distance, ThreadPool &pool) const
+  {
+    return apply(mask, &distance, nullptr, &pool);
+  }
+
+  /// Compute distances and nearest feature pixels.
+  ///
+  /// \param[in] mask Binary image; non-zero pixels are features
+  /// \param[out] distance Distance to the nearest feature pixel. May be
+  /// nullptr.
+  /// \param[out] nearest Index (y * width + x) of the nearest feature pixel;
+  /// one of the nearest if several are equally near. May be nullptr.
+  /// \param[in] pool Thread pool; nullptr to compute on the calling thread
+  /// (default)
+  /// \return True on success, false on image dimensions mismatch of any
+  /// output image
+  bool apply(const Image<unsigned char, 1> &mask, Image<float, 1> *distance, Image<unsigned int, 1> *nearest,
+             ThreadPool *pool = nullptr) const
+  {
+    if (!matchesMask(mask, distance) ||
+        !matchesMask(mask, nearest))
+    {
+      return false;
+    }
+
+    const size_t width = mask.width();
+    const size_t height = mask.height();
+    if (width == 0 || height == 0)
+    {
+      return true;
+    }
+
+    // Row of the nearest feature pixel in the column of every pixel
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(mask.imageDataPtr());
+    std::vector<unsigned int> nearestRows(width * height);
+    const size_t threads = (pool != nullptr ? pool->threadCount() : 1);
+    const size_t bandWidth = (pool != nullptr ? std::max<size_t>(64, (width / (4 * threads) + 15) / 16 * 16) : width);
+    const size_t columnBands = (width + bandWidth - 1) / bandWidth;
+    runBands(pool, columnBands, [&](size_t band, size_t) {
+      scanColumns(in, width, height, band * bandWidth, std::min((band + 1) * bandWidth, width), nearestRows.data());
+    });
+
+    // Lower envelope per row
+    float *distances = (distance != nullptr ? reinterpret_cast<float*>(distance->imageDataPtr()) : nullptr);
+    unsigned int *indices = (nearest != nullptr ? reinterpret_cast<unsigned int*>(nearest->imageDataPtr()) : nullptr);
+    const size_t bandHeight = (pool != nullptr ? std::max<size_t>(16, height / (4 * threads) + 1) : height);
+    const size_t rowBands = (height + bandHeight - 1) / bandHeight;
+    runBands(pool, rowBands, [&](size_t band, size_t) {
+      Envelope envelope(width);
+      for (size_t y = band * bandHeight; y < std::min((band + 1) * bandHeight, height); y++)
+      {
+        transformRow(nearestRows.data() + y * width, width, y, envelope,
+                     (distances != nullptr ? distances + y * width : nullptr),
+                     (indices != nullptr ? indices + y * width : nullptr));
+      }
+    });
+
+    return true;
+  }
+
+protected:
+  /// Index of no pixel
+  static unsigned int none()
+  {
+    return std::numeric_limits<unsigned int>::max();
+  }
+
+  /// Lower envelope of parabolas of a row
+  struct Envelope
+  {
+    explicit Envelope(size_t width)
+      : columns(width)
+      , heights(width)
+      , numerators(width)
+      , denominators(width)
+    {
+    }
+
+    /// Column of the apex of every parabola
+    std::vector<size_t> columns;
+
+    /// Height of the apex of every parabola; squared column distance
+    std::vector<std::int64_t> heights;
+
+    /// Left boundary of every parabola but the first, as a fraction with a
+    /// positive denominator
+    std::vector<std::int64_t> numerators;
+
+    /// Denominator of the left boundary of every parabola
+    std::vector<std::int64_t> denominators;
+  };
+
+  /// Check if an optional output image has the size of the mask.
+  template<typename T>
+  static bool matchesMask(const Image<unsigned char, 1> &mask, const Image<T, 1> *output)
+  {
+    return (output == nullptr ||
+            (output->width() == mask.width() && output->height() == mask.height()));
+  }
+
+  /// Run a task per band; on the thread pool if given.
+  static void runBands(ThreadPool *pool, size_t bandCount, const ThreadPool::Task &task)
+  {
+    if (pool != nullptr)
+    {
+      pool->run(bandCount, task);
+    }
+    else
+    {
+      for (size_t band = 0; band < bandCount; band++)
+      {
+        task(band, 0);
+      }
+    }
+  }
+
+  /// Find the nearest feature pixel in the column of every pixel, for
+  /// columns begin .. end-1. none() if the column has no feature pixel.
+  static void scanColumns(const unsigned char *in, size_t width, size_t height, size_t begin, size_t end,
+                          unsigned int *nearestRows)
+  {
+    // Down: nearest feature pixel above or at the pixel
+    std::vector<unsigned int> last(end - begin, none());
+    for (size_t y = 0; y < height; y++)
+    {
+      const unsigned char *row = in + y * width + begin;
+      unsigned int *rows = nearestRows + y * width + begin;
+      for (size_t i = 0; i < end - begin; i++)
+      {
+        last[i] = (row[i] != 0 ? static_cast<unsigned int>(y) : last[i]);
+        rows[i] = last[i];
+      }
+    }
+
+    // Up: the nearer of the feature pixel above and the one below
+    last.assign(end - begin, none());
+    for (size_t y = height; y-- > 0;)
+    {
+      const unsigned char *row = in + y * width + begin;
+      unsigned int *rows = nearestRows + y * width + begin;
+      for (size_t i = 0; i < end - begin; i++)
+      {
+        last[i] = (row[i] != 0 ? static_cast<unsigned int>(y) : last[i]);
+        const bool below = (last[i] != none() && (rows[i] == none() || last[i] - y < y - rows[i]));
+        rows[i] = (below ? last[i] : rows[i]);
+      }
+    }
+  }
+
+  /// Transform a row from the nearest feature pixels in the columns.
+  static void transformRow(const unsigned int *nearestRows, size_t width, size_t y, Envelope &envelope,
+                           float *distances, unsigned int *indices)
+  {
+    // Lower envelope of the parabolas of the columns with a feature pixel.
+    // A parabola is removed while it is not lowest anywhere right of the
+    // boundary with the parabola before it. Boundaries are exact fractions;
+    // they are compared by cross multiplication.
+    size_t count = 0;
+    for (size_t q = 0; q < width; q++)
+    {
+      if (nearestRows[q] == none())
+      {
+        continue;
+      }
+      const std::int64_t dy = static_cast<std::int64_t>(nearestRows[q]) - static_cast<std::int64_t>(y);
+      const std::int64_t height = dy * dy;
+      const std::int64_t column = static_cast<std::int64_t>(q);
+
+      std::int64_t numerator = 0;
+      std::int64_t denominator = 1;
+      while (count > 0)
+      {
+        const std::int64_t p = static_cast<std::int64_t>(envelope.columns[count - 1]);
+        numerator = (height + column * column) - (envelope.heights[count - 1] + p * p);
+        denominator = 2 * (column - p);
+        if (count > 1 && numerator * envelope.denominators[count - 1] <= envelope.numerators[count - 1] * denominator)
+        {
+          count--;
+        }
+        else
+        {
+          break;
+        }
+      }
+      envelope.columns[count] = q;
+      envelope.heights[count] = height;
+      envelope.numerators[count] = numerator;
+      envelope.denominators[count] = denominator;
+      count++;
+    }
+
+    // No feature pixels at all
+    if (count == 0)
+    {
+      for (size_t x = 0; x < width; x++)
+      {
+        if (distances != nullptr)
+        {
+          distances[x] = std::numeric_limits<float>::infinity();
+        }
+        if (indices != nullptr)
+        {
+          indices[x] = none();
+        }
+      }
+      return;
+    }
+
+    // Sample the envelope
+    size_t k = 0;
+    for (size_t x = 0; x < width; x++)
+    {
+      const std::int64_t position = static_cast<std::int64_t>(x);
+      while (k + 1 < count && envelope.numerators[k + 1] < position * envelope.denominators[k + 1])
+      {
+        k++;
+      }
+      const size_t q = envelope.columns[k];
+      const std::int64_t dx = static_cast<std::int64_t>(x) - static_cast<std::int64_t>(q);
+      if (distances != nullptr)
+      {
+        distances[x] = static_cast<float>(std::sqrt(static_cast<double>(dx * dx + envelope.heights[k])));
+      }
+      if (indices != nullptr)
+      {
+        indices[x] = static_cast<unsigned int>(nearestRows[q] * width + q);
+      }
+    }
+  }
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_DISTANCETRANSFORM_H
@@ -66,46 +66,41 @@ public:
       return false;
     }
 
-    T newValue = std::numeric_limits<T>::max();
-
+    const size_t width = input.width();
     for (size_t y = 0; y < input.height(); y++)
     {
-      for (size_t x = 0; x < input.width(); x++)
-      {
-        std::array<T, N> pixel = input.pixel(x, y);
-        T value = PixelValue<T, 1>::value(pixel)[0];
-        if (value > m_thresholdValue)
-        {
-          output.pixel(x, y) = { newValue };
-        }
-        else {
-          output.pixel(x, y) = { 0 };
-        }
-      }
+      applyRow<N>(input.imageDataPtr() + y * width, width, output.imageDataPtr() + y * width);
     }
 
     return true;
   }
 
+  /// Apply filter on a single row.
+  ///
+  /// \param[in] input Row of input pixels
+  /// \param[in] width Number of pixels in row
+  /// \param[out] output Row of binary pixels
+  template<int N>
+  void applyRow(const std::array<T, N> *input, size_t width, std::array<T, 1> *output) const
+  {
+    const T newValue = std::numeric_limits<T>::max();
+    const T threshold = m_thresholdValue;
+
+    // Select without branches, so the compiler vectorizes single channel rows
+    for (size_t x = 0; x < width; x++)
+    {
+      const T value = PixelValue<T, 1>::value(input[x])[0];
+      output[x][0] = (value > threshold ? newValue : T(0));
+    }
+  }
+
   // Apply in place
   bool apply(Image<T, 1> &inoutput)
   {
-    T newValue = std::numeric_limits<T>::max();
-
-    for (int y = 0; y < inoutput.height(); y++)
+    const size_t width = inoutput.width();
+    for (size_t y = 0; y < inoutput.height(); y++)
     {
-      for (int x = 0; x < inoutput.width(); x++)
-      {
-        std::array<T, 1> pixel = inoutput.pixel(x, y);
-        T value = pixel[0];
-        if (value > m_thresholdValue)
-        {
-          inoutput.pixel(x, y) = { newValue };
-        }
-        else {
-          inoutput.pixel(x, y) = { 0 };
-        }
-      }
+      applyRow<1>(inoutput.imageDataPtr() + y * width, width, inoutput.imageDataPtr() + y * width);
     }
 
     return true;
@@ -15,13 +15,35 @@
 
 #include "IImageFilter.h"
 
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::floor
+#include <cstdint> // std::uint32_t
+#include <limits> // std::numeric_limits
+#include <type_traits> // std::conditional
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUMLIB_IMGPROC_GRAYSCALE_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+#define SPATIUMLIB_IMGPROC_GRAYSCALE_SSSE3
+#include <tmmintrin.h> // SSSE3 intrinsics
+#endif
+
 namespace spatium {
 namespace imgproc {
 
 /// \class Grayscale
 /// \brief Color image to grayscale
 ///
-/// Convert color image as RGB format to grayscale.
+/// Convert color image as RGB or RGBA format to grayscale. Alpha is ignored.
+///
+/// Integer gray values are rounded to nearest and saturated. 8-bit and
+/// 16-bit images are converted in 14-bit fixed point if the coefficients are
+/// not negative and their sum is at most 1. 8-bit RGBA images are converted
+/// 16 pixels at a time with SSE2, 8-bit RGB images with SSSE3 (or AVX). The
+/// fixed point result may differ by 1 from the floating point result.
 template<typename T = unsigned char>
 class Grayscale : public IImageFilter
 {
@@ -38,10 +60,9 @@ public:
   Grayscale(double redCoeff = 0.2125,
             double greenCoeff = 0.7154,
             double blueCoff = 0.0721)
-    : m_redCoeff(redCoeff)
-    , m_greenCoeff(greenCoeff)
-    , m_blueCoeff(blueCoff)
-  {}
+  {
+    setCoefficients(redCoeff, greenCoeff, blueCoff);
+  }
 
   /// Apply filter.
   ///
@@ -50,23 +71,37 @@ public:
   /// \return True on success, false on image dimensions mismatch
   bool apply(const Image<T, 3> &input, Image<T, 1> &output)
   {
-    // Check image sizes
-    if (input.width() != output.width() ||
-        input.height() != output.height())
-    {
-      return false;
-    }
+    return applyImage(input, output);
+  }
 
-    for (size_t y = 0; y < input.height(); y++)
-    {
-      for (size_t x = 0; x < input.width(); x++)
-      {
-        std::array<T, 3> pixel = input.pixel(x, y);
-        output.pixel(x, y) = { pixel[0] * m_redCoeff + pixel[1] * m_greenCoeff + pixel[2] * m_blueCoeff };
-      }
-    }
+  /// Apply filter.
+  ///
+  /// \param[in] input RGBA image with 4 channels; alpha is ignored
+  /// \param[out] output Grayscale image with 1 channel
+  /// \return True on success, false on image dimensions mismatch
+  bool apply(const Image<T, 4> &input, Image<T, 1> &output)
+  {
+    return applyImage(input, output);
+  }
 
-    return true;
+  /// Apply filter on a single row.
+  ///
+  /// \param[in] input Row of RGB pixels
+  /// \param[in] width Number of pixels in row
+  /// \param[out] output Row of grayscale pixels
+  void applyRow(const std::array<T, 3> *input, size_t width, std::array<T, 1> *output) const
+  {
+    convertRow<3>(reinterpret_cast<const T*>(input), width, reinterpret_cast<T*>(output));
+  }
+
+  /// Apply filter on a single row.
+  ///
+  /// \param[in] input Row of RGBA pixels; alpha is ignored
+  /// \param[in] width Number of pixels in row
+  /// \param[out] output Row of grayscale pixels
+  void applyRow(const std::array<T, 4> *input, size_t width, std::array<T, 1> *output) const
+  {
+    convertRow<4>(reinterpret_cast<const T*>(input), width, reinterpret_cast<T*>(output));
   }
 
   /// Set RGB coefficients.
@@ -83,6 +118,24 @@ public:
     m_redCoeff = redCoeff;
     m_greenCoeff = greenCoeff;
     m_blueCoeff = blueCoeff;
+
+    // Fixed point weights. The rounding error goes to the largest weight, so
+    // the weights add up to the rounded sum of the coefficients; white stays
+    // white.
+    const double scale = static_cast<double>(1 << fractionBits);
+    const double coefficients[3] = { redCoeff, greenCoeff, blueCoeff };
+    const int sum = static_cast<int>(std::floor((redCoeff + greenCoeff + blueCoeff) * scale + 0.5));
+    m_fixedPoint = (redCoeff >= 0 && greenCoeff >= 0 && blueCoeff >= 0 && sum <= (1 << fractionBits));
+    int largest = 0;
+    int weightSum = 0;
+    for (int c = 0; c < 3; c++)
+    {
+      m_weights[c] = static_cast<int>(std::floor(coefficients[c] * scale + 0.5));
+      weightSum += m_weights[c];
+      largest = (coefficients[c] > coefficients[largest] ? c : largest);
+    }
+    m_weights[largest] += sum - weightSum;
+    m_fixedPoint = m_fixedPoint && m_weights[largest] >= 0;
   }
 
   /// Get RGB coefficients.
@@ -98,13 +151,230 @@ public:
   }
 
 private:
+  /// Number of fraction bits of the fixed point weights
+  static const int fractionBits = 14;
+
+  /// Apply filter on an image with N channels.
+  template<int N>
+  bool applyImage(const Image<T, N> &input, Image<T, 1> &output) const
+  {
+    // Check image sizes
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+
+    const size_t width = input.width();
+    for (size_t y = 0; y < input.height(); y++)
+    {
+      applyRow(input.imageDataPtr() + y * width, width, output.imageDataPtr() + y * width);
+    }
+
+    return true;
+  }
+
+  /// Convert a row of 8-bit pixels with N channels.
+  template<int N>
+  void convertRow(const unsigned char *input, size_t width, unsigned char *output) const
+  {
+    if (!m_fixedPoint)
+    {
+      convertRowFloat<N>(input, width, output);
+      return;
+    }
+
+    size_t x = 0;
+#ifdef SPATIUMLIB_IMGPROC_GRAYSCALE_SSSE3
+    if (N == 3)
+    {
+      convertRgbSsse3(input, width, output);
+      x = width - width % 16;
+    }
+#endif
+#ifdef SPATIUMLIB_IMGPROC_GRAYSCALE_SSE2
+    if (N == 4)
+    {
+      convertRgbaSse2(input, width, output);
+      x = width - width % 16;
+    }
+#endif
+    convertRowFixed<N>(input + x * N, width - x, output + x);
+  }
+
+  /// Convert a row of 16-bit pixels with N channels.
+  template<int N>
+  void convertRow(const unsigned short *input, size_t width, unsigned short *output) const
+  {
+    if (m_fixedPoint)
+    {
+      convertRowFixed<N>(input, width, output);
+    }
+    else
+    {
+      convertRowFloat<N>(input, width, output);
+    }
+  }
+
+  /// Convert a row of pixels with N channels.
+  template<int N, typename U>
+  void convertRow(const U *input, size_t width, U *output) const
+  {
+    convertRowFloat<N>(input, width, output);
+  }
+
+  /// Convert a row of pixels in fixed point. The weighted sum is at most
+  /// 65535 * 2^14, so it fits 32 bits.
+  template<int N, typename U>
+  void convertRowFixed(const U *input, size_t width, U *output) const
+  {
+    const std::uint32_t red = static_cast<std::uint32_t>(m_weights[0]);
+    const std::uint32_t green = static_cast<std::uint32_t>(m_weights[1]);
+    const std::uint32_t blue = static_cast<std::uint32_t>(m_weights[2]);
+    const std::uint32_t half = 1u << (fractionBits - 1);
+    for (size_t x = 0; x < width; x++)
+    {
+      const U *pixel = input + x * N;
+      output[x] = static_cast<U>((pixel[0] * red + pixel[1] * green + pixel[2] * blue + half) >> fractionBits);
+    }
+  }
+
+  /// Convert a row of pixels in floating point.
+  template<int N, typename U>
+  void convertRowFloat(const U *input, size_t width, U *output) const
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      const U *pixel = input + x * N;
+      const double gray = pixel[0] * m_redCoeff + pixel[1] * m_greenCoeff + pixel[2] * m_blueCoeff;
+      output[x] = toSample<U>(gray);
+    }
+  }
+
+  /// Convert gray value to sample type; integers are rounded to nearest and
+  /// saturated.
+  template<typename U>
+  static U toSample(double value)
+  {
+    if (!std::numeric_limits<U>::is_integer)
+    {
+      return static_cast<U>(value);
+    }
+    // Round, then saturate in the integer domain, which the compiler
+    // vectorizes. Weighted sums of samples stay far within the range of the
+    // wider integer type for any sensible coefficients.
+    typedef typename std::conditional<(sizeof(U) < sizeof(int)), int, long long>::type Integer;
+    Integer rounded = static_cast<Integer>(std::numeric_limits<U>::is_signed ? std::floor(value + 0.5) : value + 0.5);
+    rounded = std::max(rounded, static_cast<Integer>(std::numeric_limits<U>::min()));
+    rounded = std::min(rounded, static_cast<Integer>(std::numeric_limits<U>::max()));
+    return static_cast<U>(rounded);
+  }
+
+#ifdef SPATIUMLIB_IMGPROC_GRAYSCALE_SSE2
+  /// Convert 8-bit RGBA pixels 16 at a time; a multiple of 16 pixels.
+  ///
+  /// Every 32-bit lane holds a pixel. Masking gives 16-bit pairs (R, B) and
+  /// (G, A), which are weighted and summed by multiply-add.
+  void convertRgbaSse2(const unsigned char *input, size_t width, unsigned char *output) const
+  {
+    const __m128i mask = _mm_set1_epi32(0x00FF00FF);
+    const __m128i redBlue = _mm_set1_epi32(m_weights[0] | (m_weights[2] << 16));
+    const __m128i green = _mm_set1_epi32(m_weights[1]);
+    const __m128i half = _mm_set1_epi32(1 << (fractionBits - 1));
+    for (size_t x = 0; x + 16 <= width; x += 16)
+    {
+      __m128i gray[4];
+      for (int i = 0; i < 4; i++)
+      {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + (x + 4 * i) * 4));
+        const __m128i rb = _mm_and_si128(pixels, mask);
+        const __m128i ga = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+        const __m128i sum = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rb, redBlue), _mm_madd_epi16(ga, green)), half);
+        gray[i] = _mm_srli_epi32(sum, fractionBits);
+      }
+      const __m128i low = _mm_packs_epi32(gray[0], gray[1]);
+      const __m128i high = _mm_packs_epi32(gray[2], gray[3]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x), _mm_packus_epi16(low, high));
+    }
+  }
+#endif
+
+#ifdef SPATIUMLIB_IMGPROC_GRAYSCALE_SSSE3
+  /// Convert 8-bit RGB pixels 16 at a time; a multiple of 16 pixels.
+  ///
+  /// The 48 bytes of 16 pixels are split into channels by byte shuffles.
+  /// Interleaved 16-bit pairs (R, G) and (B, 1) are weighted and summed by
+  /// multiply-add; the 1 adds the rounding term.
+  void convertRgbSsse3(const unsigned char *input, size_t width, unsigned char *output) const
+  {
+    __m128i shuffles[3][3];
+    for (int c = 0; c < 3; c++)
+    {
+      for (int block = 0; block < 3; block++)
+      {
+        shuffles[c][block] = shuffleMask(c, block);
+      }
+    }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i redGreen = _mm_set1_epi32(m_weights[0] | (m_weights[1] << 16));
+    const __m128i blueHalf = _mm_set1_epi32(m_weights[2] | ((1 << (fractionBits - 1)) << 16));
+
+    for (size_t x = 0; x + 16 <= width; x += 16)
+    {
+      const __m128i *data = reinterpret_cast<const __m128i*>(input + x * 3);
+      const __m128i blocks[3] = { _mm_loadu_si128(data), _mm_loadu_si128(data + 1), _mm_loadu_si128(data + 2) };
+      __m128i channels[3];
+      for (int c = 0; c < 3; c++)
+      {
+        channels[c] = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(blocks[0], shuffles[c][0]),
+                                                _mm_shuffle_epi8(blocks[1], shuffles[c][1])),
+                                   _mm_shuffle_epi8(blocks[2], shuffles[c][2]));
+      }
+
+      const __m128i rgLow = _mm_unpacklo_epi8(channels[0], channels[1]);
+      const __m128i rgHigh = _mm_unpackhi_epi8(channels[0], channels[1]);
+      const __m128i b1Low = _mm_unpacklo_epi8(channels[2], one);
+      const __m128i b1High = _mm_unpackhi_epi8(channels[2], one);
+      const __m128i rg[4] = { _mm_unpacklo_epi8(rgLow, zero), _mm_unpackhi_epi8(rgLow, zero),
+                              _mm_unpacklo_epi8(rgHigh, zero), _mm_unpackhi_epi8(rgHigh, zero) };
+      const __m128i b1[4] = { _mm_unpacklo_epi8(b1Low, zero), _mm_unpackhi_epi8(b1Low, zero),
+                              _mm_unpacklo_epi8(b1High, zero), _mm_unpackhi_epi8(b1High, zero) };
+      __m128i gray[4];
+      for (int i = 0; i < 4; i++)
+      {
+        const __m128i sum = _mm_add_epi32(_mm_madd_epi16(rg[i], redGreen), _mm_madd_epi16(b1[i], blueHalf));
+        gray[i] = _mm_srli_epi32(sum, fractionBits);
+      }
+      const __m128i low = _mm_packs_epi32(gray[0], gray[1]);
+      const __m128i high = _mm_packs_epi32(gray[2], gray[3]);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x), _mm_packus_epi16(low, high));
+    }
+  }
+
+  /// Byte shuffle that gathers channel c of 16 RGB pixels from block 0, 1 or
+  /// 2 of their 48 bytes. Bytes of other blocks are zeroed.
+  static __m128i shuffleMask(int c, int block)
+  {
+    char mask[16];
+    for (int i = 0; i < 16; i++)
+    {
+      const int index = 3 * i + c;
+      mask[i] = static_cast<char>(index / 16 == block ? index % 16 : -128);
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(mask));
+  }
+#endif
+
   double m_redCoeff;    ///< Red channel coefficient
   double m_greenCoeff;  ///< Green channel coefficient
   double m_blueCoeff;   ///< Blue channel coefficient
+
+  int m_weights[3];     ///< Fixed point red, green and blue weights
+  bool m_fixedPoint;    ///< Fixed point weights are valid
 };
 
 } // namespace imgproc
 } // namespace spatium
 
 #endif // SPATIUMLIB_IMGPROC_GRAYSCALE_H
-
@@ -0,0 +1,229 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_HISTOGRAM_H
+#define SPATIUMLIB_IMGPROC_HISTOGRAM_H
+
+#include "spatium/Image.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::copy, std::min
+#include <array> // std::array
+#include <cstddef> // size_t
+#include <limits> // std::numeric_limits
+#include <type_traits> // std::is_integral, std::is_unsigned
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class Histogram
+/// \brief Histogram of pixel values
+///
+/// Counts the pixels of an image with 8 or 16 bit unsigned integer values,
+/// per channel. There is one bin per value: 256 bins for unsigned char
+/// images and 65536 bins for unsigned short images.
+///
+/// The histogram can be computed in parallel. Every thread then counts bands
+/// of rows in a histogram of its own; these are summed afterwards.
+///
+/// Example:
+/// \code
+/// Histogram histogram;
+/// histogram.compute(image);
+/// size_t blackPixels = histogram.count(0);
+/// \endcode
+class Histogram
+{
+public:
+  /// Constructor. The histogram is empty.
+  Histogram()
+    : m_counts()
+    , m_total(0)
+  {
+  }
+
+  /// Compute histogram of image.
+  ///
+  /// \param[in] image Image
+  template<typename T, int N>
+  void compute(const Image<T, N> &image)
+  {
+    reset<T>(N);
+    std::vector<size_t> counts(N * binCount(), 0);
+    accumulate(image.imageDataPtr(), image.width() * image.height(), &counts[0]);
+    store(counts);
+    m_total = image.width() * image.height();
+  }
+
+  /// Compute histogram of image in parallel.
+  ///
+  /// \param[in] image Image
+  /// \param[in] pool Thread pool
+  template<typename T, int N>
+  void compute(const Image<T, N> &image, ThreadPool &pool)
+  {
+    reset<T>(N);
+
+    const size_t width = image.width();
+    const size_t height = image.height();
+    const size_t bandCount = std::min(height, 4 * pool.threadCount());
+
+    // Partial histogram per thread; the channels one after another
+    std::vector<std::vector<size_t>> partials(pool.threadCount(), std::vector<size_t>(N * binCount(), 0));
+    pool.run(bandCount, [&](size_t band, size_t thread) {
+      const size_t firstRow = height * band / bandCount;
+      const size_t lastRow = height * (band + 1) / bandCount;
+      accumulate(image.imageDataPtr() + firstRow * width, (lastRow - firstRow) * width, &partials[thread][0]);
+    });
+
+    std::vector<size_t> counts(N * binCount(), 0);
+    for (const std::vector<size_t> &partial : partials)
+    {
+      for (size_t bin = 0; bin < counts.size(); bin++)
+      {
+        counts[bin] += partial[bin];
+      }
+    }
+    store(counts);
+    m_total = width * height;
+  }
+
+  /// Get number of bins.
+  ///
+  /// \return Number of bins per channel; 0 if not computed
+  size_t binCount() const
+  {
+    return (m_counts.empty() ? 0 : m_counts[0].size());
+  }
+
+  /// Get number of channels.
+  ///
+  /// \return Number of channels; 0 if not computed
+  int channelCount() const
+  {
+    return static_cast<int>(m_counts.size());
+  }
+
+  /// Get number of pixels in bin.
+  ///
+  /// \param[in] bin Bin (pixel value)
+  /// \param[in] channel Channel (default = 0)
+  /// \return Number of pixels
+  size_t count(size_t bin, int channel = 0) const
+  {
+    return m_counts[channel][bin];
+  }
+
+  /// Get number of pixels of all bins.
+  ///
+  /// \param[in] channel Channel (default = 0)
+  /// \return Counts; one per bin
+  const std::vector<size_t> &counts(int channel = 0) const
+  {
+    return m_counts[channel];
+  }
+
+  /// Get total number of pixels.
+  ///
+  /// \return Number of pixels; per channel
+  size_t total() const
+  {
+    return m_total;
+  }
+
+protected:
+  /// Clear counts and allocate one bin per value of T for every channel.
+  template<typename T>
+  void reset(int channels)
+  {
+    static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value && sizeof(T) <= 2,
+                  "Histogram requires 8 or 16 bit unsigned integer pixels");
+
+    m_counts.assign(channels, std::vector<size_t>(static_cast<size_t>(std::numeric_limits<T>::max()) + 1, 0));
+    m_total = 0;
+  }
+
+  /// Store counts of all channels.
+  ///
+  /// \param[in] counts Counts; the channels one after another
+  void store(const std::vector<size_t> &counts)
+  {
+    const size_t bins = binCount();
+    for (size_t channel = 0; channel < m_counts.size(); channel++)
+    {
+      std::copy(counts.begin() + channel * bins, counts.begin() + (channel + 1) * bins, m_counts[channel].begin());
+    }
+  }
+
+  /// Add pixels to counts.
+  ///
+  /// \param[in] pixels Pixels
+  /// \param[in] count Number of pixels
+  /// \param[in,out] counts Counts; one per bin, the channels one after
+  /// another
+  template<typename T, size_t N>
+  static void accumulate(const std::array<T, N> *pixels, size_t count, size_t *counts)
+  {
+    const size_t bins = static_cast<size_t>(std::numeric_limits<T>::max()) + 1;
+    for (size_t i = 0; i < count; i++)
+    {
+      for (size_t c = 0; c < N; c++)
+      {
+        counts[c * bins + pixels[i][c]]++;
+      }
+    }
+  }
+
+  /// Add pixels to counts; 8 bit, single channel.
+  ///
+  /// Runs of equal values make consecutive increments of one bin wait for
+  /// each other. Four interleaved histograms, summed at the end, avoid this.
+  /// Channels of multichannel images interleave by themselves.
+  static void accumulate(const std::array<unsigned char, 1> *pixels, size_t count, size_t *counts)
+  {
+    std::vector<size_t> sub(4 * 256, 0);
+    size_t *sub0 = &sub[0];
+    size_t *sub1 = sub0 + 256;
+    size_t *sub2 = sub1 + 256;
+    size_t *sub3 = sub2 + 256;
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+      sub0[pixels[i][0]]++;
+      sub1[pixels[i + 1][0]]++;
+      sub2[pixels[i + 2][0]]++;
+      sub3[pixels[i + 3][0]]++;
+    }
+    for (; i < count; i++)
+    {
+      sub0[pixels[i][0]]++;
+    }
+
+    for (size_t bin = 0; bin < 256; bin++)
+    {
+      counts[bin] += sub0[bin] + sub1[bin] + sub2[bin] + sub3[bin];
+    }
+  }
+
+  /// Counts; one per bin, per channel
+  std::vector<std::vector<size_t>> m_counts;
+
+  /// Total number of pixels
+  size_t m_total;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_HISTOGRAM_H
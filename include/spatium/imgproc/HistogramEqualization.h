@@ -0,0 +1,204 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_HISTOGRAMEQUALIZATION_H
+#define SPATIUMLIB_IMGPROC_HISTOGRAMEQUALIZATION_H
+
+#include "IImageFilter.h"
+#include "Histogram.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::min
+#include <array> // std::array
+#include <cstddef> // size_t
+#include <limits> // std::numeric_limits
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class HistogramEqualization
+/// \brief Global histogram equalization
+///
+/// Spreads the values of an image with 8 or 16 bit unsigned integer values
+/// over the full range, per channel, so that the cumulative histogram
+/// becomes approximately linear. Value v is mapped through a lookup table
+/// built from the cumulative histogram cdf:
+///
+///   (cdf(v) - cdf(min)) / (total - cdf(min)) * maximum value
+///
+/// rounded to nearest, where min is the smallest value in the channel. The
+/// smallest value becomes 0 and the largest the maximum value. A channel
+/// with a single value is left unchanged.
+///
+/// With a thread pool, the histogram is computed and the lookup tables are
+/// applied on bands of rows in parallel.
+///
+/// Example:
+/// \code
+/// HistogramEqualization equalization;
+/// equalization.apply(image, image);
+/// \endcode
+class HistogramEqualization : public IImageFilter
+{
+public:
+  virtual ~HistogramEqualization() = default;
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, int N>
+  bool apply(const Image<T, N> &input, Image<T, N> &output) const
+  {
+    return equalize(input, output, nullptr);
+  }
+
+  /// Apply filter in parallel.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \param[in] pool Thread pool
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, int N>
+  bool apply(const Image<T, N> &input, Image<T, N> &output, ThreadPool &pool) const
+  {
+    return equalize(input, output, &pool);
+  }
+
+  /// Build the lookup table of a channel.
+  ///
+  /// \param[in] histogram Histogram of the image
+  /// \param[in] channel Channel
+  /// \return Output value of every input value
+  template<typename T>
+  static std::vector<T> lookupTable(const Histogram &histogram, int channel)
+  {
+    const std::vector<size_t> &counts = histogram.counts(channel);
+    std::vector<T> table(counts.size());
+    for (size_t value = 0; value < table.size(); value++)
+    {
+      table[value] = static_cast<T>(value);
+    }
+
+    // Count of the smallest value
+    size_t first = 0;
+    while (first < counts.size() && counts[first] == 0)
+    {
+      first++;
+    }
+    if (first == counts.size() || counts[first] == histogram.total())
+    {
+      return table;
+    }
+
+    // Exact rounding in 64-bit integers: the product of a pixel count and
+    // the maximum value stays far below 2^64
+    const unsigned long long maximum = std::numeric_limits<T>::max();
+    const unsigned long long range = histogram.total() - counts[first];
+    unsigned long long cumulative = 0;
+    for (size_t value = first; value < counts.size(); value++)
+    {
+      cumulative += counts[value];
+      const unsigned long long above = cumulative - counts[first];
+      table[value] = static_cast<T>((above * maximum + range / 2) / range);
+    }
+    return table;
+  }
+
+protected:
+  /// Equalize; in parallel if a thread pool is given.
+  template<typename T, int N>
+  bool equalize(const Image<T, N> &input, Image<T, N> &output, ThreadPool *pool) const
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    Histogram histogram;
+    if (pool != nullptr)
+    {
+      histogram.compute(input, *pool);
+    }
+    else
+    {
+      histogram.compute(input);
+    }
+
+    std::vector<std::vector<T>> tables(N);
+    for (int c = 0; c < N; c++)
+    {
+      tables[c] = lookupTable<T>(histogram, c);
+    }
+
+    // Pixels are mapped independently, so the output may be the input
+    const size_t pixelCount = input.width() * input.height();
+    const std::array<T, N> *in = input.imageDataPtr();
+    std::array<T, N> *out = output.imageDataPtr();
+    if (pool != nullptr)
+    {
+      const size_t bandCount = std::min(input.height(), 4 * pool->threadCount());
+      pool->run(bandCount, [&](size_t band, size_t) {
+        const size_t first = pixelCount * band / bandCount;
+        const size_t last = pixelCount * (band + 1) / bandCount;
+        map<T, N>(in + first, last - first, tables, out + first);
+      });
+    }
+    else
+    {
+      map<T, N>(in, pixelCount, tables, out);
+    }
+    return true;
+  }
+
+  /// Map pixels through the lookup tables.
+  ///
+  /// \param[in] pixels Input pixels
+  /// \param[in] count Number of pixels
+  /// \param[in] tables Lookup table per channel
+  /// \param[out] output Output pixels; may be the input pixels
+  template<typename T, int N>
+  static void map(const std::array<T, N> *pixels, size_t count, const std::vector<std::vector<T>> &tables,
+                  std::array<T, N> *output)
+  {
+    const T *table[N];
+    for (int c = 0; c < N; c++)
+    {
+      table[c] = &tables[c][0];
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        output[i][c] = table[c][pixels[i][c]];
+      }
+    }
+  }
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_HISTOGRAMEQUALIZATION_H
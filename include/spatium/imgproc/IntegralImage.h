@@ -0,0 +1,329 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_INTEGRALIMAGE_H
+#define SPATIUMLIB_IMGPROC_INTEGRALIMAGE_H
+
+#include "spatium/Image.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::max, std::min
+#include <cstddef> // size_t
+#include <cstdint> // std::int64_t, std::uint64_t
+#include <type_traits> // std::conditional, std::is_floating_point, std::is_integral, std::is_signed
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class IntegralImage
+/// \brief Integral image (summed area table)
+///
+/// Holds for every position the sum of the pixel values above and left of
+/// it, per channel. The sum of any rectangle of pixels then takes four
+/// lookups, regardless of its size. Optionally the sums of squared pixel
+/// values are held too, for the variance of rectangles.
+///
+/// Sums are accumulated in 64-bit integers for integer images (signed if T
+/// is signed) and in double for floating point images. Sums of 8 and 16 bit
+/// images are exact for images of up to 2^32 pixels; squared sums of larger
+/// integer types are accumulated in double.
+///
+/// On a single thread every table row is the row above plus the prefix sum of
+/// the image row, in one pass. The pass is bound by memory bandwidth of the
+/// 64-bit table, not by arithmetic. With a thread pool the table is built in
+/// two passes: prefix sums of all rows in parallel, then sums down bands of
+/// columns in parallel.
+///
+/// Example:
+/// \code
+/// IntegralImage<unsigned char> integral;
+/// integral.compute(image);
+/// double mean = integral.mean(10, 10, 20, 20);
+/// \endcode
+template<typename T>
+class IntegralImage
+{
+public:
+  /// Sum of pixel values
+  typedef typename std::conditional<std::is_floating_point<T>::value, double,
+          typename std::conditional<std::is_signed<T>::value, std::int64_t, std::uint64_t>::type>::type Sum;
+
+  /// Sum of squared pixel values
+  typedef typename std::conditional<std::is_integral<T>::value && sizeof(T) <= 2, Sum, double>::type SquareSum;
+
+  /// Constructor. The integral image is empty.
+  IntegralImage()
+    : m_width(0)
+    , m_height(0)
+    , m_channels(0)
+    , m_sums()
+    , m_squareSums()
+  {
+  }
+
+  /// Compute integral image.
+  ///
+  /// \param[in] image Image
+  /// \param[in] squares Also compute sums of squared values (default = false)
+  template<int N>
+  void compute(const Image<T, N> &image, bool squares = false)
+  {
+    reset(image.width(), image.height(), N, squares);
+
+    const T *data = reinterpret_cast<const T*>(image.imageDataPtr());
+    for (size_t y = 0; y < m_height; y++)
+    {
+      prefixRow<N>(data + y * m_width * N, m_width, row(m_sums, y), row(m_sums, y + 1));
+      if (squares)
+      {
+        prefixSquareRow<N>(data + y * m_width * N, m_width, row(m_squareSums, y), row(m_squareSums, y + 1));
+      }
+    }
+  }
+
+  /// Compute integral image in parallel.
+  ///
+  /// \param[in] image Image
+  /// \param[in] pool Thread pool
+  /// \param[in] squares Also compute sums of squared values (default = false)
+  template<int N>
+  void compute(const Image<T, N> &image, ThreadPool &pool, bool squares = false)
+  {
+    reset(image.width(), image.height(), N, squares);
+
+    // Prefix sum along rows. The first table row is 0; rows are summed on
+    // top of it.
+    const T *data = reinterpret_cast<const T*>(image.imageDataPtr());
+    pool.run(m_height, [&](size_t y, size_t) {
+      prefixRow<N>(data + y * m_width * N, m_width, row(m_sums, 0), row(m_sums, y + 1));
+      if (squares)
+      {
+        prefixSquareRow<N>(data + y * m_width * N, m_width, row(m_squareSums, 0), row(m_squareSums, y + 1));
+      }
+    });
+
+    // Sum down columns; bands of whole cache lines
+    const size_t stride = (m_width + 1) * m_channels;
+    const size_t bandWidth = std::max<size_t>(64, (stride / (4 * pool.threadCount()) + 7) / 8 * 8);
+    const size_t bandCount = (stride + bandWidth - 1) / bandWidth;
+    pool.run(bandCount, [&](size_t band, size_t) {
+      const size_t begin = band * bandWidth;
+      const size_t end = std::min(begin + bandWidth, stride);
+      sumColumns(m_sums, begin, end);
+      if (squares)
+      {
+        sumColumns(m_squareSums, begin, end);
+      }
+    });
+  }
+
+  /// Get width of the image.
+  ///
+  /// \return Width in pixels
+  size_t width() const
+  {
+    return m_width;
+  }
+
+  /// Get height of the image.
+  ///
+  /// \return Height in pixels
+  size_t height() const
+  {
+    return m_height;
+  }
+
+  /// Get number of channels of the image.
+  ///
+  /// \return Number of channels
+  size_t channels() const
+  {
+    return m_channels;
+  }
+
+  /// Check whether sums of squared values have been computed.
+  ///
+  /// \return True if computed, false otherwise
+  bool hasSquares() const
+  {
+    return !m_squareSums.empty();
+  }
+
+  /// Get sum of pixels above and left of a position.
+  ///
+  /// \param[in] x X coordinate; 0 .. width
+  /// \param[in] y Y coordinate; 0 .. height
+  /// \param[in] channel Channel (default = 0)
+  /// \return Sum of pixels [0, x) x [0, y)
+  Sum integral(size_t x, size_t y, size_t channel = 0) const
+  {
+    return m_sums[(y * (m_width + 1) + x) * m_channels + channel];
+  }
+
+  /// Get sum of pixels of a rectangle.
+  ///
+  /// \param[in] left Left column, inclusive
+  /// \param[in] top Top row, inclusive
+  /// \param[in] right Right column, exclusive; at most width
+  /// \param[in] bottom Bottom row, exclusive; at most height
+  /// \param[in] channel Channel (default = 0)
+  /// \return Sum of pixels [left, right) x [top, bottom)
+  Sum sum(size_t left, size_t top, size_t right, size_t bottom, size_t channel = 0) const
+  {
+    return rectangle(m_sums, left, top, right, bottom, channel);
+  }
+
+  /// Get sum of squared pixel values of a rectangle. Requires squares to be
+  /// computed.
+  ///
+  /// \param[in] left Left column, inclusive
+  /// \param[in] top Top row, inclusive
+  /// \param[in] right Right column, exclusive; at most width
+  /// \param[in] bottom Bottom row, exclusive; at most height
+  /// \param[in] channel Channel (default = 0)
+  /// \return Sum of squared pixel values [left, right) x [top, bottom)
+  SquareSum squareSum(size_t left, size_t top, size_t right, size_t bottom, size_t channel = 0) const
+  {
+    return rectangle(m_squareSums, left, top, right, bottom, channel);
+  }
+
+  /// Get mean of pixels of a non-empty rectangle.
+  ///
+  /// \param[in] left Left column, inclusive
+  /// \param[in] top Top row, inclusive
+  /// \param[in] right Right column, exclusive; at most width
+  /// \param[in] bottom Bottom row, exclusive; at most height
+  /// \param[in] channel Channel (default = 0)
+  /// \return Mean
+  double mean(size_t left, size_t top, size_t right, size_t bottom, size_t channel = 0) const
+  {
+    const double area = static_cast<double>((right - left) * (bottom - top));
+    return static_cast<double>(sum(left, top, right, bottom, channel)) / area;
+  }
+
+  /// Get (population) variance of pixels of a non-empty rectangle. Requires
+  /// squares to be computed.
+  ///
+  /// \param[in] left Left column, inclusive
+  /// \param[in] top Top row, inclusive
+  /// \param[in] right Right column, exclusive; at most width
+  /// \param[in] bottom Bottom row, exclusive; at most height
+  /// \param[in] channel Channel (default = 0)
+  /// \return Variance
+  double variance(size_t left, size_t top, size_t right, size_t bottom, size_t channel = 0) const
+  {
+    const double area = static_cast<double>((right - left) * (bottom - top));
+    const double mean = static_cast<double>(sum(left, top, right, bottom, channel)) / area;
+    const double variance = static_cast<double>(squareSum(left, top, right, bottom, channel)) / area - mean * mean;
+    return (variance > 0 ? variance : 0);
+  }
+
+protected:
+  /// Allocate table for an image; zero.
+  void reset(size_t width, size_t height, size_t channels, bool squares)
+  {
+    m_width = width;
+    m_height = height;
+    m_channels = channels;
+    m_sums.assign((width + 1) * (height + 1) * channels, 0);
+    m_squareSums.assign(squares ? m_sums.size() : 0, 0);
+  }
+
+  /// Get row of table; row y holds sums of image rows above y.
+  template<typename S>
+  S *row(std::vector<S> &table, size_t y) const
+  {
+    return &table[y * (m_width + 1) * m_channels];
+  }
+
+  /// Sum of rectangle from a table.
+  template<typename S>
+  S rectangle(const std::vector<S> &table, size_t left, size_t top, size_t right, size_t bottom, size_t channel) const
+  {
+    const size_t stride = (m_width + 1) * m_channels;
+    const S *topRow = &table[top * stride + channel];
+    const S *bottomRow = &table[bottom * stride + channel];
+    return bottomRow[right * m_channels] - bottomRow[left * m_channels] - topRow[right * m_channels] + topRow[left * m_channels];
+  }
+
+  /// Prefix sum of a row of pixels, added to the table row above.
+  ///
+  /// \param[in] input Row of pixels; N samples per pixel
+  /// \param[in] width Number of pixels
+  /// \param[in] above Table row above
+  /// \param[out] current Table row; the first pixel is left 0
+  template<int N, typename U>
+  static void prefixRow(const U *input, size_t width, const Sum *above, Sum *current)
+  {
+    Sum rowSums[N] = {};
+    for (size_t x = 0; x < width; x++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        rowSums[c] += static_cast<Sum>(input[x * N + c]);
+        current[(x + 1) * N + c] = above[(x + 1) * N + c] + rowSums[c];
+      }
+    }
+  }
+
+  /// Prefix sum of squares of a row of pixels, added to the table row above.
+  template<int N, typename U>
+  static void prefixSquareRow(const U *input, size_t width, const SquareSum *above, SquareSum *current)
+  {
+    SquareSum rowSums[N] = {};
+    for (size_t x = 0; x < width; x++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        const SquareSum value = static_cast<SquareSum>(input[x * N + c]);
+        rowSums[c] += value * value;
+        current[(x + 1) * N + c] = above[(x + 1) * N + c] + rowSums[c];
+      }
+    }
+  }
+
+  /// Add every table row to the row below it; columns begin .. end-1.
+  template<typename S>
+  void sumColumns(std::vector<S> &table, size_t begin, size_t end)
+  {
+    for (size_t y = 2; y <= m_height; y++)
+    {
+      const S *above = row(table, y - 1);
+      S *current = row(table, y);
+      for (size_t i = begin; i < end; i++)
+      {
+        current[i] += above[i];
+      }
+    }
+  }
+
+  /// Width of the image
+  size_t m_width;
+
+  /// Height of the image
+  size_t m_height;
+
+  /// Number of channels of the image
+  size_t m_channels;
+
+  /// Sums; (width + 1) x (height + 1) positions, channels per position
+  std::vector<Sum> m_sums;
+
+  /// Sums of squared values; empty if not computed
+  std::vector<SquareSum> m_squareSums;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_INTEGRALIMAGE_H
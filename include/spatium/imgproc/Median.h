@@ -0,0 +1,584 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_MEDIAN_H
+#define SPATIUMLIB_IMGPROC_MEDIAN_H
+
+#include "IImageFilter.h"
+#include "spatium/ThreadPool.h"
+
+#include <algorithm> // std::copy, std::fill, std::max, std::min
+#include <cstddef> // size_t, std::ptrdiff_t
+#include <cstdint> // std::uint16_t, std::uint32_t
+#include <cstring> // std::memcpy
+#include <vector> // std::vector
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUMLIB_IMGPROC_MEDIAN_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+
+namespace spatium {
+namespace imgproc {
+
+/// \class Median
+/// \brief Median filter for 8-bit images
+///
+/// Each output pixel is the median of the square window of
+/// (2 * radius + 1) x (2 * radius + 1) input pixels around it, per channel.
+/// Pixels outside the image are clamped to the nearest border pixel.
+///
+/// Radius 1 and 2 (3x3 and 5x5) use selection networks of 19 and 99
+/// compare-exchanges (Devillard, 1998), applied to 16 samples at a time
+/// with SSE2.
+///
+/// Larger radii use the sliding histogram of Perreault and Hebert (2007):
+/// every column keeps a histogram of the window rows, updated with one
+/// removal and one addition when moving down a row. The window histogram is
+/// the sum of the column histograms; moving right adds one column histogram
+/// and removes another. Histograms have two levels, 16 coarse bins and 256
+/// fine bins. The coarse level locates the 16 values that hold the median;
+/// only that part of the fine level is brought up to date, lazily. The cost
+/// per pixel does not depend on the radius.
+///
+/// With a thread pool, the image is divided into bands of rows that are
+/// filtered in parallel.
+class Median : public IImageFilter
+{
+public:
+  /// Constructor
+  ///
+  /// \param[in] radius Window radius (default = 1; 3x3 window)
+  Median(size_t radius = 1)
+    : m_radius(radius)
+  {
+  }
+
+  virtual ~Median() = default;
+
+  /// Get window radius.
+  ///
+  /// \return Window radius
+  size_t radius() const
+  {
+    return m_radius;
+  }
+
+  /// Set window radius.
+  ///
+  /// \param[in] radius Window radius
+  void setRadius(size_t radius)
+  {
+    m_radius = radius;
+  }
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \return True on success, false on image dimensions mismatch
+  template<int N>
+  bool apply(const Image<unsigned char, N> &input, Image<unsigned char, N> &output) const
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    filterBand<N>(input, output, 0, input.height());
+    return true;
+  }
+
+  /// Apply filter on bands of rows in parallel.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image and should not be the input image itself.
+  /// \param[in] pool Thread pool
+  /// \return True on success, false on image dimensions mismatch or aliasing
+  template<int N>
+  bool apply(const Image<unsigned char, N> &input, Image<unsigned char, N> &output, ThreadPool &pool) const
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height() ||
+        &input == &output)
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    // About 4 bands per thread. Histograms are rebuilt at the start of a
+    // band, so bands are at least a few windows high.
+    const size_t height = input.height();
+    const size_t bandHeight = std::max(std::max<size_t>(16, 4 * m_radius), height / (4 * pool.threadCount()) + 1);
+    const size_t bandCount = (height + bandHeight - 1) / bandHeight;
+    pool.run(bandCount, [&](size_t band, size_t) {
+      filterBand<N>(input, output, band * bandHeight, std::min((band + 1) * bandHeight, height));
+    });
+    return true;
+  }
+
+protected:
+  /// Rows of the window, padded by clamping to the border pixels.
+  ///
+  /// A ring of 2r+2 padded copies of input rows: the window rows of the
+  /// current output row and the row above, which the histograms remove.
+  /// Rows are copied before output rows are written, so the output may be
+  /// the input.
+  template<int N>
+  class RowRing
+  {
+  public:
+    RowRing(const Image<unsigned char, N> &image, size_t radius)
+      : m_image(image)
+      , m_radius(radius)
+      , m_stride((image.width() + 2 * radius) * N)
+      , m_slots(2 * radius + 2)
+      , m_rows(m_slots * m_stride)
+      , m_next(0)
+      , m_loaded(false)
+    {
+    }
+
+    /// Copy rows up to row (inclusive); row - 2r - 1 is the first row kept.
+    void load(std::ptrdiff_t row)
+    {
+      const std::ptrdiff_t first = row - static_cast<std::ptrdiff_t>(m_slots) + 1;
+      if (!m_loaded || m_next < first)
+      {
+        m_next = first;
+        m_loaded = true;
+      }
+      for (; m_next <= row; m_next++)
+      {
+        copyRow(m_next);
+      }
+    }
+
+    /// Padded row; the first pixel is r pixels left of the image.
+    const unsigned char *row(std::ptrdiff_t row) const
+    {
+      return &m_rows[slot(row) * m_stride];
+    }
+
+  protected:
+    size_t slot(std::ptrdiff_t row) const
+    {
+      const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(m_slots);
+      return static_cast<size_t>(((row % count) + count) % count);
+    }
+
+    void copyRow(std::ptrdiff_t row)
+    {
+      const std::ptrdiff_t height = static_cast<std::ptrdiff_t>(m_image.height());
+      const size_t source = static_cast<size_t>(row < 0 ? 0 : (row >= height ? height - 1 : row));
+      const size_t width = m_image.width();
+      const unsigned char *input = reinterpret_cast<const unsigned char*>(m_image.imageDataPtr() + source * width);
+      unsigned char *padded = &m_rows[slot(row) * m_stride];
+
+      std::memcpy(padded + m_radius * N, input, width * N);
+      for (size_t x = 0; x < m_radius; x++)
+      {
+        std::memcpy(padded + x * N, input, N);
+        std::memcpy(padded + (m_radius + width + x) * N, input + (width - 1) * N, N);
+      }
+    }
+
+    const Image<unsigned char, N> &m_image;
+    size_t m_radius;
+    size_t m_stride;
+    size_t m_slots;
+    std::vector<unsigned char> m_rows;
+    std::ptrdiff_t m_next;
+    bool m_loaded;
+  };
+
+  /// Filter output rows firstRow .. lastRow-1.
+  template<int N>
+  void filterBand(const Image<unsigned char, N> &input, Image<unsigned char, N> &output, size_t firstRow, size_t lastRow) const
+  {
+    const size_t width = input.width();
+    if (m_radius == 0)
+    {
+      if (&input != &output)
+      {
+        std::copy(input.imageDataPtr() + firstRow * width, input.imageDataPtr() + lastRow * width, output.imageDataPtr() + firstRow * width);
+      }
+      return;
+    }
+
+    RowRing<N> ring(input, m_radius);
+    if (m_radius <= 2)
+    {
+      filterNetwork<N>(ring, output, firstRow, lastRow);
+    }
+    else
+    {
+      filterHistogram<N>(ring, output, firstRow, lastRow);
+    }
+  }
+
+  /// Compare-exchange pairs of the 3x3 median network; median at 4
+  static const unsigned char (&network9())[19][2]
+  {
+    static const unsigned char pairs[19][2] = {
+      { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 1 }, { 3, 4 }, { 6, 7 }, { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 3 },
+      { 5, 8 }, { 4, 7 }, { 3, 6 }, { 1, 4 }, { 2, 5 }, { 4, 7 }, { 4, 2 }, { 6, 4 }, { 4, 2 }
+    };
+    return pairs;
+  }
+
+  /// Compare-exchange pairs of the 5x5 median network; median at 12
+  static const unsigned char (&network25())[99][2]
+  {
+    static const unsigned char pairs[99][2] = {
+      { 0, 1 }, { 3, 4 }, { 2, 4 }, { 2, 3 }, { 6, 7 }, { 5, 7 }, { 5, 6 }, { 9, 10 }, { 8, 10 }, { 8, 9 },
+      { 12, 13 }, { 11, 13 }, { 11, 12 }, { 15, 16 }, { 14, 16 }, { 14, 15 }, { 18, 19 }, { 17, 19 }, { 17, 18 }, { 21, 22 },
+      { 20, 22 }, { 20, 21 }, { 23, 24 }, { 2, 5 }, { 3, 6 }, { 0, 6 }, { 0, 3 }, { 4, 7 }, { 1, 7 }, { 1, 4 },
+      { 11, 14 }, { 8, 14 }, { 8, 11 }, { 12, 15 }, { 9, 15 }, { 9, 12 }, { 13, 16 }, { 10, 16 }, { 10, 13 }, { 20, 23 },
+      { 17, 23 }, { 17, 20 }, { 21, 24 }, { 18, 24 }, { 18, 21 }, { 19, 22 }, { 8, 17 }, { 9, 18 }, { 0, 18 }, { 0, 9 },
+      { 10, 19 }, { 1, 19 }, { 1, 10 }, { 11, 20 }, { 2, 20 }, { 2, 11 }, { 12, 21 }, { 3, 21 }, { 3, 12 }, { 13, 22 },
+      { 4, 22 }, { 4, 13 }, { 14, 23 }, { 5, 23 }, { 5, 14 }, { 15, 24 }, { 6, 24 }, { 6, 15 }, { 7, 16 }, { 7, 19 },
+      { 13, 21 }, { 15, 23 }, { 7, 13 }, { 7, 15 }, { 1, 9 }, { 3, 11 }, { 5, 17 }, { 11, 17 }, { 9, 17 }, { 4, 10 },
+      { 6, 12 }, { 7, 14 }, { 4, 6 }, { 4, 7 }, { 12, 14 }, { 10, 14 }, { 6, 7 }, { 10, 12 }, { 6, 10 }, { 6, 17 },
+      { 12, 17 }, { 7, 17 }, { 7, 10 }, { 12, 18 }, { 7, 12 }, { 10, 18 }, { 12, 20 }, { 10, 20 }, { 10, 12 }
+    };
+    return pairs;
+  }
+
+  /// Apply compare-exchanges; afterwards the first of a pair is the lesser.
+  template<typename V, size_t P>
+  static void compareExchange(V *values, const unsigned char (&pairs)[P][2])
+  {
+    for (size_t i = 0; i < P; i++)
+    {
+      V &a = values[pairs[i][0]];
+      V &b = values[pairs[i][1]];
+      const V lesser = minimum(a, b);
+      b = maximum(a, b);
+      a = lesser;
+    }
+  }
+
+  static unsigned char minimum(unsigned char a, unsigned char b)
+  {
+    return (b < a ? b : a);
+  }
+
+  static unsigned char maximum(unsigned char a, unsigned char b)
+  {
+    return (b > a ? b : a);
+  }
+
+#ifdef SPATIUMLIB_IMGPROC_MEDIAN_SSE2
+  static __m128i minimum(__m128i a, __m128i b)
+  {
+    return _mm_min_epu8(a, b);
+  }
+
+  static __m128i maximum(__m128i a, __m128i b)
+  {
+    return _mm_max_epu8(a, b);
+  }
+#endif
+
+  /// Filter rows by selection network; radius 1 or 2.
+  ///
+  /// Window samples of a channel lie N bytes apart in a row, so the network
+  /// runs over the samples of all channels at once.
+  template<int N>
+  void filterNetwork(RowRing<N> &ring, Image<unsigned char, N> &output, size_t firstRow, size_t lastRow) const
+  {
+    const size_t window = 2 * m_radius + 1;
+    const size_t samples = output.width() * N;
+    const size_t count = window * window;
+
+    for (size_t y = firstRow; y < lastRow; y++)
+    {
+      const std::ptrdiff_t row = static_cast<std::ptrdiff_t>(y);
+      ring.load(row + static_cast<std::ptrdiff_t>(m_radius));
+
+      // Window sample k of output sample i is at offsets[k] + i
+      const unsigned char *offsets[25];
+      for (size_t dy = 0; dy < window; dy++)
+      {
+        const unsigned char *padded = ring.row(row + static_cast<std::ptrdiff_t>(dy) - static_cast<std::ptrdiff_t>(m_radius));
+        for (size_t dx = 0; dx < window; dx++)
+        {
+          offsets[dy * window + dx] = padded + dx * N;
+        }
+      }
+      unsigned char *out = reinterpret_cast<unsigned char*>(output.imageDataPtr() + y * output.width());
+
+      size_t i = 0;
+#ifdef SPATIUMLIB_IMGPROC_MEDIAN_SSE2
+      for (; i + 16 <= samples; i += 16)
+      {
+        __m128i values[25];
+        for (size_t k = 0; k < count; k++)
+        {
+          values[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(offsets[k] + i));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), selectMedian(values));
+      }
+#endif
+      for (; i < samples; i++)
+      {
+        unsigned char values[25];
+        for (size_t k = 0; k < count; k++)
+        {
+          values[k] = offsets[k][i];
+        }
+        out[i] = selectMedian(values);
+      }
+    }
+  }
+
+  /// Median of 9 or 25 values by selection network.
+  template<typename V>
+  V selectMedian(V *values) const
+  {
+    if (m_radius == 1)
+    {
+      compareExchange(values, network9());
+      return values[4];
+    }
+    compareExchange(values, network25());
+    return values[12];
+  }
+
+  /// Filter rows by sliding histograms; any radius.
+  template<int N>
+  void filterHistogram(RowRing<N> &ring, Image<unsigned char, N> &output, size_t firstRow, size_t lastRow) const
+  {
+    const size_t width = output.width();
+    const size_t window = 2 * m_radius + 1;
+    const std::ptrdiff_t radius = static_cast<std::ptrdiff_t>(m_radius);
+    const size_t columns = (width + 2 * m_radius) * N;
+
+    // Histograms per padded column and channel; column counts fit 16 bits
+    std::vector<std::uint16_t> coarse(columns * 16, 0);
+    std::vector<std::uint16_t> fine(columns * 256, 0);
+
+    for (size_t y = firstRow; y < lastRow; y++)
+    {
+      const std::ptrdiff_t row = static_cast<std::ptrdiff_t>(y);
+      ring.load(row + radius);
+
+      // Move column histograms down a row, or build them at the first row
+      if (y == firstRow)
+      {
+        for (std::ptrdiff_t i = row - radius; i <= row + radius; i++)
+        {
+          updateColumns(ring.row(i), columns, coarse, fine, 1);
+        }
+      }
+      else
+      {
+        updateColumns(ring.row(row - radius - 1), columns, coarse, fine, -1);
+        updateColumns(ring.row(row + radius), columns, coarse, fine, 1);
+      }
+
+      unsigned char *out = reinterpret_cast<unsigned char*>(output.imageDataPtr() + y * width);
+      for (int c = 0; c < N; c++)
+      {
+        // Window counts fit 16 bits up to 255x255 windows
+        if (window < 256)
+        {
+          filterRow<std::uint16_t>(&coarse[c * 16], &fine[c * 256], width, window, N, out + c);
+        }
+        else
+        {
+          filterRow<std::uint32_t>(&coarse[c * 16], &fine[c * 256], width, window, N, out + c);
+        }
+      }
+    }
+  }
+
+  /// Add (1) or remove (-1) a padded row to the column histograms.
+  static void updateColumns(const unsigned char *row, size_t columns, std::vector<std::uint16_t> &coarse, std::vector<std::uint16_t> &fine, int sign)
+  {
+    const std::uint16_t delta = static_cast<std::uint16_t>(sign);
+    for (size_t j = 0; j < columns; j++)
+    {
+      coarse[j * 16 + (row[j] >> 4)] += delta;
+      fine[j * 256 + row[j]] += delta;
+    }
+  }
+
+  /// Filter a row of a channel by sliding the window histogram right.
+  ///
+  /// Fine histograms of the window are kept per coarse bin, together with
+  /// the output column they are valid for. When the median falls in a coarse
+  /// bin, its fine histogram is updated by the columns that slid in and out
+  /// since, or rebuilt if all window columns changed.
+  ///
+  /// \param[in] coarse Coarse histogram of the first padded column of the
+  /// channel; columns are step histograms apart
+  /// \param[in] fine Fine histogram of the first padded column of the
+  /// channel; columns are step histograms apart
+  /// \param[in] width Number of output pixels
+  /// \param[in] window Window size
+  /// \param[in] step Number of channels
+  /// \param[out] output First output sample; samples are step bytes apart
+  template<typename Count>
+  static void filterRow(const std::uint16_t *coarse, const std::uint16_t *fine, size_t width, size_t window, size_t step, unsigned char *output)
+  {
+    const Count half = static_cast<Count>(window * window / 2);
+    const size_t coarseStride = 16 * step;
+    const size_t fineStride = 256 * step;
+
+    Count windowCoarse[16] = {};
+    Count windowFine[256];
+    size_t valid[16];
+    std::fill(valid, valid + 16, width);
+
+    // Output pixel x has window columns x .. x + w - 1 (padded)
+    for (size_t j = 0; j < window; j++)
+    {
+      for (size_t b = 0; b < 16; b++)
+      {
+        windowCoarse[b] += coarse[j * coarseStride + b];
+      }
+    }
+
+    for (size_t x = 0; x < width; x++)
+    {
+      if (x > 0)
+      {
+        const std::uint16_t *added = coarse + (x + window - 1) * coarseStride;
+        const std::uint16_t *removed = coarse + (x - 1) * coarseStride;
+        for (size_t b = 0; b < 16; b++)
+        {
+          windowCoarse[b] += added[b];
+          windowCoarse[b] -= removed[b];
+        }
+      }
+
+      // Coarse bin of the median: the first bin where the cumulative count
+      // exceeds half
+      Count below = 0;
+      const size_t bin = findBin(windowCoarse, half, below);
+
+      // Bring fine histogram of the bin up to date
+      Count *binFine = windowFine + bin * 16;
+      if (valid[bin] == width || x - valid[bin] >= window)
+      {
+        std::fill(binFine, binFine + 16, 0);
+        for (size_t j = x; j < x + window; j++)
+        {
+          const std::uint16_t *column = fine + j * fineStride + bin * 16;
+          for (size_t v = 0; v < 16; v++)
+          {
+            binFine[v] += column[v];
+          }
+        }
+      }
+      else
+      {
+        for (size_t k = valid[bin] + 1; k <= x; k++)
+        {
+          const std::uint16_t *added = fine + (k + window - 1) * fineStride + bin * 16;
+          const std::uint16_t *removed = fine + (k - 1) * fineStride + bin * 16;
+          for (size_t v = 0; v < 16; v++)
+          {
+            binFine[v] += added[v];
+            binFine[v] -= removed[v];
+          }
+        }
+      }
+      valid[bin] = x;
+
+      Count belowFine = 0;
+      const size_t value = findBin(binFine, static_cast<Count>(half - below), belowFine);
+      output[x * step] = static_cast<unsigned char>(bin * 16 + value);
+    }
+  }
+
+  /// Find the number of leading bins of a 16 bin histogram whose cumulative
+  /// count does not exceed a limit.
+  ///
+  /// \param[in] histogram Histogram of 16 bins
+  /// \param[in] limit Limit of the cumulative count
+  /// \param[out] below Cumulative count of the leading bins
+  /// \return Number of leading bins; the bin where the count exceeds limit
+  template<typename Count>
+  static size_t findBin(const Count *histogram, Count limit, Count &below)
+  {
+    // Cumulative counts increase; the bins found form a prefix. Counted
+    // without branches on the data.
+    Count cumulative = 0;
+    size_t bin = 0;
+    below = 0;
+    for (size_t b = 0; b < 16; b++)
+    {
+      cumulative += histogram[b];
+      const bool before = (cumulative <= limit);
+      bin += before;
+      below += (before ? histogram[b] : 0);
+    }
+    return bin;
+  }
+
+#ifdef SPATIUMLIB_IMGPROC_MEDIAN_SSE2
+  static size_t findBin(const std::uint16_t *histogram, std::uint16_t limit, std::uint16_t &below)
+  {
+    // Prefix sums of 8 counts per register
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(histogram));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(histogram + 8));
+    low = _mm_add_epi16(low, _mm_slli_si128(low, 2));
+    high = _mm_add_epi16(high, _mm_slli_si128(high, 2));
+    low = _mm_add_epi16(low, _mm_slli_si128(low, 4));
+    high = _mm_add_epi16(high, _mm_slli_si128(high, 4));
+    low = _mm_add_epi16(low, _mm_slli_si128(low, 8));
+    high = _mm_add_epi16(high, _mm_slli_si128(high, 8));
+    const __m128i lowTotal = _mm_shufflehi_epi16(low, 0xFF);
+    high = _mm_add_epi16(high, _mm_unpackhi_epi64(lowTotal, lowTotal));
+
+    // Cumulative counts not exceeding the limit (unsigned): saturated
+    // difference is 0. Count them as bytes of 1.
+    const __m128i limits = _mm_set1_epi16(static_cast<short>(limit));
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lowBefore = _mm_cmpeq_epi16(_mm_subs_epu16(low, limits), zero);
+    const __m128i highBefore = _mm_cmpeq_epi16(_mm_subs_epu16(high, limits), zero);
+    const __m128i before = _mm_and_si128(_mm_packs_epi16(lowBefore, highBefore), _mm_set1_epi8(1));
+    const __m128i sums = _mm_sad_epu8(before, zero);
+    const size_t bin = static_cast<size_t>(_mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+
+    std::uint16_t cumulative[17];
+    cumulative[0] = 0;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cumulative + 1), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(cumulative + 9), high);
+    below = cumulative[bin];
+    return bin;
+  }
+#endif
+
+  /// Window radius
+  size_t m_radius;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_MEDIAN_H
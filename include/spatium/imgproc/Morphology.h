@@ -0,0 +1,634 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_MORPHOLOGY_H
+#define SPATIUMLIB_IMGPROC_MORPHOLOGY_H
+
+#include "IImageFilter.h"
+
+#include <algorithm> // std::copy, std::fill, std::min
+#include <cstddef> // size_t, std::ptrdiff_t
+#include <cstdint> // std::uint64_t
+#include <cstring> // std::memcpy
+#include <limits> // std::numeric_limits
+#include <vector> // std::vector
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUMLIB_IMGPROC_MORPHOLOGY_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+
+namespace spatium {
+namespace imgproc {
+
+/// \class Morphology
+/// \brief Morphological erosion, dilation, opening and closing
+///
+/// The structuring element is a rectangle of (2 * radiusX + 1) x
+/// (2 * radiusY + 1) pixels centered at the pixel. Erosion takes the minimum
+/// of the element, dilation the maximum, per channel. Opening is erosion
+/// followed by dilation, closing is dilation followed by erosion. Pixels
+/// outside the image are ignored.
+///
+/// A rectangle is separable into a horizontal and a vertical line. Lines are
+/// filtered with the algorithm of van Herk (1992) and Gil and Werman (1993):
+/// the line is divided into blocks of the element length, and the minimum
+/// (maximum) of a window is combined from a running minimum to the end of
+/// one block and a running minimum from the start of the next. This takes
+/// three comparisons per pixel, regardless of the element size. The vertical
+/// pass runs over whole rows of contiguous samples, which the compiler
+/// vectorizes.
+///
+/// 8-bit single channel images of which all pixels are 0 or 255 (binary
+/// masks, e.g. from GlobalThreshold) are packed into 64-bit words, a bit per
+/// pixel, and filtered 64 pixels at a time: horizontally by shifted AND (OR)
+/// of the words, taking log2 of the element width steps, and vertically by
+/// the algorithm above on words.
+class Morphology : public IImageFilter
+{
+public:
+  /// Morphological operation
+  enum class Operation
+  {
+    Erode,  ///< Minimum
+    Dilate, ///< Maximum
+    Open,   ///< Erode, then dilate
+    Close   ///< Dilate, then erode
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] operation Operation (default = Erode)
+  /// \param[in] radiusX Horizontal radius of the element (default = 1)
+  /// \param[in] radiusY Vertical radius of the element (default = 1)
+  Morphology(Operation operation = Operation::Erode, size_t radiusX = 1, size_t radiusY = 1)
+    : m_operation(operation)
+    , m_radiusX(radiusX)
+    , m_radiusY(radiusY)
+  {
+  }
+
+  virtual ~Morphology() = default;
+
+  /// Get operation.
+  ///
+  /// \return Operation
+  Operation operation() const
+  {
+    return m_operation;
+  }
+
+  /// Set operation.
+  ///
+  /// \param[in] operation Operation
+  void setOperation(Operation operation)
+  {
+    m_operation = operation;
+  }
+
+  /// Get horizontal radius of the element.
+  ///
+  /// \return Radius in pixels
+  size_t radiusX() const
+  {
+    return m_radiusX;
+  }
+
+  /// Get vertical radius of the element.
+  ///
+  /// \return Radius in pixels
+  size_t radiusY() const
+  {
+    return m_radiusY;
+  }
+
+  /// Set radii of the element.
+  ///
+  /// \param[in] radiusX Horizontal radius in pixels
+  /// \param[in] radiusY Vertical radius in pixels
+  void setRadius(size_t radiusX, size_t radiusY)
+  {
+    m_radiusX = radiusX;
+    m_radiusY = radiusY;
+  }
+
+  /// Apply filter.
+  ///
+  /// The output image may be the input image.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image. Should have the size of the input
+  /// image.
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, int N>
+  bool apply(const Image<T, N> &input, Image<T, N> &output) const
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    applySamples<T, N>(input, output);
+    return true;
+  }
+
+  /// Apply filter; 8-bit single channel.
+  ///
+  /// Binary masks (only values 0 and 255) are filtered bit packed.
+  bool apply(const Image<unsigned char, 1> &input, Image<unsigned char, 1> &output) const
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height())
+    {
+      return false;
+    }
+    if (input.width() == 0 || input.height() == 0)
+    {
+      return true;
+    }
+
+    std::vector<std::uint64_t> words;
+    if (pack(input, words))
+    {
+      applyBits(words, input.width(), input.height());
+      unpack(words, output);
+    }
+    else
+    {
+      applySamples<unsigned char, 1>(input, output);
+    }
+    return true;
+  }
+
+protected:
+  /// Minimum of samples; erosion
+  template<typename E>
+  struct Minimum
+  {
+    E identity() const
+    {
+      return std::numeric_limits<E>::max();
+    }
+
+    E operator()(E a, E b) const
+    {
+      return (b < a ? b : a);
+    }
+  };
+
+  /// Maximum of samples; dilation
+  template<typename E>
+  struct Maximum
+  {
+    E identity() const
+    {
+      return std::numeric_limits<E>::lowest();
+    }
+
+    E operator()(E a, E b) const
+    {
+      return (b > a ? b : a);
+    }
+  };
+
+  /// Bitwise AND of packed pixels; erosion
+  struct BitAnd
+  {
+    std::uint64_t identity() const
+    {
+      return ~std::uint64_t(0);
+    }
+
+    std::uint64_t operator()(std::uint64_t a, std::uint64_t b) const
+    {
+      return a & b;
+    }
+  };
+
+  /// Bitwise OR of packed pixels; dilation
+  struct BitOr
+  {
+    std::uint64_t identity() const
+    {
+      return 0;
+    }
+
+    std::uint64_t operator()(std::uint64_t a, std::uint64_t b) const
+    {
+      return a | b;
+    }
+  };
+
+  /// Apply operation on samples.
+  template<typename T, int N>
+  void applySamples(const Image<T, N> &input, Image<T, N> &output) const
+  {
+    const T *in = reinterpret_cast<const T*>(input.imageDataPtr());
+    T *out = reinterpret_cast<T*>(output.imageDataPtr());
+    const size_t width = input.width();
+    const size_t height = input.height();
+
+    switch (m_operation)
+    {
+    case Operation::Erode:
+      filterSamples<T, N>(in, out, width, height, Minimum<T>());
+      break;
+    case Operation::Dilate:
+      filterSamples<T, N>(in, out, width, height, Maximum<T>());
+      break;
+    case Operation::Open:
+      filterSamples<T, N>(in, out, width, height, Minimum<T>());
+      filterSamples<T, N>(out, out, width, height, Maximum<T>());
+      break;
+    case Operation::Close:
+      filterSamples<T, N>(in, out, width, height, Maximum<T>());
+      filterSamples<T, N>(out, out, width, height, Minimum<T>());
+      break;
+    }
+  }
+
+  /// Erode or dilate samples; horizontal pass, then vertical pass in place.
+  template<typename T, int N, typename Op>
+  void filterSamples(const T *input, T *output, size_t width, size_t height, Op op) const
+  {
+    if (m_radiusX > 0)
+    {
+      // Padded line and running minima
+      std::vector<T> line(width + 2 * m_radiusX, op.identity());
+      std::vector<T> forward(line.size());
+      std::vector<T> backward(line.size());
+      for (size_t y = 0; y < height; y++)
+      {
+        for (int c = 0; c < N; c++)
+        {
+          filterLine(input + y * width * N + c, output + y * width * N + c, width, N, m_radiusX, op,
+                     &line[0], &forward[0], &backward[0]);
+        }
+      }
+      input = output;
+    }
+
+    filterColumns(input, output, width * N, height, m_radiusY, op);
+  }
+
+  /// Erode or dilate a line by van Herk / Gil-Werman.
+  ///
+  /// The line is padded with r identity elements on both sides and divided
+  /// into blocks of w = 2r+1 elements. forward[i] holds the minimum from the
+  /// start of the block of i up to i, backward[i] from i up to the end of its
+  /// block. The window of padded elements i .. i+w-1 overlaps at most two
+  /// blocks, so its minimum is min(backward[i], forward[i+w-1]).
+  ///
+  /// \param[in] input First element of the line
+  /// \param[out] output First element of the line; may be the input
+  /// \param[in] count Number of elements
+  /// \param[in] step Distance between elements
+  /// \param[in] radius Radius of the window; at least 1
+  /// \param[in] op Minimum or maximum
+  /// \param[in] line Buffer of count + 2r elements; padding is identity
+  /// \param[in] forward Buffer of count + 2r elements
+  /// \param[in] backward Buffer of count + 2r elements
+  template<typename E, typename Op>
+  static void filterLine(const E *input, E *output, size_t count, size_t step, size_t radius, Op op,
+                         E *line, E *forward, E *backward)
+  {
+    const size_t window = 2 * radius + 1;
+    const size_t padded = count + 2 * radius;
+    for (size_t i = 0; i < count; i++)
+    {
+      line[radius + i] = input[i * step];
+    }
+
+    for (size_t begin = 0; begin < padded; begin += window)
+    {
+      const size_t end = std::min(begin + window, padded);
+      forward[begin] = line[begin];
+      for (size_t i = begin + 1; i < end; i++)
+      {
+        forward[i] = op(forward[i - 1], line[i]);
+      }
+      backward[end - 1] = line[end - 1];
+      for (size_t i = end - 1; i > begin; i--)
+      {
+        backward[i - 1] = op(backward[i], line[i - 1]);
+      }
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+      output[i * step] = op(backward[i], forward[i + window - 1]);
+    }
+  }
+
+  /// Erode or dilate columns by van Herk / Gil-Werman, a whole row of
+  /// elements at a time.
+  ///
+  /// Rows are padded and divided into blocks like a line (see filterLine()).
+  /// Output rows of block k need the running minima of blocks k and k+1, so
+  /// only those of two blocks are kept. Running minima of block k+1 are
+  /// computed before the output rows of block k are written, which are above
+  /// all input rows still to be read; the output may be the input.
+  ///
+  /// \param[in] input Rows of elements
+  /// \param[out] output Rows of elements; may be the input
+  /// \param[in] rowSize Number of elements per row
+  /// \param[in] height Number of rows
+  /// \param[in] radius Radius of the window
+  /// \param[in] op Minimum or maximum
+  template<typename E, typename Op>
+  static void filterColumns(const E *input, E *output, size_t rowSize, size_t height, size_t radius, Op op)
+  {
+    if (radius == 0)
+    {
+      if (input != output)
+      {
+        std::copy(input, input + rowSize * height, output);
+      }
+      return;
+    }
+
+    const size_t window = 2 * radius + 1;
+    const size_t padded = height + 2 * radius;
+    const std::vector<E> identityRow(rowSize, op.identity());
+
+    // Running minima of two blocks
+    std::vector<E> forward[2] = { std::vector<E>(window * rowSize), std::vector<E>(window * rowSize) };
+    std::vector<E> backward[2] = { std::vector<E>(window * rowSize), std::vector<E>(window * rowSize) };
+
+    // Padded row i is input row i - r
+    auto paddedRow = [&](size_t i) -> const E* {
+      return (i < radius || i >= radius + height ? &identityRow[0] : input + (i - radius) * rowSize);
+    };
+
+    auto runningMinima = [&](size_t block, E *blockForward, E *blockBackward) {
+      const size_t begin = block * window;
+      const size_t end = std::min(begin + window, padded);
+      for (size_t i = begin; i < end; i++)
+      {
+        const E *row = paddedRow(i);
+        E *current = blockForward + (i - begin) * rowSize;
+        if (i == begin)
+        {
+          std::copy(row, row + rowSize, current);
+          continue;
+        }
+        const E *previous = current - rowSize;
+        for (size_t j = 0; j < rowSize; j++)
+        {
+          current[j] = op(previous[j], row[j]);
+        }
+      }
+      for (size_t i = end; i-- > begin; )
+      {
+        const E *row = paddedRow(i);
+        E *current = blockBackward + (i - begin) * rowSize;
+        if (i == end - 1)
+        {
+          std::copy(row, row + rowSize, current);
+          continue;
+        }
+        const E *next = current + rowSize;
+        for (size_t j = 0; j < rowSize; j++)
+        {
+          current[j] = op(next[j], row[j]);
+        }
+      }
+    };
+
+    runningMinima(0, &forward[0][0], &backward[0][0]);
+    for (size_t block = 0; block * window < height; block++)
+    {
+      const size_t current = block % 2;
+      const size_t next = 1 - current;
+      if ((block + 1) * window < padded)
+      {
+        runningMinima(block + 1, &forward[next][0], &backward[next][0]);
+      }
+
+      // Window of output row y is padded rows y .. y + w - 1
+      const size_t end = std::min((block + 1) * window, height);
+      for (size_t y = block * window; y < end; y++)
+      {
+        const size_t last = y + window - 1;
+        const E *firstRow = &backward[current][(y - block * window) * rowSize];
+        const E *lastRow = (last < (block + 1) * window ? &forward[current][(last - block * window) * rowSize]
+                                                        : &forward[next][(last - (block + 1) * window) * rowSize]);
+        E *row = output + y * rowSize;
+        for (size_t j = 0; j < rowSize; j++)
+        {
+          row[j] = op(firstRow[j], lastRow[j]);
+        }
+      }
+    }
+  }
+
+  /// Apply operation on packed pixels.
+  void applyBits(std::vector<std::uint64_t> &words, size_t width, size_t height) const
+  {
+    switch (m_operation)
+    {
+    case Operation::Erode:
+      filterBits(words, width, height, BitAnd());
+      break;
+    case Operation::Dilate:
+      filterBits(words, width, height, BitOr());
+      break;
+    case Operation::Open:
+      filterBits(words, width, height, BitAnd());
+      filterBits(words, width, height, BitOr());
+      break;
+    case Operation::Close:
+      filterBits(words, width, height, BitOr());
+      filterBits(words, width, height, BitAnd());
+      break;
+    }
+  }
+
+  /// Erode or dilate packed pixels in place.
+  ///
+  /// Bits beyond the width are treated as identity, like pixels outside the
+  /// image.
+  template<typename Op>
+  void filterBits(std::vector<std::uint64_t> &words, size_t width, size_t height, Op op) const
+  {
+    const size_t rowWords = (width + 63) / 64;
+    const std::uint64_t identity = op.identity();
+
+    // Horizontal. The row is shifted right by the radius, so that the window
+    // starting at x is centered at x. The window of w pixels is then built
+    // from windows of powers of 2 and a shifted copy. The row is extended
+    // with identity pixels to hold the shifted pixels.
+    const size_t window = 2 * m_radiusX + 1;
+    const size_t extendedWords = (width + m_radiusX + 63) / 64;
+    const size_t tailBits = width % 64;
+    std::vector<std::uint64_t> row(extendedWords);
+    std::vector<std::uint64_t> shifted(extendedWords);
+    for (size_t y = 0; m_radiusX > 0 && y < height; y++)
+    {
+      std::uint64_t *packed = &words[y * rowWords];
+      std::copy(packed, packed + rowWords, row.begin());
+      std::fill(row.begin() + rowWords, row.end(), identity);
+      if (tailBits > 0)
+      {
+        const std::uint64_t tailMask = ~std::uint64_t(0) << tailBits;
+        row[rowWords - 1] = (row[rowWords - 1] & ~tailMask) | (identity & tailMask);
+      }
+
+      shiftBits(&row[0], &shifted[0], extendedWords, -static_cast<std::ptrdiff_t>(m_radiusX), identity);
+      row.swap(shifted);
+
+      size_t length = 1;
+      while (length < window)
+      {
+        const size_t shift = (2 * length <= window ? length : window - length);
+        shiftBits(&row[0], &shifted[0], extendedWords, static_cast<std::ptrdiff_t>(shift), identity);
+        for (size_t i = 0; i < extendedWords; i++)
+        {
+          row[i] = op(row[i], shifted[i]);
+        }
+        length += shift;
+      }
+
+      std::copy(row.begin(), row.begin() + rowWords, packed);
+    }
+
+    filterColumns(&words[0], &words[0], rowWords, height, m_radiusY, op);
+  }
+
+  /// Shift packed pixels: output pixel x is input pixel x + shift. Pixels
+  /// outside the row are filled.
+  ///
+  /// \param[in] input Words of the row
+  /// \param[out] output Words of the row
+  /// \param[in] count Number of words
+  /// \param[in] shift Shift in pixels; positive to take pixels on the right
+  /// \param[in] fill Word of pixels outside the row
+  static void shiftBits(const std::uint64_t *input, std::uint64_t *output, size_t count, std::ptrdiff_t shift, std::uint64_t fill)
+  {
+    const std::ptrdiff_t n = static_cast<std::ptrdiff_t>(count);
+    const std::ptrdiff_t words = (shift >= 0 ? shift : -shift) / 64;
+    const unsigned int bits = static_cast<unsigned int>((shift >= 0 ? shift : -shift) % 64);
+    for (std::ptrdiff_t i = 0; i < n; i++)
+    {
+      if (shift >= 0)
+      {
+        const std::uint64_t low = (i + words < n ? input[i + words] : fill);
+        const std::uint64_t high = (i + words + 1 < n ? input[i + words + 1] : fill);
+        output[i] = (bits == 0 ? low : (low >> bits) | (high << (64 - bits)));
+      }
+      else
+      {
+        const std::uint64_t high = (i - words >= 0 ? input[i - words] : fill);
+        const std::uint64_t low = (i - words - 1 >= 0 ? input[i - words - 1] : fill);
+        output[i] = (bits == 0 ? high : (high << bits) | (low >> (64 - bits)));
+      }
+    }
+  }
+
+  /// Pack a binary mask; bit x % 64 of word x / 64 is pixel x of a row.
+  ///
+  /// \param[in] image Image
+  /// \param[out] words Packed rows
+  /// \return True if all pixels are 0 or 255, false otherwise
+  static bool pack(const Image<unsigned char, 1> &image, std::vector<std::uint64_t> &words)
+  {
+    const size_t width = image.width();
+    const size_t rowWords = (width + 63) / 64;
+    words.assign(rowWords * image.height(), 0);
+
+    for (size_t y = 0; y < image.height(); y++)
+    {
+      const unsigned char *row = reinterpret_cast<const unsigned char*>(image.imageDataPtr() + y * width);
+      std::uint64_t *packed = &words[y * rowWords];
+
+      size_t x = 0;
+#ifdef SPATIUMLIB_IMGPROC_MORPHOLOGY_SSE2
+      // 16 pixels to a 16-bit mask by comparison and byte sign bits
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i full = _mm_set1_epi8(static_cast<char>(0xFF));
+      for (; x + 16 <= width; x += 16)
+      {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        const int zeros = _mm_movemask_epi8(_mm_cmpeq_epi8(pixels, zero));
+        const int ones = _mm_movemask_epi8(_mm_cmpeq_epi8(pixels, full));
+        if ((zeros | ones) != 0xFFFF)
+        {
+          return false;
+        }
+        packed[x / 64] |= static_cast<std::uint64_t>(ones) << (x % 64);
+      }
+#endif
+      for (; x < width; x++)
+      {
+        if (row[x] != 0 && row[x] != 255)
+        {
+          return false;
+        }
+        packed[x / 64] |= static_cast<std::uint64_t>(row[x] != 0) << (x % 64);
+      }
+    }
+    return true;
+  }
+
+  /// Unpack packed pixels to 0 and 255.
+  static void unpack(const std::vector<std::uint64_t> &words, Image<unsigned char, 1> &image)
+  {
+    // 8 pixels of every byte value
+    std::uint64_t bytes[256];
+    for (size_t value = 0; value < 256; value++)
+    {
+      unsigned char pixels[8];
+      for (size_t bit = 0; bit < 8; bit++)
+      {
+        pixels[bit] = (((value >> bit) & 1) ? 255 : 0);
+      }
+      std::memcpy(&bytes[value], pixels, 8);
+    }
+
+    const size_t width = image.width();
+    const size_t rowWords = (width + 63) / 64;
+    for (size_t y = 0; y < image.height(); y++)
+    {
+      unsigned char *row = reinterpret_cast<unsigned char*>(image.imageDataPtr() + y * width);
+      const std::uint64_t *packed = &words[y * rowWords];
+
+      size_t x = 0;
+      for (; x + 8 <= width; x += 8)
+      {
+        std::memcpy(row + x, &bytes[(packed[x / 64] >> (x % 64)) & 0xFF], 8);
+      }
+      for (; x < width; x++)
+      {
+        row[x] = (((packed[x / 64] >> (x % 64)) & 1) ? 255 : 0);
+      }
+    }
+  }
+
+  /// Operation
+  Operation m_operation;
+
+  /// Horizontal radius of the element
+  size_t m_radiusX;
+
+  /// Vertical radius of the element
+  size_t m_radiusY;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_MORPHOLOGY_H
@@ -0,0 +1,144 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_PARALLELEXECUTOR_H
+#define SPATIUMLIB_IMGPROC_PARALLELEXECUTOR_H
+
+#include "spatium/ThreadPool.h"
+#include "Pipeline.h"
+
+#include <algorithm> // std::min, std::max
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class ParallelExecutor
+/// \brief Apply filters on bands of rows in parallel
+///
+/// The output image is divided into bands of rows. Every band is filtered by
+/// a copy of the pipeline per thread, reading the input rows of the band
+/// plus the margin of the filter (halo) directly from the input image. Bands
+/// are distributed over the threads of a pool with work stealing. The result
+/// is equal to applying the filter on a single thread.
+///
+/// Rows are contiguous in memory, so bands need no copies of the input and
+/// neighbouring threads do not write to the same cache lines, except at band
+/// borders.
+///
+/// Example:
+/// \code
+/// ThreadPool pool;
+/// ParallelExecutor executor(pool);
+/// executor.apply(Blur(5), input, output);
+/// \endcode
+class ParallelExecutor
+{
+public:
+  /// Constructor.
+  ///
+  /// \param[in] pool Thread pool; must outlive the executor
+  /// \param[in] bandHeight Number of rows per band. 0 chooses a height that
+  /// gives about 4 bands per thread, and at least 16 rows per band.
+  explicit ParallelExecutor(ThreadPool &pool, size_t bandHeight = 0)
+    : m_pool(pool)
+    , m_bandHeight(bandHeight)
+  {}
+
+  /// Get band height.
+  ///
+  /// \return Number of rows per band; 0 for automatic
+  size_t bandHeight() const
+  {
+    return m_bandHeight;
+  }
+
+  /// Set band height.
+  ///
+  /// \param[in] bandHeight Number of rows per band; 0 for automatic
+  void setBandHeight(size_t bandHeight)
+  {
+    m_bandHeight = bandHeight;
+  }
+
+  /// Apply pipeline.
+  ///
+  /// \param[in] pipeline Pipeline; copied once per thread
+  /// \param[in] input Input image
+  /// \param[out] output Output image; not the input image
+  /// \return True on success, false on image dimensions mismatch or aliasing
+  template<typename... Stages>
+  bool apply(const Pipeline<Stages...> &pipeline,
+             const Image<typename Pipeline<Stages...>::InputType, Pipeline<Stages...>::InputChannels> &input,
+             Image<typename Pipeline<Stages...>::OutputType, Pipeline<Stages...>::OutputChannels> &output)
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height() ||
+        static_cast<const void*>(&input) == static_cast<const void*>(&output))
+    {
+      return false;
+    }
+
+    const size_t height = input.height();
+    const size_t bandHeight = (m_bandHeight > 0 ? m_bandHeight
+                                                : std::max<size_t>(16, height / (4 * m_pool.threadCount()) + 1));
+    const size_t bandCount = (height + bandHeight - 1) / bandHeight;
+
+    // Pipelines keep row buffers; one per thread
+    std::vector<Pipeline<Stages...>> pipelines(m_pool.threadCount(), pipeline);
+    m_pool.run(bandCount, [&](size_t band, size_t thread) {
+      pipelines[thread].apply(input, output, band * bandHeight, std::min((band + 1) * bandHeight, height));
+    });
+
+    return true;
+  }
+
+  /// Apply grayscale filter.
+  template<typename T>
+  bool apply(const Grayscale<T> &filter, const Image<T, 3> &input, Image<T, 1> &output)
+  {
+    return apply(Pipeline<GrayscaleStage<T>>(GrayscaleStage<T>(filter)), input, output);
+  }
+
+  /// Apply blur filter.
+  template<typename T, int N>
+  bool apply(const Blur &filter, const Image<T, N> &input, Image<T, N> &output)
+  {
+    return apply(Pipeline<BlurStage<T, N>>(BlurStage<T, N>(filter)), input, output);
+  }
+
+  /// Apply Sobel filter; gradient magnitude.
+  template<typename T>
+  bool apply(const Sobel &filter, const Image<T, 1> &input, Image<T, 1> &output)
+  {
+    return apply(Pipeline<SobelStage<T>>(SobelStage<T>(filter)), input, output);
+  }
+
+  /// Apply global threshold filter.
+  template<typename T, int N>
+  bool apply(const GlobalThreshold<T> &filter, const Image<T, N> &input, Image<T, 1> &output)
+  {
+    return apply(Pipeline<GlobalThresholdStage<T, N>>(GlobalThresholdStage<T, N>(filter)), input, output);
+  }
+
+protected:
+  /// Thread pool
+  ThreadPool &m_pool;
+
+  /// Number of rows per band; 0 for automatic
+  size_t m_bandHeight;
+};
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_PARALLELEXECUTOR_H
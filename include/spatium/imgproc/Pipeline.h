@@ -0,0 +1,549 @@
+/*
+ * Program: Spatium Library
+ *
+ * Copyright (C) Martijn Koopman
+ * All Rights Reserved
+ *
+ * This software is distributed WITHOUT ANY WARRANTY; without even
+ * the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ * PURPOSE.
+ *
+ */
+
+#ifndef SPATIUMLIB_IMGPROC_PIPELINE_H
+#define SPATIUMLIB_IMGPROC_PIPELINE_H
+
+#include "IImageFilter.h"
+#include "Blur.h"
+#include "GlobalThreshold.h"
+#include "Grayscale.h"
+#include "Sobel.h"
+
+#include <algorithm> // std::min, std::max
+#include <array> // std::array
+#include <cstdint> // std::uint32_t, std::int64_t
+#include <tuple> // std::tuple, std::tuple_element
+#include <type_traits> // std::is_same
+#include <vector> // std::vector
+
+namespace spatium {
+namespace imgproc {
+
+/// \class GrayscaleStage
+/// \brief Grayscale filter as pipeline stage
+///
+/// A pipeline stage filters one row at a time. It provides:
+/// - InputType, InputChannels, OutputType and OutputChannels;
+/// - margin(): number of rows above and below that an output row depends on;
+/// - begin(width, height): called before the first row of an image or of a
+///   band of rows;
+/// - filterRow(rows, width, y, output): compute output row y from the
+///   2*margin+2 input rows y-margin-1 .. y+margin, clamped at the image
+///   borders. Rows are filtered in order. Row y-margin-1 is only valid if y
+///   is not the first row since begin().
+template<typename T = unsigned char>
+class GrayscaleStage : public Grayscale<T>
+{
+public:
+  typedef T InputType;
+  typedef T OutputType;
+  static const int InputChannels = 3;
+  static const int OutputChannels = 1;
+
+  /// Constructor. See Grayscale.
+  GrayscaleStage(double redCoeff = 0.2125,
+                 double greenCoeff = 0.7154,
+                 double blueCoff = 0.0721)
+    : Grayscale<T>(redCoeff, greenCoeff, blueCoff)
+  {}
+
+  /// Constructor. Stage of a grayscale filter.
+  explicit GrayscaleStage(const Grayscale<T> &filter)
+    : Grayscale<T>(filter)
+  {}
+
+  /// Number of rows above and below an output row depends on.
+  size_t margin() const
+  {
+    return 0;
+  }
+
+  /// Prepare for an image.
+  void begin(size_t, size_t)
+  {
+  }
+
+  /// Filter a row.
+  void filterRow(const std::array<T, 3> *const *rows, size_t width, size_t, std::array<T, 1> *output)
+  {
+    this->applyRow(rows[1], width, output);
+  }
+};
+
+/// \class BlurStage
+/// \brief Blur filter as pipeline stage
+///
+/// Column sums are kept between rows, so the cost per row is independent of
+/// the radius, like Blur.
+template<typename T = unsigned char, int N = 1>
+class BlurStage : public Blur
+{
+public:
+  typedef T InputType;
+  typedef T OutputType;
+  static const int InputChannels = N;
+  static const int OutputChannels = N;
+
+  /// Constructor. See Blur.
+  BlurStage(size_t radius = 1)
+    : Blur(radius)
+    , m_accumulator(Accumulator::UInt32)
+    , m_reciprocal(1)
+    , m_first(true)
+  {}
+
+  /// Constructor. Stage of a blur filter.
+  explicit BlurStage(const Blur &filter)
+    : Blur(filter)
+    , m_accumulator(Accumulator::UInt32)
+    , m_reciprocal(1)
+    , m_first(true)
+  {}
+
+  /// Number of rows above and below an output row depends on.
+  size_t margin() const
+  {
+    return m_radius;
+  }
+
+  /// Prepare for an image.
+  void begin(size_t width, size_t)
+  {
+    const size_t area = (2 * m_radius + 1) * (2 * m_radius + 1);
+    m_accumulator = accumulator<T>();
+    m_first = true;
+    m_reciprocal = Reciprocal(static_cast<std::uint32_t>(std::min<size_t>(area, 0x80000000u)));
+    switch (m_accumulator)
+    {
+    case Accumulator::UInt32:
+      m_sumsUInt32.resize(width * N);
+      break;
+    case Accumulator::Int64:
+      m_sumsInt64.resize(width * N);
+      break;
+    case Accumulator::Double:
+      m_sumsDouble.resize(width * N);
+      break;
+    }
+  }
+
+  /// Filter a row.
+  void filterRow(const std::array<T, N> *const *rows, size_t width, size_t, std::array<T, N> *output)
+  {
+    switch (m_accumulator)
+    {
+    case Accumulator::UInt32:
+      slide(m_sumsUInt32, rows, width, output);
+      break;
+    case Accumulator::Int64:
+      slide(m_sumsInt64, rows, width, output);
+      break;
+    case Accumulator::Double:
+      slide(m_sumsDouble, rows, width, output);
+      break;
+    }
+    m_first = false;
+  }
+
+protected:
+  /// Update column sums for a row and filter the row horizontally.
+  template<typename Acc>
+  void slide(std::vector<Acc> &columnSums, const std::array<T, N> *const *rows, size_t width, std::array<T, N> *output) const
+  {
+    const size_t rowSize = width * N;
+    const size_t r = m_radius;
+    if (m_first)
+    {
+      // Sum rows y-r .. y+r
+      const T *row = reinterpret_cast<const T*>(rows[1]);
+      for (size_t i = 0; i < rowSize; i++)
+      {
+        columnSums[i] = static_cast<Acc>(row[i]);
+      }
+      for (size_t k = 2; k <= 2 * r + 1; k++)
+      {
+        row = reinterpret_cast<const T*>(rows[k]);
+        for (size_t i = 0; i < rowSize; i++)
+        {
+          columnSums[i] += static_cast<Acc>(row[i]);
+        }
+      }
+    }
+    else
+    {
+      // Slide window one row down: add row y+r, subtract row y-r-1
+      const T *addRow = reinterpret_cast<const T*>(rows[2 * r + 1]);
+      const T *subRow = reinterpret_cast<const T*>(rows[0]);
+      for (size_t i = 0; i < rowSize; i++)
+      {
+        columnSums[i] += static_cast<Acc>(addRow[i]) - static_cast<Acc>(subRow[i]);
+      }
+    }
+
+    const Acc area = static_cast<Acc>((2 * r + 1) * (2 * r + 1));
+    Blur::filterRow<Acc, T, N>(columnSums.data(), width, area, m_reciprocal, reinterpret_cast<T*>(output));
+  }
+
+  /// Type of column sums for the current image
+  Accumulator m_accumulator;
+
+  /// Divisor for 32-bit sums
+  Reciprocal m_reciprocal;
+
+  /// Next row is the first row since begin()
+  bool m_first;
+
+  /// Column sums; one of these is used
+  std::vector<std::uint32_t> m_sumsUInt32;
+  std::vector<std::int64_t> m_sumsInt64;
+  std::vector<double> m_sumsDouble;
+};
+
+/// \class SobelStage
+/// \brief Sobel filter (gradient magnitude) as pipeline stage
+template<typename T = unsigned char>
+class SobelStage : public Sobel
+{
+public:
+  typedef T InputType;
+  typedef T OutputType;
+  static const int InputChannels = 1;
+  static const int OutputChannels = 1;
+
+  /// Constructor. See Sobel.
+  SobelStage(Norm norm = Norm::L2)
+    : Sobel(norm)
+  {}
+
+  /// Constructor. Stage of a Sobel filter.
+  explicit SobelStage(const Sobel &filter)
+    : Sobel(filter)
+  {}
+
+  /// Number of rows above and below an output row depends on.
+  size_t margin() const
+  {
+    return 1;
+  }
+
+  /// Prepare for an image.
+  void begin(size_t, size_t)
+  {
+  }
+
+  /// Filter a row.
+  void filterRow(const std::array<T, 1> *const *rows, size_t width, size_t, std::array<T, 1> *output)
+  {
+    Sobel::filterRow(reinterpret_cast<const T*>(rows[1]),
+                     reinterpret_cast<const T*>(rows[2]),
+                     reinterpret_cast<const T*>(rows[3]),
+                     width, reinterpret_cast<T*>(output));
+  }
+};
+
+/// \class GlobalThresholdStage
+/// \brief Global threshold filter as pipeline stage
+template<typename T = unsigned char, int N = 1>
+class GlobalThresholdStage : public GlobalThreshold<T>
+{
+public:
+  typedef T InputType;
+  typedef T OutputType;
+  static const int InputChannels = N;
+  static const int OutputChannels = 1;
+
+  /// Constructor. See GlobalThreshold.
+  GlobalThresholdStage(T thresholdValue = 0)
+    : GlobalThreshold<T>(thresholdValue)
+  {}
+
+  /// Constructor. Stage of a global threshold filter.
+  explicit GlobalThresholdStage(const GlobalThreshold<T> &filter)
+    : GlobalThreshold<T>(filter)
+  {}
+
+  /// Number of rows above and below an output row depends on.
+  size_t margin() const
+  {
+    return 0;
+  }
+
+  /// Prepare for an image.
+  void begin(size_t, size_t)
+  {
+  }
+
+  /// Filter a row.
+  void filterRow(const std::array<T, N> *const *rows, size_t width, size_t, std::array<T, 1> *output)
+  {
+    this->template applyRow<N>(rows[1], width, output);
+  }
+};
+
+/// \class PipelineNode
+/// \brief Stage of a pipeline with the rows buffered for it
+///
+/// Every node buffers the last 2*margin+2 rows produced by the previous
+/// stage. The first node reads the input image directly and the last node
+/// (without stage) writes into the output image.
+template<typename OutputPixel, typename... Stages>
+class PipelineNode;
+
+/// \brief End of pipeline; rows are written into the output image.
+template<typename OutputPixel>
+class PipelineNode<OutputPixel>
+{
+public:
+  typedef OutputPixel InputPixel;
+
+  /// Number of rows above and below an output row depends on.
+  size_t margin() const
+  {
+    return 0;
+  }
+
+  /// Prepare for a band of rows.
+  void begin(size_t width, size_t, size_t, size_t, const InputPixel *, OutputPixel *output)
+  {
+    m_width = width;
+    m_output = output;
+  }
+
+  /// Row y to write to
+  InputPixel *inputRow(size_t y)
+  {
+    return m_output + y * m_width;
+  }
+
+  /// Row y has been written.
+  void pushed(size_t)
+  {
+  }
+
+protected:
+  size_t m_width;
+  OutputPixel *m_output;
+};
+
+template<typename OutputPixel, typename Stage, typename... Rest>
+class PipelineNode<OutputPixel, Stage, Rest...>
+{
+public:
+  typedef std::array<typename Stage::InputType, Stage::InputChannels> InputPixel;
+  typedef std::array<typename Stage::OutputType, Stage::OutputChannels> StageOutputPixel;
+  typedef PipelineNode<OutputPixel, Rest...> Next;
+
+  static_assert(std::is_same<StageOutputPixel, typename Next::InputPixel>::value,
+                "Output of pipeline stage does not match input of next stage");
+
+  PipelineNode() = default;
+
+  PipelineNode(const Stage &stage, const Rest&... rest)
+    : m_stage(stage)
+    , m_next(rest...)
+  {}
+
+  /// Number of rows above and below an output row of the pipeline depends
+  /// on; sum of the margins of this and the following stages.
+  size_t margin() const
+  {
+    return m_stage.margin() + m_next.margin();
+  }
+
+  /// Prepare for a band of rows.
+  ///
+  /// The stage filters the output rows of the band extended by the margin of
+  /// the following stages.
+  ///
+  /// \param[in] width Image width
+  /// \param[in] height Image height
+  /// \param[in] firstRow First output row of the pipeline
+  /// \param[in] lastRow Last output row of the pipeline (exclusive)
+  /// \param[in] source Input image; nullptr if rows are pushed into this node
+  /// \param[out] output Output image of the pipeline
+  void begin(size_t width, size_t height, size_t firstRow, size_t lastRow, const InputPixel *source, OutputPixel *output)
+  {
+    const size_t margin = m_next.margin();
+    m_width = width;
+    m_height = height;
+    m_source = source;
+    m_nextRow = (firstRow > margin ? firstRow - margin : 0);
+    m_endRow = std::min(lastRow + margin, height);
+    m_rows.resize(2 * m_stage.margin() + 2);
+    if (source == nullptr)
+    {
+      m_buffer.resize(m_rows.size() * width);
+    }
+    m_stage.begin(width, height);
+    m_next.begin(width, height, firstRow, lastRow, nullptr, output);
+  }
+
+  /// Row y to write to by the previous stage
+  InputPixel *inputRow(size_t y)
+  {
+    return m_buffer.data() + (y % m_rows.size()) * m_width;
+  }
+
+  /// Row y has been written. Filter all output rows that depend on rows up
+  /// to y only.
+  void pushed(size_t y)
+  {
+    const size_t margin = m_stage.margin();
+    while (m_nextRow < m_endRow && std::min(m_nextRow + margin, m_height - 1) <= y)
+    {
+      // Rows m_nextRow-margin-1 .. m_nextRow+margin, clamped
+      for (size_t k = 0; k < m_rows.size(); k++)
+      {
+        const size_t i = std::min(std::max(m_nextRow + k, margin + 1) - (margin + 1), m_height - 1);
+        m_rows[k] = (m_source != nullptr ? m_source + i * m_width
+                                         : m_buffer.data() + (i % m_rows.size()) * m_width);
+      }
+
+      m_stage.filterRow(m_rows.data(), m_width, m_nextRow, m_next.inputRow(m_nextRow));
+      m_next.pushed(m_nextRow);
+      m_nextRow++;
+    }
+  }
+
+protected:
+  Stage m_stage;
+  Next m_next;
+
+  size_t m_width;
+  size_t m_height;
+  const InputPixel *m_source;
+
+  /// Next output row to filter
+  size_t m_nextRow;
+
+  /// Last output row to filter (exclusive)
+  size_t m_endRow;
+
+  /// Input rows for the current output row
+  std::vector<const InputPixel*> m_rows;
+
+  /// Ring of input rows
+  std::vector<InputPixel> m_buffer;
+};
+
+/// \class Pipeline
+/// \brief Chain of filters applied in a single pass
+///
+/// Applying filters one after another writes and reads a full intermediate
+/// image per filter. A pipeline passes rows from stage to stage instead: each
+/// stage only buffers the few rows its filter needs (2*margin+2), which stay
+/// in cache. The result is equal to applying the filters one after another.
+///
+/// A band of output rows can be filtered separately; it reads the input rows
+/// of the band extended by margin(). Bands can be filtered concurrently by
+/// copies of a pipeline (see ParallelExecutor).
+///
+/// Example:
+/// \code
+/// Pipeline<GrayscaleStage<>, BlurStage<>, SobelStage<>> edges;
+/// edges.apply(rgbImage, edgeImage);
+/// \endcode
+template<typename... Stages>
+class Pipeline : public IImageFilter
+{
+  static_assert(sizeof...(Stages) > 0, "Pipeline requires at least one stage");
+
+  typedef typename std::tuple_element<0, std::tuple<Stages...>>::type FirstStage;
+  typedef typename std::tuple_element<sizeof...(Stages) - 1, std::tuple<Stages...>>::type LastStage;
+
+public:
+  typedef typename FirstStage::InputType InputType;
+  typedef typename LastStage::OutputType OutputType;
+  static const int InputChannels = FirstStage::InputChannels;
+  static const int OutputChannels = LastStage::OutputChannels;
+
+  /// Constructor. Default constructed stages.
+  Pipeline() = default;
+
+  /// Constructor.
+  ///
+  /// \param[in] stages Stages, in order of application
+  explicit Pipeline(const Stages&... stages)
+    : m_head(stages...)
+  {}
+
+  /// Number of rows above and below an output row depends on; sum of the
+  /// margins of all stages.
+  size_t margin() const
+  {
+    return m_head.margin();
+  }
+
+  /// Apply filter.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image; not the input image
+  /// \return True on success, false on image dimensions mismatch or aliasing
+  bool apply(const Image<InputType, InputChannels> &input, Image<OutputType, OutputChannels> &output)
+  {
+    return apply(input, output, 0, input.height());
+  }
+
+  /// Apply filter on a band of rows. Other rows of the output image are not
+  /// written.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Output image; not the input image
+  /// \param[in] firstRow First row of band
+  /// \param[in] lastRow Last row of band (exclusive)
+  /// \return True on success, false on image dimensions mismatch or aliasing
+  bool apply(const Image<InputType, InputChannels> &input, Image<OutputType, OutputChannels> &output,
+             size_t firstRow, size_t lastRow)
+  {
+    if (input.width() != output.width() ||
+        input.height() != output.height() ||
+        static_cast<const void*>(&input) == static_cast<const void*>(&output))
+    {
+      return false;
+    }
+
+    lastRow = std::min(lastRow, input.height());
+    if (input.width() == 0 || firstRow >= lastRow)
+    {
+      return true;
+    }
+
+    // Push the input rows of the band and its margin
+    const size_t margin = m_head.margin();
+    m_head.begin(input.width(), input.height(), firstRow, lastRow, input.imageDataPtr(), output.imageDataPtr());
+    for (size_t y = (firstRow > margin ? firstRow - margin : 0); y < std::min(lastRow + margin, input.height()); y++)
+    {
+      m_head.pushed(y);
+    }
+
+    return true;
+  }
+
+protected:
+  PipelineNode<std::array<OutputType, OutputChannels>, Stages...> m_head;
+};
+
+/// Create a pipeline from stages.
+///
+/// \param[in] stages Stages, in order of application
+/// \return Pipeline
+template<typename... Stages>
+Pipeline<Stages...> makePipeline(const Stages&... stages)
+{
+  return Pipeline<Stages...>(stages...);
+}
+
+} // namespace imgproc
+} // namespace spatium
+
+#endif // SPATIUMLIB_IMGPROC_PIPELINE_H
@@ -14,59 +14,573 @@
 #define SPATIUMLIB_IMGPROC_SOBEL_H
 
 #include "IImageFilter.h"
+#include "Border.h"
 
-#include <cmath> // std::sqrt
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::abs, std::floor, std::sqrt
+#include <cstddef> // std::ptrdiff_t
+#include <cstdlib> // std::abs
+#include <limits> // std::numeric_limits
+#include <vector> // std::vector
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SPATIUMLIB_IMGPROC_SOBEL_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
 
 namespace spatium {
 namespace imgproc {
 
 /// \class Sobel
+/// \brief Sobel edge detection filter
+///
+/// Computes the image gradient with the 3x3 Sobel operators:
+///
+///        | -1  0  1 |          | -1 -2 -1 |
+///   Gx = | -2  0  2 |     Gy = |  0  0  0 |
+///        | -1  0  1 |          |  1  2  1 |
+///
+/// The y axis points down. Pixels outside the image are determined by a
+/// border policy (see Border.h); by default they are clamped to the nearest
+/// border pixel. Only the first and last row and column use the policy. The
+/// output image should not be the input image.
+///
+/// For 8-bit images the gradients are computed with 16-bit integers, 8
+/// pixels at a time if SSE2 is available. The gradients Gx and Gy and the
+/// quantized gradient orientation can be output as well, for instance for
+/// edge thinning.
 class Sobel : public IImageFilter
 {
 public:
-  Sobel() = default;
+  /// Norm of the gradient magnitude
+  enum class Norm
+  {
+    L1, ///< |Gx| + |Gy|
+    L2  ///< sqrt(Gx^2 + Gy^2)
+  };
+
+  /// Gradient orientation quantized to 4 directions (of 45 degrees)
+  enum Orientation
+  {
+    Horizontal = 0,   ///< Gradient along the x axis (vertical edge)
+    DiagonalDown = 1, ///< Gradient along (1, 1) or (-1, -1)
+    Vertical = 2,     ///< Gradient along the y axis (horizontal edge)
+    DiagonalUp = 3    ///< Gradient along (1, -1) or (-1, 1)
+  };
+
+  /// Constructor
+  ///
+  /// \param[in] norm Norm of the gradient magnitude (default = L2)
+  Sobel(Norm norm = Norm::L2)
+    : m_norm(norm)
+  {
+  }
+
   virtual ~Sobel() = default;
 
-  // Apply filter
-  template<typename T>
-  bool apply(const Image<T, 1> &input, Image<T, 1> &output)
+  /// Get norm of the gradient magnitude.
+  ///
+  /// \return Norm
+  Norm norm() const
+  {
+    return m_norm;
+  }
+
+  /// Set norm of the gradient magnitude.
+  ///
+  /// \param[in] norm Norm
+  void setNorm(Norm norm)
+  {
+    m_norm = norm;
+  }
+
+  /// Apply filter; compute gradient magnitude.
+  ///
+  /// Magnitudes are rounded to nearest and saturated to the range of T.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Gradient magnitude. Should have the size of the
+  /// input image.
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch
+  template<typename T, typename Border = BorderClamp>
+  bool apply(const Image<T, 1> &input, Image<T, 1> &output, const Border &border = Border())
   {
     if (input.width() != output.width() ||
-        input.height() != output.height())
+        input.height() != output.height() ||
+        &input == &output)
     {
       return false;
     }
 
-    // Iterate pixels
-    for (size_t y = 1; y < input.height()-1; y++)
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const T *in = reinterpret_cast<const T*>(input.imageDataPtr());
+    T *out = reinterpret_cast<T*>(output.imageDataPtr());
+    const std::vector<T> outsideRow(width, borderValue<T>(border));
+    for (size_t y = (Border::filtersBorder ? 0 : 1); y + (Border::filtersBorder ? 0 : 1) < height; y++)
+    {
+      filterRow(borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(y) - 1, width, height, border),
+                in + y * width,
+                borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(y) + 1, width, height, border),
+                width, out + y * width, border);
+    }
+
+    return true;
+  }
+
+  /// Apply filter on 8-bit image; compute gradient magnitude.
+  ///
+  /// Magnitudes are rounded to nearest and saturated to 255.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] output Gradient magnitude. Should have the size of the
+  /// input image.
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch
+  template<typename Border = BorderClamp>
+  bool apply(const Image<unsigned char, 1> &input, Image<unsigned char, 1> &output, const Border &border = Border())
+  {
+    return apply(input, &output, nullptr, nullptr, nullptr, border);
+  }
+
+  /// Apply filter on 8-bit image; compute gradients.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] gradientX Gradient Gx; range -1020 to 1020
+  /// \param[out] gradientY Gradient Gy; range -1020 to 1020
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch
+  template<typename Border = BorderClamp>
+  bool apply(const Image<unsigned char, 1> &input, Image<short, 1> &gradientX, Image<short, 1> &gradientY,
+             const Border &border = Border())
+  {
+    return apply(input, nullptr, &gradientX, &gradientY, nullptr, border);
+  }
+
+  /// Apply filter on 8-bit image; compute any of the gradient images.
+  ///
+  /// All gradient images are computed in a single pass over the input.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] magnitude Gradient magnitude, saturated to 255. May be
+  /// nullptr.
+  /// \param[out] gradientX Gradient Gx. May be nullptr.
+  /// \param[out] gradientY Gradient Gy. May be nullptr.
+  /// \param[out] orientation Gradient orientation; see Orientation. Zero
+  /// gradients have orientation Horizontal. May be nullptr.
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch of any
+  /// output image
+  template<typename Border = BorderClamp>
+  bool apply(const Image<unsigned char, 1> &input,
+             Image<unsigned char, 1> *magnitude,
+             Image<short, 1> *gradientX,
+             Image<short, 1> *gradientY,
+             Image<unsigned char, 1> *orientation,
+             const Border &border = Border())
+  {
+    return apply(input, magnitude, gradientX, gradientY, orientation, 0, input.height(), border);
+  }
+
+  /// Apply filter on 8-bit image; compute any of the gradient images for a
+  /// band of rows.
+  ///
+  /// Only rows firstRow .. lastRow-1 of the output images are written, from
+  /// input rows firstRow-1 .. lastRow. Bands of an image can be filtered in
+  /// parallel.
+  ///
+  /// \param[in] input Input image
+  /// \param[out] magnitude Gradient magnitude, saturated to 255. May be
+  /// nullptr.
+  /// \param[out] gradientX Gradient Gx. May be nullptr.
+  /// \param[out] gradientY Gradient Gy. May be nullptr.
+  /// \param[out] orientation Gradient orientation; see Orientation. May be
+  /// nullptr.
+  /// \param[in] firstRow First row of the band
+  /// \param[in] lastRow Row after the last row of the band; at most the
+  /// image height
+  /// \param[in] border Border policy (default = BorderClamp)
+  /// \return True on success, false on image dimensions mismatch of any
+  /// output image
+  template<typename Border = BorderClamp>
+  bool apply(const Image<unsigned char, 1> &input,
+             Image<unsigned char, 1> *magnitude,
+             Image<short, 1> *gradientX,
+             Image<short, 1> *gradientY,
+             Image<unsigned char, 1> *orientation,
+             size_t firstRow,
+             size_t lastRow,
+             const Border &border = Border())
+  {
+    if (!matchesInput(input, magnitude) ||
+        !matchesInput(input, gradientX) ||
+        !matchesInput(input, gradientY) ||
+        !matchesInput(input, orientation) ||
+        magnitude == &input || orientation == &input)
+    {
+      return false;
+    }
+
+    const size_t width = input.width();
+    const size_t height = input.height();
+    const unsigned char *in = reinterpret_cast<const unsigned char*>(input.imageDataPtr());
+    const std::vector<unsigned char> outsideRow(width, borderValue<unsigned char>(border));
+    const size_t begin = std::max<size_t>(firstRow, Border::filtersBorder ? 0 : 1);
+    const size_t end = std::min(lastRow, Border::filtersBorder ? height : (height > 0 ? height - 1 : 0));
+    for (size_t y = begin; y < end; y++)
+    {
+      Rows rows;
+      rows.above = borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(y) - 1, width, height, border);
+      rows.row = in + y * width;
+      rows.below = borderRow(in, outsideRow.data(), static_cast<std::ptrdiff_t>(y) + 1, width, height, border);
+      rows.magnitude = (magnitude != nullptr ? reinterpret_cast<unsigned char*>(magnitude->imageDataPtr()) + y * width : nullptr);
+      rows.gradientX = (gradientX != nullptr ? reinterpret_cast<short*>(gradientX->imageDataPtr()) + y * width : nullptr);
+      rows.gradientY = (gradientY != nullptr ? reinterpret_cast<short*>(gradientY->imageDataPtr()) + y * width : nullptr);
+      rows.orientation = (orientation != nullptr ? reinterpret_cast<unsigned char*>(orientation->imageDataPtr()) + y * width : nullptr);
+      filterRow(rows, width, border);
+    }
+
+    return true;
+  }
+
+  /// Quantize gradient orientation.
+  ///
+  /// The gradient is Horizontal within 22.5 degrees of the x axis, Vertical
+  /// within 22.5 degrees of the y axis and diagonal otherwise.
+  ///
+  /// \param[in] gx Gradient Gx; absolute value at most 1020
+  /// \param[in] gy Gradient Gy; absolute value at most 1020
+  /// \return Orientation
+  static unsigned char quantizeOrientation(int gx, int gy)
+  {
+    const int ax = std::abs(gx);
+    const int ay = std::abs(gy);
+    const int t = (ax * tan22_5) >> 16; // ax * tan(22.5)
+    if (ay <= t)
+    {
+      return Horizontal;
+    }
+    if (ay > 2 * ax + t) // ax * tan(67.5)
+    {
+      return Vertical;
+    }
+    return ((gx ^ gy) < 0 ? DiagonalUp : DiagonalDown);
+  }
+
+protected:
+  /// tan(22.5 degrees) in 16-bit fixed point
+  static const int tan22_5 = 27146;
+
+  /// Input and output rows of an 8-bit image
+  struct Rows
+  {
+    const unsigned char *above;
+    const unsigned char *row;
+    const unsigned char *below;
+    unsigned char *magnitude;
+    short *gradientX;
+    short *gradientY;
+    unsigned char *orientation;
+  };
+
+  /// Check if an optional output image has the size of the input image.
+  template<typename T>
+  static bool matchesInput(const Image<unsigned char, 1> &input, const Image<T, 1> *output)
+  {
+    return (output == nullptr ||
+            (output->width() == input.width() && output->height() == input.height()));
+  }
+
+  /// Row of the input image or outside the image.
+  template<typename T, typename Border>
+  static const T *borderRow(const T *in, const T *outsideRow, std::ptrdiff_t y, size_t width, size_t height, const Border &border)
+  {
+    size_t index;
+    return (border.index(y, height, index) ? in + index * width : outsideRow);
+  }
+
+  /// Sample of a row inside or outside the image.
+  template<typename T, typename Border>
+  static T borderSample(const T *row, std::ptrdiff_t x, size_t width, const Border &border)
+  {
+    size_t index;
+    return (border.index(x, width, index) ? row[index] : borderValue<T>(border));
+  }
+
+  /// Filter a row; compute gradient magnitude.
+  ///
+  /// \param[in] above Row above; may be outside the image
+  /// \param[in] row Row
+  /// \param[in] below Row below; may be outside the image
+  /// \param[in] width Number of pixels in row
+  /// \param[out] output Gradient magnitude
+  /// \param[in] border Border policy for the first and last pixel
+  template<typename T, typename Border = BorderClamp>
+  void filterRow(const T *above, const T *row, const T *below, size_t width, T *output,
+                 const Border &border = Border()) const
+  {
+    if (width == 0)
+    {
+      return;
+    }
+
+    if (Border::filtersBorder)
+    {
+      filterBorderPixel(above, row, below, 0, width, output, border);
+    }
+    for (size_t x = 1; x + 1 < width; x++)
+    {
+      const double gx = (static_cast<double>(above[x + 1]) - above[x - 1]) +
+                        2 * (static_cast<double>(row[x + 1]) - row[x - 1]) +
+                        (static_cast<double>(below[x + 1]) - below[x - 1]);
+      const double gy = (static_cast<double>(below[x - 1]) + 2 * static_cast<double>(below[x]) + below[x + 1]) -
+                        (static_cast<double>(above[x - 1]) + 2 * static_cast<double>(above[x]) + above[x + 1]);
+      output[x] = magnitude<T>(gx, gy);
+    }
+    if (Border::filtersBorder && width > 1)
+    {
+      filterBorderPixel(above, row, below, width - 1, width, output, border);
+    }
+  }
+
+  /// Filter the first or last pixel of a row.
+  template<typename T, typename Border>
+  void filterBorderPixel(const T *above, const T *row, const T *below, size_t x, size_t width, T *output,
+                         const Border &border) const
+  {
+    const std::ptrdiff_t left = static_cast<std::ptrdiff_t>(x) - 1;
+    const std::ptrdiff_t right = static_cast<std::ptrdiff_t>(x) + 1;
+    const double aboveLeft = borderSample(above, left, width, border);
+    const double aboveRight = borderSample(above, right, width, border);
+    const double rowLeft = borderSample(row, left, width, border);
+    const double rowRight = borderSample(row, right, width, border);
+    const double belowLeft = borderSample(below, left, width, border);
+    const double belowRight = borderSample(below, right, width, border);
+    const double gx = (aboveRight - aboveLeft) + 2 * (rowRight - rowLeft) + (belowRight - belowLeft);
+    const double gy = (belowLeft + 2 * static_cast<double>(below[x]) + belowRight) -
+                      (aboveLeft + 2 * static_cast<double>(above[x]) + aboveRight);
+    output[x] = magnitude<T>(gx, gy);
+  }
+
+  /// Gradient magnitude as sample.
+  template<typename T>
+  T magnitude(double gx, double gy) const
+  {
+    return toSample<T>(m_norm == Norm::L1 ? std::abs(gx) + std::abs(gy) : std::sqrt(gx * gx + gy * gy));
+  }
+
+  /// Filter a row of an 8-bit image; compute gradient magnitude.
+  template<typename Border = BorderClamp>
+  void filterRow(const unsigned char *above, const unsigned char *row, const unsigned char *below,
+                 size_t width, unsigned char *output, const Border &border = Border()) const
+  {
+    Rows rows;
+    rows.above = above;
+    rows.row = row;
+    rows.below = below;
+    rows.magnitude = output;
+    rows.gradientX = nullptr;
+    rows.gradientY = nullptr;
+    rows.orientation = nullptr;
+    filterRow(rows, width, border);
+  }
+
+  /// Filter a row of an 8-bit image.
+  template<typename Border = BorderClamp>
+  void filterRow(const Rows &rows, size_t width, const Border &border = Border()) const
+  {
+    if (width == 0)
+    {
+      return;
+    }
+
+    // First pixel; left neighbour outside the image
+    if (Border::filtersBorder)
     {
-      for (size_t x = 1; x < input.width()-1; x++)
+      filterBorderPixel(rows, 0, width, border);
+    }
+
+    size_t x = 1;
+#ifdef SPATIUMLIB_IMGPROC_SOBEL_SSE2
+    // 8 pixels at a time; reads up to pixel x + 8
+    for (; x + 8 < width; x += 8)
+    {
+      filterPixels(rows, x);
+    }
+#endif
+
+    for (; x + 1 < width; x++)
+    {
+      filterPixel(rows, x - 1, x, x + 1);
+    }
+
+    // Last pixel; right neighbour outside the image
+    if (Border::filtersBorder && width > 1)
+    {
+      filterBorderPixel(rows, width - 1, width, border);
+    }
+  }
+
+  /// Filter the first or last pixel of a row of an 8-bit image.
+  template<typename Border>
+  void filterBorderPixel(const Rows &rows, size_t x, size_t width, const Border &border) const
+  {
+    const std::ptrdiff_t left = static_cast<std::ptrdiff_t>(x) - 1;
+    const std::ptrdiff_t right = static_cast<std::ptrdiff_t>(x) + 1;
+    const int aboveLeft = borderSample(rows.above, left, width, border);
+    const int aboveRight = borderSample(rows.above, right, width, border);
+    const int rowLeft = borderSample(rows.row, left, width, border);
+    const int rowRight = borderSample(rows.row, right, width, border);
+    const int belowLeft = borderSample(rows.below, left, width, border);
+    const int belowRight = borderSample(rows.below, right, width, border);
+    const int gx = (aboveRight - aboveLeft) + 2 * (rowRight - rowLeft) + (belowRight - belowLeft);
+    const int gy = (belowLeft + 2 * rows.below[x] + belowRight) - (aboveLeft + 2 * rows.above[x] + aboveRight);
+    storePixel(rows, x, gx, gy);
+  }
+
+  /// Filter a pixel of an 8-bit image.
+  ///
+  /// \param[in] rows Input and output rows
+  /// \param[in] left Index of left neighbour
+  /// \param[in] x Index of pixel
+  /// \param[in] right Index of right neighbour
+  void filterPixel(const Rows &rows, size_t left, size_t x, size_t right) const
+  {
+    const int gx = (rows.above[right] - rows.above[left]) +
+                   2 * (rows.row[right] - rows.row[left]) +
+                   (rows.below[right] - rows.below[left]);
+    const int gy = (rows.below[left] + 2 * rows.below[x] + rows.below[right]) -
+                   (rows.above[left] + 2 * rows.above[x] + rows.above[right]);
+    storePixel(rows, x, gx, gy);
+  }
+
+  /// Store gradients of a pixel of an 8-bit image.
+  void storePixel(const Rows &rows, size_t x, int gx, int gy) const
+  {
+    if (rows.magnitude != nullptr)
+    {
+      int g;
+      if (m_norm == Norm::L1)
+      {
+        g = std::abs(gx) + std::abs(gy);
+      }
+      else
       {
-        double Gx = input.pixel(x-1, y-1)[0] * -1 +
-                    input.pixel(x-1,   y)[0] * -2 +
-                    input.pixel(x-1, y+1)[0] * -1 +
-                    input.pixel(x+1, y-1)[0] * 1 +
-                     input.pixel(x+1,   y)[0] * 2 +
-               input.pixel(x+1, y+1)[0] * 1;
-
-        double Gy = input.pixel(x-1, y-1)[0] * -1 +
-               input.pixel(  x, y-1)[0] * -2 +
-               input.pixel(x+1, y-1)[0] * -1 +
-               input.pixel(x-1, y+1)[0] * 1 +
-               input.pixel(  x, y+1)[0] * 2 +
-               input.pixel(x+1, y+1)[0] * 1;
-
-        T G = std::sqrt(Gx * Gx + Gy * Gy);
-        output.pixel(x, y) = { G };
+        // Single precision, as in filterPixels()
+        g = static_cast<int>(std::sqrt(static_cast<float>(gx * gx + gy * gy)) + 0.5f);
       }
+      rows.magnitude[x] = static_cast<unsigned char>(std::min(g, 255));
     }
+    if (rows.gradientX != nullptr)
+    {
+      rows.gradientX[x] = static_cast<short>(gx);
+    }
+    if (rows.gradientY != nullptr)
+    {
+      rows.gradientY[x] = static_cast<short>(gy);
+    }
+    if (rows.orientation != nullptr)
+    {
+      rows.orientation[x] = quantizeOrientation(gx, gy);
+    }
+  }
 
-    return true;
+#ifdef SPATIUMLIB_IMGPROC_SOBEL_SSE2
+  /// Filter 8 pixels of an 8-bit image with SSE2; x to x + 7.
+  ///
+  /// Results equal those of filterPixel().
+  void filterPixels(const Rows &rows, size_t x) const
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i aboveLeft = load8(rows.above + x - 1, zero);
+    const __m128i above = load8(rows.above + x, zero);
+    const __m128i aboveRight = load8(rows.above + x + 1, zero);
+    const __m128i rowLeft = load8(rows.row + x - 1, zero);
+    const __m128i rowRight = load8(rows.row + x + 1, zero);
+    const __m128i belowLeft = load8(rows.below + x - 1, zero);
+    const __m128i below = load8(rows.below + x, zero);
+    const __m128i belowRight = load8(rows.below + x + 1, zero);
+
+    const __m128i rowDiff = _mm_sub_epi16(rowRight, rowLeft);
+    const __m128i gx = _mm_add_epi16(_mm_add_epi16(_mm_sub_epi16(aboveRight, aboveLeft), _mm_add_epi16(rowDiff, rowDiff)),
+                                     _mm_sub_epi16(belowRight, belowLeft));
+    const __m128i gy = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(belowLeft, belowRight), _mm_add_epi16(below, below)),
+                                     _mm_add_epi16(_mm_add_epi16(aboveLeft, aboveRight), _mm_add_epi16(above, above)));
+
+    if (rows.magnitude != nullptr)
+    {
+      __m128i g;
+      if (m_norm == Norm::L1)
+      {
+        g = _mm_add_epi16(abs16(gx, zero), abs16(gy, zero));
+      }
+      else
+      {
+        // gx^2 + gy^2 in 32 bits, square root in single precision
+        const __m128i low = _mm_unpacklo_epi16(gx, gy);
+        const __m128i high = _mm_unpackhi_epi16(gx, gy);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128i gLow = _mm_cvttps_epi32(_mm_add_ps(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(low, low))), half));
+        const __m128i gHigh = _mm_cvttps_epi32(_mm_add_ps(_mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(high, high))), half));
+        g = _mm_packs_epi32(gLow, gHigh);
+      }
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.magnitude + x), _mm_packus_epi16(g, g));
+    }
+    if (rows.gradientX != nullptr)
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.gradientX + x), gx);
+    }
+    if (rows.gradientY != nullptr)
+    {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(rows.gradientY + x), gy);
+    }
+    if (rows.orientation != nullptr)
+    {
+      // See quantizeOrientation()
+      const __m128i ax = abs16(gx, zero);
+      const __m128i ay = abs16(gy, zero);
+      const __m128i t = _mm_mulhi_epi16(ax, _mm_set1_epi16(static_cast<short>(tan22_5)));
+      const __m128i notHorizontal = _mm_cmpgt_epi16(ay, t);
+      const __m128i vertical = _mm_cmpgt_epi16(ay, _mm_add_epi16(_mm_add_epi16(ax, ax), t));
+      const __m128i up = _mm_srai_epi16(_mm_xor_si128(gx, gy), 15);
+      __m128i o = _mm_or_si128(_mm_set1_epi16(DiagonalDown), _mm_and_si128(up, _mm_set1_epi16(2)));
+      o = _mm_or_si128(_mm_and_si128(vertical, _mm_set1_epi16(Vertical)), _mm_andnot_si128(vertical, o));
+      o = _mm_and_si128(notHorizontal, o);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(rows.orientation + x), _mm_packus_epi16(o, o));
+    }
+  }
+
+  /// Load 8 bytes and widen to 16-bit integers.
+  static __m128i load8(const unsigned char *data, __m128i zero)
+  {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)), zero);
+  }
+
+  /// Absolute value of 16-bit integers.
+  static __m128i abs16(__m128i values, __m128i zero)
+  {
+    return _mm_max_epi16(values, _mm_sub_epi16(zero, values));
   }
+#endif
+
+  /// Convert gradient magnitude to sample type.
+  template<typename T>
+  static T toSample(double value)
+  {
+    if (!std::numeric_limits<T>::is_integer)
+    {
+      return static_cast<T>(value);
+    }
+    value = std::min(std::floor(value + 0.5), static_cast<double>(std::numeric_limits<T>::max()));
+    return static_cast<T>(value);
+  }
+
+  /// Norm of the gradient magnitude
+  Norm m_norm;
 };
 
 } // namespace imgproc
 } // namespace spatium
 
 #endif // SPATIUMLIB_IMGPROC_SOBEL_H
-
@@ -18,6 +18,8 @@
 #include "Vector.h"
 #include "stats.h"
 #include "Image.h"
+#include "ImagePool.h"
+#include "ThreadPool.h"
 #include "imgproc.h"
 #include "idx.h"
 #include "geom2d.h"
@@ -7,9 +7,6 @@
 
 #include <spatium/Image.h>
 #include <spatium/imgproc/GlobalThreshold.h>
-#include <spatium/imgproc/Grayscale.h>
-#include <spatium/imgproc/Blur.h>
-#include <spatium/imgproc/Sobel.h>
 
 VideoSurface::VideoSurface(QObject *parent)
   : QAbstractVideoSurface(parent)
@@ -48,23 +45,12 @@ bool VideoSurface::present(const QVideoFrame &frame)
   }
 
   // QImage to spatium Image
-  spatium::Image<unsigned char, 3> image;
-  spatium::QImageConvert::QImageToImage(qimage, image);
+  spatium::ImagePool<unsigned char, 3>::Lease image = m_rgbPool.acquire(frame.width(), frame.height());
+  spatium::QImageConvert::QImageToImage(qimage, *image);
 
-  // Grayscale
-  spatium::Image<unsigned char, 1> grayscale(frame.width(), frame.height());
-  spatium::imgproc::Grayscale<unsigned char> grayscaleFilter;
-  grayscaleFilter.apply(image, grayscale);
-
-  // Blur
-  spatium::Image<unsigned char, 1> blur(frame.width(), frame.height());
-  spatium::imgproc::Blur blurFilter;
-  blurFilter.apply(grayscale, blur);
-
-  // Sobel
-  spatium::Image<unsigned char, 1> sobel(frame.width(), frame.height());
-  spatium::imgproc::Sobel sobelFilter;
-  sobelFilter.apply(blur, sobel);
+  // Grayscale, blur and Sobel in a single pass
+  spatium::ImagePool<unsigned char, 1>::Lease sobel = m_grayPool.acquire(frame.width(), frame.height());
+  m_edgePipeline.apply(*image, *sobel);
 
   // Threshold
 //  spatium::Image<unsigned char, 1> binary(frame.width(), frame.height());
@@ -73,7 +59,7 @@ bool VideoSurface::present(const QVideoFrame &frame)
 
   // Spatium image to QImage
   QImage qimageOut;
-  spatium::QImageConvert::ImageToQImage(sobel, qimageOut);
+  spatium::QImageConvert::ImageToQImage(*sobel, qimageOut);
 
   m_mainWindow->setImage(qimageOut);
 
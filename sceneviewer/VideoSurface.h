@@ -3,6 +3,9 @@
 
 #include <QAbstractVideoSurface>
 
+#include <spatium/ImagePool.h>
+#include <spatium/imgproc/Pipeline.h>
+
 class MainWindow;
 
 class VideoSurface : public QAbstractVideoSurface
@@ -32,6 +35,16 @@ public slots:
 private:
   MainWindow *m_mainWindow;
 
+  // Recycled images; no image memory is allocated for subsequent frames of
+  // the same size.
+  spatium::ImagePool<unsigned char, 3> m_rgbPool;
+  spatium::ImagePool<unsigned char, 1> m_grayPool;
+
+  // Grayscale, blur and Sobel edge detection
+  spatium::imgproc::Pipeline<spatium::imgproc::GrayscaleStage<unsigned char>,
+                             spatium::imgproc::BlurStage<unsigned char, 1>,
+                             spatium::imgproc::SobelStage<unsigned char>> m_edgePipeline;
+
 //  QImage qt_imageFromVideoFrame(const QVideoFrame &f);
 };
 
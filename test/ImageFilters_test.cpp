@@ -3,13 +3,589 @@
 
 #include <spatium/Image.h>
 #include <spatium/ImageIO.h>
+#include <spatium/Matrix.h>
+#include <spatium/ThreadPool.h>
+#include <spatium/imgproc/AdaptiveThreshold.h>
+#include <spatium/imgproc/AutoThreshold.h>
+#include <spatium/imgproc/Border.h>
+#include <spatium/imgproc/Canny.h>
+#include <spatium/imgproc/Clahe.h>
+#include <spatium/imgproc/ConnectedComponents.h>
+#include <spatium/imgproc/Convolve.h>
+#include <spatium/imgproc/DistanceTransform.h>
 #include <spatium/imgproc/GlobalThreshold.h>
 #include <spatium/imgproc/Grayscale.h>
 #include <spatium/imgproc/Blur.h>
+#include <spatium/imgproc/GaussianBlur.h>
+#include <spatium/imgproc/Histogram.h>
+#include <spatium/imgproc/HistogramEqualization.h>
+#include <spatium/imgproc/IntegralImage.h>
+#include <spatium/imgproc/Median.h>
+#include <spatium/imgproc/Morphology.h>
+#include <spatium/imgproc/Pipeline.h>
+#include <spatium/imgproc/ParallelExecutor.h>
 #include <spatium/imgproc/Sobel.h>
 
+#include <algorithm> // std::min, std::max, std::nth_element
+#include <atomic> // std::atomic
+#include <chrono> // std::chrono::milliseconds
+#include <cmath> // std::abs, std::exp, std::floor, std::sqrt
+#include <cstdint> // uint64_t
+#include <cstdlib> // std::abs
+#include <limits> // std::numeric_limits
+#include <stdexcept> // std::runtime_error
+#include <string> // std::string, std::to_string
+#include <thread> // std::this_thread::sleep_for
+#include <utility> // std::pair, std::make_pair
+#include <vector> // std::vector
+
 using namespace spatium;
 
+// Sample of an image; pixels outside the image by a border policy
+template<typename T, int N, typename Border>
+static double borderSample(const Image<T, N> &image, int x, int y, int c, const Border &border)
+{
+  size_t px, py;
+  if (!border.index(x, image.width(), px) || !border.index(y, image.height(), py))
+  {
+    return imgproc::borderValue<T>(border);
+  }
+  return image.pixel(px, py)[c];
+}
+
+// Brute force box blur; rounded to nearest. Skipped pixels are 0.
+template<typename T, int N, typename Border = imgproc::BorderClamp>
+static Image<T, N> referenceBlur(const Image<T, N> &input, int radius, const Border &border = Border())
+{
+  const int width = static_cast<int>(input.width());
+  const int height = static_cast<int>(input.height());
+  const double area = (2.0 * radius + 1) * (2.0 * radius + 1);
+  Image<T, N> output(input.width(), input.height());
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      if (!Border::filtersBorder &&
+          (x < radius || x + radius >= width || y < radius || y + radius >= height))
+      {
+        continue;
+      }
+      for (int c = 0; c < N; c++)
+      {
+        double sum = 0;
+        for (int dy = -radius; dy <= radius; dy++)
+        {
+          for (int dx = -radius; dx <= radius; dx++)
+          {
+            sum += borderSample(input, x + dx, y + dy, c, border);
+          }
+        }
+        output.pixel(static_cast<size_t>(x), static_cast<size_t>(y))[c] = static_cast<T>(std::floor(sum / area + 0.5));
+      }
+    }
+  }
+  return output;
+}
+
+// Brute force Sobel gradient magnitude (L1). Skipped pixels are 0.
+template<typename T, typename Border>
+static Image<T, 1> referenceSobel(const Image<T, 1> &input, const Border &border)
+{
+  const int width = static_cast<int>(input.width());
+  const int height = static_cast<int>(input.height());
+  Image<T, 1> output(input.width(), input.height());
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      if (!Border::filtersBorder && (x < 1 || x + 1 >= width || y < 1 || y + 1 >= height))
+      {
+        continue;
+      }
+      double gx = 0, gy = 0;
+      for (int k = -1; k <= 1; k++)
+      {
+        const double weight = (k == 0 ? 2 : 1);
+        gx += weight * (borderSample(input, x + 1, y + k, 0, border) - borderSample(input, x - 1, y + k, 0, border));
+        gy += weight * (borderSample(input, x + k, y + 1, 0, border) - borderSample(input, x + k, y - 1, 0, border));
+      }
+      output.pixel(static_cast<size_t>(x), static_cast<size_t>(y))[0] = static_cast<T>(std::min(std::abs(gx) + std::abs(gy), 255.0));
+    }
+  }
+  return output;
+}
+
+// Verify box blur and Sobel with a border policy
+template<typename Border>
+static void verifyBorder(const Image<unsigned char, 3> &imageRgb, const Border &border)
+{
+  Image<unsigned char, 3> input(23, 17);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = imageRgb.pixel(x + 250, y + 260);
+    }
+  }
+
+  // Radius larger than the image reads pixels beyond the opposite border
+  imgproc::Blur blur;
+  for (size_t radius : { size_t(1), size_t(4), size_t(30) })
+  {
+    blur.setRadius(radius);
+    Image<unsigned char, 3> output(input.width(), input.height());
+    QVERIFY(blur.apply(input, output, border));
+    QVERIFY(output == referenceBlur(input, static_cast<int>(radius), border));
+  }
+
+  // Single column
+  Image<unsigned short, 1> column(1, 5);
+  for (size_t y = 0; y < column.height(); y++)
+  {
+    column.pixel(0, y)[0] = static_cast<unsigned short>(1000 * y);
+  }
+  Image<unsigned short, 1> columnOutput(1, 5);
+  blur.setRadius(2);
+  QVERIFY(blur.apply(column, columnOutput, border));
+  QVERIFY(columnOutput == referenceBlur(column, 2, border));
+
+  // Sobel; 8-bit and floating point images. Wide enough for SSE2.
+  Image<unsigned char, 1> gray(input.width(), input.height());
+  Image<float, 1> grayFloat(input.width(), input.height());
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      gray.pixel(x, y)[0] = input.pixel(x, y)[1];
+      grayFloat.pixel(x, y)[0] = input.pixel(x, y)[1];
+    }
+  }
+  imgproc::Sobel sobel(imgproc::Sobel::Norm::L1);
+  Image<unsigned char, 1> magnitude(gray.width(), gray.height());
+  QVERIFY(sobel.apply(gray, magnitude, border));
+  QVERIFY(magnitude == referenceSobel(gray, border));
+
+  Image<float, 1> magnitudeFloat(gray.width(), gray.height());
+  Image<float, 1> expectedFloat = referenceSobel(grayFloat, border);
+  QVERIFY(sobel.apply(grayFloat, magnitudeFloat, border));
+  bool equal = true;
+  for (size_t y = 0; y < gray.height(); y++)
+  {
+    for (size_t x = 0; x < gray.width(); x++)
+    {
+      // Reference saturates at 255
+      equal = equal && (std::min(magnitudeFloat.pixel(x, y)[0], 255.0f) == expectedFloat.pixel(x, y)[0]);
+    }
+  }
+  QVERIFY(equal);
+}
+
+// Brute force Gaussian blur; clamped borders, kernel truncated at 6 sigma
+template<typename T, int N>
+static std::vector<double> referenceGaussianBlur(const Image<T, N> &input, double sigma)
+{
+  const int width = static_cast<int>(input.width());
+  const int height = static_cast<int>(input.height());
+  const int radius = static_cast<int>(std::ceil(6 * sigma));
+  std::vector<double> kernel(2 * radius + 1);
+  double total = 0;
+  for (int k = -radius; k <= radius; k++)
+  {
+    kernel[k + radius] = std::exp(-0.5 * k * k / (sigma * sigma));
+    total += kernel[k + radius];
+  }
+
+  std::vector<double> output(input.width() * input.height() * N);
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        double sum = 0;
+        for (int dy = -radius; dy <= radius; dy++)
+        {
+          for (int dx = -radius; dx <= radius; dx++)
+          {
+            const int px = std::min(std::max(x + dx, 0), width - 1);
+            const int py = std::min(std::max(y + dy, 0), height - 1);
+            sum += kernel[dx + radius] * kernel[dy + radius] * input.pixel(static_cast<size_t>(px), static_cast<size_t>(py))[c];
+          }
+        }
+        output[(y * width + x) * N + c] = sum / (total * total);
+      }
+    }
+  }
+  return output;
+}
+
+// Brute force erosion or dilation; pixels outside the image are ignored
+template<typename T, int N>
+static Image<T, N> referenceMorphology(const Image<T, N> &input, size_t radiusX, size_t radiusY, bool dilate)
+{
+  Image<T, N> output(input.width(), input.height());
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        T value = input.pixel(x, y)[c];
+        for (size_t v = (y > radiusY ? y - radiusY : 0); v <= std::min(y + radiusY, input.height() - 1); v++)
+        {
+          for (size_t u = (x > radiusX ? x - radiusX : 0); u <= std::min(x + radiusX, input.width() - 1); u++)
+          {
+            value = (dilate ? std::max(value, input.pixel(u, v)[c]) : std::min(value, input.pixel(u, v)[c]));
+          }
+        }
+        output.pixel(x, y)[c] = value;
+      }
+    }
+  }
+  return output;
+}
+
+// Brute force median; pixels outside the image are clamped to the border
+template<int N>
+static Image<unsigned char, N> referenceMedian(const Image<unsigned char, N> &input, size_t radius)
+{
+  Image<unsigned char, N> output(input.width(), input.height());
+  const long r = static_cast<long>(radius);
+  const long width = static_cast<long>(input.width());
+  const long height = static_cast<long>(input.height());
+  for (long y = 0; y < height; y++)
+  {
+    for (long x = 0; x < width; x++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        std::vector<unsigned char> values;
+        for (long v = y - r; v <= y + r; v++)
+        {
+          for (long u = x - r; u <= x + r; u++)
+          {
+            values.push_back(input.pixel(static_cast<size_t>(std::min(std::max(u, 0L), width - 1)),
+                                         static_cast<size_t>(std::min(std::max(v, 0L), height - 1)))[c]);
+          }
+        }
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        output.pixel(static_cast<size_t>(x), static_cast<size_t>(y))[c] = values[values.size() / 2];
+      }
+    }
+  }
+  return output;
+}
+
+// Brute force Canny edges without blur; hysteresis by repeated sweeps
+static Image<unsigned char, 1> referenceCanny(const Image<unsigned char, 1> &input, double low, double high, bool l1)
+{
+  const size_t width = input.width();
+  const size_t height = input.height();
+  Image<short, 1> gradientX(width, height);
+  Image<short, 1> gradientY(width, height);
+  imgproc::Sobel().apply(input, gradientX, gradientY);
+
+  std::vector<double> magnitude(width * height);
+  for (size_t i = 0; i < width * height; i++)
+  {
+    const double gx = gradientX.imageDataPtr()[i][0];
+    const double gy = gradientY.imageDataPtr()[i][0];
+    magnitude[i] = (l1 ? std::abs(gx) + std::abs(gy) : std::sqrt(gx * gx + gy * gy));
+  }
+  const auto magnitudeAt = [&](long x, long y) {
+    return (x < 0 || y < 0 || x >= static_cast<long>(width) || y >= static_cast<long>(height) ? 0.0 : magnitude[y * width + x]);
+  };
+
+  // Non-maximum suppression; 1 weak, 2 strong
+  const int dx[4] = { 1, 1, 0, 1 };
+  const int dy[4] = { 0, 1, 1, -1 };
+  std::vector<int> label(width * height, 0);
+  for (long y = 0; y < static_cast<long>(height); y++)
+  {
+    for (long x = 0; x < static_cast<long>(width); x++)
+    {
+      const int o = imgproc::Sobel::quantizeOrientation(gradientX.pixel(x, y)[0], gradientY.pixel(x, y)[0]);
+      const double m = magnitudeAt(x, y);
+      if (m > low && m > magnitudeAt(x - dx[o], y - dy[o]) && m >= magnitudeAt(x + dx[o], y + dy[o]))
+      {
+        label[y * width + x] = (m > high ? 2 : 1);
+      }
+    }
+  }
+
+  // Weak pixels next to strong pixels become strong, until none changes
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    for (long y = 0; y < static_cast<long>(height); y++)
+    {
+      for (long x = 0; x < static_cast<long>(width); x++)
+      {
+        if (label[y * width + x] != 1)
+        {
+          continue;
+        }
+        for (long v = std::max(y - 1, 0L); v <= std::min(y + 1, static_cast<long>(height) - 1); v++)
+        {
+          for (long u = std::max(x - 1, 0L); u <= std::min(x + 1, static_cast<long>(width) - 1); u++)
+          {
+            if (label[v * width + u] == 2 && label[y * width + x] == 1)
+            {
+              label[y * width + x] = 2;
+              changed = true;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  Image<unsigned char, 1> output(width, height);
+  for (size_t i = 0; i < width * height; i++)
+  {
+    output.imageDataPtr()[i][0] = (label[i] == 2 ? 255 : 0);
+  }
+  return output;
+}
+
+// Labels by flood fill, numbered in row major order of the first pixel
+static Image<unsigned int, 1> referenceLabels(const Image<unsigned char, 1> &input, bool eight)
+{
+  const long width = static_cast<long>(input.width());
+  const long height = static_cast<long>(input.height());
+  Image<unsigned int, 1> labels(input.width(), input.height());
+  unsigned int count = 0;
+  for (long y = 0; y < height; y++)
+  {
+    for (long x = 0; x < width; x++)
+    {
+      if (input.pixel(x, y)[0] == 0 || labels.pixel(x, y)[0] != 0)
+      {
+        continue;
+      }
+      count++;
+      labels.pixel(x, y)[0] = count;
+      std::vector<std::pair<long, long>> stack(1, std::make_pair(x, y));
+      while (!stack.empty())
+      {
+        const std::pair<long, long> p = stack.back();
+        stack.pop_back();
+        for (long v = p.second - 1; v <= p.second + 1; v++)
+        {
+          for (long u = p.first - 1; u <= p.first + 1; u++)
+          {
+            if (u < 0 || v < 0 || u >= width || v >= height || (!eight && u != p.first && v != p.second))
+            {
+              continue;
+            }
+            if (input.pixel(u, v)[0] != 0 && labels.pixel(u, v)[0] == 0)
+            {
+              labels.pixel(u, v)[0] = count;
+              stack.push_back(std::make_pair(u, v));
+            }
+          }
+        }
+      }
+    }
+  }
+  return labels;
+}
+
+// Test kernel of rows x cols weights; separable or not, with negative
+// weights
+static Matrix testKernel(size_t rows, size_t cols, bool separable)
+{
+  Matrix kernel(rows, cols);
+  for (size_t i = 0; i < rows; i++)
+  {
+    for (size_t j = 0; j < cols; j++)
+    {
+      if (separable)
+      {
+        kernel(i, j) = (1.0 + i % 3) * (2.0 - j % 2) / static_cast<double>(3 * rows * cols);
+      }
+      else
+      {
+        kernel(i, j) = ((i * 7 + j * 13) % 11 - 3.0) / static_cast<double>(2 * rows * cols);
+      }
+    }
+  }
+  return kernel;
+}
+
+// Brute force convolution; not rounded. Skipped pixels are 0.
+template<typename T, int N, typename Border>
+static std::vector<double> referenceConvolve(const Image<T, N> &input, const Matrix &kernel, const Border &border)
+{
+  const int width = static_cast<int>(input.width());
+  const int height = static_cast<int>(input.height());
+  const int rows = static_cast<int>(kernel.rows());
+  const int cols = static_cast<int>(kernel.cols());
+  std::vector<double> output(input.width() * input.height() * N, 0.0);
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      if (!Border::filtersBorder &&
+          (x < (cols - 1) / 2 || x + cols / 2 >= width || y < (rows - 1) / 2 || y + rows / 2 >= height))
+      {
+        continue;
+      }
+      for (int c = 0; c < N; c++)
+      {
+        double sum = 0;
+        for (int i = 0; i < rows; i++)
+        {
+          for (int j = 0; j < cols; j++)
+          {
+            sum += kernel(static_cast<size_t>(i), static_cast<size_t>(j)) * borderSample(input, x + cols / 2 - j, y + rows / 2 - i, c, border);
+          }
+        }
+        output[(y * width + x) * N + c] = sum;
+      }
+    }
+  }
+  return output;
+}
+
+// Saturate reference values to 8 bits
+static std::vector<double> saturate(std::vector<double> values)
+{
+  for (double &value : values)
+  {
+    value = std::min(std::max(value, 0.0), 255.0);
+  }
+  return values;
+}
+
+// Tiles around a pixel coordinate in CLAHE; tiles interpolated between
+// their centers
+static void referenceTiles(size_t i, size_t tiles, size_t size, size_t &before, size_t &after, double &weight)
+{
+  before = 0;
+  after = 0;
+  weight = 0;
+  for (size_t tile = 0; tile < tiles; tile++)
+  {
+    const double center = (tile * size / tiles + (tile + 1) * size / tiles - 1) / 2.0;
+    if (center <= i)
+    {
+      before = tile;
+      after = tile;
+      weight = 0;
+    }
+    else
+    {
+      const double previous = ((tile - 1) * size / tiles + tile * size / tiles - 1) / 2.0;
+      if (tile > 0)
+      {
+        after = tile;
+        weight = (i - previous) / (center - previous);
+      }
+      break;
+    }
+  }
+}
+
+// Brute force CLAHE; not rounded
+template<typename T, int N>
+static std::vector<double> referenceClahe(const Image<T, N> &input, double clipLimit, size_t tilesX, size_t tilesY)
+{
+  const size_t width = input.width();
+  const size_t height = input.height();
+  const size_t bins = static_cast<size_t>(std::numeric_limits<T>::max()) + 1;
+
+  // Lookup table per tile and channel
+  std::vector<std::vector<double>> tables(tilesX * tilesY * N, std::vector<double>(bins, 0.0));
+  for (size_t ty = 0; ty < tilesY; ty++)
+  {
+    for (size_t tx = 0; tx < tilesX; tx++)
+    {
+      for (int c = 0; c < N; c++)
+      {
+        std::vector<size_t> histogram(bins, 0);
+        size_t area = 0;
+        for (size_t y = ty * height / tilesY; y < (ty + 1) * height / tilesY; y++)
+        {
+          for (size_t x = tx * width / tilesX; x < (tx + 1) * width / tilesX; x++)
+          {
+            histogram[input.pixel(x, y)[c]]++;
+            area++;
+          }
+        }
+
+        // Clip; redistribute evenly, the remainder over equally spaced bins
+        if (clipLimit > 0)
+        {
+          const size_t limit = static_cast<size_t>(std::max(1.0, clipLimit * area / bins));
+          size_t clipped = 0;
+          for (size_t &count : histogram)
+          {
+            clipped += (count > limit ? count - limit : 0);
+            count = std::min(count, limit);
+          }
+          for (size_t &count : histogram)
+          {
+            count += clipped / bins;
+          }
+          size_t remainder = clipped % bins;
+          for (size_t bin = 0; remainder > 0; bin += bins / (clipped % bins), remainder--)
+          {
+            histogram[bin]++;
+          }
+        }
+
+        std::vector<double> &table = tables[(ty * tilesX + tx) * N + c];
+        size_t cumulative = 0;
+        for (size_t bin = 0; bin < bins; bin++)
+        {
+          cumulative += histogram[bin];
+          table[bin] = std::floor(static_cast<double>(cumulative) * std::numeric_limits<T>::max() / area + 0.5);
+        }
+      }
+    }
+  }
+
+  // Bilinear interpolation between tables
+  std::vector<double> output(width * height * N);
+  for (size_t y = 0; y < height; y++)
+  {
+    size_t top, bottom;
+    double wy;
+    referenceTiles(y, tilesY, height, top, bottom, wy);
+    for (size_t x = 0; x < width; x++)
+    {
+      size_t left, right;
+      double wx;
+      referenceTiles(x, tilesX, width, left, right, wx);
+      for (int c = 0; c < N; c++)
+      {
+        const size_t value = input.pixel(x, y)[c];
+        const double upper = (1 - wx) * tables[(top * tilesX + left) * N + c][value] + wx * tables[(top * tilesX + right) * N + c][value];
+        const double lower = (1 - wx) * tables[(bottom * tilesX + left) * N + c][value] + wx * tables[(bottom * tilesX + right) * N + c][value];
+        output[(y * width + x) * N + c] = (1 - wy) * upper + wy * lower;
+      }
+    }
+  }
+  return output;
+}
+
+// Largest absolute difference between an image and reference values
+template<typename T, int N>
+static double maxDifference(const Image<T, N> &image, const std::vector<double> &reference)
+{
+  double difference = 0;
+  for (size_t i = 0; i < image.width() * image.height(); i++)
+  {
+    for (int c = 0; c < N; c++)
+    {
+      difference = std::max(difference, std::abs(image.imageDataPtr()[i][c] - reference[i * N + c]));
+    }
+  }
+  return difference;
+}
+
 class ImageFilters_test : public QObject
 {
   Q_OBJECT
@@ -23,10 +599,67 @@ private slots:
   // Constructors
   void test_globalThreshold();
   void test_grayscale();
+  void test_grayscaleFixedPoint();
   void test_blur();
+  void test_blurRadius_data();
+  void test_blurRadius();
+  void test_blur16Bit();
+  void test_border_data();
+  void test_border();
+  void test_gaussianBlur_data();
+  void test_gaussianBlur();
   void test_sobel();
+  void test_pipeline();
+  void test_threadPool();
+  void test_parallelExecutor();
+  void test_histogram();
+  void test_histogramEqualization();
+  void test_clahe();
+  void test_autoThreshold();
+  void test_adaptiveThreshold();
+  void test_integralImage();
+  void test_morphology();
+  void test_median();
+  void test_canny();
+  void test_connectedComponents();
+  void test_distanceTransform();
+  void test_convolve_data();
+  void test_convolve();
+  void test_convolveMethod();
   //void test_prewit();
 
+  // Benchmarks
+  void benchmark_grayscale_data();
+  void benchmark_grayscale();
+  void benchmark_blur_data();
+  void benchmark_blur();
+  void benchmark_gaussianBlur_data();
+  void benchmark_gaussianBlur();
+  void benchmark_sobel_data();
+  void benchmark_sobel();
+  void benchmark_pipeline_data();
+  void benchmark_pipeline();
+  void benchmark_parallelExecutor_data();
+  void benchmark_parallelExecutor();
+  void benchmark_adaptiveThreshold_data();
+  void benchmark_adaptiveThreshold();
+  void benchmark_integralImage_data();
+  void benchmark_integralImage();
+  void benchmark_morphology_data();
+  void benchmark_morphology();
+  void benchmark_median_data();
+  void benchmark_median();
+  void benchmark_canny_data();
+  void benchmark_canny();
+  void benchmark_connectedComponents_data();
+  void benchmark_connectedComponents();
+  void benchmark_distanceTransform_data();
+  void benchmark_distanceTransform();
+  void benchmark_convolve_data();
+  void benchmark_convolve();
+  void benchmark_clahe_data();
+  void benchmark_clahe();
+
 private:
 };
 
@@ -85,6 +718,81 @@ void ImageFilters_test::test_grayscale()
   QVERIFY(ImageIO::writeGrayscaleImageAsPgm(imageGray, (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_gray.pgm").toStdString()));
 }
 
+void ImageFilters_test::test_grayscaleFixedPoint()
+{
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+
+  // Odd width; vectorized blocks and scalar tail. Last pixels white and
+  // black.
+  const size_t width = 45;
+  const size_t height = 20;
+  Image<unsigned char, 3> rgb(width, height);
+  Image<unsigned char, 4> rgba(width, height);
+  Image<unsigned short, 3> rgb16(width, height);
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      std::array<unsigned char, 3> pixel = imageRgb.pixel(x + 200, y + 250);
+      if (x == width - 2)
+      {
+        pixel = { 255, 255, 255 };
+      }
+      else if (x == width - 1)
+      {
+        pixel = { 0, 0, 0 };
+      }
+      rgb.pixel(x, y) = pixel;
+      rgba.pixel(x, y) = { pixel[0], pixel[1], pixel[2], static_cast<unsigned char>(x * 5) };
+      rgb16.pixel(x, y) = { static_cast<unsigned short>(pixel[0] * 257),
+                            static_cast<unsigned short>(pixel[1] * 257),
+                            static_cast<unsigned short>(pixel[2] * 257) };
+    }
+  }
+
+  imgproc::Grayscale<unsigned char> grayscale(0.299, 0.587, 0.114);
+  Image<unsigned char, 1> gray(width, height);
+  Image<unsigned char, 1> grayRgba(width, height);
+  QVERIFY(grayscale.apply(rgb, gray));
+  QVERIFY(grayscale.apply(rgba, grayRgba));
+
+  imgproc::Grayscale<unsigned short> grayscale16(0.299, 0.587, 0.114);
+  Image<unsigned short, 1> gray16(width, height);
+  QVERIFY(grayscale16.apply(rgb16, gray16));
+
+  // Within 1 of the rounded weighted sum; alpha is ignored
+  bool equal = true;
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      const std::array<unsigned char, 3> pixel = rgb.pixel(x, y);
+      const double expected = pixel[0] * 0.299 + pixel[1] * 0.587 + pixel[2] * 0.114;
+      equal = equal &&
+          std::abs(gray.pixel(x, y)[0] - expected) <= 1 &&
+          grayRgba.pixel(x, y)[0] == gray.pixel(x, y)[0] &&
+          std::abs(gray16.pixel(x, y)[0] - expected * 257) <= 1;
+    }
+  }
+  QVERIFY(equal);
+  QCOMPARE(static_cast<int>(gray.pixel(width - 2, 0)[0]), 255);
+  QCOMPARE(static_cast<int>(gray.pixel(width - 1, 0)[0]), 0);
+  QCOMPARE(static_cast<int>(gray16.pixel(width - 2, 0)[0]), 65535);
+
+  // Negative coefficients; floating point, saturated
+  grayscale.setCoefficients(2.0, -0.5, -0.5);
+  QVERIFY(grayscale.apply(rgb, gray));
+  QCOMPARE(static_cast<int>(gray.pixel(width - 2, 0)[0]), 255);
+  const std::array<unsigned char, 3> pixel = rgb.pixel(0, 0);
+  const double expected = std::min(std::max(2.0 * pixel[0] - 0.5 * pixel[1] - 0.5 * pixel[2], 0.0), 255.0);
+  QCOMPARE(static_cast<int>(gray.pixel(0, 0)[0]), static_cast<int>(std::floor(expected + 0.5)));
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width, height + 1);
+  QVERIFY(!grayscale.apply(rgba, wrongSize));
+}
+
 void ImageFilters_test::test_blur()
 {
   // Read input image
@@ -100,11 +808,1921 @@ void ImageFilters_test::test_blur()
   QVERIFY(ImageIO::writeRgbImageAsPpm(imageBlur, (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_blur.ppm").toStdString()));
 }
 
+void ImageFilters_test::test_blurRadius_data()
+{
+  QTest::addColumn<int>("radius");
+  QTest::newRow("0") << 0;
+  QTest::newRow("1") << 1;
+  QTest::newRow("2") << 2;
+  QTest::newRow("7") << 7;
+  QTest::newRow("larger than image") << 40;
+}
+
+void ImageFilters_test::test_blurRadius()
+{
+  QFETCH(int, radius);
+
+  // Read input image; crop to keep the reference fast
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  Image<unsigned char, 3> input(61, 37);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = imageRgb.pixel(x + 200, y + 240);
+    }
+  }
+
+  // Apply blur filter
+  imgproc::Blur blur(static_cast<size_t>(radius));
+  QCOMPARE(blur.radius(), static_cast<size_t>(radius));
+  Image<unsigned char, 3> output(input.width(), input.height());
+  QVERIFY(blur.apply(input, output));
+  QVERIFY(output == referenceBlur(input, radius));
+
+  // Invalid output image
+  Image<unsigned char, 3> wrongSize(input.width() + 1, input.height());
+  QVERIFY(!blur.apply(input, wrongSize));
+  QVERIFY(!blur.apply(input, input));
+}
+
+void ImageFilters_test::test_blur16Bit()
+{
+  Image<unsigned short, 1> input(23, 19);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y)[0] = static_cast<unsigned short>((x * 7919 + y * 104729) % 65536);
+    }
+  }
+
+  // Small radius uses 32-bit sums, large radius 64-bit sums
+  Image<unsigned short, 1> output(input.width(), input.height());
+  imgproc::Blur blur(3);
+  QVERIFY(blur.apply(input, output));
+  QVERIFY(output == referenceBlur(input, 3));
+
+  blur.setRadius(130);
+  QVERIFY(blur.apply(input, output));
+  QVERIFY(output == referenceBlur(input, 130));
+}
+
+void ImageFilters_test::test_border_data()
+{
+  QTest::addColumn<int>("policy");
+  QTest::newRow("clamp") << 0;
+  QTest::newRow("reflect") << 1;
+  QTest::newRow("wrap") << 2;
+  QTest::newRow("constant") << 3;
+  QTest::newRow("skip") << 4;
+}
+
+void ImageFilters_test::test_border()
+{
+  QFETCH(int, policy);
+
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+
+  switch (policy)
+  {
+  case 0:
+    verifyBorder(imageRgb, imgproc::BorderClamp());
+    break;
+  case 1:
+    verifyBorder(imageRgb, imgproc::BorderReflect());
+    break;
+  case 2:
+    verifyBorder(imageRgb, imgproc::BorderWrap());
+    break;
+  case 3:
+    verifyBorder(imageRgb, imgproc::BorderConstant(200));
+    verifyBorder(imageRgb, imgproc::BorderConstant(-1));
+    break;
+  case 4:
+    verifyBorder(imageRgb, imgproc::BorderSkip());
+    break;
+  }
+
+  // Reflected and wrapped coordinates
+  size_t index;
+  QVERIFY(imgproc::BorderReflect().index(-1, 4, index) && index == 1);
+  QVERIFY(imgproc::BorderReflect().index(-4, 4, index) && index == 2);
+  QVERIFY(imgproc::BorderReflect().index(5, 4, index) && index == 1);
+  QVERIFY(imgproc::BorderWrap().index(-1, 4, index) && index == 3);
+  QVERIFY(imgproc::BorderWrap().index(9, 4, index) && index == 1);
+  QVERIFY(!imgproc::BorderConstant().index(4, 4, index));
+
+  // Constant values are rounded and saturated to the sample type
+  QCOMPARE(imgproc::borderValue<unsigned char>(imgproc::BorderConstant(-1)), static_cast<unsigned char>(0));
+  QCOMPARE(imgproc::borderValue<unsigned char>(imgproc::BorderConstant(300)), static_cast<unsigned char>(255));
+  QCOMPARE(imgproc::borderValue<unsigned char>(imgproc::BorderConstant(99.6)), static_cast<unsigned char>(100));
+  QCOMPARE(imgproc::borderValue<short>(imgproc::BorderConstant(-40000)), std::numeric_limits<short>::lowest());
+  QCOMPARE(imgproc::borderValue<unsigned long long>(imgproc::BorderConstant(1e30)), std::numeric_limits<unsigned long long>::max());
+  QCOMPARE(imgproc::borderValue<float>(imgproc::BorderConstant(-1.5)), -1.5f);
+}
+
+void ImageFilters_test::test_gaussianBlur_data()
+{
+  QTest::addColumn<double>("sigma");
+  QTest::addColumn<int>("method");
+  QTest::addColumn<double>("tolerance");
+  QTest::newRow("FIR 0.8") << 0.8 << static_cast<int>(imgproc::GaussianBlur::Method::Fir) << 1.0;
+  QTest::newRow("FIR 2") << 2.0 << static_cast<int>(imgproc::GaussianBlur::Method::Fir) << 1.0;
+  // Recursive filter approximates the Gaussian
+  QTest::newRow("recursive 3") << 3.0 << static_cast<int>(imgproc::GaussianBlur::Method::Recursive) << 5.0;
+  QTest::newRow("recursive 6") << 6.0 << static_cast<int>(imgproc::GaussianBlur::Method::Recursive) << 4.0;
+  QTest::newRow("automatic 4") << 4.0 << static_cast<int>(imgproc::GaussianBlur::Method::Automatic) << 5.0;
+}
+
+void ImageFilters_test::test_gaussianBlur()
+{
+  QFETCH(double, sigma);
+  QFETCH(int, method);
+  QFETCH(double, tolerance);
+
+  // Read input image; crop to keep the reference fast
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  Image<unsigned char, 3> input(45, 31);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = imageRgb.pixel(x + 250, y + 250);
+    }
+  }
+
+  // Apply Gaussian blur filter
+  imgproc::GaussianBlur blur(sigma, static_cast<imgproc::GaussianBlur::Method>(method));
+  Image<unsigned char, 3> output(input.width(), input.height());
+  QVERIFY(blur.apply(input, output));
+  QVERIFY(maxDifference(output, referenceGaussianBlur(input, sigma)) <= tolerance);
+
+  // Apply in input image
+  QVERIFY(blur.apply(input, input));
+  QVERIFY(input == output);
+
+  // Constant image remains constant
+  Image<float, 1> constant(20, 10);
+  for (size_t i = 0; i < constant.width() * constant.height(); i++)
+  {
+    constant.imageDataPtr()[i][0] = 100.0f;
+  }
+  QVERIFY(blur.apply(constant, constant));
+  QVERIFY(maxDifference(constant, std::vector<double>(200, 100.0)) < 0.01);
+
+  // Invalid output image
+  Image<unsigned char, 3> wrongSize(input.width(), input.height() + 1);
+  QVERIFY(!blur.apply(input, wrongSize));
+}
+
 void ImageFilters_test::test_sobel()
 {
   // Read input image
   Image<unsigned char, 1> imageGray;
   QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+
+  // Compute all outputs in one pass
+  const size_t width = imageGray.width();
+  const size_t height = imageGray.height();
+  imgproc::Sobel sobel(imgproc::Sobel::Norm::L1);
+  Image<unsigned char, 1> magnitude(width, height);
+  Image<short, 1> gradientX(width, height);
+  Image<short, 1> gradientY(width, height);
+  Image<unsigned char, 1> orientation(width, height);
+  QVERIFY(sobel.apply(imageGray, &magnitude, &gradientX, &gradientY, &orientation));
+
+  // Verify against the Sobel operators; borders clamped
+  bool equal = true;
+  for (size_t y = 0; y < height && equal; y++)
+  {
+    for (size_t x = 0; x < width && equal; x++)
+    {
+      const size_t left = (x > 0 ? x - 1 : 0);
+      const size_t right = std::min(x + 1, width - 1);
+      const size_t up = (y > 0 ? y - 1 : 0);
+      const size_t down = std::min(y + 1, height - 1);
+      const int gx = imageGray.pixel(right, up)[0] - imageGray.pixel(left, up)[0] +
+                     2 * (imageGray.pixel(right, y)[0] - imageGray.pixel(left, y)[0]) +
+                     imageGray.pixel(right, down)[0] - imageGray.pixel(left, down)[0];
+      const int gy = imageGray.pixel(left, down)[0] + 2 * imageGray.pixel(x, down)[0] + imageGray.pixel(right, down)[0] -
+                     imageGray.pixel(left, up)[0] - 2 * imageGray.pixel(x, up)[0] - imageGray.pixel(right, up)[0];
+      equal = (gradientX.pixel(x, y)[0] == gx &&
+               gradientY.pixel(x, y)[0] == gy &&
+               magnitude.pixel(x, y)[0] == std::min(std::abs(gx) + std::abs(gy), 255) &&
+               orientation.pixel(x, y)[0] == imgproc::Sobel::quantizeOrientation(gx, gy));
+    }
+  }
+  QVERIFY(equal);
+
+  // Magnitude only; L2 norm equals that of a floating point image
+  sobel.setNorm(imgproc::Sobel::Norm::L2);
+  QVERIFY(sobel.apply(imageGray, magnitude));
+  Image<float, 1> imageFloat(width, height);
+  Image<float, 1> magnitudeFloat(width, height);
+  for (size_t i = 0; i < width * height; i++)
+  {
+    imageFloat.imageDataPtr()[i][0] = imageGray.imageDataPtr()[i][0];
+  }
+  QVERIFY(sobel.apply(imageFloat, magnitudeFloat));
+  equal = true;
+  for (size_t i = 0; i < width * height; i++)
+  {
+    const float expected = std::min(std::floor(magnitudeFloat.imageDataPtr()[i][0] + 0.5f), 255.0f);
+    equal = equal && (magnitude.imageDataPtr()[i][0] == static_cast<unsigned char>(expected));
+  }
+  QVERIFY(equal);
+
+  // Orientation of edges
+  QCOMPARE(imgproc::Sobel::quantizeOrientation(0, 0), static_cast<unsigned char>(imgproc::Sobel::Horizontal));
+  QCOMPARE(imgproc::Sobel::quantizeOrientation(-400, 100), static_cast<unsigned char>(imgproc::Sobel::Horizontal));
+  QCOMPARE(imgproc::Sobel::quantizeOrientation(300, 280), static_cast<unsigned char>(imgproc::Sobel::DiagonalDown));
+  QCOMPARE(imgproc::Sobel::quantizeOrientation(50, -400), static_cast<unsigned char>(imgproc::Sobel::Vertical));
+  QCOMPARE(imgproc::Sobel::quantizeOrientation(-300, 280), static_cast<unsigned char>(imgproc::Sobel::DiagonalUp));
+
+  // Bands of rows, including the border rows
+  Image<short, 1> bandsX(width, height);
+  for (size_t y = 0; y < height; y += 100)
+  {
+    QVERIFY(sobel.apply(imageGray, nullptr, &bandsX, nullptr, nullptr, y, std::min<size_t>(y + 100, height)));
+  }
+  QVERIFY(bandsX == gradientX);
+
+  // Invalid output images
+  Image<short, 1> wrongSize(width + 1, height);
+  QVERIFY(!sobel.apply(imageGray, &magnitude, &wrongSize, nullptr, nullptr));
+  QVERIFY(!sobel.apply(imageGray, imageGray));
+}
+
+// Benchmarks
+
+void ImageFilters_test::test_pipeline()
+{
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  const size_t width = imageRgb.width();
+  const size_t height = imageRgb.height();
+
+  // Filters one after another
+  Image<unsigned char, 1> imageGray(width, height);
+  Image<unsigned char, 1> imageBlur(width, height);
+  Image<unsigned char, 1> imageSobel(width, height);
+  Image<unsigned char, 1> imageBinary(width, height);
+  imgproc::Grayscale<unsigned char> grayscale;
+  imgproc::Blur blur(2);
+  imgproc::Sobel sobel;
+  imgproc::GlobalThreshold<unsigned char> threshold(60);
+  QVERIFY(grayscale.apply(imageRgb, imageGray));
+  QVERIFY(blur.apply(imageGray, imageBlur));
+  QVERIFY(sobel.apply(imageBlur, imageSobel));
+  QVERIFY(threshold.apply(imageSobel, imageBinary));
+
+  // Fused pipeline
+  Image<unsigned char, 1> output(width, height);
+  imgproc::Pipeline<imgproc::GrayscaleStage<>, imgproc::BlurStage<>, imgproc::SobelStage<>> edges(
+        imgproc::GrayscaleStage<>(), imgproc::BlurStage<>(2), imgproc::SobelStage<>());
+  QVERIFY(edges.apply(imageRgb, output));
+  QVERIFY(output == imageSobel);
+
+  // Apply again; buffers are reused
+  QVERIFY(edges.apply(imageRgb, output));
+  QVERIFY(output == imageSobel);
+
+  auto binary = imgproc::makePipeline(imgproc::GrayscaleStage<>(),
+                                      imgproc::BlurStage<>(2),
+                                      imgproc::SobelStage<>(),
+                                      imgproc::GlobalThresholdStage<>(60));
+  QVERIFY(binary.apply(imageRgb, output));
+  QVERIFY(output == imageBinary);
+
+  // Blur with radius larger than the image
+  Image<unsigned char, 3> small(5, 3);
+  for (size_t y = 0; y < small.height(); y++)
+  {
+    for (size_t x = 0; x < small.width(); x++)
+    {
+      small.pixel(x, y) = imageRgb.pixel(x + 100, y + 100);
+    }
+  }
+  Image<unsigned char, 3> smallBlur(small.width(), small.height());
+  Image<unsigned char, 3> smallOutput(small.width(), small.height());
+  blur.setRadius(4);
+  QVERIFY(blur.apply(small, smallBlur));
+  auto smallPipeline = imgproc::makePipeline(imgproc::BlurStage<unsigned char, 3>(4));
+  QVERIFY(smallPipeline.apply(small, smallOutput));
+  QVERIFY(smallOutput == smallBlur);
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width + 1, height);
+  QVERIFY(!edges.apply(imageRgb, wrongSize));
+  QVERIFY(!smallPipeline.apply(small, small));
+}
+
+void ImageFilters_test::test_threadPool()
+{
+  ThreadPool pool(3);
+  QCOMPARE(pool.threadCount(), size_t(3));
+
+  // Every task is executed once; unequal task durations are balanced by
+  // stealing
+  std::vector<int> counts(1000, 0);
+  std::vector<size_t> threads(counts.size(), 0);
+  pool.run(counts.size(), [&](size_t index, size_t thread) {
+    counts[index]++;
+    threads[index] = thread;
+    if (index < 10)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+  });
+  for (size_t i = 0; i < counts.size(); i++)
+  {
+    QCOMPARE(counts[i], 1);
+    QVERIFY(threads[i] < pool.threadCount());
+  }
+
+  // Exception of a task is rethrown after all tasks finished
+  std::atomic<int> executed(0);
+  bool thrown = false;
+  try
+  {
+    pool.run(100, [&](size_t index, size_t) {
+      executed++;
+      if (index == 42)
+      {
+        throw std::runtime_error("task failed");
+      }
+    });
+  }
+  catch (const std::runtime_error &)
+  {
+    thrown = true;
+  }
+  QVERIFY(thrown);
+  QCOMPARE(executed.load(), 100);
+
+  // Pool is reusable
+  executed = 0;
+  pool.run(7, [&](size_t, size_t) { executed++; });
+  QCOMPARE(executed.load(), 7);
+  pool.run(0, [&](size_t, size_t) { executed++; });
+  QCOMPARE(executed.load(), 7);
+}
+
+void ImageFilters_test::test_parallelExecutor()
+{
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  const size_t width = imageRgb.width();
+  const size_t height = imageRgb.height();
+
+  // Single threaded
+  Image<unsigned char, 1> imageGray(width, height);
+  Image<unsigned char, 3> imageBlur(width, height);
+  Image<unsigned char, 1> imageSobel(width, height);
+  Image<unsigned char, 1> imageBinary(width, height);
+  imgproc::Grayscale<unsigned char> grayscale;
+  imgproc::Blur blur(3);
+  imgproc::Sobel sobel(imgproc::Sobel::Norm::L1);
+  imgproc::GlobalThreshold<unsigned char> threshold(100);
+  QVERIFY(grayscale.apply(imageRgb, imageGray));
+  QVERIFY(blur.apply(imageRgb, imageBlur));
+  QVERIFY(sobel.apply(imageGray, imageSobel));
+  QVERIFY(threshold.apply(imageRgb, imageBinary));
+
+  // Small bands have halos across several bands
+  ThreadPool pool(4);
+  imgproc::ParallelExecutor executor(pool, 5);
+  for (size_t bandHeight : { size_t(5), size_t(0) })
+  {
+    executor.setBandHeight(bandHeight);
+
+    Image<unsigned char, 1> gray(width, height);
+    QVERIFY(executor.apply(grayscale, imageRgb, gray));
+    QVERIFY(gray == imageGray);
+
+    Image<unsigned char, 3> blurred(width, height);
+    QVERIFY(executor.apply(blur, imageRgb, blurred));
+    QVERIFY(blurred == imageBlur);
+
+    Image<unsigned char, 1> edges(width, height);
+    QVERIFY(executor.apply(sobel, imageGray, edges));
+    QVERIFY(edges == imageSobel);
+
+    Image<unsigned char, 1> binary(width, height);
+    QVERIFY(executor.apply(threshold, imageRgb, binary));
+    QVERIFY(binary == imageBinary);
+  }
+
+  // Pipeline; margins of stages add up
+  Image<unsigned char, 1> imageBlurGray(width, height);
+  QVERIFY(blur.apply(imageGray, imageBlurGray));
+  QVERIFY(sobel.apply(imageBlurGray, imageSobel));
+  auto pipeline = imgproc::makePipeline(imgproc::GrayscaleStage<>(),
+                                        imgproc::BlurStage<>(3),
+                                        imgproc::SobelStage<>(imgproc::Sobel::Norm::L1));
+  QCOMPARE(pipeline.margin(), size_t(4));
+  executor.setBandHeight(3);
+  Image<unsigned char, 1> output(width, height);
+  QVERIFY(executor.apply(pipeline, imageRgb, output));
+  QVERIFY(output == imageSobel);
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width, height + 1);
+  QVERIFY(!executor.apply(sobel, imageGray, wrongSize));
+  QVERIFY(!executor.apply(sobel, imageGray, imageGray));
+}
+
+void ImageFilters_test::test_histogram()
+{
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+
+  // Count by brute force
+  std::vector<size_t> counts(256, 0);
+  for (size_t y = 0; y < imageGray.height(); y++)
+  {
+    for (size_t x = 0; x < imageGray.width(); x++)
+    {
+      counts[imageGray.pixel(x, y)[0]]++;
+    }
+  }
+
+  imgproc::Histogram histogram;
+  QCOMPARE(histogram.binCount(), size_t(0));
+  histogram.compute(imageGray);
+  QCOMPARE(histogram.binCount(), size_t(256));
+  QCOMPARE(histogram.total(), imageGray.width() * imageGray.height());
+  QVERIFY(histogram.counts() == counts);
+
+  // Parallel; more bands than threads
+  ThreadPool pool(3);
+  imgproc::Histogram parallel;
+  parallel.compute(imageGray, pool);
+  QVERIFY(parallel.counts() == counts);
+  QCOMPARE(parallel.total(), histogram.total());
+
+  // 16-bit; one bin per value
+  Image<unsigned short, 1> image16(7, 5);
+  for (size_t y = 0; y < image16.height(); y++)
+  {
+    for (size_t x = 0; x < image16.width(); x++)
+    {
+      image16.pixel(x, y)[0] = static_cast<unsigned short>(x * 10000);
+    }
+  }
+  histogram.compute(image16);
+  QCOMPARE(histogram.binCount(), size_t(65536));
+  QCOMPARE(histogram.count(0), size_t(5));
+  QCOMPARE(histogram.count(60000), size_t(5));
+  QCOMPARE(histogram.count(1), size_t(0));
+  parallel.compute(image16, pool);
+  QVERIFY(parallel.counts() == histogram.counts());
+
+  // Per channel
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  std::vector<std::vector<size_t>> channelCounts(3, std::vector<size_t>(256, 0));
+  for (size_t y = 0; y < imageRgb.height(); y++)
+  {
+    for (size_t x = 0; x < imageRgb.width(); x++)
+    {
+      for (int c = 0; c < 3; c++)
+      {
+        channelCounts[c][imageRgb.pixel(x, y)[c]]++;
+      }
+    }
+  }
+  histogram.compute(imageRgb);
+  parallel.compute(imageRgb, pool);
+  QCOMPARE(histogram.channelCount(), 3);
+  QCOMPARE(histogram.total(), imageRgb.width() * imageRgb.height());
+  for (int c = 0; c < 3; c++)
+  {
+    QVERIFY(histogram.counts(c) == channelCounts[c]);
+    QVERIFY(parallel.counts(c) == channelCounts[c]);
+  }
+}
+
+void ImageFilters_test::test_autoThreshold()
+{
+  typedef imgproc::AutoThreshold<unsigned char> AutoThreshold;
+
+  // Bimodal image; modes 40 .. 60 and 190 .. 210
+  Image<unsigned char, 1> bimodal(42, 10);
+  for (size_t y = 0; y < bimodal.height(); y++)
+  {
+    for (size_t x = 0; x < bimodal.width(); x++)
+    {
+      bimodal.pixel(x, y)[0] = static_cast<unsigned char>(x < 21 ? 40 + x : 169 + x);
+    }
+  }
+
+  // Otsu; every threshold between the modes separates them, the first is
+  // selected
+  AutoThreshold otsu(AutoThreshold::Method::Otsu);
+  Image<unsigned char, 1> output(bimodal.width(), bimodal.height());
+  QVERIFY(otsu.apply(bimodal, output));
+  QCOMPARE(otsu.thresholdValue(), static_cast<unsigned char>(60));
+  for (size_t x = 0; x < bimodal.width(); x++)
+  {
+    QCOMPARE(output.pixel(x, 0)[0], static_cast<unsigned char>(x < 21 ? 0 : 255));
+  }
+
+  // Parallel histogram, in place
+  ThreadPool pool(2);
+  AutoThreshold otsuParallel(AutoThreshold::Method::Otsu, &pool);
+  QVERIFY(otsuParallel.apply(bimodal, bimodal));
+  QCOMPARE(otsuParallel.thresholdValue(), static_cast<unsigned char>(60));
+  QVERIFY(bimodal == output);
+
+  // Skewed image; peak of 100 pixels at 10 and a tail of 172 pixels to the
+  // right. The line from the peak to 21 lies furthest above bin 15.
+  const size_t tail[] = { 60, 40, 30, 20, 10, 5, 3, 2, 1, 1 };
+  std::vector<unsigned char> values(100, 10);
+  for (size_t i = 0; i < 10; i++)
+  {
+    values.insert(values.end(), tail[i], static_cast<unsigned char>(11 + i));
+  }
+  Image<unsigned char, 1> skewed(values.size(), 1);
+  Image<unsigned char, 1> mirrored(values.size(), 1);
+  for (size_t x = 0; x < values.size(); x++)
+  {
+    skewed.pixel(x, 0)[0] = values[x];
+    mirrored.pixel(x, 0)[0] = static_cast<unsigned char>(255 - values[x]);
+  }
+
+  AutoThreshold triangle(AutoThreshold::Method::Triangle);
+  Image<unsigned char, 1> binary(values.size(), 1);
+  QVERIFY(triangle.apply(skewed, binary));
+  QCOMPARE(triangle.thresholdValue(), static_cast<unsigned char>(15));
+  for (size_t x = 0; x < values.size(); x++)
+  {
+    QCOMPARE(binary.pixel(x, 0)[0], static_cast<unsigned char>(values[x] > 15 ? 255 : 0));
+  }
+
+  // Tail to the left
+  QVERIFY(triangle.apply(mirrored, binary));
+  QCOMPARE(triangle.thresholdValue(), static_cast<unsigned char>(240));
+
+  // Uniform image
+  Image<unsigned char, 1> uniform(4, 4);
+  output = Image<unsigned char, 1>(4, 4);
+  QVERIFY(otsu.apply(uniform, output));
+  QCOMPARE(otsu.thresholdValue(), static_cast<unsigned char>(0));
+  QVERIFY(triangle.apply(uniform, output));
+  QCOMPARE(triangle.thresholdValue(), static_cast<unsigned char>(0));
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(3, 4);
+  QVERIFY(!otsu.apply(uniform, wrongSize));
+}
+
+void ImageFilters_test::test_adaptiveThreshold()
+{
+  typedef imgproc::AdaptiveThreshold<unsigned char> AdaptiveThreshold;
+
+  // Pseudo random image
+  const size_t width = 61;
+  const size_t height = 47;
+  Image<unsigned char, 1> input(width, height);
+  unsigned int seed = 7;
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      seed = seed * 1103515245 + 12345;
+      input.pixel(x, y)[0] = static_cast<unsigned char>((seed >> 16) & 0xff);
+    }
+  }
+
+  // Mean of window clipped at the border, by brute force. Offsets are
+  // multiples of 0.5: value + offset > sum / area in integers.
+  for (size_t radius : { size_t(0), size_t(1), size_t(5), size_t(40) })
+  {
+    for (int offsetTimes2 : { 5, 0, -6 })
+    {
+      AdaptiveThreshold filter(radius, offsetTimes2 / 2.0);
+      Image<unsigned char, 1> output(width, height);
+      QVERIFY(filter.apply(input, output));
+
+      for (size_t y = 0; y < height; y++)
+      {
+        for (size_t x = 0; x < width; x++)
+        {
+          long sum = 0;
+          long area = 0;
+          for (size_t v = (y > radius ? y - radius : 0); v <= std::min(y + radius, height - 1); v++)
+          {
+            for (size_t u = (x > radius ? x - radius : 0); u <= std::min(x + radius, width - 1); u++)
+            {
+              sum += input.pixel(u, v)[0];
+              area++;
+            }
+          }
+          const bool white = ((2 * input.pixel(x, y)[0] + offsetTimes2) * area > 2 * sum);
+          QCOMPARE(output.pixel(x, y)[0], static_cast<unsigned char>(white ? 255 : 0));
+        }
+      }
+
+      // In place
+      Image<unsigned char, 1> inout = input;
+      QVERIFY(filter.apply(inout, inout));
+      QVERIFY(inout == output);
+    }
+  }
+
+  // Gaussian; mean by Gaussian blur with the sigma of a 11 sample kernel
+  AdaptiveThreshold gaussian(5, 3, AdaptiveThreshold::Method::Gaussian);
+  QCOMPARE(gaussian.method(), AdaptiveThreshold::Method::Gaussian);
+  Image<unsigned char, 1> mean(width, height);
+  QVERIFY(imgproc::GaussianBlur(2.0).apply(input, mean));
+  Image<unsigned char, 1> output(width, height);
+  QVERIFY(gaussian.apply(input, output));
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      const bool white = (input.pixel(x, y)[0] + 3 > mean.pixel(x, y)[0]);
+      QCOMPARE(output.pixel(x, y)[0], static_cast<unsigned char>(white ? 255 : 0));
+    }
+  }
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width + 1, height);
+  QVERIFY(!gaussian.apply(input, wrongSize));
+}
+
+void ImageFilters_test::test_integralImage()
+{
+  // Pseudo random RGB image; width not a multiple of a vector
+  const size_t width = 37;
+  const size_t height = 23;
+  Image<unsigned char, 3> imageRgb(width, height);
+  Image<float, 1> imageFloat(width, height);
+  unsigned int seed = 3;
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      for (size_t c = 0; c < 3; c++)
+      {
+        seed = seed * 1103515245 + 12345;
+        imageRgb.pixel(x, y)[c] = static_cast<unsigned char>((seed >> 16) & 0xff);
+      }
+      imageFloat.pixel(x, y)[0] = imageRgb.pixel(x, y)[0] / 4.0f - 20;
+    }
+  }
+
+  ThreadPool pool(3);
+  imgproc::IntegralImage<unsigned char> integral;
+  QVERIFY(!integral.hasSquares());
+  for (int parallel = 0; parallel < 2; parallel++)
+  {
+    if (parallel)
+    {
+      integral.compute(imageRgb, pool, true);
+    }
+    else
+    {
+      integral.compute(imageRgb, true);
+    }
+    QCOMPARE(integral.width(), width);
+    QCOMPARE(integral.height(), height);
+    QCOMPARE(integral.channels(), size_t(3));
+    QVERIFY(integral.hasSquares());
+
+    // Rectangles by brute force, including empty ones and the whole image
+    for (size_t top = 0; top <= height; top += 4)
+    {
+      for (size_t bottom = top; bottom <= height; bottom += 3)
+      {
+        for (size_t left = 0; left <= width; left += 5)
+        {
+          for (size_t right = left; right <= width; right += 6)
+          {
+            for (size_t c = 0; c < 3; c++)
+            {
+              uint64_t sum = 0;
+              uint64_t squareSum = 0;
+              for (size_t y = top; y < bottom; y++)
+              {
+                for (size_t x = left; x < right; x++)
+                {
+                  const uint64_t value = imageRgb.pixel(x, y)[c];
+                  sum += value;
+                  squareSum += value * value;
+                }
+              }
+              QCOMPARE(integral.sum(left, top, right, bottom, c), sum);
+              QCOMPARE(integral.squareSum(left, top, right, bottom, c), squareSum);
+            }
+          }
+        }
+      }
+    }
+    QCOMPARE(integral.integral(width, height, 1), integral.sum(0, 0, width, height, 1));
+  }
+
+  // Mean and variance
+  const double mean = integral.mean(3, 4, 5, 6, 2);
+  double variance = 0;
+  for (size_t y = 4; y < 6; y++)
+  {
+    for (size_t x = 3; x < 5; x++)
+    {
+      const double difference = imageRgb.pixel(x, y)[2] - mean;
+      variance += difference * difference / 4;
+    }
+  }
+  QCOMPARE(mean, static_cast<double>(integral.sum(3, 4, 5, 6, 2)) / 4);
+  QVERIFY(std::abs(integral.variance(3, 4, 5, 6, 2) - variance) < 1e-9);
+
+  // Floating point; sums in double
+  imgproc::IntegralImage<float> integralFloat;
+  integralFloat.compute(imageFloat);
+  QVERIFY(!integralFloat.hasSquares());
+  double sum = 0;
+  for (size_t y = 2; y < 20; y++)
+  {
+    for (size_t x = 1; x < 30; x++)
+    {
+      sum += imageFloat.pixel(x, y)[0];
+    }
+  }
+  QVERIFY(std::abs(integralFloat.sum(1, 2, 30, 20) - sum) < 1e-9);
+
+  // 16-bit sums exceed 32 bits
+  Image<unsigned short, 1> image16(300, 300);
+  for (size_t y = 0; y < image16.height(); y++)
+  {
+    for (size_t x = 0; x < image16.width(); x++)
+    {
+      image16.pixel(x, y)[0] = 65535;
+    }
+  }
+  imgproc::IntegralImage<unsigned short> integral16;
+  integral16.compute(image16, pool);
+  QCOMPARE(integral16.sum(0, 0, 300, 300), uint64_t(65535) * 300 * 300);
+}
+
+void ImageFilters_test::test_morphology()
+{
+  typedef imgproc::Morphology::Operation Operation;
+
+  // Pseudo random images; a binary mask wider than a word, 8-bit RGB and
+  // floating point
+  const size_t width = 150;
+  const size_t height = 31;
+  Image<unsigned char, 1> mask(width, height);
+  Image<unsigned char, 3> imageRgb(width, height);
+  Image<float, 1> imageFloat(width, height);
+  unsigned int seed = 11;
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      seed = seed * 1103515245 + 12345;
+      mask.pixel(x, y)[0] = ((seed >> 16) % 3 == 0 ? 255 : 0);
+      imageRgb.pixel(x, y) = { static_cast<unsigned char>(seed >> 8), static_cast<unsigned char>(seed >> 16), static_cast<unsigned char>(seed >> 24) };
+      imageFloat.pixel(x, y)[0] = static_cast<float>(seed % 1000) - 500.5f;
+    }
+  }
+
+  // Erode and dilate; elements wider than a word and higher than the image
+  const size_t radii[][2] = { { 0, 0 }, { 1, 1 }, { 3, 0 }, { 0, 2 }, { 2, 5 }, { 70, 1 }, { 1, 40 } };
+  for (const size_t *radius : radii)
+  {
+    for (bool dilate : { false, true })
+    {
+      imgproc::Morphology filter(dilate ? Operation::Dilate : Operation::Erode, radius[0], radius[1]);
+
+      Image<unsigned char, 1> maskOutput(width, height);
+      QVERIFY(filter.apply(mask, maskOutput));
+      QVERIFY(maskOutput == referenceMorphology(mask, radius[0], radius[1], dilate));
+
+      Image<unsigned char, 3> rgbOutput(width, height);
+      QVERIFY(filter.apply(imageRgb, rgbOutput));
+      QVERIFY(rgbOutput == referenceMorphology(imageRgb, radius[0], radius[1], dilate));
+
+      Image<float, 1> floatOutput(width, height);
+      QVERIFY(filter.apply(imageFloat, floatOutput));
+      QVERIFY(floatOutput == referenceMorphology(imageFloat, radius[0], radius[1], dilate));
+    }
+  }
+
+  // Open and close, in place; 8-bit gray (not binary) and binary
+  Image<unsigned char, 1> imageGray(width, height);
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      imageGray.pixel(x, y)[0] = imageRgb.pixel(x, y)[1];
+    }
+  }
+  for (const Image<unsigned char, 1> *input : { &imageGray, &mask })
+  {
+    const Image<unsigned char, 1> eroded = referenceMorphology(*input, 2, 3, false);
+    const Image<unsigned char, 1> dilated = referenceMorphology(*input, 2, 3, true);
+
+    imgproc::Morphology open(Operation::Open, 2, 3);
+    Image<unsigned char, 1> output = *input;
+    QVERIFY(open.apply(output, output));
+    QVERIFY(output == referenceMorphology(eroded, 2, 3, true));
+
+    imgproc::Morphology close(Operation::Close, 2, 3);
+    output = *input;
+    QVERIFY(close.apply(output, output));
+    QVERIFY(output == referenceMorphology(dilated, 2, 3, false));
+  }
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width, height + 1);
+  QVERIFY(!imgproc::Morphology().apply(mask, wrongSize));
+}
+
+void ImageFilters_test::test_median()
+{
+  // Pseudo random images; 8-bit gray with few distinct values and RGB
+  const size_t width = 41;
+  const size_t height = 23;
+  Image<unsigned char, 1> imageGray(width, height);
+  Image<unsigned char, 3> imageRgb(width, height);
+  unsigned int seed = 5;
+  for (size_t y = 0; y < height; y++)
+  {
+    for (size_t x = 0; x < width; x++)
+    {
+      seed = seed * 1103515245 + 12345;
+      imageGray.pixel(x, y)[0] = static_cast<unsigned char>((seed >> 16) % 7 * 37);
+      imageRgb.pixel(x, y) = { static_cast<unsigned char>(seed >> 8), static_cast<unsigned char>(seed >> 16), static_cast<unsigned char>(seed >> 24) };
+    }
+  }
+
+  // Networks (radius 1, 2) and histograms; windows higher than the image
+  ThreadPool pool(3);
+  for (size_t radius : { 0, 1, 2, 3, 9, 15 })
+  {
+    imgproc::Median filter(radius);
+    const Image<unsigned char, 1> expectedGray = referenceMedian(imageGray, radius);
+    const Image<unsigned char, 3> expectedRgb = referenceMedian(imageRgb, radius);
+
+    Image<unsigned char, 1> outputGray(width, height);
+    QVERIFY(filter.apply(imageGray, outputGray));
+    QVERIFY(outputGray == expectedGray);
+
+    Image<unsigned char, 3> outputRgb(width, height);
+    QVERIFY(filter.apply(imageRgb, outputRgb));
+    QVERIFY(outputRgb == expectedRgb);
+
+    // In place
+    outputGray = imageGray;
+    QVERIFY(filter.apply(outputGray, outputGray));
+    QVERIFY(outputGray == expectedGray);
+
+    // Bands in parallel
+    Image<unsigned char, 1> parallelGray(width, height);
+    QVERIFY(filter.apply(imageGray, parallelGray, pool));
+    QVERIFY(parallelGray == expectedGray);
+
+    Image<unsigned char, 3> parallelRgb(width, height);
+    QVERIFY(filter.apply(imageRgb, parallelRgb, pool));
+    QVERIFY(parallelRgb == expectedRgb);
+  }
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width, height + 1);
+  QVERIFY(!imgproc::Median().apply(imageGray, wrongSize));
+  QVERIFY(!imgproc::Median().apply(imageGray, wrongSize, pool));
+  QVERIFY(!imgproc::Median().apply(imageGray, imageGray, pool));
+}
+
+void ImageFilters_test::test_canny()
+{
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+  const size_t width = imageGray.width();
+  const size_t height = imageGray.height();
+
+  // Without blur; both norms
+  ThreadPool pool(3);
+  for (bool l1 : { false, true })
+  {
+    imgproc::Canny canny(40, 100, 0, l1 ? imgproc::Sobel::Norm::L1 : imgproc::Sobel::Norm::L2);
+    const Image<unsigned char, 1> expected = referenceCanny(imageGray, 40, 100, l1);
+
+    Image<unsigned char, 1> output(width, height);
+    QVERIFY(canny.apply(imageGray, output));
+    QVERIFY(output == expected);
+
+    // Bands in parallel; edges cross band borders
+    Image<unsigned char, 1> parallelOutput(width, height);
+    QVERIFY(canny.apply(imageGray, parallelOutput, pool));
+    QVERIFY(parallelOutput == expected);
+  }
+
+  // With blur, in place; equals the edges of the blurred image
+  Image<unsigned char, 1> blurred(width, height);
+  QVERIFY(imgproc::GaussianBlur(1.4).apply(imageGray, blurred));
+  imgproc::Canny canny(20, 50, 1.4);
+  Image<unsigned char, 1> output = imageGray;
+  QVERIFY(canny.apply(output, output, pool));
+  QVERIFY(output == referenceCanny(blurred, 20, 50, false));
+
+  // Another image size; buffers are reallocated
+  Image<unsigned char, 1> imageSmall(37, 23);
+  unsigned int seed = 3;
+  for (size_t i = 0; i < 37 * 23; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    imageSmall.imageDataPtr()[i][0] = static_cast<unsigned char>(seed >> 16);
+  }
+  canny.setSigma(0);
+  canny.setThresholds(200, 400);
+  Image<unsigned char, 1> outputSmall(37, 23);
+  QVERIFY(canny.apply(imageSmall, outputSmall));
+  QVERIFY(outputSmall == referenceCanny(imageSmall, 200, 400, false));
+
+  // Invalid output
+  Image<unsigned char, 1> wrongSize(width, height + 1);
+  QVERIFY(!canny.apply(imageGray, wrongSize));
+}
+
+void ImageFilters_test::test_connectedComponents()
+{
+  typedef imgproc::ConnectedComponents::Connectivity Connectivity;
+
+  // A U shape that merges in the last row, diagonal pairs and a pixel
+  const char *rows[] = { "X.X....X",
+                         "X.X...X.",
+                         "XXX.....",
+                         "....X..X",
+                         ".....X.." };
+  Image<unsigned char, 1> mask(8, 5);
+  for (size_t y = 0; y < 5; y++)
+  {
+    for (size_t x = 0; x < 8; x++)
+    {
+      mask.pixel(x, y)[0] = (rows[y][x] == 'X' ? 255 : 0);
+    }
+  }
+
+  imgproc::ConnectedComponents labeling;
+  Image<unsigned int, 1> labels(8, 5);
+  QVERIFY(labeling.apply(mask, labels));
+  QCOMPARE(labeling.componentCount(), size_t(4));
+  QCOMPARE(labels.pixel(2, 0)[0], 1u);
+  QCOMPARE(labels.pixel(6, 1)[0], 2u);
+  QCOMPARE(labels.pixel(5, 4)[0], 3u);
+  QCOMPARE(labels.pixel(7, 3)[0], 4u);
+  QCOMPARE(labels.pixel(3, 0)[0], 0u);
+
+  const imgproc::ConnectedComponents::Component &shape = labeling.components()[0];
+  QCOMPARE(shape.area, size_t(7));
+  QCOMPARE(shape.left, size_t(0));
+  QCOMPARE(shape.top, size_t(0));
+  QCOMPARE(shape.right, size_t(2));
+  QCOMPARE(shape.bottom, size_t(2));
+  QCOMPARE(shape.centroidX(), 1.0);
+  QCOMPARE(shape.centroidY(), 8.0 / 7.0);
+
+  labeling.setConnectivity(Connectivity::Four);
+  QVERIFY(labeling.apply(mask, labels));
+  QCOMPARE(labeling.componentCount(), size_t(6));
+  QCOMPARE(labels.pixel(6, 1)[0], 3u);
+
+  // Pseudo random masks; bands in parallel give the same labels and
+  // statistics
+  const size_t width = 131;
+  const size_t height = 100;
+  Image<unsigned char, 1> randomMask(width, height);
+  unsigned int seed = 17;
+  ThreadPool pool(3);
+  for (unsigned int density : { 30, 45, 60 })
+  {
+    for (size_t i = 0; i < width * height; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      randomMask.imageDataPtr()[i][0] = ((seed >> 16) % 100 < density ? 255 : 0);
+    }
+    for (Connectivity connectivity : { Connectivity::Four, Connectivity::Eight })
+    {
+      labeling.setConnectivity(connectivity);
+      const Image<unsigned int, 1> expected = referenceLabels(randomMask, connectivity == Connectivity::Eight);
+
+      Image<unsigned int, 1> output(width, height);
+      QVERIFY(labeling.apply(randomMask, output));
+      QVERIFY(output == expected);
+      const std::vector<imgproc::ConnectedComponents::Component> components = labeling.components();
+
+      Image<unsigned int, 1> parallelOutput(width, height);
+      QVERIFY(labeling.apply(randomMask, parallelOutput, pool));
+      QVERIFY(parallelOutput == expected);
+      QCOMPARE(labeling.componentCount(), components.size());
+
+      // Statistics of the labels
+      std::vector<size_t> areas(components.size(), 0);
+      std::vector<size_t> bottoms(components.size(), 0);
+      bool equal = true;
+      for (size_t y = 0; y < height; y++)
+      {
+        for (size_t x = 0; x < width; x++)
+        {
+          const unsigned int label = expected.pixel(x, y)[0];
+          if (label != 0)
+          {
+            areas[label - 1]++;
+            bottoms[label - 1] = y;
+          }
+        }
+      }
+      for (size_t i = 0; i < components.size(); i++)
+      {
+        const imgproc::ConnectedComponents::Component &component = labeling.components()[i];
+        equal = equal && (component.area == areas[i] && components[i].area == areas[i] &&
+                          component.bottom == bottoms[i] && components[i].sumX == component.sumX);
+      }
+      QVERIFY(equal);
+    }
+  }
+
+  // Invalid output
+  Image<unsigned int, 1> wrongSize(8, 6);
+  QVERIFY(!labeling.apply(mask, wrongSize));
+}
+
+void ImageFilters_test::test_distanceTransform()
+{
+  // Pseudo random masks of sparse to dense features
+  const size_t width = 67;
+  const size_t height = 45;
+  Image<unsigned char, 1> mask(width, height);
+  unsigned int seed = 23;
+  ThreadPool pool(3);
+  imgproc::DistanceTransform transform;
+  for (unsigned int density : { 2, 20, 300 })
+  {
+    for (size_t i = 0; i < width * height; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      mask.imageDataPtr()[i][0] = ((seed >> 16) % 1000 < density ? 255 : 0);
+    }
+
+    Image<float, 1> distance(width, height);
+    Image<unsigned int, 1> nearest(width, height);
+    QVERIFY(transform.apply(mask, &distance, &nearest));
+    Image<float, 1> parallelDistance(width, height);
+    QVERIFY(transform.apply(mask, parallelDistance, pool));
+    QVERIFY(parallelDistance == distance);
+
+    // Brute force; the nearest feature pixel is at the distance
+    bool equal = true;
+    for (size_t y = 0; y < height; y++)
+    {
+      for (size_t x = 0; x < width; x++)
+      {
+        double minimum = std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < width * height; i++)
+        {
+          if (mask.imageDataPtr()[i][0] != 0)
+          {
+            const double dx = static_cast<double>(i % width) - static_cast<double>(x);
+            const double dy = static_cast<double>(i / width) - static_cast<double>(y);
+            minimum = std::min(minimum, dx * dx + dy * dy);
+          }
+        }
+        const size_t index = nearest.pixel(x, y)[0];
+        const double dx = static_cast<double>(index % width) - static_cast<double>(x);
+        const double dy = static_cast<double>(index / width) - static_cast<double>(y);
+        equal = equal && (distance.pixel(x, y)[0] == static_cast<float>(std::sqrt(minimum)) &&
+                          mask.imageDataPtr()[index][0] != 0 && dx * dx + dy * dy == minimum);
+      }
+    }
+    QVERIFY(equal);
+  }
+
+  // No features
+  Image<unsigned char, 1> empty(5, 3);
+  Image<float, 1> distance(5, 3);
+  Image<unsigned int, 1> nearest(5, 3);
+  QVERIFY(transform.apply(empty, &distance, &nearest));
+  QCOMPARE(distance.pixel(4, 2)[0], std::numeric_limits<float>::infinity());
+  QCOMPARE(nearest.pixel(4, 2)[0], std::numeric_limits<unsigned int>::max());
+
+  // Invalid output
+  Image<unsigned int, 1> wrongSize(5, 4);
+  QVERIFY(!transform.apply(empty, &distance, &wrongSize));
+}
+
+void ImageFilters_test::test_histogramEqualization()
+{
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+
+  // Dim image
+  Image<unsigned char, 3> input(imageRgb.width(), imageRgb.height());
+  for (size_t i = 0; i < input.width() * input.height(); i++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      input.imageDataPtr()[i][c] = static_cast<unsigned char>(20 + imageRgb.imageDataPtr()[i][c] / 5);
+    }
+  }
+
+  // Brute force lookup tables from the cumulative histograms
+  std::vector<double> reference(input.width() * input.height() * 3);
+  for (int c = 0; c < 3; c++)
+  {
+    std::vector<double> cumulative(256, 0.0);
+    for (size_t i = 0; i < input.width() * input.height(); i++)
+    {
+      for (int value = input.imageDataPtr()[i][c]; value < 256; value++)
+      {
+        cumulative[value]++;
+      }
+    }
+    double minimum = 0;
+    for (int value = 0; minimum == 0; value++)
+    {
+      minimum = cumulative[value];
+    }
+    const double total = static_cast<double>(input.width() * input.height());
+    for (size_t i = 0; i < input.width() * input.height(); i++)
+    {
+      reference[i * 3 + c] = std::floor((cumulative[input.imageDataPtr()[i][c]] - minimum) / (total - minimum) * 255 + 0.5);
+    }
+  }
+
+  imgproc::HistogramEqualization equalization;
+  Image<unsigned char, 3> output(input.width(), input.height());
+  QVERIFY(equalization.apply(input, output));
+  QCOMPARE(maxDifference(output, reference), 0.0);
+
+  // Parallel, in place
+  ThreadPool pool(3);
+  QVERIFY(equalization.apply(input, input, pool));
+  QVERIFY(input == output);
+
+  // 16-bit; full range
+  Image<unsigned short, 1> image16(7, 5);
+  for (size_t y = 0; y < image16.height(); y++)
+  {
+    for (size_t x = 0; x < image16.width(); x++)
+    {
+      image16.pixel(x, y)[0] = static_cast<unsigned short>(1000 + x * 10);
+    }
+  }
+  QVERIFY(equalization.apply(image16, image16));
+  QCOMPARE(image16.pixel(0, 0)[0], static_cast<unsigned short>(0));
+  QCOMPARE(image16.pixel(3, 4)[0], static_cast<unsigned short>(32768));
+  QCOMPARE(image16.pixel(6, 2)[0], static_cast<unsigned short>(65535));
+
+  // Constant image is unchanged
+  Image<unsigned char, 1> constant(5, 4);
+  for (size_t i = 0; i < 20; i++)
+  {
+    constant.imageDataPtr()[i][0] = 77;
+  }
+  Image<unsigned char, 1> constantOutput(5, 4);
+  QVERIFY(equalization.apply(constant, constantOutput));
+  QVERIFY(constantOutput == constant);
+
+  // Invalid output image
+  Image<unsigned char, 3> wrongSize(input.width(), input.height() + 1);
+  QVERIFY(!equalization.apply(input, wrongSize));
+}
+
+void ImageFilters_test::test_clahe()
+{
+  // Read input image; crop to keep the reference fast
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  Image<unsigned char, 3> input(83, 61);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = imageRgb.pixel(x + 200, y + 220);
+    }
+  }
+
+  // Clip limits; no clipping; tiles of unequal size
+  imgproc::Clahe clahe;
+  ThreadPool pool(3);
+  for (double clipLimit : { 2.0, 40.0, 0.0 })
+  {
+    for (size_t tiles : { size_t(1), size_t(4), size_t(7) })
+    {
+      clahe.setClipLimit(clipLimit);
+      clahe.setTiles(tiles, tiles + 1);
+      Image<unsigned char, 3> output(input.width(), input.height());
+      QVERIFY(clahe.apply(input, output));
+      QVERIFY(maxDifference(output, referenceClahe(input, clipLimit, tiles, tiles + 1)) <= 0.51);
+
+      // Parallel, in place
+      Image<unsigned char, 3> parallel = input;
+      QVERIFY(clahe.apply(parallel, parallel, pool));
+      QVERIFY(parallel == output);
+    }
+  }
+
+  // 16-bit; more tiles than pixels
+  Image<unsigned short, 1> image16(5, 3);
+  for (size_t y = 0; y < image16.height(); y++)
+  {
+    for (size_t x = 0; x < image16.width(); x++)
+    {
+      image16.pixel(x, y)[0] = static_cast<unsigned short>(x * 3000 + y * 100);
+    }
+  }
+  clahe.setTiles(8, 8);
+  Image<unsigned short, 1> output16(image16.width(), image16.height());
+  QVERIFY(clahe.apply(image16, output16));
+  QVERIFY(maxDifference(output16, referenceClahe(image16, 2.0, 5, 3)) <= 0.51);
+
+  // Invalid output image
+  Image<unsigned char, 3> wrongSize(input.width(), input.height() + 1);
+  QVERIFY(!clahe.apply(input, wrongSize));
+}
+
+void ImageFilters_test::test_convolve_data()
+{
+  QTest::addColumn<int>("rows");
+  QTest::addColumn<int>("cols");
+  QTest::addColumn<bool>("separable");
+  QTest::addColumn<int>("method");
+  QTest::newRow("direct 3x3") << 3 << 3 << false << static_cast<int>(imgproc::Convolve::Method::Direct);
+  QTest::newRow("direct 4x7") << 4 << 7 << false << static_cast<int>(imgproc::Convolve::Method::Direct);
+  QTest::newRow("separable 9x5") << 9 << 5 << true << static_cast<int>(imgproc::Convolve::Method::Separable);
+  QTest::newRow("FFT 15x15") << 15 << 15 << false << static_cast<int>(imgproc::Convolve::Method::Fft);
+  QTest::newRow("FFT 24x9") << 24 << 9 << false << static_cast<int>(imgproc::Convolve::Method::Fft);
+  QTest::newRow("FFT separable 21x21") << 21 << 21 << true << static_cast<int>(imgproc::Convolve::Method::Fft);
+  QTest::newRow("automatic 31x31") << 31 << 31 << false << static_cast<int>(imgproc::Convolve::Method::Automatic);
+}
+
+void ImageFilters_test::test_convolve()
+{
+  QFETCH(int, rows);
+  QFETCH(int, cols);
+  QFETCH(bool, separable);
+  QFETCH(int, method);
+
+  // Read input image; crop to keep the reference fast
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  Image<unsigned char, 3> input(45, 31);
+  Image<float, 3> inputFloat(input.width(), input.height());
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = imageRgb.pixel(x + 250, y + 250);
+      for (int c = 0; c < 3; c++)
+      {
+        inputFloat.pixel(x, y)[c] = input.pixel(x, y)[c];
+      }
+    }
+  }
+
+  const Matrix kernel = testKernel(static_cast<size_t>(rows), static_cast<size_t>(cols), separable);
+  imgproc::Convolve convolve(kernel, static_cast<imgproc::Convolve::Method>(method));
+  QCOMPARE(convolve.isSeparable(), separable);
+
+  // Results are rounded and saturated
+  const std::vector<double> reference = referenceConvolve(input, kernel, imgproc::BorderClamp());
+  Image<unsigned char, 3> output(input.width(), input.height());
+  QVERIFY(convolve.apply(input, output));
+  QVERIFY(maxDifference(output, saturate(reference)) <= 0.51);
+  Image<float, 3> outputFloat(input.width(), input.height());
+  QVERIFY(convolve.apply(inputFloat, outputFloat));
+  QVERIFY(maxDifference(outputFloat, reference) < 1e-3);
+
+  // Border policies
+  Image<unsigned char, 3> outputBorder(input.width(), input.height());
+  QVERIFY(convolve.apply(input, outputBorder, imgproc::BorderConstant(50)));
+  QVERIFY(maxDifference(outputBorder, saturate(referenceConvolve(input, kernel, imgproc::BorderConstant(50)))) <= 0.51);
+  outputBorder = Image<unsigned char, 3>(input.width(), input.height());
+  QVERIFY(convolve.apply(input, outputBorder, imgproc::BorderSkip()));
+  QVERIFY(maxDifference(outputBorder, saturate(referenceConvolve(input, kernel, imgproc::BorderSkip()))) <= 0.51);
+
+  // Parallel
+  ThreadPool pool(3);
+  Image<unsigned char, 3> outputParallel(input.width(), input.height());
+  QVERIFY(convolve.apply(input, outputParallel, pool));
+  QVERIFY(outputParallel == output);
+
+  // Invalid output image
+  Image<unsigned char, 3> wrongSize(input.width(), input.height() + 1);
+  QVERIFY(!convolve.apply(input, wrongSize));
+  QVERIFY(!convolve.apply(input, input));
+}
+
+void ImageFilters_test::test_convolveMethod()
+{
+  // Small kernels are convolved directly, or separably if possible
+  imgproc::Convolve convolve(testKernel(3, 3, false));
+  QVERIFY(convolve.methodFor(512, 512, 1) == imgproc::Convolve::Method::Direct);
+  convolve.setKernel(testKernel(3, 3, true));
+  QVERIFY(convolve.methodFor(512, 512, 1) == imgproc::Convolve::Method::Separable);
+
+  // Large kernels in the frequency domain
+  convolve.setKernel(testKernel(51, 51, false));
+  QVERIFY(convolve.methodFor(512, 512, 1) == imgproc::Convolve::Method::Fft);
+
+  // Separable falls back to direct
+  convolve.setMethod(imgproc::Convolve::Method::Separable);
+  QVERIFY(convolve.methodFor(512, 512, 1) == imgproc::Convolve::Method::Direct);
+
+  // Identity kernel by default
+  Image<unsigned char, 1> input(7, 5);
+  for (size_t i = 0; i < 35; i++)
+  {
+    input.imageDataPtr()[i][0] = static_cast<unsigned char>(i * 7);
+  }
+  Image<unsigned char, 1> output(7, 5);
+  QVERIFY(imgproc::Convolve().apply(input, output));
+  QVERIFY(output == input);
+
+  // Empty kernel
+  convolve.setKernel(Matrix(0, 0));
+  QVERIFY(!convolve.apply(input, output));
+}
+
+void ImageFilters_test::benchmark_grayscale_data()
+{
+  QTest::addColumn<int>("format");
+  QTest::newRow("8-bit RGB") << 0;
+  QTest::newRow("8-bit RGBA") << 1;
+  QTest::newRow("16-bit RGB") << 2;
+  QTest::newRow("floating point RGB") << 3;
+}
+
+void ImageFilters_test::benchmark_grayscale()
+{
+  QFETCH(int, format);
+
+  // 4K frame
+  const size_t width = 3840;
+  const size_t height = 2160;
+  if (format == 0)
+  {
+    Image<unsigned char, 3> input(width, height);
+    Image<unsigned char, 1> output(width, height);
+    imgproc::Grayscale<unsigned char> grayscale;
+    QBENCHMARK
+    {
+      grayscale.apply(input, output);
+    }
+  }
+  else if (format == 1)
+  {
+    Image<unsigned char, 4> input(width, height);
+    Image<unsigned char, 1> output(width, height);
+    imgproc::Grayscale<unsigned char> grayscale;
+    QBENCHMARK
+    {
+      grayscale.apply(input, output);
+    }
+  }
+  else if (format == 2)
+  {
+    Image<unsigned short, 3> input(width, height);
+    Image<unsigned short, 1> output(width, height);
+    imgproc::Grayscale<unsigned short> grayscale;
+    QBENCHMARK
+    {
+      grayscale.apply(input, output);
+    }
+  }
+  else
+  {
+    Image<float, 3> input(width, height);
+    Image<float, 1> output(width, height);
+    imgproc::Grayscale<float> grayscale;
+    QBENCHMARK
+    {
+      grayscale.apply(input, output);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_blur_data()
+{
+  QTest::addColumn<int>("radius");
+  QTest::newRow("1") << 1;
+  QTest::newRow("5") << 5;
+  QTest::newRow("25") << 25;
+}
+
+void ImageFilters_test::benchmark_blur()
+{
+  QFETCH(int, radius);
+
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+
+  // Time is independent of the radius
+  Image<unsigned char, 3> imageBlur(imageRgb.width(), imageRgb.height());
+  imgproc::Blur blur(static_cast<size_t>(radius));
+  QBENCHMARK
+  {
+    blur.apply(imageRgb, imageBlur);
+  }
+}
+
+void ImageFilters_test::benchmark_gaussianBlur_data()
+{
+  QTest::addColumn<double>("sigma");
+  QTest::addColumn<int>("method");
+  QTest::newRow("FIR 1") << 1.0 << static_cast<int>(imgproc::GaussianBlur::Method::Fir);
+  QTest::newRow("FIR 5") << 5.0 << static_cast<int>(imgproc::GaussianBlur::Method::Fir);
+  QTest::newRow("recursive 5") << 5.0 << static_cast<int>(imgproc::GaussianBlur::Method::Recursive);
+  QTest::newRow("recursive 25") << 25.0 << static_cast<int>(imgproc::GaussianBlur::Method::Recursive);
+}
+
+void ImageFilters_test::benchmark_gaussianBlur()
+{
+  QFETCH(double, sigma);
+  QFETCH(int, method);
+
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+
+  // Time of the recursive filter is independent of sigma
+  Image<unsigned char, 3> imageBlur(imageRgb.width(), imageRgb.height());
+  imgproc::GaussianBlur blur(sigma, static_cast<imgproc::GaussianBlur::Method>(method));
+  QBENCHMARK
+  {
+    blur.apply(imageRgb, imageBlur);
+  }
+}
+
+void ImageFilters_test::benchmark_sobel_data()
+{
+  QTest::addColumn<bool>("integer");
+  QTest::newRow("8-bit") << true;
+  QTest::newRow("floating point") << false;
+}
+
+void ImageFilters_test::benchmark_sobel()
+{
+  QFETCH(bool, integer);
+
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+
+  imgproc::Sobel sobel(imgproc::Sobel::Norm::L1);
+  if (integer)
+  {
+    Image<unsigned char, 1> magnitude(imageGray.width(), imageGray.height());
+    QBENCHMARK
+    {
+      sobel.apply(imageGray, magnitude);
+    }
+  }
+  else
+  {
+    Image<float, 1> imageFloat(imageGray.width(), imageGray.height());
+    Image<float, 1> magnitude(imageGray.width(), imageGray.height());
+    QBENCHMARK
+    {
+      sobel.apply(imageFloat, magnitude);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_pipeline_data()
+{
+  QTest::addColumn<bool>("fused");
+  QTest::newRow("separate") << false;
+  QTest::newRow("fused") << true;
+}
+
+void ImageFilters_test::benchmark_pipeline()
+{
+  QFETCH(bool, fused);
+
+  Image<unsigned char, 3> imageRgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), imageRgb));
+  Image<unsigned char, 1> output(imageRgb.width(), imageRgb.height());
+
+  if (fused)
+  {
+    imgproc::Pipeline<imgproc::GrayscaleStage<>, imgproc::BlurStage<>, imgproc::SobelStage<>> edges;
+    QBENCHMARK
+    {
+      edges.apply(imageRgb, output);
+    }
+  }
+  else
+  {
+    Image<unsigned char, 1> imageGray(imageRgb.width(), imageRgb.height());
+    Image<unsigned char, 1> imageBlur(imageRgb.width(), imageRgb.height());
+    imgproc::Grayscale<unsigned char> grayscale;
+    imgproc::Blur blur;
+    imgproc::Sobel sobel;
+    QBENCHMARK
+    {
+      grayscale.apply(imageRgb, imageGray);
+      blur.apply(imageGray, imageBlur);
+      sobel.apply(imageBlur, output);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_parallelExecutor_data()
+{
+  QTest::addColumn<int>("width");
+  QTest::addColumn<int>("height");
+  QTest::addColumn<int>("threads");
+
+  const int hardwareThreads = static_cast<int>(ThreadPool::hardwareThreadCount());
+  for (int size = 0; size < 2; size++)
+  {
+    const int width = (size == 0 ? 3840 : 15360);
+    const int height = (size == 0 ? 2160 : 8640);
+    for (int threads = 1; ; threads = std::min(threads * 2, hardwareThreads))
+    {
+      const std::string name = std::string(size == 0 ? "4K " : "16K ") + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+      QTest::newRow(name.c_str()) << width << height << threads;
+      if (threads == hardwareThreads)
+      {
+        break;
+      }
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_parallelExecutor()
+{
+  QFETCH(int, width);
+  QFETCH(int, height);
+  QFETCH(int, threads);
+
+  // Blur of grayscale image
+  Image<unsigned char, 1> input(width, height);
+  Image<unsigned char, 1> output(width, height);
+  ThreadPool pool(threads);
+  imgproc::ParallelExecutor executor(pool);
+  imgproc::Blur blur(2);
+  QBENCHMARK
+  {
+    executor.apply(blur, input, output);
+  }
+}
+
+void ImageFilters_test::benchmark_adaptiveThreshold_data()
+{
+  QTest::addColumn<int>("radius");
+  QTest::addColumn<bool>("gaussian");
+  QTest::newRow("mean 3") << 3 << false;
+  QTest::newRow("mean 15") << 15 << false;
+  QTest::newRow("mean 63") << 63 << false;
+  QTest::newRow("gaussian 15") << 15 << true;
+  QTest::newRow("gaussian 63") << 63 << true;
+}
+
+void ImageFilters_test::benchmark_adaptiveThreshold()
+{
+  QFETCH(int, radius);
+  QFETCH(bool, gaussian);
+
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+
+  // Time is independent of the radius
+  typedef imgproc::AdaptiveThreshold<unsigned char> AdaptiveThreshold;
+  AdaptiveThreshold filter(static_cast<size_t>(radius), 5, gaussian ? AdaptiveThreshold::Method::Gaussian : AdaptiveThreshold::Method::Mean);
+  Image<unsigned char, 1> output(imageGray.width(), imageGray.height());
+  QBENCHMARK
+  {
+    filter.apply(imageGray, output);
+  }
+}
+
+void ImageFilters_test::benchmark_integralImage_data()
+{
+  QTest::addColumn<int>("threads");
+
+  const int hardwareThreads = static_cast<int>(ThreadPool::hardwareThreadCount());
+  for (int threads = 1; ; threads = std::min(threads * 2, hardwareThreads))
+  {
+    const std::string name = std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+    QTest::newRow(name.c_str()) << threads;
+    if (threads == hardwareThreads)
+    {
+      break;
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_integralImage()
+{
+  QFETCH(int, threads);
+
+  // 4K grayscale image
+  Image<unsigned char, 1> input(3840, 2160);
+  imgproc::IntegralImage<unsigned char> integral;
+  ThreadPool pool(threads);
+  QBENCHMARK
+  {
+    if (threads == 1)
+    {
+      integral.compute(input);
+    }
+    else
+    {
+      integral.compute(input, pool);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_morphology_data()
+{
+  QTest::addColumn<int>("radius");
+  QTest::addColumn<bool>("binary");
+  QTest::newRow("8-bit 1") << 1 << false;
+  QTest::newRow("8-bit 5") << 5 << false;
+  QTest::newRow("8-bit 25") << 25 << false;
+  QTest::newRow("binary 1") << 1 << true;
+  QTest::newRow("binary 5") << 5 << true;
+  QTest::newRow("binary 25") << 25 << true;
+}
+
+void ImageFilters_test::benchmark_morphology()
+{
+  QFETCH(int, radius);
+  QFETCH(bool, binary);
+
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+  if (binary)
+  {
+    QVERIFY(imgproc::GlobalThreshold<unsigned char>(127).apply(imageGray));
+  }
+
+  // Time is independent of the radius
+  imgproc::Morphology open(imgproc::Morphology::Operation::Open, static_cast<size_t>(radius), static_cast<size_t>(radius));
+  Image<unsigned char, 1> output(imageGray.width(), imageGray.height());
+  QBENCHMARK
+  {
+    open.apply(imageGray, output);
+  }
+}
+
+void ImageFilters_test::benchmark_median_data()
+{
+  QTest::addColumn<int>("radius");
+  QTest::addColumn<int>("threads");
+  QTest::newRow("radius 1") << 1 << 0;
+  QTest::newRow("radius 2") << 2 << 0;
+  QTest::newRow("radius 3") << 3 << 0;
+  QTest::newRow("radius 15") << 15 << 0;
+  QTest::newRow("radius 50") << 50 << 0;
+  QTest::newRow("radius 15, 4 threads") << 15 << 4;
+}
+
+void ImageFilters_test::benchmark_median()
+{
+  QFETCH(int, radius);
+  QFETCH(int, threads);
+
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+
+  // Time is independent of the radius from radius 3
+  imgproc::Median median(static_cast<size_t>(radius));
+  Image<unsigned char, 1> output(imageGray.width(), imageGray.height());
+  if (threads == 0)
+  {
+    QBENCHMARK
+    {
+      median.apply(imageGray, output);
+    }
+  }
+  else
+  {
+    ThreadPool pool(threads);
+    QBENCHMARK
+    {
+      median.apply(imageGray, output, pool);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_canny_data()
+{
+  QTest::addColumn<int>("threads");
+  QTest::newRow("single thread") << 0;
+  QTest::newRow("2 threads") << 2;
+  QTest::newRow("4 threads") << 4;
+}
+
+void ImageFilters_test::benchmark_canny()
+{
+  QFETCH(int, threads);
+
+  Image<unsigned char, 1> imageGray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), imageGray));
+
+  // Buffers are allocated by the first run
+  imgproc::Canny canny(20, 50, 1.4);
+  Image<unsigned char, 1> output(imageGray.width(), imageGray.height());
+  if (threads == 0)
+  {
+    QBENCHMARK
+    {
+      canny.apply(imageGray, output);
+    }
+  }
+  else
+  {
+    ThreadPool pool(threads);
+    QBENCHMARK
+    {
+      canny.apply(imageGray, output, pool);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_connectedComponents_data()
+{
+  QTest::addColumn<int>("threads");
+  QTest::newRow("single thread") << 0;
+  QTest::newRow("2 threads") << 2;
+  QTest::newRow("4 threads") << 4;
+}
+
+void ImageFilters_test::benchmark_connectedComponents()
+{
+  QFETCH(int, threads);
+
+  Image<unsigned char, 1> mask;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), mask));
+  QVERIFY(imgproc::GlobalThreshold<unsigned char>(127).apply(mask));
+
+  imgproc::ConnectedComponents labeling;
+  Image<unsigned int, 1> labels(mask.width(), mask.height());
+  if (threads == 0)
+  {
+    QBENCHMARK
+    {
+      labeling.apply(mask, labels);
+    }
+  }
+  else
+  {
+    ThreadPool pool(threads);
+    QBENCHMARK
+    {
+      labeling.apply(mask, labels, pool);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_distanceTransform_data()
+{
+  QTest::addColumn<int>("threads");
+  QTest::newRow("single thread") << 0;
+  QTest::newRow("2 threads") << 2;
+  QTest::newRow("4 threads") << 4;
+}
+
+void ImageFilters_test::benchmark_distanceTransform()
+{
+  QFETCH(int, threads);
+
+  // Features: bright pixels
+  Image<unsigned char, 1> mask;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), mask));
+  QVERIFY(imgproc::GlobalThreshold<unsigned char>(200).apply(mask));
+
+  imgproc::DistanceTransform transform;
+  Image<float, 1> distance(mask.width(), mask.height());
+  if (threads == 0)
+  {
+    QBENCHMARK
+    {
+      transform.apply(mask, distance);
+    }
+  }
+  else
+  {
+    ThreadPool pool(threads);
+    QBENCHMARK
+    {
+      transform.apply(mask, distance, pool);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_convolve_data()
+{
+  QTest::addColumn<int>("size");
+  QTest::addColumn<int>("method");
+  QTest::addColumn<int>("threads");
+  QTest::newRow("direct 5x5") << 5 << static_cast<int>(imgproc::Convolve::Method::Direct) << 0;
+  QTest::newRow("direct 15x15") << 15 << static_cast<int>(imgproc::Convolve::Method::Direct) << 0;
+  QTest::newRow("FFT 15x15") << 15 << static_cast<int>(imgproc::Convolve::Method::Fft) << 0;
+  QTest::newRow("FFT 63x63") << 63 << static_cast<int>(imgproc::Convolve::Method::Fft) << 0;
+  QTest::newRow("FFT 255x255") << 255 << static_cast<int>(imgproc::Convolve::Method::Fft) << 0;
+  QTest::newRow("FFT 63x63, 4 threads") << 63 << static_cast<int>(imgproc::Convolve::Method::Fft) << 4;
+}
+
+void ImageFilters_test::benchmark_convolve()
+{
+  QFETCH(int, size);
+  QFETCH(int, method);
+  QFETCH(int, threads);
+
+  Image<unsigned char, 1> image;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), image));
+
+  // Disk kernel; not separable
+  Matrix kernel(static_cast<size_t>(size), static_cast<size_t>(size));
+  const double radius = size / 2.0;
+  double total = 0;
+  for (size_t i = 0; i < kernel.rows(); i++)
+  {
+    for (size_t j = 0; j < kernel.cols(); j++)
+    {
+      const double dx = j + 0.5 - radius;
+      const double dy = i + 0.5 - radius;
+      kernel(i, j) = (dx * dx + dy * dy <= radius * radius ? 1.0 : 0.0);
+      total += kernel(i, j);
+    }
+  }
+  imgproc::Convolve convolve(kernel / total, static_cast<imgproc::Convolve::Method>(method));
+
+  // Time of the FFT grows with the logarithm of the kernel size
+  Image<unsigned char, 1> output(image.width(), image.height());
+  if (threads == 0)
+  {
+    QBENCHMARK
+    {
+      convolve.apply(image, output);
+    }
+  }
+  else
+  {
+    ThreadPool pool(threads);
+    QBENCHMARK
+    {
+      convolve.apply(image, output, pool);
+    }
+  }
+}
+
+void ImageFilters_test::benchmark_clahe_data()
+{
+  QTest::addColumn<bool>("sixteenBit");
+  QTest::addColumn<int>("threads");
+  QTest::newRow("8 bit") << false << 0;
+  QTest::newRow("8 bit, 4 threads") << false << 4;
+  QTest::newRow("16 bit") << true << 0;
+}
+
+void ImageFilters_test::benchmark_clahe()
+{
+  QFETCH(bool, sixteenBit);
+  QFETCH(int, threads);
+
+  Image<unsigned char, 1> image;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), image));
+  Image<unsigned short, 1> image16(image.width(), image.height());
+  for (size_t i = 0; i < image.width() * image.height(); i++)
+  {
+    image16.imageDataPtr()[i][0] = static_cast<unsigned short>(image.imageDataPtr()[i][0] * 257);
+  }
+
+  imgproc::Clahe clahe;
+  Image<unsigned char, 1> output(image.width(), image.height());
+  Image<unsigned short, 1> output16(image.width(), image.height());
+  if (sixteenBit)
+  {
+    QBENCHMARK
+    {
+      clahe.apply(image16, output16);
+    }
+  }
+  else if (threads == 0)
+  {
+    QBENCHMARK
+    {
+      clahe.apply(image, output);
+    }
+  }
+  else
+  {
+    ThreadPool pool(threads);
+    QBENCHMARK
+    {
+      clahe.apply(image, output, pool);
+    }
+  }
 }
 
 QTEST_APPLESS_MAIN(ImageFilters_test)
@@ -1,11 +1,49 @@
 #include <QtTest>
 
+#include <spatium/AsyncImageLoader.h>
 #include <spatium/Image.h>
 #include <spatium/ImageIO.h>
+#include <spatium/MappedImage.h>
+#include <spatium/PnmScanlineReader.h>
+#include <spatium/PnmScanlineWriter.h>
+#include <spatium/TiffReader.h>
 #include <spatium/gfx2d/Drawing.h>
 
+#include <future> // std::promise, std::shared_future
+#include <mutex> // std::mutex, std::lock_guard
+
 using namespace spatium;
 
+/// Stream buffer that delivers one byte at a time and cannot seek, like a
+/// pipe or a socket
+class SequentialStreamBuffer : public std::streambuf
+{
+public:
+  SequentialStreamBuffer(const std::vector<std::uint8_t> &data)
+    : m_data(data)
+    , m_position(0)
+    , m_byte(0)
+  {
+  }
+
+protected:
+  int_type underflow() override
+  {
+    if (m_position == m_data.size())
+    {
+      return traits_type::eof();
+    }
+    m_byte = static_cast<char>(m_data[m_position++]);
+    setg(&m_byte, &m_byte, &m_byte + 1);
+    return traits_type::to_int_type(m_byte);
+  }
+
+private:
+  std::vector<std::uint8_t> m_data;
+  size_t m_position;
+  char m_byte;
+};
+
 class ImageIO_test : public QObject
 {
   Q_OBJECT
@@ -34,6 +72,44 @@ private slots:
   void test_readWriteBinaryImageAsPbm();
   void test_readWriteGrayscaleImageAsPgm();
   void test_readWriteRgbImagePpm();
+  void test_readWriteRgbaImageAsPam();
+  void test_readAsciiPnm();
+  void test_read16BitPgmPpm();
+  void test_rejectOversizedPnmHeader();
+
+  // Memory buffers and streams
+  void test_readWriteRgbImagePpmBuffer();
+  void test_readImagesFromNonSeekableStream();
+
+  // Quite OK Image format (QOI)
+  void test_readWriteRgbImageAsQoi();
+  void test_readWriteRgbaImageAsQoi();
+
+  // Benchmarks: QOI versus PPM/PAM
+  void benchmark_writeRgbImage_data();
+  void benchmark_writeRgbImage();
+  void benchmark_readRgbImage_data();
+  void benchmark_readRgbImage();
+
+  // Memory mapped images
+  void test_mapGrayscaleImageFromPgm();
+  void test_mapRgbImageFromPpm();
+
+  // Scanline reading and writing
+  void test_scanlineReadWriteRgbImagePpm();
+  void test_scanlineReadWrite16BitRgbImagePpm();
+  void test_scanlineReadBinaryImagePbm();
+
+  // TIFF reading
+  void test_readRgbImageFromTiffStrips();
+  void test_readGrayscaleImageFromTiffTiles();
+  void test_readFloatWindowFromTiff();
+  void test_reopenTiffReader();
+  void test_rejectTiffWithHugeTiles();
+
+  // Asynchronous loading
+  void test_asyncImageLoader();
+  void test_asyncImageLoaderException();
 
 private:
 };
@@ -63,7 +139,18 @@ void ImageIO_test::test_writeGrayscaleToPgm()
 
   Image<unsigned short, 1> image16(20, 15);
   gfx2d::Drawing::drawCircle(image16, {10,8}, 5, {32768});
+  image16.pixel(0, 0) = { 0x1234 };
   QVERIFY(ImageIO::writeGrayscaleImageAsPgm(image16, "grayscale16bit.pgm"));
+
+  // Verify 16-bit samples are written big-endian
+  QFile file("grayscale16bit.pgm");
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray content = file.readAll();
+  const QByteArray header = "P5\n20\n15\n65535\n";
+  QVERIFY(content.startsWith(header));
+  QCOMPARE(content.size(), header.size() + 20 * 15 * 2);
+  QCOMPARE(static_cast<unsigned char>(content[header.size()]), static_cast<unsigned char>(0x12));
+  QCOMPARE(static_cast<unsigned char>(content[header.size() + 1]), static_cast<unsigned char>(0x34));
 }
 
 void ImageIO_test::test_writeRgbToPpm()
@@ -149,10 +236,883 @@ void ImageIO_test::test_readWriteRgbImagePpm()
   QVERIFY(input == output);
 }
 
-// Read functions
+void ImageIO_test::test_readWriteRgbaImageAsPam()
+{
+  // Read RGB image and add alpha channel
+  Image<unsigned char, 3> rgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), rgb));
+  Image<unsigned char, 4> input(rgb.width(), rgb.height());
+  for (size_t y = 0; y < rgb.height(); y++)
+  {
+    for (size_t x = 0; x < rgb.width(); x++)
+    {
+      const std::array<unsigned char, 3> px = rgb.pixel(x, y);
+      input.pixel(x, y) = { px[0], px[1], px[2], static_cast<unsigned char>(x + y) };
+    }
+  }
+
+  // Write RGBA image
+  QVERIFY(ImageIO::writeRgbaImageAsPam(input, (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgba.pam").toStdString()));
+
+  // Read RGBA image
+  Image<unsigned char, 4> output;
+  QVERIFY(ImageIO::readImageFromPam((QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgba.pam").toStdString(), output));
+  QVERIFY(input == output);
+
+  // Depth must match channel count
+  QVERIFY(!ImageIO::readImageFromPam((QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgba.pam").toStdString(), rgb));
+}
+
+void ImageIO_test::test_readAsciiPnm()
+{
+  // PBM: digits need not be separated
+  const std::string pbm = "P1\n# comment\n3 2\n0 1 0\n110\n";
+  Image<unsigned char, 1> binary;
+  QVERIFY(ImageIO::readBinaryImageFromPbm(reinterpret_cast<const std::uint8_t*>(pbm.data()), pbm.size(), binary));
+  QCOMPARE(binary.width(), static_cast<size_t>(3));
+  QCOMPARE(binary.height(), static_cast<size_t>(2));
+  QCOMPARE(binary.pixel(0, 0)[0], static_cast<unsigned char>(255));
+  QCOMPARE(binary.pixel(1, 0)[0], static_cast<unsigned char>(0));
+  QCOMPARE(binary.pixel(2, 1)[0], static_cast<unsigned char>(255));
+
+  // PGM
+  const std::string pgm = "P2\n3 2\n255\n0 17 255\n  # comment\n 128\t9\r\n42";
+  Image<unsigned char, 1> gray;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm(reinterpret_cast<const std::uint8_t*>(pgm.data()), pgm.size(), gray));
+  QCOMPARE(gray.pixel(1, 0)[0], static_cast<unsigned char>(17));
+  QCOMPARE(gray.pixel(2, 0)[0], static_cast<unsigned char>(255));
+  QCOMPARE(gray.pixel(0, 1)[0], static_cast<unsigned char>(128));
+  QCOMPARE(gray.pixel(2, 1)[0], static_cast<unsigned char>(42));
+
+  // Truncated data and values above the maximum value
+  QVERIFY(!ImageIO::readGrayscaleImageFromPgm(reinterpret_cast<const std::uint8_t*>(pgm.data()), pgm.size() - 2, gray));
+  const std::string pgmOutOfRange = "P2\n1 1\n100\n101\n";
+  QVERIFY(!ImageIO::readGrayscaleImageFromPgm(reinterpret_cast<const std::uint8_t*>(pgmOutOfRange.data()), pgmOutOfRange.size(), gray));
+
+  // PPM with 16-bit values
+  const std::string ppm = "P3\n2 1\n65535\n1 2 3 65535 1000 0\n";
+  Image<unsigned short, 3> rgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm(reinterpret_cast<const std::uint8_t*>(ppm.data()), ppm.size(), rgb));
+  QVERIFY(rgb.pixel(0, 0) == (std::array<unsigned short, 3>{ 1, 2, 3 }));
+  QVERIFY(rgb.pixel(1, 0) == (std::array<unsigned short, 3>{ 65535, 1000, 0 }));
+
+  // 16-bit values do not fit in 8-bit image
+  Image<unsigned char, 3> rgb8;
+  QVERIFY(!ImageIO::readRgbImageFromPpm(reinterpret_cast<const std::uint8_t*>(ppm.data()), ppm.size(), rgb8));
+}
+
+void ImageIO_test::test_read16BitPgmPpm()
+{
+  // Write and read 16-bit grayscale image
+  Image<unsigned short, 1> gray(33, 17);
+  for (size_t y = 0; y < gray.height(); y++)
+  {
+    for (size_t x = 0; x < gray.width(); x++)
+    {
+      gray.pixel(x, y) = { static_cast<unsigned short>(x * 1000 + y * 7) };
+    }
+  }
+  std::vector<std::uint8_t> buffer;
+  QVERIFY(ImageIO::writeGrayscaleImageAsPgm(gray, buffer));
+  Image<unsigned short, 1> grayOutput;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm(buffer.data(), buffer.size(), grayOutput));
+  QVERIFY(gray == grayOutput);
+
+  // Read 8-bit grayscale file into 16-bit image
+  Image<unsigned char, 1> gray8;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), gray8));
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString(), grayOutput));
+  QCOMPARE(grayOutput.width(), gray8.width());
+  QCOMPARE(grayOutput.height(), gray8.height());
+  for (size_t y = 0; y < gray8.height(); y++)
+  {
+    for (size_t x = 0; x < gray8.width(); x++)
+    {
+      QCOMPARE(grayOutput.pixel(x, y)[0], static_cast<unsigned short>(gray8.pixel(x, y)[0]));
+    }
+  }
+
+  // Read 16-bit RGB file (big-endian samples)
+  const std::string header = "P6\n2 1\n4095\n";
+  std::vector<std::uint8_t> ppm(header.begin(), header.end());
+  const std::uint8_t samples[] = { 0x0F, 0xFF, 0x01, 0x02, 0x00, 0x03, 0x0A, 0xBC, 0x00, 0x00, 0x08, 0x00 };
+  ppm.insert(ppm.end(), samples, samples + sizeof(samples));
+  Image<unsigned short, 3> rgb;
+  QVERIFY(ImageIO::readRgbImageFromPpm(ppm.data(), ppm.size(), rgb));
+  QVERIFY(rgb.pixel(0, 0) == (std::array<unsigned short, 3>{ 0x0FFF, 0x0102, 0x0003 }));
+  QVERIFY(rgb.pixel(1, 0) == (std::array<unsigned short, 3>{ 0x0ABC, 0x0000, 0x0800 }));
+  QVERIFY(!ImageIO::readRgbImageFromPpm(ppm.data(), ppm.size() - 1, rgb));
+}
+
+void ImageIO_test::test_rejectOversizedPnmHeader()
+{
+  // Width * height wraps to 0
+  const std::string wrapped = "P6\n8589934592 2147483648\n255\n\x01\x02\x03";
+  Image<unsigned char, 3> rgb;
+  QVERIFY(!ImageIO::readRgbImageFromPpm(reinterpret_cast<const std::uint8_t*>(wrapped.data()), wrapped.size(), rgb));
+
+  // More than 400 million pixels; rejected before allocating
+  const std::string pgm = "P5\n20001 20000\n255\n\x01";
+  Image<unsigned char, 1> gray;
+  QVERIFY(!ImageIO::readGrayscaleImageFromPgm(reinterpret_cast<const std::uint8_t*>(pgm.data()), pgm.size(), gray));
+  const std::string pgmAscii = "P2\n20001 20000\n255\n1 2 3\n";
+  QVERIFY(!ImageIO::readGrayscaleImageFromPgm(reinterpret_cast<const std::uint8_t*>(pgmAscii.data()), pgmAscii.size(), gray));
+  const std::string pbm = "P4\n4000000000 4000000000\n\x01";
+  QVERIFY(!ImageIO::readBinaryImageFromPbm(reinterpret_cast<const std::uint8_t*>(pbm.data()), pbm.size(), gray));
+  const std::string pam = "P7\nWIDTH 30000\nHEIGHT 30000\nDEPTH 4\nMAXVAL 65535\nENDHDR\n\x01";
+  Image<unsigned short, 4> rgba16;
+  QVERIFY(!ImageIO::readImageFromPam(reinterpret_cast<const std::uint8_t*>(pam.data()), pam.size(), rgba16));
+}
+
+// Memory buffers
+
+void ImageIO_test::test_readWriteRgbImagePpmBuffer()
+{
+  // Read RGB file into memory
+  QFile file(QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm");
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray content = file.readAll();
+
+  // Decode RGB image from memory
+  Image<unsigned char, 3> input;
+  QVERIFY(ImageIO::readRgbImageFromPpm(reinterpret_cast<const std::uint8_t*>(content.constData()), static_cast<size_t>(content.size()), input));
+
+  // Encode RGB image into memory
+  std::vector<std::uint8_t> buffer;
+  QVERIFY(ImageIO::writeRgbImageAsPpm(input, buffer));
+
+  // Compare output with input
+  Image<unsigned char, 3> output;
+  QVERIFY(ImageIO::readRgbImageFromPpm(buffer.data(), buffer.size(), output));
+  QVERIFY(input == output);
+
+  // Truncated data
+  QVERIFY(!ImageIO::readRgbImageFromPpm(buffer.data(), buffer.size() - 1, output));
+}
+
+void ImageIO_test::test_readImagesFromNonSeekableStream()
+{
+  Image<unsigned char, 1> binary(13, 7);
+  Image<unsigned short, 1> gray16(13, 7);
+  Image<unsigned char, 3> rgb(13, 7);
+  Image<unsigned char, 4> rgba(13, 7);
+  for (size_t y = 0; y < rgb.height(); y++)
+  {
+    for (size_t x = 0; x < rgb.width(); x++)
+    {
+      binary.pixel(x, y) = { static_cast<unsigned char>((x + y) % 3 == 0 ? 0 : 255) };
+      gray16.pixel(x, y) = { static_cast<unsigned short>(x * 5000 + y) };
+      rgb.pixel(x, y) = { static_cast<unsigned char>(x * 19), static_cast<unsigned char>(y * 31), static_cast<unsigned char>(x * y) };
+      rgba.pixel(x, y) = { static_cast<unsigned char>(x * 19), static_cast<unsigned char>(y * 31), 7, static_cast<unsigned char>(x < 6 ? 255 : y) };
+    }
+  }
+
+  // The stream cannot seek. Writing appends to the buffer.
+  std::vector<std::uint8_t> buffer;
+  QVERIFY(ImageIO::writeRgbImageAsPpm(rgb, buffer));
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    QVERIFY(stream.tellg() == std::streampos(-1));
+  }
+
+  // Binary PBM, PGM, PPM and PAM
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 3> output;
+    QVERIFY(ImageIO::readRgbImageFromPpm(stream, output));
+    QVERIFY(output == rgb);
+  }
+  buffer.clear();
+  QVERIFY(ImageIO::writeBinaryImageAsPbm(binary, buffer));
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 1> output;
+    QVERIFY(ImageIO::readBinaryImageFromPbm(stream, output));
+    QVERIFY(output == binary);
+  }
+  buffer.clear();
+  QVERIFY(ImageIO::writeGrayscaleImageAsPgm(gray16, buffer));
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned short, 1> output;
+    QVERIFY(ImageIO::readGrayscaleImageFromPgm(stream, output));
+    QVERIFY(output == gray16);
+  }
+  buffer.clear();
+  QVERIFY(ImageIO::writeRgbaImageAsPam(rgba, buffer));
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 4> output;
+    QVERIFY(ImageIO::readImageFromPam(stream, output));
+    QVERIFY(output == rgba);
+  }
+
+  // QOI is read up to the end of the stream
+  buffer.clear();
+  QVERIFY(ImageIO::writeRgbaImageAsQoi(rgba, buffer));
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 4> output;
+    QVERIFY(ImageIO::readRgbaImageFromQoi(stream, output));
+    QVERIFY(output == rgba);
+  }
+
+  // ASCII PBM and PGM
+  const std::string pbm = "P1\n# comment\n3 2\n0 1 0\n110\n";
+  buffer.assign(pbm.begin(), pbm.end());
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 1> output, expected;
+    QVERIFY(ImageIO::readBinaryImageFromPbm(stream, output));
+    QVERIFY(ImageIO::readBinaryImageFromPbm(buffer.data(), buffer.size(), expected));
+    QVERIFY(output == expected);
+  }
+  const std::string pgm = "P2\n3 2\n255\n0 1 2\n3 4 255\n";
+  buffer.assign(pgm.begin(), pgm.end());
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 1> output;
+    QVERIFY(ImageIO::readGrayscaleImageFromPgm(stream, output));
+    QCOMPARE(output.pixel(2, 1)[0], static_cast<unsigned char>(255));
+  }
+
+  // Truncated data
+  buffer.clear();
+  QVERIFY(ImageIO::writeRgbImageAsPpm(rgb, buffer));
+  buffer.pop_back();
+  {
+    SequentialStreamBuffer streamBuffer(buffer);
+    std::istream stream(&streamBuffer);
+    Image<unsigned char, 3> output;
+    QVERIFY(!ImageIO::readRgbImageFromPpm(stream, output));
+  }
+}
+
+// Quite OK Image format (QOI)
+
+void ImageIO_test::test_readWriteRgbImageAsQoi()
+{
+  // Read RGB image
+  Image<unsigned char, 3> input;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), input));
+
+  // Write RGB image
+  QVERIFY(ImageIO::writeRgbImageAsQoi(input, (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgb.qoi").toStdString()));
+
+  // Compare output with input
+  Image<unsigned char, 3> output;
+  QVERIFY(ImageIO::readRgbImageFromQoi((QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgb.qoi").toStdString(), output));
+  QVERIFY(input == output);
+
+  // Read RGB image as RGBA; alpha is opaque
+  Image<unsigned char, 4> outputRgba;
+  QVERIFY(ImageIO::readRgbaImageFromQoi((QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgb.qoi").toStdString(), outputRgba));
+  QCOMPARE(outputRgba.pixel(10, 20)[3], static_cast<unsigned char>(255));
+}
+
+void ImageIO_test::test_readWriteRgbaImageAsQoi()
+{
+  // Image with runs, small differences and varying alpha
+  Image<unsigned char, 4> input(64, 48);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = { static_cast<unsigned char>(x * 4),
+                            static_cast<unsigned char>(y < 24 ? 0 : y * 5),
+                            static_cast<unsigned char>((x * y) % 256),
+                            static_cast<unsigned char>(x < 32 ? 255 : x) };
+    }
+  }
+
+  std::vector<std::uint8_t> buffer;
+  QVERIFY(ImageIO::writeRgbaImageAsQoi(input, buffer));
+
+  Image<unsigned char, 4> output;
+  QVERIFY(ImageIO::readRgbaImageFromQoi(buffer.data(), buffer.size(), output));
+  QVERIFY(input == output);
+
+  // Corrupt data
+  QVERIFY(!ImageIO::readRgbaImageFromQoi(buffer.data(), 20, output));
+
+  // Header with huge dimensions is rejected before allocating
+  std::vector<std::uint8_t> huge(buffer.begin(), buffer.begin() + 14);
+  std::fill(huge.begin() + 4, huge.begin() + 12, 0xFF);
+  huge.insert(huge.end(), buffer.end() - 8, buffer.end());
+  QVERIFY(!ImageIO::readRgbaImageFromQoi(huge.data(), huge.size(), output));
+  huge[4] = huge[5] = huge[8] = huge[9] = 0; // 65535 x 65535
+  QVERIFY(!ImageIO::readRgbaImageFromQoi(huge.data(), huge.size(), output));
+
+  buffer[0] = 'x';
+  QVERIFY(!ImageIO::readRgbaImageFromQoi(buffer.data(), buffer.size(), output));
+}
+
+// Benchmarks: QOI versus PPM/PAM
+
+void ImageIO_test::benchmark_writeRgbImage_data()
+{
+  QTest::addColumn<QString>("format");
+  QTest::newRow("PPM") << "PPM";
+  QTest::newRow("PAM") << "PAM";
+  QTest::newRow("QOI") << "QOI";
+}
+
+void ImageIO_test::benchmark_writeRgbImage()
+{
+  QFETCH(QString, format);
+
+  Image<unsigned char, 3> image;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), image));
+
+  // Encode into memory to measure the codec rather than the disk
+  std::vector<std::uint8_t> buffer;
+  QBENCHMARK
+  {
+    buffer.clear();
+    if (format == "PPM")
+    {
+      ImageIO::writeRgbImageAsPpm(image, buffer);
+    }
+    else if (format == "PAM")
+    {
+      ImageIO::writeRgbImageAsPam(image, buffer);
+    }
+    else
+    {
+      ImageIO::writeRgbImageAsQoi(image, buffer);
+    }
+  }
+
+  // QOI compresses; PPM and PAM add a header to the raw samples
+  const size_t rawSize = image.width() * image.height() * 3;
+  if (format == "QOI")
+  {
+    QVERIFY(buffer.size() < rawSize);
+  }
+  else
+  {
+    QVERIFY(buffer.size() > rawSize);
+  }
+}
+
+void ImageIO_test::benchmark_readRgbImage_data()
+{
+  benchmark_writeRgbImage_data();
+}
+
+void ImageIO_test::benchmark_readRgbImage()
+{
+  QFETCH(QString, format);
 
-// ...
+  Image<unsigned char, 3> image;
+  QVERIFY(ImageIO::readRgbImageFromPpm((QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString(), image));
 
+  std::vector<std::uint8_t> buffer;
+  if (format == "PPM")
+  {
+    QVERIFY(ImageIO::writeRgbImageAsPpm(image, buffer));
+  }
+  else if (format == "PAM")
+  {
+    QVERIFY(ImageIO::writeRgbImageAsPam(image, buffer));
+  }
+  else
+  {
+    QVERIFY(ImageIO::writeRgbImageAsQoi(image, buffer));
+  }
+
+  // Decode from memory to measure the codec rather than the disk
+  Image<unsigned char, 3> output;
+  QBENCHMARK
+  {
+    if (format == "PPM")
+    {
+      ImageIO::readRgbImageFromPpm(buffer.data(), buffer.size(), output);
+    }
+    else if (format == "PAM")
+    {
+      ImageIO::readImageFromPam(buffer.data(), buffer.size(), output);
+    }
+    else
+    {
+      ImageIO::readRgbImageFromQoi(buffer.data(), buffer.size(), output);
+    }
+  }
+  QVERIFY(image == output);
+}
+
+// Memory mapped images
+
+void ImageIO_test::test_mapGrayscaleImageFromPgm()
+{
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/lenna_gray.pgm").toStdString();
+
+  // Read grayscale image
+  Image<unsigned char, 1> input;
+  QVERIFY(ImageIO::readGrayscaleImageFromPgm(path, input));
+
+  // Map grayscale image
+  MappedImage<unsigned char, 1> mapped(path);
+  QVERIFY(mapped.isOpen());
+  QVERIFY(!mapped.isWritable());
+  QCOMPARE(mapped.width(), input.width());
+  QCOMPARE(mapped.height(), input.height());
+  QVERIFY(mapped.pixel(10, 20) == input.pixel(10, 20));
+
+  // Compare mapped image with read image
+  Image<unsigned char, 1> output;
+  QVERIFY(mapped.toImage(output));
+  QVERIFY(input == output);
+
+  // Wrong channel count
+  MappedImage<unsigned char, 3> mappedRgb(path);
+  QVERIFY(!mappedRgb.isOpen());
+}
+
+void ImageIO_test::test_mapRgbImageFromPpm()
+{
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString();
+
+  // Read RGB image
+  Image<unsigned char, 3> input;
+  QVERIFY(ImageIO::readRgbImageFromPpm(path, input));
+
+  // Map RGB image copy-on-write
+  MappedImage<unsigned char, 3> mapped;
+  QVERIFY(mapped.open(path, MappedImage<unsigned char, 3>::Mode::CopyOnWrite));
+  QVERIFY(mapped.isWritable());
+  Image<unsigned char, 3> output;
+  QVERIFY(mapped.toImage(output));
+  QVERIFY(input == output);
+
+  // Modify mapped pixel; the file is left untouched
+  mapped.writableImageDataPtr()[0] = { 1, 2, 3 };
+  QVERIFY((mapped.pixel(0, 0) == std::array<unsigned char, 3>{ 1, 2, 3 }));
+  MappedImage<unsigned char, 3> mappedAgain(path);
+  QVERIFY(mappedAgain.pixel(0, 0) == input.pixel(0, 0));
+
+  // Header of which the data size overflows: width * 3 wraps to 2 bytes
+  const QString overflowPath = QFileInfo(__FILE__).absolutePath() + "/resources/tmp/overflow.ppm";
+  QFile file(overflowPath);
+  QVERIFY(file.open(QIODevice::WriteOnly));
+  file.write("P6\n6148914691236517206 1\n255\n");
+  file.write(QByteArray(16, 0));
+  file.close();
+  MappedImage<unsigned char, 3> overflow(overflowPath.toStdString());
+  QVERIFY(!overflow.isOpen());
+}
+
+
+// Scanline reading and writing
+
+void ImageIO_test::test_scanlineReadWriteRgbImagePpm()
+{
+  const std::string inputPath = (QFileInfo(__FILE__).absolutePath() + "/resources/lenna_rgb.ppm").toStdString();
+  const std::string outputPath = (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/lenna_rgb_scanline.ppm").toStdString();
+
+  // Copy file in bands of 7 rows (last band is partial)
+  PnmScanlineReader<unsigned char, 3> reader(inputPath);
+  QVERIFY(reader.isOpen());
+  PnmScanlineWriter<unsigned char, 3> writer(outputPath, reader.width(), reader.height());
+  QVERIFY(writer.isOpen());
+
+  Image<unsigned char, 3> band(reader.width(), 7);
+  size_t rows = 0;
+  while ((rows = reader.readRows(band)) > 0)
+  {
+    QCOMPARE(writer.writeRows(band, rows), rows);
+  }
+  QCOMPARE(reader.remainingRows(), static_cast<size_t>(0));
+  QVERIFY(writer.close());
+
+  // Compare output with input
+  Image<unsigned char, 3> input, output;
+  QVERIFY(ImageIO::readRgbImageFromPpm(inputPath, input));
+  QVERIFY(ImageIO::readRgbImageFromPpm(outputPath, output));
+  QVERIFY(input == output);
+}
+
+void ImageIO_test::test_scanlineReadWrite16BitRgbImagePpm()
+{
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/rgb16_scanline.ppm").toStdString();
+
+  Image<unsigned short, 3> input(37, 23);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = { static_cast<unsigned short>(x * 1700 + y),
+                            static_cast<unsigned short>(y * 2800 + 0x0100),
+                            static_cast<unsigned short>(65535 - x * y) };
+    }
+  }
+
+  // Write in bands of 5 rows (last band is partial)
+  PnmScanlineWriter<unsigned short, 3> writer(path, input.width(), input.height());
+  QVERIFY(writer.isOpen());
+  Image<unsigned short, 3> band(input.width(), 5);
+  for (size_t y = 0; y < input.height(); y += band.height())
+  {
+    const size_t rows = std::min(band.height(), input.height() - y);
+    for (size_t row = 0; row < rows; row++)
+    {
+      for (size_t x = 0; x < input.width(); x++)
+      {
+        band.pixel(x, row) = input.pixel(x, y + row);
+      }
+    }
+    QCOMPARE(writer.writeRows(band, rows), rows);
+  }
+  QVERIFY(writer.close());
+
+  // Samples are stored big-endian
+  QFile file(QString::fromStdString(path));
+  QVERIFY(file.open(QIODevice::ReadOnly));
+  const QByteArray content = file.readAll();
+  const QByteArray header = "P6\n37\n23\n65535\n";
+  QVERIFY(content.startsWith(header));
+  QCOMPARE(content.size(), header.size() + 37 * 23 * 3 * 2);
+  QCOMPARE(static_cast<unsigned char>(content[header.size() + 2]), static_cast<unsigned char>(0x01));
+  QCOMPARE(static_cast<unsigned char>(content[header.size() + 3]), static_cast<unsigned char>(0x00));
+
+  // Read back in bands of 4 rows
+  PnmScanlineReader<unsigned short, 3> reader(path);
+  QVERIFY(reader.isOpen());
+  QCOMPARE(reader.width(), input.width());
+  QCOMPARE(reader.height(), input.height());
+  Image<unsigned short, 3> readBand(reader.width(), 4);
+  size_t rows = 0, y = 0;
+  while ((rows = reader.readRows(readBand)) > 0)
+  {
+    for (size_t row = 0; row < rows; row++)
+    {
+      for (size_t x = 0; x < input.width(); x++)
+      {
+        QVERIFY(readBand.pixel(x, row) == input.pixel(x, y + row));
+      }
+    }
+    y += rows;
+  }
+  QCOMPARE(y, input.height());
+
+  // 8-bit samples cannot hold the values
+  PnmScanlineReader<unsigned char, 3> reader8(path);
+  QVERIFY(!reader8.isOpen());
+}
+
+void ImageIO_test::test_scanlineReadBinaryImagePbm()
+{
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/tmp/binary_scanline.pbm").toStdString();
+
+  // Width is not a multiple of 8, so every row is padded
+  Image<unsigned char, 1> input(37, 23);
+  for (size_t y = 0; y < input.height(); y++)
+  {
+    for (size_t x = 0; x < input.width(); x++)
+    {
+      input.pixel(x, y) = { static_cast<unsigned char>((x * x + y) % 5 < 2 ? 0 : 255) };
+    }
+  }
+  QVERIFY(ImageIO::writeBinaryImageAsPbm(input, path));
+
+  // Read in bands of 6 rows (last band is partial)
+  PnmScanlineReader<unsigned char, 1> reader(path);
+  QVERIFY(reader.isOpen());
+  QCOMPARE(reader.width(), input.width());
+  QCOMPARE(reader.height(), input.height());
+  Image<unsigned char, 1> band(reader.width(), 6);
+  size_t rows = 0, y = 0;
+  while ((rows = reader.readRows(band)) > 0)
+  {
+    for (size_t row = 0; row < rows; row++)
+    {
+      for (size_t x = 0; x < input.width(); x++)
+      {
+        QCOMPARE(band.pixel(x, row)[0], input.pixel(x, y + row)[0]);
+      }
+    }
+    y += rows;
+  }
+  QCOMPARE(y, input.height());
+  QCOMPARE(reader.remainingRows(), static_cast<size_t>(0));
+
+  // Packed bits are only read into 8-bit samples
+  PnmScanlineReader<unsigned short, 1> reader16(path);
+  QVERIFY(!reader16.isOpen());
+}
+
+void ImageIO_test::test_readRgbImageFromTiffStrips()
+{
+  // 40x30 RGB, 8-bit, strips of 7 rows, PackBits compressed, little-endian
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/gradient_rgb_packbits.tif").toStdString();
+
+  Image<unsigned char, 3> image;
+  QVERIFY(ImageIO::readImageFromTiff(path, image));
+  QCOMPARE(image.width(), static_cast<size_t>(40));
+  QCOMPARE(image.height(), static_cast<size_t>(30));
+  for (size_t y = 0; y < image.height(); y++)
+  {
+    for (size_t x = 0; x < image.width(); x++)
+    {
+      const unsigned char blue = static_cast<unsigned char>((x / 5) % 2 ? (x + y) * 3 : 100);
+      QVERIFY(image.pixel(x, y) == (std::array<unsigned char, 3>{ static_cast<unsigned char>(x * 6), static_cast<unsigned char>(y * 8), blue }));
+    }
+  }
+
+  // Sample type and channel count must match the file
+  Image<unsigned char, 1> gray;
+  QVERIFY(!ImageIO::readImageFromTiff(path, gray));
+
+  // Read last (partial) strip
+  TiffReader reader(path);
+  QVERIFY(reader.isOpen());
+  QVERIFY(!reader.isTiled());
+  QCOMPARE(reader.chunkCount(), static_cast<size_t>(5));
+  Image<unsigned char, 3> strip;
+  QVERIFY(reader.readStrip(4, strip));
+  QCOMPARE(strip.height(), static_cast<size_t>(2));
+  QVERIFY(strip.pixel(0, 0) == image.pixel(0, 28));
+
+  // Read window spanning 3 strips
+  Image<unsigned char, 3> window;
+  QVERIFY(reader.readWindow(3, 5, 30, 11, window));
+  for (size_t y = 0; y < window.height(); y++)
+  {
+    for (size_t x = 0; x < window.width(); x++)
+    {
+      QVERIFY(window.pixel(x, y) == image.pixel(x + 3, y + 5));
+    }
+  }
+  QVERIFY(!reader.readWindow(30, 20, 11, 5, window));
+}
+
+void ImageIO_test::test_readGrayscaleImageFromTiffTiles()
+{
+  // 40x30 grayscale, 16-bit, tiles of 16x16, uncompressed, big-endian BigTIFF
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/gradient_gray16_tiled.tif").toStdString();
+
+  TiffReader reader(path);
+  QVERIFY(reader.isOpen());
+  QVERIFY(reader.isBigTiff());
+  QVERIFY(reader.isTiled());
+  QCOMPARE(reader.chunksAcross(), static_cast<size_t>(3));
+  QCOMPARE(reader.chunkCount(), static_cast<size_t>(6));
+
+  Image<unsigned short, 1> image;
+  QVERIFY(reader.readImage(image));
+  for (size_t y = 0; y < image.height(); y++)
+  {
+    for (size_t x = 0; x < image.width(); x++)
+    {
+      QCOMPARE(image.pixel(x, y)[0], static_cast<unsigned short>(x * 1000 + y * 17));
+    }
+  }
+
+  // Read bottom right tile; includes padding
+  Image<unsigned short, 1> tile;
+  QVERIFY(reader.readTile(5, tile));
+  QCOMPARE(tile.width(), static_cast<size_t>(16));
+  QCOMPARE(tile.height(), static_cast<size_t>(16));
+  QCOMPARE(tile.pixel(0, 0)[0], image.pixel(32, 16)[0]);
+  QVERIFY(!reader.readStrip(0, tile));
+
+  // Read window inside a single tile
+  Image<unsigned short, 1> window;
+  QVERIFY(reader.readWindow(17, 17, 5, 5, window));
+  QCOMPARE(window.pixel(4, 4)[0], image.pixel(21, 21)[0]);
+}
+
+void ImageIO_test::test_readFloatWindowFromTiff()
+{
+  // 20x12 grayscale, 32-bit float, strips of 4 rows, uncompressed,
+  // little-endian. The last strip points beyond the end of the file.
+  const std::string path = (QFileInfo(__FILE__).absolutePath() + "/resources/gradient_float32_truncated.tif").toStdString();
+
+  TiffReader reader(path);
+  QVERIFY(reader.isOpen());
+  QCOMPARE(reader.sampleFormat(), 3u);
+  QCOMPARE(reader.bitsPerSample(), static_cast<size_t>(32));
+  QCOMPARE(reader.chunkCount(), static_cast<size_t>(3));
+
+  // Sample type must be floating point
+  Image<unsigned int, 1> integer;
+  QVERIFY(!reader.readWindow(0, 0, 4, 4, integer));
+
+  // Window inside the first two strips: the missing strip is not read
+  Image<float, 1> window;
+  QVERIFY(reader.readWindow(2, 1, 15, 6, window));
+  QCOMPARE(window.width(), static_cast<size_t>(15));
+  QCOMPARE(window.height(), static_cast<size_t>(6));
+  for (size_t y = 0; y < window.height(); y++)
+  {
+    for (size_t x = 0; x < window.width(); x++)
+    {
+      QCOMPARE(window.pixel(x, y)[0], (x + 2) * 0.5f - (y + 1) * 0.25f + 0.125f);
+    }
+  }
+
+  // Windows overlapping the missing strip fail
+  QVERIFY(!reader.readWindow(0, 7, 1, 2, window));
+  QVERIFY(!reader.readStrip(2, window));
+  Image<float, 1> image;
+  QVERIFY(!reader.readImage(image));
+}
+
+void ImageIO_test::test_reopenTiffReader()
+{
+  const std::string floatPath = (QFileInfo(__FILE__).absolutePath() + "/resources/gradient_float32_truncated.tif").toStdString();
+  const std::string gray8Path = (QFileInfo(__FILE__).absolutePath() + "/resources/gradient_gray8_minimal.tif").toStdString();
+  const std::string gray16Path = (QFileInfo(__FILE__).absolutePath() + "/resources/gradient_gray16_tiled.tif").toStdString();
+
+  // Open a tiled BigTIFF and a floating point TIFF first
+  TiffReader reader;
+  QVERIFY(reader.open(gray16Path));
+  QVERIFY(reader.isBigTiff());
+  QVERIFY(reader.isTiled());
+  QVERIFY(reader.open(floatPath));
+  QCOMPARE(reader.sampleFormat(), 3u);
+
+  // 20x12 grayscale, 8-bit, single strip, big-endian. Only the required tags
+  // are present; nothing may carry over from the previous files.
+  QVERIFY(reader.open(gray8Path));
+  QVERIFY(!reader.isBigTiff());
+  QVERIFY(!reader.isTiled());
+  QCOMPARE(reader.sampleFormat(), 1u);
+  QCOMPARE(reader.bitsPerSample(), static_cast<size_t>(8));
+  QCOMPARE(reader.samplesPerPixel(), static_cast<size_t>(1));
+  QCOMPARE(reader.chunkCount(), static_cast<size_t>(1));
+
+  Image<unsigned char, 1> image;
+  QVERIFY(reader.readImage(image));
+  QCOMPARE(image.width(), static_cast<size_t>(20));
+  QCOMPARE(image.height(), static_cast<size_t>(12));
+  for (size_t y = 0; y < image.height(); y++)
+  {
+    for (size_t x = 0; x < image.width(); x++)
+    {
+      QCOMPARE(image.pixel(x, y)[0], static_cast<unsigned char>(x * 10 + y));
+    }
+  }
+}
+
+void ImageIO_test::test_rejectTiffWithHugeTiles()
+{
+  // 16x16 grayscale, 8-bit, a single tile of 4294967280x4294967280
+  const std::string hugePath = (QFileInfo(__FILE__).absolutePath() + "/resources/huge_tiles.tif").toStdString();
+  TiffReader reader(hugePath);
+  QVERIFY(!reader.isOpen());
+  Image<unsigned char, 1> image;
+  QVERIFY(!ImageIO::readImageFromTiff(hugePath, image));
+
+  // BigTIFF, 16x16 grayscale, 8-bit, a single tile of 2^32x2^32; the tile
+  // size in bytes wraps to 0
+  const std::string wrapPath = (QFileInfo(__FILE__).absolutePath() + "/resources/huge_tiles_wrap.tif").toStdString();
+  QVERIFY(!reader.open(wrapPath));
+  QVERIFY(!ImageIO::readImageFromTiff(wrapPath, image));
+}
+
+// Asynchronous loading
+
+void ImageIO_test::test_asyncImageLoader()
+{
+  // Write frames with distinct content
+  const size_t frameCount = 12;
+  std::vector<std::string> paths;
+  for (size_t i = 0; i < frameCount; i++)
+  {
+    Image<unsigned char, 3> frame(16 + i, 8);
+    frame.pixel(0, 0) = { static_cast<unsigned char>(i), 0, 0 };
+    paths.push_back((QFileInfo(__FILE__).absolutePath() + "/resources/tmp/frame" + QString::number(i) + ".ppm").toStdString());
+    QVERIFY(ImageIO::writeRgbImageAsPpm(frame, paths.back()));
+  }
+  paths.push_back((QFileInfo(__FILE__).absolutePath() + "/resources/tmp/missing.ppm").toStdString());
+
+  // Load with 3 threads and 2 buffers. The first frame waits until the
+  // second frame has been read, so frames finish out of order.
+  std::promise<void> secondRead;
+  const std::shared_future<void> secondReadDone = secondRead.get_future().share();
+  std::mutex mutex;
+  std::vector<std::string> readOrder;
+  AsyncImageLoader<unsigned char, 3> loader([&](const std::string &path, Image<unsigned char, 3> &image) {
+    if (path == paths[0])
+    {
+      secondReadDone.wait();
+    }
+    const bool success = ImageIO::readRgbImageFromPpm(path, image);
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      readOrder.push_back(path);
+    }
+    if (path == paths[1])
+    {
+      secondRead.set_value();
+    }
+    return success;
+  }, 3, 2);
+  loader.enqueue(paths);
+  QCOMPARE(loader.size(), frameCount + 1);
+
+  // Frames are delivered in order
+  Image<unsigned char, 3> frame;
+  bool success = false;
+  for (size_t i = 0; i < frameCount; i++)
+  {
+    QVERIFY(loader.next(frame, success));
+    QVERIFY(success);
+    QCOMPARE(frame.width(), 16 + i);
+    QCOMPARE(frame.pixel(0, 0)[0], static_cast<unsigned char>(i));
+  }
+
+  // Missing file fails, then the queue is exhausted
+  QVERIFY(loader.next(frame, success));
+  QVERIFY(!success);
+  QVERIFY(!loader.next(frame, success));
+  QCOMPARE(loader.delivered(), frameCount + 1);
+
+  // Every path has been read once; the second frame before the first
+  std::lock_guard<std::mutex> lock(mutex);
+  QCOMPARE(readOrder.size(), frameCount + 1);
+  QVERIFY(readOrder[0] == paths[1]);
+}
+
+void ImageIO_test::test_asyncImageLoaderException()
+{
+  // Read function throws a non-standard exception for the second path
+  std::vector<std::string> paths = { "a", "b", "c" };
+  AsyncImageLoader<unsigned char, 3> loader([](const std::string &path, Image<unsigned char, 3> &image) {
+    if (path == "b")
+    {
+      throw 42;
+    }
+    image = Image<unsigned char, 3>(path == "a" ? 1 : 3, 1);
+    return true;
+  });
+  loader.enqueue(paths);
+
+  Image<unsigned char, 3> frame;
+  bool success = false;
+  QVERIFY(loader.next(frame, success));
+  QVERIFY(success);
+  QCOMPARE(frame.width(), size_t(1));
+
+  // Exception is rethrown by the consumer
+  QVERIFY_EXCEPTION_THROWN(loader.next(frame, success), int);
+
+  // Subsequent paths are still delivered
+  QVERIFY(loader.next(frame, success));
+  QVERIFY(success);
+  QCOMPARE(frame.width(), size_t(3));
+  QVERIFY(!loader.next(frame, success));
+  QCOMPARE(loader.delivered(), size_t(3));
+}
 
 QTEST_APPLESS_MAIN(ImageIO_test)
 
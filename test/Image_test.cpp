@@ -2,6 +2,7 @@
 #include "TestUtilities.h"
 
 #include <spatium/Image.h>
+#include <spatium/ImagePool.h>
 
 class Image_test : public QObject
 {
@@ -28,6 +29,10 @@ private slots:
 
   void test_getSetPixel();
   void test_clear();
+  void test_resizeReusesMemory();
+
+  // Image pool
+  void test_imagePool();
 
 private:
 };
@@ -209,6 +214,74 @@ void Image_test::test_clear()
   }
 }
 
+void Image_test::test_resizeReusesMemory()
+{
+  Image<unsigned char, 3> img(20, 10);
+  img.pixel(3, 4) = { 1, 2, 3 };
+  std::array<unsigned char, 3> *data = img.imageDataPtr();
+
+  // Same pixel count: memory is reused and cleared
+  img.resize(10, 20);
+  QCOMPARE(img.imageDataPtr(), data);
+  QCOMPARE(img.width(), static_cast<size_t>(10));
+  QCOMPARE(img.height(), static_cast<size_t>(20));
+  QCOMPARE(img.pixel(4, 6), (std::array<unsigned char, 3>{ 0, 0, 0 }));
+
+  // Swap exchanges memory
+  Image<unsigned char, 3> other(5, 5);
+  img.swap(other);
+  QCOMPARE(other.imageDataPtr(), data);
+  QCOMPARE(img.width(), static_cast<size_t>(5));
+}
+
+// Image pool
+
+void Image_test::test_imagePool()
+{
+  ImagePool<unsigned char, 1> pool;
+  std::array<unsigned char, 1> *data = nullptr;
+  {
+    ImagePool<unsigned char, 1>::Lease lease = pool.acquire(20, 10);
+    QVERIFY(static_cast<bool>(lease));
+    QCOMPARE(lease->width(), static_cast<size_t>(20));
+    QCOMPARE(lease->height(), static_cast<size_t>(10));
+    data = lease->imageDataPtr();
+    QCOMPARE(pool.idleCount(), static_cast<size_t>(0));
+  }
+  QCOMPARE(pool.idleCount(), static_cast<size_t>(1));
+
+  // Same size: image is reused
+  ImagePool<unsigned char, 1>::Lease first = pool.acquire(20, 10);
+  QCOMPARE(first->imageDataPtr(), data);
+
+  // Other size, or same size while in use: new image
+  ImagePool<unsigned char, 1>::Lease second = pool.acquire(20, 10);
+  ImagePool<unsigned char, 1>::Lease third = pool.acquire(10, 20);
+  QVERIFY(second->imageDataPtr() != data);
+  QCOMPARE(pool.allocationCount(), static_cast<size_t>(3));
+
+  // Moving a lease transfers ownership
+  ImagePool<unsigned char, 1>::Lease moved(std::move(first));
+  QVERIFY(!first);
+  QCOMPARE(moved.get()->imageDataPtr(), data);
+  moved.release();
+  QVERIFY(!moved);
+  QCOMPARE(pool.idleCount(), static_cast<size_t>(1));
+
+  // Steady state: no allocations
+  second.release();
+  QCOMPARE(pool.idleCount(), static_cast<size_t>(2));
+  for (int i = 0; i < 10; i++)
+  {
+    ImagePool<unsigned char, 1>::Lease a = pool.acquire(20, 10);
+    ImagePool<unsigned char, 1>::Lease b = pool.acquire(20, 10);
+  }
+  QCOMPARE(pool.allocationCount(), static_cast<size_t>(3));
+
+  pool.clear();
+  QCOMPARE(pool.idleCount(), static_cast<size_t>(0));
+}
+
 QTEST_APPLESS_MAIN(Image_test)
 
 #include "Image_test.moc"